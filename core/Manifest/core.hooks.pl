@@ -59,6 +59,7 @@
 '$builder_hook'(item_nested(core_cmds)).
 '$builder_hook'(core_cmds:cmd('cmds/ciaodump')).
 '$builder_hook'(core_cmds:cmd('cmds/pldiff')).
+'$builder_hook'(core_cmds:cmd('cmds/heapsnap')).
 '$builder_hook'(core_cmds:cmd('cmds/ciaoc_sdyn')).
 '$builder_hook'(core_cmds:cmd('cmds/ciao-serve/ciao-serve')).
 % TODO: temporary, see rundaemon.pl TODOs
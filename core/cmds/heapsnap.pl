@@ -0,0 +1,56 @@
+:- module(_, [main/1], [assertions]).
+
+:- use_module(library(format)).
+:- use_module(library(heap_snapshot), [heap_snapshot_analyze/5]).
+
+:- doc(title,"Analysis of heap snapshots").
+
+:- doc(author,"The Ciao Development Team").
+
+:- doc(module,"This program reads a heap snapshot (see
+   @lib{heap_snapshot}) and prints the functors and the roots (frames,
+   choicepoints, etc. labeled with the owner predicate) that retain
+   most memory.
+
+   @section{Usage (heapsnap)}
+
+   @includefact{usage_text/1}
+   ").
+
+main([File]) :- !,
+    heapsnap(File, 20).
+main([File, NA]) :-
+    atom_number(NA, N), integer(N), N >= 0, !,
+    heapsnap(File, N).
+main(['-h']) :- !,
+    usage.
+main(Args) :-
+    format(user_error, "ERROR: Invalid arguments ~w~n", [Args]),
+    usage.
+
+usage :-
+    usage_text(TextS),
+    format(user_error, "Usage: ~n~s", [TextS]).
+
+usage_text("
+    heapsnap <file> [<n>]
+       : print the <n> (20 by default, 0 for all) functors and roots
+         with largest retained size
+
+    heapsnap -h
+       : print this information
+").
+
+heapsnap(File, N) :-
+    heap_snapshot_analyze(File, N, Total, ByFunctor, ByRoot),
+    format("Reachable heap: ~d bytes~n~n", [Total]),
+    format("~w~t~40|~t~w~52|~t~w~66|~t~w~80|~n", ['Functor', 'Count', 'Shallow', 'Retained']),
+    print_summary(ByFunctor),
+    format("~n", []),
+    format("~w~t~40|~t~w~52|~t~w~66|~t~w~80|~n", ['Root', 'Count', 'Shallow', 'Retained']),
+    print_summary(ByRoot).
+
+print_summary([]).
+print_summary([Label-[Count, Shallow, Retained]|Xs]) :-
+    format("~w~t~40|~t~d~52|~t~d~66|~t~d~80|~n", [Label, Count, Shallow, Retained]),
+    print_summary(Xs).
@@ -75,6 +75,76 @@ static inline bool_t float_is_finite(flt64_t f) {
   } \
 })
 
+/* --------------------------------------------------------------------------- */
+/* Rational numbers (representation) */
+
+/* A rational number is a rat(N,D) structure where N and D are
+   integers, D > 1 and gcd(N,D) = 1 (rationals with D = 1 are just
+   integers). Canonical rat(N,D) terms evaluate to themselves, so that
+   they can be mixed with other numbers in arithmetic expressions (see
+   the rational arithmetic below). */
+
+#define IsRat(X) (TaggedIsSTR(X) && TaggedToHeadfunctor(X) == functor_rat)
+
+/* N and D of the rational or integer X */
+#define RatParts(X, N, D) ({ \
+  if (IsRat(X)) { \
+    DerefArg(N, X, 1); \
+    DerefArg(D, X, 2); \
+  } else { \
+    N = X; \
+    D = MakeSmall(1); \
+  } \
+})
+
+/* (a, b >= 0) */
+static inline intmach_t intmach_gcd(intmach_t a, intmach_t b) {
+  while (b != 0) {
+    intmach_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+/* X (a rat/2 structure) is in canonical form (coprimality is only
+   checked for small N and D) */
+static bool_t rat_is_canonical(tagged_t x) {
+  tagged_t n, d;
+  DerefArg(n, x, 1);
+  DerefArg(d, x, 2);
+  if (TaggedIsSmall(n) && TaggedIsSmall(d)) {
+    intmach_t a = GetSmall(n);
+    intmach_t b = GetSmall(d);
+    return b > 1 && intmach_gcd(a < 0 ? -a : a, b) == 1;
+  }
+  if (!IsInteger(n) || !IsInteger(d)) return FALSE;
+  if (TaggedIsSmall(d)) return d > MakeSmall(1);
+  return bn_positive(TaggedToBignum(d));
+}
+
+/* x = f*2^(*exp) for an integer x */
+static inline flt64_t int_to_flt64_scaled(tagged_t x, intmach_t *exp) {
+  if (TaggedIsSmall(x)) {
+    *exp = 0;
+    return (flt64_t)GetSmall(x);
+  }
+  return bn_to_float_scaled(TaggedToBignum(x), exp);
+}
+
+static inline flt64_t rat_to_flt64(tagged_t x) {
+  tagged_t n, d;
+  flt64_t fn, fd;
+  intmach_t en, ed;
+  RatParts(x, n, d);
+  /* (scaled, so that huge parts do not give inf/inf) */
+  fn = int_to_flt64_scaled(n, &en);
+  fd = int_to_flt64_scaled(d, &ed);
+  return ldexp(fn/fd, en-ed);
+}
+
+#define NumOrRatToFloat(X) (IsRat(X) ? rat_to_flt64(X) : TaggedToFloat(X))
+
 /* --------------------------------------------------------------------------- */
 
 /* Evaluate an arithmetic expression 
@@ -92,6 +162,9 @@ static CFUN__PROTO(evaluate, tagged_t, tagged_t v) {
   }, { /* STR(blob) */
     CFUN__PROCEED(v);
   }, { /* STR(struct) */
+    if (t_head_functor == functor_rat && rat_is_canonical(v)) {
+      CFUN__PROCEED(v);
+    }
 #if defined(OPTIM_COMP)
     void *proc = hashtab_get(switch_on_function,t_head_functor)->value.as_ptr;
 #else
@@ -146,11 +219,34 @@ static CFUN__PROTO(evaluate, tagged_t, tagged_t v) {
   } \
 })
 
+/* Numbers or rationals (see rational numbers below) */
+#define IsNumOrRat(X) IsNumber(X)
+#define CheckNumOrRat(U,ArgNo) ({ \
+  if (!IsNumber(U) && !IsRat(U)) { \
+    BUILTIN_ERROR(ERR_type_error(evaluable), (U), (ArgNo)); \
+  } \
+})
+
+/* Rationals are converted to floats where numbers are expected, and
+   they are not integers */
+#define RatToNumber_GC(U, ArgNo, ...) ({ \
+  if (IsRat(U)) { \
+    PROT_GC(U = CFUN__EVAL(flt64_to_blob_GC, rat_to_flt64(U)), __VA_ARGS__); \
+  } \
+})
+#define RatToInteger_GC(U, ArgNo, ...) ({ \
+  if (IsRat(U)) { \
+    BUILTIN_ERROR(ERR_type_error(integer), (U), (ArgNo)); \
+  } \
+})
+#define RatToNumOrRat_GC(U, ArgNo, ...) {}
+
 /* Evaluate U (if needed) and check that it has type DOM.
    Additional arguments are GC roots (if a heap overflow or GC is needed) */
 #define EvalArith_GC(DOM, U, ArgNo, ...) ({ \
   if (!Is##DOM(U)) { \
     PROT_GC(U = CFUN__EVAL(evaluate, U), __VA_ARGS__); \
+    RatTo##DOM##_GC(U, ArgNo, __VA_ARGS__); \
     Check##DOM(U, ArgNo); \
   } \
 })
@@ -409,19 +505,340 @@ CFUN__PROTO(flt64_to_blob_GC, tagged_t, flt64_t i) {
 // }
 // #endif
 
+/* --------------------------------------------------------------------------- */
+/* Rational arithmetic */
+
+/* Rationals are computed with the integer operations below (which may
+   trigger a GC). Intermediate values are kept as GC roots in a frame
+   (RatRoot(1) to RatRoot(N)). */
+
+CFUN__PROTO(fu1_minus, tagged_t, tagged_t x0);
+CFUN__PROTO(fu1_add1, tagged_t, tagged_t x0);
+CFUN__PROTO(fu1_sub1, tagged_t, tagged_t x0);
+CFUN__PROTO(fu2_plus, tagged_t, tagged_t x0, tagged_t x1);
+CFUN__PROTO(fu2_minus, tagged_t, tagged_t x0, tagged_t x1);
+CFUN__PROTO(fu2_times, tagged_t, tagged_t x0, tagged_t x1);
+CFUN__PROTO(fu2_idivide, tagged_t, tagged_t x0, tagged_t x1);
+CFUN__PROTO(fu2_rem, tagged_t, tagged_t x0, tagged_t x1);
+CFUN__PROTO(fu2_gcd, tagged_t, tagged_t x0, tagged_t x1);
+CFUN__PROTO(fu2_lsh, tagged_t, tagged_t x0, tagged_t x1);
+
+#define RatRootsPush(N) ({ \
+  CVOID__CALL(push_gc_frame, (N)); \
+  frame_t *a_ = G->frame; \
+  for (intmach_t i_ = 0; i_ <= (N); i_++) a_->x[i_] = TaggedZero; \
+})
+#define RatRoot(I) (G->frame->x[(I)])
+#define RatRootsPop() CVOID__CALL(pop_gc_frame)
+/* RatRoot(I) = F(RatRoot(J), RatRoot(K)) */
+#define RatOp2(I, F, J, K) ({ \
+  tagged_t r_ = CFUN__EVAL(F, RatRoot(J), RatRoot(K)); \
+  RatRoot(I) = r_; \
+})
+/* RatRoot(I) = F(RatRoot(J)) */
+#define RatOp1(I, F, J) ({ \
+  tagged_t r_ = CFUN__EVAL(F, RatRoot(J)); \
+  RatRoot(I) = r_; \
+})
+
+/* P=A*B on small integer values, jump to LabOverflow if P is not a
+   small integer value */
+#define SmiMul(A, B, P, LabOverflow) ({ \
+  SMUL_OVERFLOW((A), (B), P, { goto LabOverflow; }); \
+  if (!IsInSmiValRange(P)) goto LabOverflow; \
+})
+
+static inline intmach_t integer_sign(tagged_t t) {
+  if (TaggedIsSmall(t)) {
+    return t < TaggedZero ? -1 : (t > TaggedZero ? 1 : 0);
+  } else {
+    return bn_positive(TaggedToBignum(t)) ? 1 : -1;
+  }
+}
+
+static inline intmach_t integer_compare(tagged_t t, tagged_t u) {
+  if (TaggedIsSmall(t) && TaggedIsSmall(u)) {
+    return t < u ? -1 : (t > u ? 1 : 0);
+  } else if (TaggedIsSmall(t)) {
+    return bn_positive(TaggedToBignum(u)) ? -1 : 1;
+  } else if (TaggedIsSmall(u)) {
+    return bn_positive(TaggedToBignum(t)) ? 1 : -1;
+  } else {
+    intmach_t c = bn_compare(TaggedToBignum(t), TaggedToBignum(u));
+    return c < 0 ? -1 : (c > 0 ? 1 : 0);
+  }
+}
+
+#define RatSign(X) ({ \
+  tagged_t n_; \
+  DerefArg(n_, X, 1); \
+  integer_sign(n_); \
+})
+
+/* The rat(N,D) structure (N and D already in canonical form) */
+static CFUN__PROTO(rat_build_GC, tagged_t, tagged_t n, tagged_t d) {
+  tagged_t *h;
+  HeapMargin_GC(3*sizeof(tagged_t), n, d);
+  h = G->heap_top;
+  HeapPush(h, functor_rat);
+  HeapPush(h, n);
+  HeapPush(h, d);
+  G->heap_top = h;
+  CFUN__PROCEED(Tagp(STR, h-3));
+}
+
+/* The rational A/B, for A and B in the range of small integer values
+   (b != 0) */
+static CFUN__PROTO(rat_make_small_GC, tagged_t, intmach_t a, intmach_t b) {
+  tagged_t *h;
+  intmach_t g;
+  /* (rat/2 structure and two integers, see make_integer()) */
+  HeapMargin_GC(9*sizeof(tagged_t));
+  if (b < 0) {
+    a = -a;
+    b = -b;
+  }
+  g = intmach_gcd(a < 0 ? -a : a, b);
+  a /= g;
+  b /= g;
+  if (b == 1) CFUN__PROCEED(IntmachToTagged(a));
+  tagged_t n = IntmachToTagged(a);
+  tagged_t d = IntmachToTagged(b);
+  h = G->heap_top;
+  HeapPush(h, functor_rat);
+  HeapPush(h, n);
+  HeapPush(h, d);
+  G->heap_top = h;
+  CFUN__PROCEED(Tagp(STR, h-3));
+}
+
+/* The rational N/D, for integers N and D (D != 0) */
+static CFUN__PROTO(rat_make_GC, tagged_t, tagged_t n, tagged_t d) {
+  if (TaggedIsSmall(n) && TaggedIsSmall(d)) {
+    CFUN__LASTCALL(rat_make_small_GC, GetSmall(n), GetSmall(d));
+  }
+  RatRootsPush(3);
+  RatRoot(1) = n;
+  RatRoot(2) = d;
+  RatOp2(3, fu2_gcd, 1, 2);
+  if (integer_sign(RatRoot(2)) < 0) RatOp1(3, fu1_minus, 3);
+  if (RatRoot(3) != MakeSmall(1)) {
+    RatOp2(1, fu2_idivide, 1, 3);
+    RatOp2(2, fu2_idivide, 2, 3);
+  }
+  n = RatRoot(1);
+  d = RatRoot(2);
+  RatRootsPop();
+  if (d == MakeSmall(1)) CFUN__PROCEED(n);
+  CFUN__LASTCALL(rat_build_GC, n, d);
+}
+
+/* T+U (or T-U if neg), where T and U are rationals or integers */
+static CFUN__PROTO(rat_add_GC, tagged_t, tagged_t t, tagged_t u, bool_t neg) {
+  tagged_t a, b, c, d;
+  RatParts(t, a, b);
+  RatParts(u, c, d);
+  if (TaggedIsSmall(a) && TaggedIsSmall(b) && TaggedIsSmall(c) && TaggedIsSmall(d)) {
+    intmach_t ad, cb, bd;
+    SmiMul(GetSmall(a), GetSmall(d), ad, big);
+    SmiMul(GetSmall(c), GetSmall(b), cb, big);
+    SmiMul(GetSmall(b), GetSmall(d), bd, big);
+    CFUN__LASTCALL(rat_make_small_GC, neg ? ad-cb : ad+cb, bd);
+  }
+ big:
+  RatRootsPush(6);
+  RatRoot(1) = a;
+  RatRoot(2) = b;
+  RatRoot(3) = c;
+  RatRoot(4) = d;
+  RatOp2(5, fu2_times, 1, 4);
+  RatOp2(6, fu2_times, 3, 2);
+  if (neg) {
+    RatOp2(5, fu2_minus, 5, 6);
+  } else {
+    RatOp2(5, fu2_plus, 5, 6);
+  }
+  RatOp2(6, fu2_times, 2, 4);
+  a = RatRoot(5);
+  b = RatRoot(6);
+  RatRootsPop();
+  CFUN__LASTCALL(rat_make_GC, a, b);
+}
+
+/* T*U (or T/U if inv, U != 0), where T and U are rationals or
+   integers */
+static CFUN__PROTO(rat_mul_GC, tagged_t, tagged_t t, tagged_t u, bool_t inv) {
+  tagged_t a, b, c, d;
+  RatParts(t, a, b);
+  if (inv) {
+    RatParts(u, d, c);
+  } else {
+    RatParts(u, c, d);
+  }
+  if (TaggedIsSmall(a) && TaggedIsSmall(b) && TaggedIsSmall(c) && TaggedIsSmall(d)) {
+    intmach_t ac, bd;
+    SmiMul(GetSmall(a), GetSmall(c), ac, big);
+    SmiMul(GetSmall(b), GetSmall(d), bd, big);
+    CFUN__LASTCALL(rat_make_small_GC, ac, bd);
+  }
+ big:
+  RatRootsPush(4);
+  RatRoot(1) = a;
+  RatRoot(2) = b;
+  RatRoot(3) = c;
+  RatRoot(4) = d;
+  RatOp2(1, fu2_times, 1, 3);
+  RatOp2(2, fu2_times, 2, 4);
+  a = RatRoot(1);
+  b = RatRoot(2);
+  RatRootsPop();
+  CFUN__LASTCALL(rat_make_GC, a, b);
+}
+
+/* Compare T and U (rationals or integers), returns -1, 0, or 1 */
+static CFUN__PROTO(rat_compare_GC, intmach_t, tagged_t t, tagged_t u) {
+  tagged_t a, b, c, d;
+  intmach_t r;
+  RatParts(t, a, b);
+  RatParts(u, c, d);
+  if (TaggedIsSmall(a) && TaggedIsSmall(b) && TaggedIsSmall(c) && TaggedIsSmall(d)) {
+    intmach_t ad, cb;
+    SmiMul(GetSmall(a), GetSmall(d), ad, big);
+    SmiMul(GetSmall(c), GetSmall(b), cb, big);
+    CFUN__PROCEED(ad < cb ? -1 : (ad > cb ? 1 : 0));
+  }
+ big:
+  RatRootsPush(4);
+  RatRoot(1) = a;
+  RatRoot(2) = b;
+  RatRoot(3) = c;
+  RatRoot(4) = d;
+  RatOp2(1, fu2_times, 1, 4);
+  RatOp2(3, fu2_times, 3, 2);
+  r = integer_compare(RatRoot(1), RatRoot(3));
+  RatRootsPop();
+  CFUN__PROCEED(r);
+}
+
+static CFUN__PROTO(rat_neg_GC, tagged_t, tagged_t t) {
+  tagged_t n, d;
+  RatParts(t, n, d);
+  PROT_GC(n = CFUN__EVAL(fu1_minus, n), d);
+  CFUN__LASTCALL(rat_build_GC, n, d);
+}
+
+#define RAT_TRUNCATE 0
+#define RAT_FLOOR 1
+#define RAT_CEILING 2
+#define RAT_ROUND 3 /* (half away from zero) */
+
+/* Round the rational T to an integer */
+static CFUN__PROTO(rat_round_GC, tagged_t, tagged_t t, int mode) {
+  tagged_t a, b;
+  RatParts(t, a, b);
+  if (TaggedIsSmall(a) && TaggedIsSmall(b)) {
+    intmach_t n = GetSmall(a);
+    intmach_t d = GetSmall(b);
+    intmach_t q = n / d;
+    intmach_t r = n % d;
+    switch (mode) {
+    case RAT_FLOOR: if (r < 0) q--; break;
+    case RAT_CEILING: if (r > 0) q++; break;
+    case RAT_ROUND: if (2*(r < 0 ? -r : r) >= d) q += (n < 0 ? -1 : 1); break;
+    }
+    CFUN__PROCEED(MakeSmall(q));
+  }
+  RatRootsPush(4);
+  RatRoot(1) = a;
+  RatRoot(2) = b;
+  RatOp2(3, fu2_idivide, 1, 2);
+  RatOp2(4, fu2_rem, 1, 2);
+  switch (mode) {
+  case RAT_FLOOR:
+    if (integer_sign(RatRoot(4)) < 0) RatOp1(3, fu1_sub1, 3);
+    break;
+  case RAT_CEILING:
+    if (integer_sign(RatRoot(4)) > 0) RatOp1(3, fu1_add1, 3);
+    break;
+  case RAT_ROUND:
+    if (integer_sign(RatRoot(4)) < 0) RatOp1(4, fu1_minus, 4);
+    RatOp2(4, fu2_plus, 4, 4);
+    if (integer_compare(RatRoot(4), RatRoot(2)) >= 0) {
+      if (integer_sign(RatRoot(1)) < 0) {
+        RatOp1(3, fu1_sub1, 3);
+      } else {
+        RatOp1(3, fu1_add1, 3);
+      }
+    }
+    break;
+  }
+  a = RatRoot(3);
+  RatRootsPop();
+  CFUN__PROCEED(a);
+}
+
+/* The rational that is exactly equal to the (finite) float F */
+static CFUN__PROTO(rat_from_float_GC, tagged_t, flt64_t f) {
+  tagged_t n, d;
+  flt64_t m;
+  int e;
+  if (f == aint(f)) CFUN__LASTCALL(bn_from_float_GC, f);
+  /* F = M*2^E, with M an odd integer and E < 0 */
+  m = ldexp(frexp(f, &e), 53);
+  e -= 53;
+  while (fmod(m, 2.0) == 0.0) {
+    m = m / 2.0;
+    e++;
+  }
+  n = CFUN__EVAL(bn_from_float_GC, m);
+  PROT_GC(d = CFUN__EVAL(fu2_lsh, MakeSmall(1), MakeSmall(-e)), n);
+  CFUN__LASTCALL(rat_build_GC, n, d);
+}
+
+/* The simplest rational that converts back to the (finite) float F
+   (continued fraction expansion, using the exact conversion if the
+   expansion does not converge quickly) */
+static CFUN__PROTO(rat_rationalize_GC, tagged_t, flt64_t f) {
+  flt64_t e0 = f, p0 = 0.0, q0 = 1.0;
+  flt64_t e1 = -1.0, p1 = 1.0, q1 = 0.0;
+  tagged_t n, d;
+  int i;
+  if (f == aint(f)) CFUN__LASTCALL(bn_from_float_GC, f);
+  for (i = 0; ; i++) {
+    flt64_t r = floor(e0/e1);
+    flt64_t e00 = e0, p00 = p0, q00 = q0;
+    e0 = e1;
+    p0 = p1;
+    q0 = q1;
+    e1 = e00 - r*e1;
+    p1 = p00 - r*p1;
+    q1 = q00 - r*q1;
+    /* (p1 and q1 must be exact) */
+    if (i >= 100 || fabs(p1) >= 9007199254740992.0 || fabs(q1) >= 9007199254740992.0) {
+      CFUN__LASTCALL(rat_from_float_GC, f);
+    }
+    if (p1/q1 == f) break;
+  }
+  n = CFUN__EVAL(bn_from_float_GC, p1);
+  PROT_GC(d = CFUN__EVAL(bn_from_float_GC, q1), n);
+  CFUN__LASTCALL(rat_make_GC, n, d);
+}
+
 /* --------------------------------------------------------------------------- */
 
 CBOOL__PROTO(bu2_numeq, tagged_t x0, tagged_t x1) {
   ERR__FUNCTOR("arithmetic:=:=", 2);
   tagged_t t=x0,u=x1;
-  EvalArith2Sw(Number, t, u, small, nonsmall);
+  EvalArith2Sw(NumOrRat, t, u, small, nonsmall);
 
  small:
   CBOOL__LASTTEST(t==u);
 
  nonsmall:
   if (IsFloat(t) || IsFloat(u)) {
-    CBOOL__LASTTEST(TaggedToFloat(t)==TaggedToFloat(u));
+    CBOOL__LASTTEST(NumOrRatToFloat(t)==NumOrRatToFloat(u));
+  } else if (IsRat(t) || IsRat(u)) {
+    CBOOL__LASTTEST(CFUN__EVAL(rat_compare_GC,t,u)==0);
   } else if (TaggedIsSmall(t) || TaggedIsSmall(u)) {
     CBOOL__FAIL;
   } else {
@@ -432,14 +849,16 @@ CBOOL__PROTO(bu2_numeq, tagged_t x0, tagged_t x1) {
 CBOOL__PROTO(bu2_numne, tagged_t x0, tagged_t x1) {
   ERR__FUNCTOR("arithmetic:=\\=", 2);
   tagged_t t=x0,u=x1;
-  EvalArith2Sw(Number, t, u, small, nonsmall);
+  EvalArith2Sw(NumOrRat, t, u, small, nonsmall);
 
  small:
   CBOOL__LASTTEST(t!=u);
 
  nonsmall:
   if (IsFloat(t) || IsFloat(u)) {
-    CBOOL__LASTTEST(TaggedToFloat(t)!=TaggedToFloat(u));
+    CBOOL__LASTTEST(NumOrRatToFloat(t)!=NumOrRatToFloat(u));
+  } else if (IsRat(t) || IsRat(u)) {
+    CBOOL__LASTTEST(CFUN__EVAL(rat_compare_GC,t,u)!=0);
   } else if (TaggedIsSmall(t) || TaggedIsSmall(u)) {
     CBOOL__PROCEED;
   } else {
@@ -450,14 +869,16 @@ CBOOL__PROTO(bu2_numne, tagged_t x0, tagged_t x1) {
 CBOOL__PROTO(bu2_numlt, tagged_t x0, tagged_t x1) {
   ERR__FUNCTOR("arithmetic:<", 2);
   tagged_t t=x0,u=x1;
-  EvalArith2Sw(Number, t, u, small, nonsmall);
+  EvalArith2Sw(NumOrRat, t, u, small, nonsmall);
 
  small:
   CBOOL__LASTTEST(t<u);
 
  nonsmall:
   if (IsFloat(t) || IsFloat(u)) {
-    CBOOL__LASTTEST(TaggedToFloat(t)<TaggedToFloat(u));
+    CBOOL__LASTTEST(NumOrRatToFloat(t)<NumOrRatToFloat(u));
+  } else if (IsRat(t) || IsRat(u)) {
+    CBOOL__LASTTEST(CFUN__EVAL(rat_compare_GC,t,u)<0);
   } else if (TaggedIsSmall(t)) {
     CBOOL__LASTTEST(bn_positive(TaggedToBignum(u)));
   } else if (TaggedIsSmall(u)) {
@@ -470,14 +891,16 @@ CBOOL__PROTO(bu2_numlt, tagged_t x0, tagged_t x1) {
 CBOOL__PROTO(bu2_numle, tagged_t x0, tagged_t x1) {
   ERR__FUNCTOR("arithmetic:=<", 2);
   tagged_t t=x0,u=x1;
-  EvalArith2Sw(Number, t, u, small, nonsmall);
+  EvalArith2Sw(NumOrRat, t, u, small, nonsmall);
 
  small:
   CBOOL__LASTTEST(t<=u);
 
  nonsmall:
   if (IsFloat(t) || IsFloat(u)) {
-    CBOOL__LASTTEST(TaggedToFloat(t)<=TaggedToFloat(u));
+    CBOOL__LASTTEST(NumOrRatToFloat(t)<=NumOrRatToFloat(u));
+  } else if (IsRat(t) || IsRat(u)) {
+    CBOOL__LASTTEST(CFUN__EVAL(rat_compare_GC,t,u)<=0);
   } else if (TaggedIsSmall(t)) {
     CBOOL__LASTTEST(bn_positive(TaggedToBignum(u)));
   } else if (TaggedIsSmall(u)) {
@@ -490,14 +913,16 @@ CBOOL__PROTO(bu2_numle, tagged_t x0, tagged_t x1) {
 CBOOL__PROTO(bu2_numgt, tagged_t x0, tagged_t x1) {
   ERR__FUNCTOR("arithmetic:>", 2);
   tagged_t t=x0,u=x1;
-  EvalArith2Sw(Number, t, u, small, nonsmall);
+  EvalArith2Sw(NumOrRat, t, u, small, nonsmall);
 
  small:
   CBOOL__LASTTEST(t>u);
 
  nonsmall:
   if (IsFloat(t) || IsFloat(u)) {
-    CBOOL__LASTTEST(TaggedToFloat(t)>TaggedToFloat(u));
+    CBOOL__LASTTEST(NumOrRatToFloat(t)>NumOrRatToFloat(u));
+  } else if (IsRat(t) || IsRat(u)) {
+    CBOOL__LASTTEST(CFUN__EVAL(rat_compare_GC,t,u)>0);
   } else if (TaggedIsSmall(t)) {
     CBOOL__LASTTEST(!bn_positive(TaggedToBignum(u)));
   } else if (TaggedIsSmall(u)) {
@@ -510,14 +935,16 @@ CBOOL__PROTO(bu2_numgt, tagged_t x0, tagged_t x1) {
 CBOOL__PROTO(bu2_numge, tagged_t x0, tagged_t x1) {
   ERR__FUNCTOR("arithmetic:>=", 2);
   tagged_t t=x0,u=x1;
-  EvalArith2Sw(Number, t, u, small, nonsmall);
+  EvalArith2Sw(NumOrRat, t, u, small, nonsmall);
 
  small:
   CBOOL__LASTTEST(t>=u);
 
  nonsmall:
   if (IsFloat(t) || IsFloat(u)) {
-    CBOOL__LASTTEST(TaggedToFloat(t)>=TaggedToFloat(u));
+    CBOOL__LASTTEST(NumOrRatToFloat(t)>=NumOrRatToFloat(u));
+  } else if (IsRat(t) || IsRat(u)) {
+    CBOOL__LASTTEST(CFUN__EVAL(rat_compare_GC,t,u)>=0);
   } else if (TaggedIsSmall(t)) {
     CBOOL__LASTTEST(!bn_positive(TaggedToBignum(u)));
   } else if (TaggedIsSmall(u)) {
@@ -540,6 +967,8 @@ CBOOL__PROTO(bu2_numge, tagged_t x0, tagged_t x1) {
  LabNonsmall: \
   if (IsFloat(U)) { \
     CFUN__LASTCALL(flt64_to_blob_GC, -TaggedToFloat(U)); \
+  } else if (IsRat(U)) { \
+    CFUN__LASTCALL(rat_neg_GC, U); \
   } else { \
     goto big_; \
   } \
@@ -563,21 +992,21 @@ end_: {} \
 CFUN__PROTO(fu1_minus, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$-", 2);
   tagged_t t=x0;
-  EvalArith1Sw(Number, t, small, nonsmall);
+  EvalArith1Sw(NumOrRat, t, small, nonsmall);
   CFUN__LASTCALL_NumberNegate(small, nonsmall, t);
 }
 
 CFUN__PROTO(fu1_plus, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$+", 2);
   tagged_t t=x0;
-  EvalArith1(Number, t);
+  EvalArith1(NumOrRat, t);
   CFUN__PROCEED(t);
 }
 
 CFUN__PROTO(fu1_integer, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$integer", 2);
   tagged_t t=x0;
-  EvalArith1Sw(Number, t, small, nonsmall);
+  EvalArith1Sw(NumOrRat, t, small, nonsmall);
 
  small:
   CFUN__PROCEED(t);
@@ -587,6 +1016,8 @@ CFUN__PROTO(fu1_integer, tagged_t, tagged_t x0) {
     flt64_t f;
     GetFiniteFloat(f, t, 1);
     CFUN__LASTCALL(bn_from_float_GC, f);
+  } else if (IsRat(t)) {
+    CFUN__LASTCALL(rat_round_GC, t, RAT_TRUNCATE);
   } else {
     CFUN__PROCEED(t);
   }
@@ -595,11 +1026,11 @@ CFUN__PROTO(fu1_integer, tagged_t, tagged_t x0) {
 CFUN__PROTO(fu1_float, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$float", 2);
   tagged_t t=x0;
-  EvalArith1(Number, t);
+  EvalArith1(NumOrRat, t);
   if (IsFloat(t)) {
     CFUN__PROCEED(t);
   } else {
-    CFUN__LASTCALL(flt64_to_blob_GC, TaggedToFloat(t));
+    CFUN__LASTCALL(flt64_to_blob_GC, NumOrRatToFloat(t));
   }
 }
 
@@ -608,7 +1039,7 @@ CFUN__PROTO(fu1_float, tagged_t, tagged_t x0) {
 CFUN__PROTO(fu1_add1, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$++", 2);
   tagged_t t=x0;
-  EvalArith1Sw(Number, t, small, nonsmall);
+  EvalArith1Sw(NumOrRat, t, small, nonsmall);
 
  small:
   if (t==TaggedIntMax) goto big;//CFUN__LASTCALL(SmiVal1ToTagged_GC, SmiValMaxPlus1);
@@ -620,6 +1051,8 @@ CFUN__PROTO(fu1_add1, tagged_t, tagged_t x0) {
  nonsmall:
   if (IsFloat(t)) {
     CFUN__LASTCALL(flt64_to_blob_GC, TaggedToFloat(t) + 1.0);
+  } else if (IsRat(t)) {
+    CFUN__LASTCALL(rat_add_GC, t, MakeSmall(1), FALSE);
   } else {
     goto big;
   }
@@ -628,7 +1061,7 @@ CFUN__PROTO(fu1_add1, tagged_t, tagged_t x0) {
 CFUN__PROTO(fu1_sub1, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$--", 2);
   tagged_t t=x0;
-  EvalArith1Sw(Number, t, small, nonsmall);
+  EvalArith1Sw(NumOrRat, t, small, nonsmall);
 
  small:
   if (t==TaggedLow) goto big;//CFUN__LASTCALL(SmiVal1ToTagged_GC, SmiValMinMinus1);
@@ -640,6 +1073,8 @@ CFUN__PROTO(fu1_sub1, tagged_t, tagged_t x0) {
  nonsmall:
   if (IsFloat(t)) {
     CFUN__LASTCALL(flt64_to_blob_GC, TaggedToFloat(t) - 1.0);
+  } else if (IsRat(t)) {
+    CFUN__LASTCALL(rat_add_GC, t, MakeSmall(1), TRUE);
   } else {
     goto big;
   }
@@ -671,7 +1106,7 @@ CFUN__PROTO(fu1_sub1, tagged_t, tagged_t x0) {
 CFUN__PROTO(fu2_plus, tagged_t, tagged_t x0, tagged_t x1) {
   ERR__FUNCTOR("arithmetic:$+", 3);
   tagged_t t=x0,u=x1;
-  EvalArith2Sw(Number, t, u, small, nonsmall);
+  EvalArith2Sw(NumOrRat, t, u, small, nonsmall);
 
  small:
   {
@@ -685,7 +1120,9 @@ CFUN__PROTO(fu2_plus, tagged_t, tagged_t x0, tagged_t x1) {
 
  nonsmall:
   if (IsFloat(t) || IsFloat(u)) {
-    CFUN__LASTCALL(flt64_to_blob_GC, TaggedToFloat(t) + TaggedToFloat(u));
+    CFUN__LASTCALL(flt64_to_blob_GC, NumOrRatToFloat(t) + NumOrRatToFloat(u));
+  } else if (IsRat(t) || IsRat(u)) {
+    CFUN__LASTCALL(rat_add_GC, t, u, FALSE);
   } else {
     goto big;
   }
@@ -717,7 +1154,7 @@ CFUN__PROTO(fu2_plus, tagged_t, tagged_t x0, tagged_t x1) {
 CFUN__PROTO(fu2_minus, tagged_t, tagged_t x0, tagged_t x1) {
   ERR__FUNCTOR("arithmetic:$-", 3);
   tagged_t t=x0,u=x1;
-  EvalArith2Sw(Number, t, u, small, nonsmall);
+  EvalArith2Sw(NumOrRat, t, u, small, nonsmall);
 
  small:
   {
@@ -731,7 +1168,9 @@ CFUN__PROTO(fu2_minus, tagged_t, tagged_t x0, tagged_t x1) {
 
  nonsmall:
   if (IsFloat(t) || IsFloat(u)) {
-    CFUN__LASTCALL(flt64_to_blob_GC, TaggedToFloat(t) - TaggedToFloat(u));
+    CFUN__LASTCALL(flt64_to_blob_GC, NumOrRatToFloat(t) - NumOrRatToFloat(u));
+  } else if (IsRat(t) || IsRat(u)) {
+    CFUN__LASTCALL(rat_add_GC, t, u, TRUE);
   } else {
     goto big;
   }
@@ -761,7 +1200,7 @@ CFUN__PROTO(fu2_minus, tagged_t, tagged_t x0, tagged_t x1) {
 CFUN__PROTO(fu2_times, tagged_t, tagged_t x0, tagged_t x1) {
   ERR__FUNCTOR("arithmetic:$*", 3);
   tagged_t t=x0,u=x1;
-  EvalArith2Sw(Number, t, u, small, nonsmall);
+  EvalArith2Sw(NumOrRat, t, u, small, nonsmall);
 
  small:
   {
@@ -775,7 +1214,9 @@ CFUN__PROTO(fu2_times, tagged_t, tagged_t x0, tagged_t x1) {
 
  nonsmall:
   if (IsFloat(t) || IsFloat(u)) {
-    CFUN__LASTCALL(flt64_to_blob_GC, TaggedToFloat(t) * TaggedToFloat(u));
+    CFUN__LASTCALL(flt64_to_blob_GC, NumOrRatToFloat(t) * NumOrRatToFloat(u));
+  } else if (IsRat(t) || IsRat(u)) {
+    CFUN__LASTCALL(rat_mul_GC, t, u, FALSE);
   } else {
     goto big;
   }
@@ -867,6 +1308,8 @@ CFUN__PROTO(fu2_mod, tagged_t, tagged_t x0, tagged_t x1) {
   } else { \
     if (IsFloat(U)) { \
       if (TaggedToFloat(U) < 0.0) goto NegNonsmall; \
+    } else if (IsRat(U)) { \
+      if (RatSign(U) < 0) goto NegNonsmall; \
     } else { \
       if (!bn_positive(TaggedToBignum(U))) goto NegNonsmall; \
     } \
@@ -885,7 +1328,7 @@ CFUN__PROTO(fu2_mod, tagged_t, tagged_t x0, tagged_t x1) {
 CFUN__PROTO(fu1_sign, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$sign", 2);
   tagged_t t=x0;
-  EvalArith1Sw(Number, t, small, nonsmall);
+  EvalArith1Sw(NumOrRat, t, small, nonsmall);
 
  small:
   if (t==TaggedZero) {
@@ -906,6 +1349,8 @@ CFUN__PROTO(fu1_sign, tagged_t, tagged_t x0) {
     } else {
       CFUN__LASTCALL(flt64_to_blob_GC, 1.0);
     }
+  } else if (IsRat(t)) {
+    CFUN__PROCEED(MakeSmall(RatSign(t)));
   } else {
     if (!bn_positive(TaggedToBignum(t))) {
       CFUN__PROCEED(SmallSub(TaggedZero,1));
@@ -929,7 +1374,7 @@ end_: {} \
 CFUN__PROTO(fu1_abs, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$abs", 2);
   tagged_t t=x0;
-  EvalArith1(Number, t);
+  EvalArith1(NumOrRat, t);
 
   BranchNumberIsNeg(t, neg_small, neg_nonsmall);
   CFUN__PROCEED(t);
@@ -1175,7 +1620,7 @@ CFUN__PROTO(fu1_fractpart, tagged_t, tagged_t x0) {
 CFUN__PROTO(fu1_floor, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$floor", 2);
   tagged_t t=x0;
-  EvalArith1Sw(Number, t, small, nonsmall);
+  EvalArith1Sw(NumOrRat, t, small, nonsmall);
 
  small:
   CFUN__PROCEED(t);
@@ -1185,6 +1630,8 @@ CFUN__PROTO(fu1_floor, tagged_t, tagged_t x0) {
     flt64_t f;
     GetFiniteFloat(f, t, 1);
     CFUN__LASTCALL(bn_from_float_GC, floor(f));
+  } else if (IsRat(t)) {
+    CFUN__LASTCALL(rat_round_GC, t, RAT_FLOOR);
   } else {
     CFUN__PROCEED(t);
   }
@@ -1193,7 +1640,7 @@ CFUN__PROTO(fu1_floor, tagged_t, tagged_t x0) {
 CFUN__PROTO(fu1_round, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$round", 2);
   tagged_t t=x0;
-  EvalArith1Sw(Number, t, small, nonsmall);
+  EvalArith1Sw(NumOrRat, t, small, nonsmall);
 
  small:
   CFUN__PROCEED(t);
@@ -1203,6 +1650,8 @@ CFUN__PROTO(fu1_round, tagged_t, tagged_t x0) {
     flt64_t f;
     GetFiniteFloat(f, t, 1);
     CFUN__LASTCALL(bn_from_float_GC, round(f));
+  } else if (IsRat(t)) {
+    CFUN__LASTCALL(rat_round_GC, t, RAT_ROUND);
   } else {
     CFUN__PROCEED(t);
   }
@@ -1211,7 +1660,7 @@ CFUN__PROTO(fu1_round, tagged_t, tagged_t x0) {
 CFUN__PROTO(fu1_ceil, tagged_t, tagged_t x0) {
   ERR__FUNCTOR("arithmetic:$ceiling", 2);
   tagged_t t=x0;
-  EvalArith1Sw(Number, t, small, nonsmall);
+  EvalArith1Sw(NumOrRat, t, small, nonsmall);
 
  small:
   CFUN__PROCEED(t);
@@ -1221,6 +1670,8 @@ CFUN__PROTO(fu1_ceil, tagged_t, tagged_t x0) {
     flt64_t f;
     GetFiniteFloat(f, t, 1);
     CFUN__LASTCALL(bn_from_float_GC, ceil(f));
+  } else if (IsRat(t)) {
+    CFUN__LASTCALL(rat_round_GC, t, RAT_CEILING);
   } else {
     CFUN__PROCEED(t);
   }
@@ -1275,6 +1726,54 @@ CFUN__PROTO(fu1_atan, tagged_t, tagged_t x0) {
   CFUN__LASTCALL(flt64_to_blob_GC, atan(TaggedToFloat(t)));
 }
 
+/* --------------------------------------------------------------------------- */
+/* Rational numbers */
+
+CFUN__PROTO(fu2_rdiv, tagged_t, tagged_t x0, tagged_t x1) {
+  ERR__FUNCTOR("arithmetic:$rdiv", 3);
+  tagged_t t=x0,u=x1;
+  EvalArith2(NumOrRat, t, u);
+  if (IsFloat(t)) {
+    flt64_t f;
+    GetFiniteFloat(f, t, 1);
+    PROT_GC(t = CFUN__EVAL(rat_from_float_GC, f), u);
+  }
+  if (IsFloat(u)) {
+    flt64_t f;
+    GetFiniteFloat(f, u, 2);
+    PROT_GC(u = CFUN__EVAL(rat_from_float_GC, f), t);
+  }
+  if (u == TaggedZero) BUILTIN_ERROR(ERR_evaluation_error(zero_divisor), u, 2);
+  if (TaggedIsSmall(t) && TaggedIsSmall(u)) {
+    CFUN__LASTCALL(rat_make_small_GC, GetSmall(t), GetSmall(u));
+  }
+  CFUN__LASTCALL(rat_mul_GC, t, u, TRUE);
+}
+
+CFUN__PROTO(fu1_rational, tagged_t, tagged_t x0) {
+  ERR__FUNCTOR("arithmetic:$rational", 2);
+  tagged_t t=x0;
+  EvalArith1(NumOrRat, t);
+  if (IsFloat(t)) {
+    flt64_t f;
+    GetFiniteFloat(f, t, 1);
+    CFUN__LASTCALL(rat_from_float_GC, f);
+  }
+  CFUN__PROCEED(t);
+}
+
+CFUN__PROTO(fu1_rationalize, tagged_t, tagged_t x0) {
+  ERR__FUNCTOR("arithmetic:$rationalize", 2);
+  tagged_t t=x0;
+  EvalArith1(NumOrRat, t);
+  if (IsFloat(t)) {
+    flt64_t f;
+    GetFiniteFloat(f, t, 1);
+    CFUN__LASTCALL(rat_rationalize_GC, f);
+  }
+  CFUN__PROCEED(t);
+}
+
 /* --------------------------------------------------------------------------- */
 /* TODO:[JF] New arithmetic functions, integrated into is/2 ! */
 
@@ -1329,3 +1828,275 @@ CBOOL__PROTO(prolog_getbit) {
  ok: CBOOL__LASTUNIFY(X(2), MakeSmall(r));
  zero: CBOOL__LASTUNIFY(X(2), MakeSmall(0));
 }
+
+/* --------------------------------------------------------------------------- */
+/* Sparse linear forms (for library(clpqr)) */
+
+/* A linear form is a list of V*K terms, ordered by decreasing V (in
+   the standard order of terms) and with non-zero coefficients K.
+
+   With Eps=0 the coefficients are exact (integers or rationals) and
+   K1+K2 is zero when it is 0. Otherwise K1+K2 is zero when
+   abs(K1+K2) =< Eps*(abs(K1)+abs(K2)) and K is one when
+   abs(1-K) =< Eps*(abs(K)+1) (as in clpr). */
+
+CFUN__PROTO(fu2_compare, tagged_t, tagged_t x1, tagged_t x2);
+
+/* GC roots (X registers after the arguments) */
+#define LinHead X(6) /* result list */
+#define LinLast X(7) /* last cell of the result (or atom_nil) */
+#define LinK1 X(8)
+#define LinK2 X(9)
+#define LIN_ARITY 10
+
+/* (list cell and V*K structure) */
+#define LIN_CELL_SIZE (5*sizeof(tagged_t))
+
+static inline bool_t lin_is_zero(tagged_t k, tagged_t k1, tagged_t k2, flt64_t eps) {
+  if (eps == 0) {
+    return k == TaggedZero || (IsFloat(k) && TaggedToFloat(k) == 0.0);
+  } else {
+    flt64_t f1 = NumOrRatToFloat(k1);
+    flt64_t f2 = NumOrRatToFloat(k2);
+    return fabs(f1+f2) <= eps*(fabs(f1)+fabs(f2));
+  }
+}
+
+static inline bool_t lin_is_one(tagged_t k, flt64_t eps) {
+  if (eps == 0) {
+    return k == MakeSmall(1) || (IsFloat(k) && TaggedToFloat(k) == 1.0);
+  } else {
+    flt64_t f = NumOrRatToFloat(k);
+    return fabs(1-f) <= eps*(fabs(f)+1);
+  }
+}
+
+/* Standard order of U and V (usually variables) */
+static inline CFUN__PROTO(lin_compare, intmach_t, tagged_t u, tagged_t v) {
+  tagged_t r;
+  if (IsVar(u) && IsVar(v)) {
+    CFUN__PROCEED(u<v ? -1 : u>v ? 1 : 0);
+  }
+  r = CFUN__EVAL(fu2_compare, u, v);
+  CFUN__PROCEED(r == atom_lessthan ? -1 : r == atom_greaterthan ? 1 : 0);
+}
+
+/* Append E to the result (the heap must have room for a list cell) */
+static inline CVOID__PROTO(lin_emit, tagged_t e) {
+  tagged_t *h = G->heap_top;
+  tagged_t cell = Tagp(LST, h);
+  HeapPush(h, e);
+  HeapPush(h, atom_nil);
+  G->heap_top = h;
+  if (LinLast == atom_nil) {
+    LinHead = cell;
+  } else {
+    *TaggedToCdr(LinLast) = cell;
+  }
+  LinLast = cell;
+}
+
+/* Append V*K to the result (the heap must have room for
+   LIN_CELL_SIZE) */
+static inline CVOID__PROTO(lin_emit_factor, tagged_t v, tagged_t k) {
+  tagged_t *h = G->heap_top;
+  HeapPush(h, functor_times);
+  HeapPush(h, v);
+  HeapPush(h, k);
+  G->heap_top = h;
+  CVOID__CALL(lin_emit, Tagp(STR, h-3));
+}
+
+/* The V*K term at the head of the list L (fails if L is not a linear
+   form) */
+#define LinFactor(L, E, V) ({ \
+  if (!TaggedIsLST(L)) CBOOL__FAIL; \
+  DerefCar(E, L); \
+  if (!TaggedIsSTR(E) || TaggedToHeadfunctor(E) != functor_times) CBOOL__FAIL; \
+  DerefArg(V, E, 1); \
+})
+
+/* '$linear_add'(+A, +Ka, +B, +Kb, +Eps, -R): R is Ka*A+Kb*B, where A,
+   B, and R are linear forms. The tail of R is shared with A (or B)
+   when the rest of B (or A) is empty and Ka (or Kb) is one. */
+CBOOL__PROTO(prolog_linear_add) {
+  ERR__FUNCTOR("arithmetic:$linear_add", 6);
+  liveinfo_t liveinfo;
+  tagged_t a, b, ea, eb, va, vb, k;
+  flt64_t eps;
+  intmach_t c;
+
+  LIVEINFO__INIT(liveinfo, CONTPAD, LIN_ARITY);
+  w->liveinfo = liveinfo;
+  DEREF(X(1), X(1));
+  DEREF(X(3), X(3));
+  DEREF(X(4), X(4));
+  if (X(4) == TaggedZero) {
+    eps = 0;
+  } else if (IsNumber(X(4))) {
+    eps = TaggedToFloat(X(4));
+  } else {
+    ERROR_IN_ARG(X(4), 5, ERR_type_error(number));
+  }
+  LinHead = atom_nil;
+  LinLast = atom_nil;
+  LinK1 = TaggedZero;
+  LinK2 = TaggedZero;
+
+  /* Merge (C locals are reloaded from the roots after each operation
+     that may move the heap) */
+  for (;;) {
+    DEREF(a, X(0));
+    DEREF(b, X(2));
+    if (a == atom_nil) {
+      X(0) = b;
+      X(1) = X(3);
+      break;
+    }
+    if (b == atom_nil) break;
+    LinFactor(a, ea, va);
+    LinFactor(b, eb, vb);
+    c = CFUN__EVAL(lin_compare, vb, va);
+    if (c == 0) {
+      DerefArg(LinK1, ea, 2);
+      DerefArg(LinK2, eb, 2);
+      if (X(1) != MakeSmall(1)) LinK1 = CFUN__EVAL(fu2_times, X(1), LinK1);
+      if (X(3) != MakeSmall(1)) LinK2 = CFUN__EVAL(fu2_times, X(3), LinK2);
+      k = CFUN__EVAL(fu2_plus, LinK1, LinK2);
+      if (!lin_is_zero(k, LinK1, LinK2, eps)) {
+        LinK1 = k;
+        HeapMargin_GC(LIN_CELL_SIZE);
+        DEREF(a, X(0));
+        LinFactor(a, ea, va);
+        CVOID__CALL(lin_emit_factor, va, LinK1);
+      }
+      DEREF(a, X(0));
+      DerefCdr(X(0), a);
+      DEREF(b, X(2));
+      DerefCdr(X(2), b);
+    } else if (c < 0) {
+      if (X(1) == MakeSmall(1)) {
+        HeapMargin_GC(LIN_CELL_SIZE);
+        DEREF(a, X(0));
+        DerefCar(ea, a);
+        CVOID__CALL(lin_emit, ea);
+      } else {
+        DerefArg(LinK1, ea, 2);
+        LinK1 = CFUN__EVAL(fu2_times, X(1), LinK1);
+        HeapMargin_GC(LIN_CELL_SIZE);
+        DEREF(a, X(0));
+        LinFactor(a, ea, va);
+        CVOID__CALL(lin_emit_factor, va, LinK1);
+      }
+      DEREF(a, X(0));
+      DerefCdr(X(0), a);
+    } else {
+      if (X(3) == MakeSmall(1)) {
+        HeapMargin_GC(LIN_CELL_SIZE);
+        DEREF(b, X(2));
+        DerefCar(eb, b);
+        CVOID__CALL(lin_emit, eb);
+      } else {
+        DerefArg(LinK2, eb, 2);
+        LinK2 = CFUN__EVAL(fu2_times, X(3), LinK2);
+        HeapMargin_GC(LIN_CELL_SIZE);
+        DEREF(b, X(2));
+        LinFactor(b, eb, vb);
+        CVOID__CALL(lin_emit_factor, vb, LinK2);
+      }
+      DEREF(b, X(2));
+      DerefCdr(X(2), b);
+    }
+  }
+
+  /* The rest X(0) times X(1) */
+  DEREF(a, X(0));
+  if (a != atom_nil && !lin_is_one(X(1), eps)) {
+    do {
+      LinFactor(a, ea, va);
+      DerefArg(LinK1, ea, 2);
+      LinK1 = CFUN__EVAL(fu2_times, X(1), LinK1);
+      HeapMargin_GC(LIN_CELL_SIZE);
+      DEREF(a, X(0));
+      LinFactor(a, ea, va);
+      CVOID__CALL(lin_emit_factor, va, LinK1);
+      DEREF(a, X(0));
+      DerefCdr(X(0), a);
+      a = X(0);
+    } while (a != atom_nil);
+  } else if (LinLast == atom_nil) {
+    LinHead = a;
+  } else {
+    *TaggedToCdr(LinLast) = a;
+  }
+  CBOOL__LASTUNIFY(LinHead, X(5));
+}
+
+/* The linear form H of a dependent variable D (in clpqr, D has the
+   attribute eqn_var(_,_,Lin,_,_) and Lin has the attribute I+H), or
+   ERRORTAG if D is not a dependent variable */
+static inline tagged_t lin_row_form(tagged_t d) {
+  tagged_t t;
+  DEREF(d, d);
+  if (!TaggedIsCVA(d)) return ERRORTAG;
+  DEREF(t, *TaggedToGoal(d));
+  if (!TaggedIsSTR(t) || Arity(TaggedToHeadfunctor(t)) != 5) return ERRORTAG;
+  DerefArg(t, t, 3);
+  if (!TaggedIsCVA(t)) return ERRORTAG;
+  DEREF(t, *TaggedToGoal(t));
+  if (!TaggedIsSTR(t) || TaggedToHeadfunctor(t) != functor_plus) return ERRORTAG;
+  DerefArg(t, t, 2);
+  return t;
+}
+
+/* V occurs in the linear form L */
+static inline CFUN__PROTO(lin_occurs, bool_t, tagged_t l, tagged_t v) {
+  tagged_t e, u;
+  intmach_t c;
+  while (TaggedIsLST(l)) {
+    DerefCar(e, l);
+    if (!TaggedIsSTR(e) || TaggedToHeadfunctor(e) != functor_times) break;
+    DerefArg(u, e, 1);
+    c = CFUN__EVAL(lin_compare, u, v);
+    if (c == 0) CFUN__PROCEED(TRUE);
+    if (c < 0) break; /* (ordered by decreasing variables) */
+    DerefCdr(l, l);
+  }
+  CFUN__PROCEED(FALSE);
+}
+
+/* '$linear_rows'(+De, +V, -Rows): Rows are the dependent variables in
+   the (open) list De whose linear form contains V, in the same order
+   (as an open list). This avoids visiting the rows of the tableau
+   that are not affected by a pivot on V. */
+CBOOL__PROTO(prolog_linear_rows) {
+  tagged_t l, d, v, *h, *tail;
+  intmach_t n;
+
+  n = 0;
+  DEREF(l, X(0));
+  while (TaggedIsLST(l)) {
+    DerefCar(d, l);
+    DEREF(v, X(1));
+    if (CFUN__EVAL(lin_occurs, lin_row_form(d), v)) n++;
+    DerefCdr(l, l);
+  }
+  if (n == 0) CBOOL__PROCEED; /* (Rows is an empty open list) */
+  TEST_HEAP_OVERFLOW(G->heap_top, (2*n+1)*sizeof(tagged_t)+CONTPAD, 3);
+  h = G->heap_top;
+  tail = NULL;
+  DEREF(l, X(0));
+  while (TaggedIsLST(l)) {
+    DerefCar(d, l);
+    DEREF(v, X(1));
+    if (CFUN__EVAL(lin_occurs, lin_row_form(d), v)) {
+      if (tail != NULL) *tail = Tagp(LST, h);
+      HeapPush(h, d);
+      tail = h;
+      HeapPush(h, Tagp(HVA, h));
+    }
+    DerefCdr(l, l);
+  }
+  G->heap_top = h;
+  CBOOL__LASTUNIFY(X(2), Tagp(LST, h-2*n));
+}
@@ -223,6 +223,12 @@ X=\=Y :- X=\=Y. % (compiled inline, hook for interpreter)
 :- '$props'('$cos'/2, [impnat=cfun(fu1_cos,yes)]). % (ISO) 
 :- export('$atan'/2).
 :- '$props'('$atan'/2, [impnat=cfun(fu1_atan,yes)]). % (ISO) 
+:- export('$rdiv'/3).
+:- '$props'('$rdiv'/3, [impnat=cfun(fu2_rdiv,yes)]).
+:- export('$rational'/2).
+:- '$props'('$rational'/2, [impnat=cfun(fu1_rational,yes)]).
+:- export('$rationalize'/2).
+:- '$props'('$rationalize'/2, [impnat=cfun(fu1_rationalize,yes)]).
 
 % TODO: write in Prolog, obtain c funtion name using pred props
 :- export('$eval_arith'/2). % TODO: NOT A EXPORT BUT A INTERNAL ENTRY
@@ -262,6 +268,10 @@ X=\=Y :- X=\=Y. % (compiled inline, hook for interpreter)
     ;'sin'/1->fu1_sin
     ;'cos'/1->fu1_cos
     ;'atan'/1->fu1_atan
+    ;'rdiv'/2->fu2_rdiv
+    ;'rat'/2->fu2_rdiv
+    ;'rational'/1->fu1_rational
+    ;'rationalize'/1->fu1_rationalize
     ))]).
 :- endif.
 
@@ -367,8 +377,30 @@ X=\=Y :- X=\=Y. % (compiled inline, hook for interpreter)
    @item @pred{gcd/2}: Greatest common divisor.  Arguments must evaluate
    to integers, result always integer.
 
+   @item @pred{rdiv/2}: exact division. Float arguments are converted
+   exactly to rationals, result always a rational (or an integer).
+
+   @item @pred{rational/1}: conversion to a rational, the result is
+   exactly equal to the argument.
+
+   @item @pred{rationalize/1}: conversion to a rational, the result is
+   the simplest rational that converts back to the same float.
+
    @end{itemize}
 
+   @cindex{rational numbers} Rational numbers are represented as
+   @tt{rat(N,D)} terms where @var{N} and @var{D} are integers, @tt{D >
+   1} and @var{N} and @var{D} are coprime (i.e., rationals that are
+   integers are always represented as integers). These terms evaluate
+   to themselves, while other @tt{rat(N,D)} terms evaluate as @tt{N
+   rdiv D}. Sign reversal, addition, subtraction, multiplication,
+   @pred{abs/1}, @pred{sign/1} and arithmetic comparison are exact on
+   rationals and integers, @pred{truncate/1}, @pred{integer/1},
+   @pred{floor/1}, @pred{round/1} and @pred{ceiling/1} round rationals
+   to integers, and other evaluable functors convert rationals to
+   floats (e.g., @tt{1 rdiv 3 / 2} evaluates to a float). Integer
+   evaluable functors raise a type error on rationals.
+
    In addition to these functors, a list of just a number evaluates to
    this number.  Since a @concept{quoted string} is just a list of
    integers, this allows a quoted character to be used in place of its
@@ -417,6 +449,10 @@ arithexpression(sqrt(X)) :- arithexpression(X).
 arithexpression(sin(X)) :- arithexpression(X).
 arithexpression(cos(X)) :- arithexpression(X).
 arithexpression(atan(X)) :- arithexpression(X).
+arithexpression(rdiv(X,Y)) :- arithexpression(X), arithexpression(Y).
+arithexpression(rational(X)) :- arithexpression(X).
+arithexpression(rationalize(X)) :- arithexpression(X).
+arithexpression(rat(X,Y)) :- arithexpression(X), arithexpression(Y).
 %arithexpression(gcd(X,Y)) :- arithexpression(X), arithexpression(Y).
 arithexpression([X]) :- arithexpression(X).
 arithexpression(X) :- intexpression(X).
@@ -487,6 +523,9 @@ intexpression([X]) :- intexpression(X).
 '$internal_error_where_term'('arithmetic:$sin', 2, _, 'arithmetic:is'/2-2).
 '$internal_error_where_term'('arithmetic:$cos', 2, _, 'arithmetic:is'/2-2).
 '$internal_error_where_term'('arithmetic:$atan', 2, _, 'arithmetic:is'/2-2).
+'$internal_error_where_term'('arithmetic:$rdiv', 3, _, 'arithmetic:is'/2-2).
+'$internal_error_where_term'('arithmetic:$rational', 2, _, 'arithmetic:is'/2-2).
+'$internal_error_where_term'('arithmetic:$rationalize', 2, _, 'arithmetic:is'/2-2).
 
 % ---------------------------------------------------------------------------
 % TODO:[JF] New arithmetic functions, integrated into is/2 !
@@ -524,3 +563,25 @@ intexpression([X]) :- intexpression(X).
 :- impl_defined('$getbit'/3).
 :- endif.
 
+
+% ---------------------------------------------------------------------------
+% Sparse linear forms (for library(clpqr))
+
+% '$linear_add'(A, Ka, B, Kb, Eps, R): R is Ka*A+Kb*B, where A, B, and
+% R are lists of V*K terms ordered by decreasing V (see arithmetic.c
+% for the meaning of Eps)
+:- export('$linear_add'/6).
+:- if(defined(optim_comp)).
+:- '$props'('$linear_add'/6, [impnat=cbool(prolog_linear_add)]).
+:- else.
+:- impl_defined('$linear_add'/6).
+:- endif.
+
+% '$linear_rows'(De, V, Rows): Rows are the dependent variables in De
+% whose linear form contains V (see arithmetic.c)
+:- export('$linear_rows'/3).
+:- if(defined(optim_comp)).
+:- '$props'('$linear_rows'/3, [impnat=cbool(prolog_linear_rows)]).
+:- else.
+:- impl_defined('$linear_rows'/3).
+:- endif.
@@ -71,6 +71,7 @@ CVOID__PROTO(wr_call, char *s, definition_t *func);
   AssignNodeFunctor(Y); \
   PRED_TRACE(X,Y); \
   PRED_PROFILE(X,Y); \
+  PRED_CALLSTATS(Y); \
 }
 
 #if defined(DEBUG_TRACE)
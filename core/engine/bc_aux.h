@@ -184,6 +184,11 @@ static try_node_t *get_null_alt(int arity)
                                + 2*sizeof(intmach_t)
 #endif
                                );
+  MEMCAT_INC(MEMCAT_CODE, sizeof(try_node_t) + sizeof(try_node_t *)
+#if defined(GAUGE)
+             + 2*sizeof(intmach_t)
+#endif
+             );
 
   INC_MEM_PROG(total_mem_count - current_mem);
 
@@ -462,6 +467,7 @@ CVOID__PROTO(finish_profilecc);
 #endif
 
 void init_profile(void) {
+  init_callstats();
 #if defined(ABSMACH_OPT__profilecc)
   init_profilecc();
 #endif
@@ -1051,6 +1057,7 @@ CFUN__PROTO(compile_term_aux, instance_t *,
                         bsize,
                         object);
   INC_MEM_PROG(object->objsize);
+  MEMCAT_INC(MEMCAT_DYNAMIC, object->objsize);
   current_insn = (bcp_t)object->emulcode;
   object->pending_x2 = NULL;
   object->pending_x5 = NULL;
@@ -1102,6 +1109,7 @@ CFUN__PROTO(compile_term_aux, instance_t *,
   truesize = SIZEOF_FLEXIBLE_STRUCT(instance_t, char, (char *)current_insn - (char *)object->emulcode);
   if (truesize > object->objsize) {
     DEC_MEM_PROG(object->objsize);
+    MEMCAT_DEC(MEMCAT_DYNAMIC, object->objsize);
     checkdealloc_FLEXIBLE_S(instance_t, objsize, object);
     SERIOUS_FAULT("bug: memory overrun in assert or record");
   }
@@ -1110,6 +1118,7 @@ CFUN__PROTO(compile_term_aux, instance_t *,
     /* findall record---make it fast */
   } else {
     INC_MEM_PROG(truesize - object->objsize);
+    MEMCAT_INC(MEMCAT_DYNAMIC, truesize - object->objsize);
     //fprintf(stderr, "resize %x-%x\n", object->objsize, truesize);
     object=(instance_t *)checkrealloc((char *)object, object->objsize, truesize);
     object->objsize = truesize;
@@ -1141,6 +1150,7 @@ CFUN__PROTO(compile_term_aux, instance_t *,
 
  sizebomb:
   DEC_MEM_PROG(object->objsize);
+  MEMCAT_DEC(MEMCAT_DYNAMIC, object->objsize);
   checkdealloc_FLEXIBLE_S(instance_t, objsize, object);
   SERIOUS_FAULT("term too large in assert or record");
 }
@@ -1292,9 +1302,9 @@ CBOOL__PROTO(nd_yield) {
 /*------------------------------------------------------------*/
 
 static CBOOL__PROTO(cunify_args_aux,
-                    int arity, tagged_t *pt1, tagged_t *pt2,
+                    argstk_t *s, intmach_t arity, tagged_t *pt1, tagged_t *pt2,
                     tagged_t *x1, tagged_t *x2);
-static CBOOL__PROTO(cunify_aux, tagged_t x1, tagged_t x2);
+static CBOOL__PROTO(cunify_aux, argstk_t *s, tagged_t x1, tagged_t x2);
 
 /* Unify the argument lists of two compund terms.
  * pt1 - first argument list.
@@ -1303,12 +1313,19 @@ static CBOOL__PROTO(cunify_aux, tagged_t x1, tagged_t x2);
  */
 CBOOL__PROTO(cunify_args, int arity, tagged_t *pt1, tagged_t *pt2) {
   tagged_t x1, x2;
-  bool_t result = (cunify_args_aux(Arg,arity,pt1,pt2,&x1,&x2) && cunify_aux(Arg,x1,x2));
+  argstk_t s;
+  bool_t result;
+  ARGSTK__INIT(s);
+  result = (cunify_args_aux(Arg,&s,arity,pt1,pt2,&x1,&x2) && cunify_aux(Arg,&s,x1,x2));
+  ARGSTK__FREE(s);
   VALUETRAIL__UNDO();
   return result;
 }
 
-static CBOOL__PROTO(cunify_args_aux, int arity, tagged_t *pt1, tagged_t *pt2, tagged_t *x1, tagged_t *x2) {
+/* Find the next pair of arguments to unify (x1 and x2). If it is not
+   the last one, the rest of the block is pushed on the argument
+   stack. */
+static CBOOL__PROTO(cunify_args_aux, argstk_t *s, intmach_t arity, tagged_t *pt1, tagged_t *pt2, tagged_t *x1, tagged_t *x2) {
   tagged_t t1 = ~0;
   tagged_t t2 = ~0;
 
@@ -1317,6 +1334,13 @@ static CBOOL__PROTO(cunify_args_aux, int arity, tagged_t *pt1, tagged_t *pt2, ta
      values. */
 
   VALUETRAIL__TEST_OVERFLOW(2*CHOICEPAD);
+  /* Skip identical words (the whole block if it is bitwise identical) */
+  if (arity <= 0 || pt1 == pt2) goto identical;
+  for (; *pt1 == *pt2; --arity) {
+    if (arity == 1) goto identical;
+    (void)HeapNext(pt1);
+    (void)HeapNext(pt2);
+  }
   for (; arity>0; --arity) {
     t1 = *pt1, t2 = *pt2;
     if (t1 != t2) {
@@ -1331,8 +1355,11 @@ static CBOOL__PROTO(cunify_args_aux, int arity, tagged_t *pt1, tagged_t *pt2, ta
           VALUETRAIL__SET(pt2, t1);
         }
       noforward:
-        if (arity>1 && !cunify_aux(Arg,t1,t2))
-          return FALSE;
+        if (arity>1) {
+          /* unify this pair first, resume the rest later */
+          ARGSTK__PUSH(*s, pt1+1, pt2+1, arity-1);
+          break;
+        }
       } else if (t1 != t2)
         return FALSE;
     }
@@ -1345,6 +1372,10 @@ static CBOOL__PROTO(cunify_args_aux, int arity, tagged_t *pt1, tagged_t *pt2, ta
 
   VALUETRAIL__TEST_OVERFLOW(CHOICEPAD);
   return TRUE;
+ identical:
+  *x1 = atom_nil;
+  *x2 = atom_nil;
+  return TRUE;
 }
 
 /* Unify two terms.
@@ -1352,16 +1383,22 @@ static CBOOL__PROTO(cunify_args_aux, int arity, tagged_t *pt1, tagged_t *pt2, ta
  * x2 - second term
  */
 
-/* NOTE: This is a recursive version of Robinson's 1965 unification
-   algorithm without occurs check */
+/* NOTE: This is a version of Robinson's 1965 unification algorithm
+   without occurs check. It is iterative: argument blocks of complex
+   terms that are pending are kept in an explicit (growable) argument
+   stack, so that deep terms do not exhaust the C stack. */
 
 CBOOL__PROTO(cunify, tagged_t x1, tagged_t x2) {
-  bool_t result = cunify_aux(Arg,x1,x2);
+  argstk_t s;
+  bool_t result;
+  ARGSTK__INIT(s);
+  result = cunify_aux(Arg,&s,x1,x2);
+  ARGSTK__FREE(s);
   VALUETRAIL__UNDO();
   return result;
 }
 
-static CBOOL__PROTO(cunify_aux, tagged_t x1, tagged_t x2)
+static CBOOL__PROTO(cunify_aux, argstk_t *s, tagged_t x1, tagged_t x2)
 {
   tagged_t u, v;
 
@@ -1390,7 +1427,7 @@ static CBOOL__PROTO(cunify_aux, tagged_t x1, tagged_t x2)
     goto lose;
   else if (!(u & TagBitFunctor)) /* list? */
     {
-      if (cunify_args_aux(Arg,2,TaggedToCar(u),TaggedToCar(v),&x1,&x2))
+      if (cunify_args_aux(Arg,s,2,TaggedToCar(u),TaggedToCar(v),&x1,&x2))
         goto in;
       else
         goto lose;
@@ -1408,7 +1445,7 @@ static CBOOL__PROTO(cunify_aux, tagged_t x1, tagged_t x2)
             if (*TaggedToArg(u,i) != *TaggedToArg(v,i)) goto lose;
           goto win;
         }
-      if (cunify_args_aux(Arg,Arity(t1),TaggedToArg(u,1),TaggedToArg(v,1),&x1,&x2))
+      if (cunify_args_aux(Arg,s,Arity(t1),TaggedToArg(u,1),TaggedToArg(v,1),&x1,&x2))
         goto in;
       else
         goto lose;
@@ -1466,6 +1503,15 @@ static CBOOL__PROTO(cunify_aux, tagged_t x1, tagged_t x2)
   BindSVA(u,v);
 
  win:
+  if (!ARGSTK__EMPTY(*s)) {
+    tagged_t *pt1, *pt2;
+    intmach_t arity;
+    ARGSTK__POP(*s, pt1, pt2, arity);
+    if (cunify_args_aux(Arg,s,arity,pt1,pt2,&x1,&x2))
+      goto in;
+    else
+      goto lose;
+  }
   return TRUE;
 
  lose:
@@ -43,13 +43,14 @@
 #include <ciao/eng_bignum.h>
 #include <ciao/eng_gc.h>
 #include <ciao/basiccontrol.h>
+#include <ciao/eng_numvec.h>
 #endif
 
 void ciao_exit(int result);
 
 /* ------------------------------------------------------------------------- */
 
-ciao_ctx ciao_implicit_ctx;
+__thread ciao_ctx ciao_implicit_ctx;
 
 /* ------------------------------------------------------------------------- */
 
@@ -908,6 +909,72 @@ TEMPLATE(ciao_mk_c_int_list, int, IntmachToTagged((intmach_t)(*s)), 4)
 TEMPLATE(ciao_mk_c_double_list, double, BoxFloat(*s), 8)
 #undef TEMPLATE
 
+/* ------------------------------------------------------------------------- */
+/* Packed numeric vectors (see eng_numvec.h) */
+
+/* Vectors are passed to C as a pointer to their data in the heap (no
+   copy), which can be read or filled in place. The pointer is only
+   valid until the control returns to Prolog (the vector may be moved
+   by GC). */
+
+static int ciao_numvec(ciao_ctx ctx, ciao_term term, intmach_t *len, void **data) {
+  tagged_t t = ciao_unref(ctx, term);
+  DEREF(t, t);
+  return numvec_decomp(t, len, data);
+}
+
+size_t ciao_numvec_length(ciao_ctx ctx, ciao_term term) {
+  intmach_t len;
+  void *data;
+  if (ciao_numvec(ctx, term, &len, &data) < 0) return 0;
+  return len;
+}
+
+#define TEMPLATE(Name, X, Type) \
+ciao_bool Name(ciao_ctx ctx, ciao_term term) { \
+  intmach_t len; \
+  void *data; \
+  return ciao_numvec(ctx, term, &len, &data) == (Type); \
+}
+TEMPLATE(ciao_is_c_int8_vec, int8_t, NUMVEC_INT8)
+TEMPLATE(ciao_is_c_int16_vec, int16_t, NUMVEC_INT16)
+TEMPLATE(ciao_is_c_int32_vec, int32_t, NUMVEC_INT32)
+TEMPLATE(ciao_is_c_int64_vec, int64_t, NUMVEC_INT64)
+TEMPLATE(ciao_is_c_double_vec, double, NUMVEC_FLOAT64)
+#undef TEMPLATE
+
+#define TEMPLATE(Name, X, Type) \
+X *Name(ciao_ctx ctx, ciao_term term) { \
+  intmach_t len; \
+  void *data; \
+  if (ciao_numvec(ctx, term, &len, &data) != (Type)) return NULL; \
+  return (X *)data; \
+}
+TEMPLATE(ciao_get_c_int8_vec, int8_t, NUMVEC_INT8)
+TEMPLATE(ciao_get_c_int16_vec, int16_t, NUMVEC_INT16)
+TEMPLATE(ciao_get_c_int32_vec, int32_t, NUMVEC_INT32)
+TEMPLATE(ciao_get_c_int64_vec, int64_t, NUMVEC_INT64)
+TEMPLATE(ciao_get_c_double_vec, double, NUMVEC_FLOAT64)
+#undef TEMPLATE
+
+#define TEMPLATE(Name, X, Type) \
+ciao_term Name(ciao_ctx ctx, X *s, size_t length) { \
+  tagged_t t; \
+  void *data; \
+  WITH_WORKER(ctx->worker_registers, { \
+    ciao_ensure_heap(ctx, NUMVEC_CELLS((Type), length)); \
+    t = CFUN__EVAL(numvec_make, (Type), length, &data); \
+    memcpy(data, s, length * sizeof(X)); \
+  }); \
+  return ciao_ref(ctx, t); \
+}
+TEMPLATE(ciao_mk_c_int8_vec, int8_t, NUMVEC_INT8)
+TEMPLATE(ciao_mk_c_int16_vec, int16_t, NUMVEC_INT16)
+TEMPLATE(ciao_mk_c_int32_vec, int32_t, NUMVEC_INT32)
+TEMPLATE(ciao_mk_c_int64_vec, int64_t, NUMVEC_INT64)
+TEMPLATE(ciao_mk_c_double_vec, double, NUMVEC_FLOAT64)
+#undef TEMPLATE
+
 /* ------------------------------------------------------------------------- */
 
 char *ciao_list_to_str(ciao_ctx ctx, ciao_term list) {
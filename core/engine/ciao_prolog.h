@@ -30,7 +30,8 @@ typedef struct goal_descriptor *ciao_ctx;
 typedef goal_descriptor_t *ciao_ctx;
 #endif
 
-extern ciao_ctx ciao_implicit_ctx;
+/* (per thread, set on each call to foreign code) */
+extern __thread ciao_ctx ciao_implicit_ctx;
 
 typedef unsigned long ciao_choice;
 typedef unsigned long ciao_term;
@@ -160,6 +161,25 @@ ciao_term ciao_mk_c_uint8_list(ciao_ctx ctx, const unsigned char *s, size_t leng
 ciao_term ciao_mk_c_int_list(ciao_ctx ctx, int *s, size_t length);
 ciao_term ciao_mk_c_double_list(ciao_ctx ctx, double *s, size_t length);
 
+/* Packed numeric vectors (data is accessed in place) */
+
+size_t ciao_numvec_length(ciao_ctx ctx, ciao_term term);
+ciao_bool ciao_is_c_int8_vec(ciao_ctx ctx, ciao_term term);
+ciao_bool ciao_is_c_int16_vec(ciao_ctx ctx, ciao_term term);
+ciao_bool ciao_is_c_int32_vec(ciao_ctx ctx, ciao_term term);
+ciao_bool ciao_is_c_int64_vec(ciao_ctx ctx, ciao_term term);
+ciao_bool ciao_is_c_double_vec(ciao_ctx ctx, ciao_term term);
+int8_t *ciao_get_c_int8_vec(ciao_ctx ctx, ciao_term term);
+int16_t *ciao_get_c_int16_vec(ciao_ctx ctx, ciao_term term);
+int32_t *ciao_get_c_int32_vec(ciao_ctx ctx, ciao_term term);
+int64_t *ciao_get_c_int64_vec(ciao_ctx ctx, ciao_term term);
+double *ciao_get_c_double_vec(ciao_ctx ctx, ciao_term term);
+ciao_term ciao_mk_c_int8_vec(ciao_ctx ctx, int8_t *s, size_t length);
+ciao_term ciao_mk_c_int16_vec(ciao_ctx ctx, int16_t *s, size_t length);
+ciao_term ciao_mk_c_int32_vec(ciao_ctx ctx, int32_t *s, size_t length);
+ciao_term ciao_mk_c_int64_vec(ciao_ctx ctx, int64_t *s, size_t length);
+ciao_term ciao_mk_c_double_vec(ciao_ctx ctx, double *s, size_t length);
+
 /* Helper functions for term creation */
 
 ciao_term ciao_list_s(ciao_ctx ctx, ciao_term head, ciao_term tail);
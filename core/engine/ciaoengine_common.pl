@@ -15,6 +15,10 @@
 :- '$native_include_c_header'('ciao_gluecode.h').
 :- '$native_include_c_header'('os_threads.h').
 :- '$native_include_c_header'('eng_profile.h').
+:- '$native_include_c_header'('eng_evtrace.h').
+:- '$native_include_c_header'('eng_lockstat.h').
+:- '$native_include_c_header'('eng_heapsnap.h').
+:- '$native_include_c_header'('eng_numvec.h').
 :- '$native_include_c_header'('tabling.h').
 :- '$native_include_c_header'('basiccontrol.h').
 
@@ -95,6 +99,10 @@
 :- '$native_include_c_source'('eng_debug.c').
 
 :- '$native_include_c_source'('eng_profile.c').
+:- '$native_include_c_source'('eng_evtrace.c').
+:- '$native_include_c_source'('eng_lockstat.c').
+:- '$native_include_c_source'('eng_heapsnap.c').
+:- '$native_include_c_source'('eng_numvec.c').
 
 :- '$native_include_c_source'('eng_interrupt.c').
 
@@ -13,6 +13,7 @@
 #include <ciao/eng_start.h>
 #include <ciao/eng_registry.h>
 #include <ciao/stream_basic.h>
+#include <ciao/eng_lockstat.h>
 #endif
 
 #include <unistd.h>
@@ -117,7 +118,7 @@ CBOOL__PROTO(prolog_lock_atom) {
 
   if (TaggedIsATM(term)) { /* Atom -- lock */
     atomptr = TaggedToAtom(term);
-    Wait_Acquire_lock(atomptr->atom_lock_l);
+    Wait_Acquire_lock_stat(atomptr->atom_lock_l, LOCKSTAT_ATOM);
     Wait_Acquire_slock(atomptr->counter_lock);
     atomptr->atom_lock_counter--;
     if (atomptr->atom_lock_counter > 0)
@@ -189,7 +190,7 @@ CBOOL__PROTO(prolog_lock_atom_bin) {
 
   if (TaggedIsATM(term)) {                                    /* Atom -- lock */
     atomptr = TaggedToAtom(term);
-    Wait_Acquire_lock(atomptr->atom_lock_l);
+    Wait_Acquire_lock_stat(atomptr->atom_lock_l, LOCKSTAT_ATOM);
   } else {
     BUILTIN_ERROR(ERR_type_error(atom),X(0),1);
   }
@@ -630,6 +631,7 @@ CVOID__PROTO(print_task_status);
 
 CBOOL__PROTO(prolog_eng_status) {
   CVOID__CALL(print_task_status);
+  CVOID__CALL(print_lockstat);
   CBOOL__PROCEED;
 }
 
@@ -14,6 +14,8 @@
 #include <ciao/internals.h>
 #include <ciao/eng_start.h>
 #include <ciao/basiccontrol.h>
+#include <ciao/eng_evtrace.h>
+#include <ciao/eng_lockstat.h>
 #include <unistd.h>
 #include <stddef.h> /* ptrdiff_t */
 #endif
@@ -104,8 +106,10 @@ static void link_handle(instance_handle_t *handle,
 #if defined(OPTIM_COMP)
 void predicate_def__interpreted(definition_t *f, bool_t concurrent) {
   int_info_t *d = checkalloc_TYPE(int_info_t);
+  MEMCAT_INC(MEMCAT_DYNAMIC, sizeof(int_info_t));
 
   Init_Cond(d->clause_insertion_cond);
+  d->clause_insertion_holder = (THREAD_ID)0;
 
   /*  MCL added on 26 Nov 98 */
   d->x2_pending_on_instance = NULL;
@@ -134,8 +138,10 @@ void predicate_def__interpreted(definition_t *f, bool_t concurrent) {
 #else
 void init_interpreted(definition_t *f) {
   int_info_t *d = checkalloc_TYPE(int_info_t);
+  MEMCAT_INC(MEMCAT_DYNAMIC, sizeof(int_info_t));
 
   Init_Cond(d->clause_insertion_cond);
+  d->clause_insertion_holder = (THREAD_ID)0;
 
   /* By default, make it DYNAMIC.  
      set_property() may change this behavior later. MCL. */
@@ -394,7 +400,7 @@ static CFUN__PROTO(current_instance_noconc, instance_t *)
   int_info_t *root = TaggedToRoot(X(2));
 #endif
 
-  Wait_Acquire_Cond_lock(root->clause_insertion_cond);
+  Cond_Begin_root_stat(root);
   CURRENT_INSTANCE(X(0), root, ACTIVE_INSTANCE, { /* fail */
     Release_Cond_lock(root->clause_insertion_cond);
 #if defined(OPTIM_COMP)
@@ -483,7 +489,7 @@ CBOOL__PROTO(first_instance) {
   if (root->behavior_on_failure == DYNAMIC) {
     inst = ACTIVE_INSTANCE(root->first,use_clock,TRUE);
   } else {
-    Cond_Begin(root->clause_insertion_cond);
+    Cond_Begin_root_stat(root);
     inst = root->first;
     Broadcast_Cond(root->clause_insertion_cond);
   }
@@ -511,7 +517,7 @@ CBOOL__PROTO(next_instance, instance_t **ipp)
   int_info_t *root = TaggedToRoot(X(6));
 #endif
 
-  Wait_Acquire_Cond_lock(root->clause_insertion_cond);
+  Cond_Begin_root_stat(root);
 
   if (x2_insp == x5_insp) {
 #if defined(OPTIM_COMP)
@@ -667,7 +673,7 @@ CBOOL__PROTO(close_predicate)
 #if !defined(OPTIM_COMP)
   int_info_t *root = TaggedToRoot(X(0));
 #endif
-  Cond_Begin(root->clause_insertion_cond);
+  Cond_Begin_root_stat(root);
   if (root->behavior_on_failure == CONC_OPEN) 
     root->behavior_on_failure = CONC_CLOSED;
   Broadcast_Cond(root->clause_insertion_cond);
@@ -686,7 +692,7 @@ CBOOL__PROTO(open_predicate)
 #if !defined(OPTIM_COMP)
   int_info_t *root = TaggedToRoot(X(0));
 #endif
-  Cond_Begin(root->clause_insertion_cond);
+  Cond_Begin_root_stat(root);
   if (root->behavior_on_failure == CONC_CLOSED) 
     root->behavior_on_failure = CONC_OPEN;
   Broadcast_Cond(root->clause_insertion_cond);
@@ -872,12 +878,19 @@ static bool_t wait_for_an_instance_pointer(instance_t **inst_pptr1,
     /* Wait until a change is signaled, and test that the change affects us */
 
     if (block == BLOCK) {
+      inttime_t t0 = (lockstat_enabled ? walltick() : 0);
+      EVTRACE(EVT_CONC_WAIT, EVT_PH_BEGIN, 0);
       Wait_For_Cond_Begin(((*inst_pptr1 == NULL) &&
                            (*inst_pptr2 == NULL) &&
                            root->behavior_on_failure == CONC_OPEN),
                           root->clause_insertion_cond);
+      EVTRACE(EVT_CONC_WAIT, EVT_PH_END, 0);
+      if (lockstat_enabled) {
+        root->clause_insertion_holder = Thread_Id;
+        lockstat__waited(LOCKSTAT_CONC_WAIT, t0);
+      }
     } else { /* In any case, leave the predicate locked */
-      Cond_Begin(root->clause_insertion_cond);
+      Cond_Begin_root_stat(root);
     }
           
     /* Test again to find out which was the case */
@@ -1224,6 +1237,7 @@ void expunge_instance(instance_t *i) {
 #if defined(OPTIM_COMP)
   CHECKDEALLOC0_TAILED(instance_t, i);
 #else
+  MEMCAT_DEC(MEMCAT_DYNAMIC, i->objsize);
   checkdealloc_FLEXIBLE_S(instance_t, objsize, i);
 #endif
 }
@@ -1242,7 +1256,7 @@ void remove_link_chains(choice_t **topdynamic, choice_t *chpttoclear) {
   while (ChoiceYounger(movingtop, chpttoclear)) {
     DEBUG__TRACEconc(debug_conc, "removing handle at (dynamic) node %p\n", movingtop);
 
-    Cond_Begin(TaggedToRoot(movingtop->x[RootArg])->clause_insertion_cond);
+    Cond_Begin_root_stat(TaggedToRoot(movingtop->x[RootArg]));
 
     RTCHECK_concwarn(TaggedToInstHandle(movingtop->x[X2_CHN]) == NULL, "X2 handle is NULL!\n");
     RTCHECK_concwarn(TaggedToInstHandle(movingtop->x[X5_CHN]) == NULL, "X5 handle is NULL!\n");
@@ -1279,14 +1293,14 @@ CVOID__PROTO(erase_interpreted, definition_t *f) {
            predicates) are erased, so we better put a lock on those
            predicates.  MCL.
         */
-        Cond_Begin(f->code.intinfo->clause_insertion_cond);
+        Cond_Begin_root_stat(f->code.intinfo);
         expunge_instance(i);
         Broadcast_Cond(f->code.intinfo->clause_insertion_cond);
       }
     }
   }
 
-  Cond_Begin(f->code.intinfo->clause_insertion_cond);
+  Cond_Begin_root_stat(f->code.intinfo);
   (void)ACTIVE_INSTANCE(f->code.intinfo->first,use_clock,TRUE);
   Broadcast_Cond(f->code.intinfo->clause_insertion_cond);
 }
@@ -1332,7 +1346,7 @@ CBOOL__PROTO(prolog_purge) {
   DEREF(X(0),X(0));
   inst = TaggedToInstance(X(0));
 
-  Cond_Begin(inst->root->clause_insertion_cond);
+  Cond_Begin_root_stat(inst->root);
   expunge_instance(inst);
   Broadcast_Cond(inst->root->clause_insertion_cond);
 
@@ -1548,7 +1562,7 @@ CBOOL__PROTO(inserta)
   bool_t move_insts_to_new_clause = FALSE;
 #endif
 
-  Cond_Begin(root->clause_insertion_cond);
+  Cond_Begin_root_stat(root);
 
   DEBUG__TRACEconc(debug_conc, "(root = %p, first = %p, &first = %p)\n", root, root->first, &(root->first));
 
@@ -1644,7 +1658,7 @@ CBOOL__PROTO(insertz)
 #endif
   intmach_t current_mem = total_mem_count;
 
-  Cond_Begin(root->clause_insertion_cond);
+  Cond_Begin_root_stat(root);
 
   DEBUG__TRACEconc(debug_conc, "(root = %p, first = %p, &first = %p)\n", root, root->first, &(root->first));
 
@@ -546,6 +546,61 @@ tagged_t deffunctor(char *pname, int arity); /* eng_registry.c */
 #define ChoiceFromChoiceTop(BT) ((choice_t *)(((char *)(BT))-w->value_trail*sizeof(tagged_t)))
 #define ChoiceTopFromChoice(B) ((tagged_t *)(((char *)(B))+w->value_trail*sizeof(tagged_t)))
 
+/* ------------------------------------------------------------------------- */
+/* Argument stack */
+
+/* note: pending argument blocks for the iterative term traversals
+   (unify, compare, occurs check); a fixed-size block on the C stack
+   is used first and it grows on the C heap for deeper terms */
+
+typedef struct argblk_ argblk_t;
+struct argblk_ {
+  tagged_t *pt1;
+  tagged_t *pt2;
+  intmach_t arity;
+};
+
+#define ARGSTK_INITIAL 32
+
+typedef struct argstk_ argstk_t;
+struct argstk_ {
+  argblk_t *base;
+  intmach_t top;
+  intmach_t size;
+  argblk_t initial[ARGSTK_INITIAL];
+};
+
+void argstk__grow(argstk_t *s);
+
+#define ARGSTK__INIT(S) do { \
+  (S).base = (S).initial; \
+  (S).top = 0; \
+  (S).size = ARGSTK_INITIAL; \
+} while(0)
+
+#define ARGSTK__EMPTY(S) ((S).top == 0)
+
+/* push the (non-empty) block of ARITY arguments at PT1 and PT2 */
+#define ARGSTK__PUSH(S, PT1, PT2, ARITY) do { \
+  argblk_t *b_; \
+  if ((S).top == (S).size) argstk__grow(&(S)); \
+  b_ = &(S).base[(S).top++]; \
+  b_->pt1 = (PT1); \
+  b_->pt2 = (PT2); \
+  b_->arity = (ARITY); \
+} while(0)
+
+#define ARGSTK__POP(S, PT1, PT2, ARITY) do { \
+  argblk_t *b_ = &(S).base[--(S).top]; \
+  (PT1) = b_->pt1; \
+  (PT2) = b_->pt2; \
+  (ARITY) = b_->arity; \
+} while(0)
+
+#define ARGSTK__FREE(S) do { \
+  if ((S).base != (S).initial) checkdealloc_ARRAY(argblk_t, (S).size, (S).base); \
+} while(0)
+
 /* ------------------------------------------------------------------------- */
 /* Events (WakeCount and interrupts) based on heap limit checks */
 
@@ -883,6 +938,9 @@ struct debugger_state_ {
 #define GLOBAL_VARS_ROOT (w->misc->global_vars_root)
 #endif
 
+typedef struct callstats_ callstats_t; /* defined in eng_profile.c */
+typedef struct gvar_ gvar_t; /* defined in internals.c */
+
 typedef struct misc_info_ misc_info_t;
 struct misc_info_ {
 
@@ -910,6 +968,14 @@ struct misc_info_ {
 #if defined(USE_GLOBAL_VARS)
   tagged_t global_vars_root;
 #endif
+  /* Keys of global variables (module -> key -> gvar_t); NULL until used */
+  hashtab_t *gvars;
+  intmach_t gvars_count;
+  /* Sampling counters (key -> intmach_t *); NULL until used */
+  hashtab_t *samples;
+
+  /* Per-worker call statistics (see eng_profile.c); NULL until used */
+  callstats_t *callstats;
 
   /* For dynamic_neck_proceed */
   instance_t *ins; /* clause/2, instance/2 */
@@ -1546,6 +1612,7 @@ struct int_info_ {
   /*  SLOCK clause_insertion_cond;            */
   condition_t clause_insertion_cond;
 #endif
+  volatile THREAD_ID clause_insertion_holder; /* (only with lock statistics) */
 
   instance_handle_t *x2_pending_on_instance;     /* Used when pred. is empty */
   instance_handle_t *x5_pending_on_instance;
@@ -1633,6 +1700,7 @@ struct try_node_ {
 };
 
 #define HASHTAB_SIZE(X) (((X)->mask / sizeof(hashtab_node_t))+1) 
+#define HASHTAB_CHARSIZE(SIZE) SIZEOF_FLEXIBLE_STRUCT(hashtab_t, hashtab_node_t, (SIZE))
 #define SizeToMask(X) (((X)-1) * sizeof(hashtab_node_t))
 
 #if !defined(OPTIM_COMP)
@@ -1838,6 +1906,7 @@ extern SLOCK    prolog_modules_l;                         /* Pointer to it */
 /* Wait until new worker Id is generated */
 extern SLOCK    worker_id_pool_l;
 extern SLOCK    atom_id_l;
+extern SLOCK    gvar_ids_l;
 extern SLOCK    wam_list_l;
 
 #if defined(PARBACK)
@@ -1977,6 +2046,9 @@ extern tagged_t functor_Dhandler;
 extern tagged_t functor_Dsetarg;
 extern tagged_t functor_Dsetargstr;
 extern tagged_t functor_large;
+extern tagged_t functor_rat;
+extern tagged_t functor_plus;
+extern tagged_t functor_times;
 extern tagged_t functor_long;
 
 extern tagged_t functor_active;
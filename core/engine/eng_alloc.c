@@ -14,6 +14,7 @@
 #include <unistd.h>
 
 #include <ciao/eng.h>
+#include <ciao/eng_lockstat.h>
 
 #if !defined(USE_OWN_MALLOC)
 #include <stdlib.h>
@@ -144,6 +145,23 @@ intmach_t total_mem_count = 0; /* Shared */
 /* # bytes used by the Prolog program & database code.  Probably not
    accurately measured (patched here and there) (MCL).  */
 intmach_t mem_prog_count = 0; /* Shared */
+/* # bytes requested through tryalloc/tryrealloc and not freed (unlike
+   total_mem_count, this does not include unused tiny blocks) */
+intmach_t mem_live_count = 0; /* Shared */
+
+/* Memory accounting by category (see eng_alloc.h) */
+volatile intmach_t mem_cat_count[MEMCAT_N]; /* Shared */
+const char *mem_cat_name[MEMCAT_N] = {
+  "other",
+  "stacks",
+  "atoms",
+  "predicates",
+  "code",
+  "dynamic",
+  "hashtables",
+  "streams",
+  "tabling"
+};
 
 #define USE_TINY_BLOCKS 1
 #if defined(USE_TINY_BLOCKS)
@@ -192,7 +210,7 @@ static char *get_tiny_blocks(void) {
 
 char *tryalloc(intmach_t size) {
   char *p;
-  Wait_Acquire_slock(mem_mng_l);
+  Wait_Acquire_slock_stat(mem_mng_l, LOCKSTAT_MEM_MNG);
 
 #if defined(USE_TINY_BLOCKS)
   if (size<=THRESHHOLD) {
@@ -223,6 +241,7 @@ char *tryalloc(intmach_t size) {
 #if defined(USE_TINY_BLOCKS)
   }
 #endif
+  mem_live_count += size;
   DEBUG__TRACE_ALLOC(p, size);
   Release_slock(mem_mng_l);
   return p;
@@ -233,7 +252,7 @@ char *checkalloc(intmach_t size) {
 }
 
 void checkdealloc(char *ptr, intmach_t decr) {
-  Wait_Acquire_slock(mem_mng_l);
+  Wait_Acquire_slock_stat(mem_mng_l, LOCKSTAT_MEM_MNG);
 
 #if defined(USE_TINY_BLOCKS)
   if (decr<=THRESHHOLD) {
@@ -246,13 +265,14 @@ void checkdealloc(char *ptr, intmach_t decr) {
 #if defined(USE_TINY_BLOCKS)
   }
 #endif
+  mem_live_count -= decr;
   DEBUG__TRACE_FREE(ptr, decr);
   Release_slock(mem_mng_l);
 }
 
 char *tryrealloc(char *ptr, intmach_t decr, intmach_t size) {
   char *p;
-  Wait_Acquire_slock(mem_mng_l);
+  Wait_Acquire_slock_stat(mem_mng_l, LOCKSTAT_MEM_MNG);
 
 #if defined(USE_TINY_BLOCKS)
   if (decr<=THRESHHOLD) {
@@ -315,6 +335,7 @@ char *tryrealloc(char *ptr, intmach_t decr, intmach_t size) {
     }
   }
 #endif
+  mem_live_count += (size-decr);
   DEBUG__TRACE_REALLOC(ptr, decr, p, size);
   Release_slock(mem_mng_l);
   return p;
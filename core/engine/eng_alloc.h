@@ -88,10 +88,46 @@ void checkdealloc(char *ptr, intmach_t decr);
   checkdealloc((char *)(Ptr), \
                (ArrayLen) * sizeof(ArrayType))
 
+/* --------------------------------------------------------------------------- */
+/* Memory accounting by category */
+
+/* Bytes allocated (and not freed) for each category. Allocation
+   sites of known structures move their bytes from "other" (the
+   default for any checkalloc) to a category with MEMCAT_INC, and
+   back with MEMCAT_DEC before freeing them. The "other" category is
+   computed as mem_live_count minus the sum of the rest. Keep in sync
+   with mem_cat_name[] in eng_alloc.c. */
+
+#define MEMCAT_OTHER    0 /* not classified */
+#define MEMCAT_STACKS   1 /* worker stacks (heap, frames, choicepoints, trail) */
+#define MEMCAT_ATOMS    2 /* atom names and atom table */
+#define MEMCAT_PREDS    3 /* predicate and module descriptors */
+#define MEMCAT_CODE     4 /* compiled (incore) clauses and indexing */
+#define MEMCAT_DYNAMIC  5 /* dynamic clauses and records */
+#define MEMCAT_HASHTAB  6 /* hash tables (atoms, predicates, indexing) */
+#define MEMCAT_STREAMS  7 /* stream descriptors */
+#define MEMCAT_TABLING  8 /* tabling tables and stacks */
+#define MEMCAT_N        9
+
+extern intmach_t mem_live_count; /* bytes requested and not freed */
+extern volatile intmach_t mem_cat_count[MEMCAT_N];
+extern const char *mem_cat_name[MEMCAT_N];
+
+#define MEMCAT_INC(CAT, SIZE) \
+  __atomic_add_fetch(&mem_cat_count[(CAT)], (intmach_t)(SIZE), __ATOMIC_RELAXED)
+#define MEMCAT_DEC(CAT, SIZE) \
+  __atomic_sub_fetch(&mem_cat_count[(CAT)], (intmach_t)(SIZE), __ATOMIC_RELAXED)
+
 /* Memory management for raw binary buffers (e.g., for stacks) */
 
-#define ALLOC_AREA(I) ((tagged_t *)checkalloc_ARRAY(char, (I)))
-#define REALLOC_AREA(START, OLDCOUNT, NEWCOUNT) ((tagged_t *)checkrealloc_ARRAY(char, (OLDCOUNT), (NEWCOUNT), (char *)(START)))
+#define ALLOC_AREA(I) ({ \
+  MEMCAT_INC(MEMCAT_STACKS, (I)); \
+  (tagged_t *)checkalloc_ARRAY(char, (I)); \
+})
+#define REALLOC_AREA(START, OLDCOUNT, NEWCOUNT) ({ \
+  MEMCAT_INC(MEMCAT_STACKS, (NEWCOUNT)-(OLDCOUNT)); \
+  (tagged_t *)checkrealloc_ARRAY(char, (OLDCOUNT), (NEWCOUNT), (char *)(START)); \
+})
 
 /* --------------------------------------------------------------------------- */
 /* TODO: move somewhere else? */
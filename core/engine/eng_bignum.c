@@ -1126,10 +1126,12 @@ bignum_size_t bn_from_float(flt64_t f, bignum_t *z, bignum_t *zmax) {
   return 0;
 }
 
-flt64_t bn_to_float(bignum_t *bn) {
+/* Value of the digits of bn above digit lo (lo >= 0), i.e.,
+   bn/2^(lo*BIGNUM_BITSIZE) rounded down */
+static inline flt64_t bn_to_float_from(bignum_t *bn, intmach_t lo) {
   intmach_t i = BignumLength(bn);
   flt64_t f = (signed_bignum_t)Bn(bn,i);
-  while (i > 1) {
+  while (i > lo+1) {
     const bignum_t sbit = (bignum_t)1<<(8*sizeof(bignum_t)-1);
 #if LOG2_bignum_size == 5
     const flt64_t norm2 = 4294967296.0; /* 2**32 */
@@ -1150,6 +1152,20 @@ flt64_t bn_to_float(bignum_t *bn) {
   return f;
 }
 
+flt64_t bn_to_float(bignum_t *bn) {
+  return bn_to_float_from(bn, 0);
+}
+
+/* Like bn_to_float(), but only from the most significant digits (at
+   least 64 bits), so that it does not overflow. The value of bn is
+   the result times 2^(*exp). */
+flt64_t bn_to_float_scaled(bignum_t *bn, intmach_t *exp) {
+  intmach_t lo = (intmach_t)BignumLength(bn) - (intmach_t)(128/BIGNUM_BITSIZE);
+  if (lo < 0) lo = 0;
+  *exp = lo*BIGNUM_BITSIZE;
+  return bn_to_float_from(bn, lo);
+}
+
 /* Pre: x is a syntactically correct string denoting an integer */
 bignum_size_t bn_from_string(char *x, bignum_t *z, bignum_t *zmax, int base) {
   bool_t sx;
@@ -147,6 +147,7 @@ bignum_size_t bn_from_float(flt64_t f, bignum_t *z, bignum_t *zmax);
 #if defined(OPTIM_COMP)
 flt64_t bn_to_float(bignum_t *bn);
 #endif
+flt64_t bn_to_float_scaled(bignum_t *bn, intmach_t *exp);
 bignum_size_t bn_from_string(char *x, bignum_t *z, bignum_t *zmax, int base);
 CVOID__PROTO(bn_to_string, bignum_t *x, int base);
 bignum_size_t bn_length(bignum_t *x);
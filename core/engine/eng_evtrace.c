@@ -0,0 +1,199 @@
+/*
+ *  eng_evtrace.c
+ *
+ *  Ring-buffered event tracer (Chrome trace format output).
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ciao/eng.h>
+#include <ciao/timing.h>
+#include <ciao/eng_evtrace.h>
+
+/* Events are appended to a global ring buffer of fixed size records
+   (older events are overwritten). Slots are claimed with an atomic
+   increment so that threads never block on the tracer. The buffer is
+   translated to the Chrome trace event format (JSON, which can also
+   be loaded in Perfetto) only when dumped. */
+
+typedef struct evtrace_rec_ evtrace_rec_t;
+struct evtrace_rec_ {
+  inttime_t ts; /* microsecs (walltick) */
+  intmach_t arg;
+  tagged_t name; /* atom (only for EVT_USER) */
+  uint32_t tid;
+  unsigned char kind;
+  char ph;
+};
+
+/* Rings are published (with their size) through a single pointer.
+   Since other threads may still be writing to a replaced ring, rings
+   are never freed: they are kept in a list and reused when tracing
+   is restarted with the same size (at most one per power of 2). */
+typedef struct evtrace_ring_ evtrace_ring_t;
+struct evtrace_ring_ {
+  evtrace_ring_t *next; /* (list of all rings) */
+  uintmach_t size; /* power of 2 */
+  evtrace_rec_t recs[FLEXIBLE_SIZE];
+};
+
+static const char *evtrace_kind_name[] = {
+  "gc",
+  "heap_shift",
+  "stack_shift",
+  "choice_shift",
+  "goal",
+  "conc_wait",
+  "table_complete",
+  "user"
+};
+
+volatile bool_t evtrace_enabled = FALSE; /* Shared */
+
+static evtrace_ring_t *evtrace_ring = NULL; /* Shared (current ring) */
+static evtrace_ring_t *evtrace_rings = NULL; /* (all rings) */
+static volatile uintmach_t evtrace_next = 0; /* next slot (not wrapped) */
+static volatile uint32_t evtrace_last_tid = 0;
+
+/* Small thread identifiers, assigned on first event */
+static __thread uint32_t evtrace_tid = 0;
+
+void evtrace__emit(int kind, char ph, tagged_t name, intmach_t arg) {
+  evtrace_ring_t *ring;
+  evtrace_rec_t *r;
+  uintmach_t i;
+
+  ring = __atomic_load_n(&evtrace_ring, __ATOMIC_ACQUIRE);
+  if (ring == NULL) return;
+  if (evtrace_tid == 0) {
+    evtrace_tid = __atomic_add_fetch(&evtrace_last_tid, 1, __ATOMIC_RELAXED);
+  }
+  i = __atomic_fetch_add(&evtrace_next, 1, __ATOMIC_RELAXED);
+  r = &ring->recs[i & (ring->size-1)];
+  r->ts = walltick();
+  r->arg = arg;
+  r->name = name;
+  r->tid = evtrace_tid;
+  r->kind = kind;
+  r->ph = ph;
+}
+
+/* '$evtrace_start'(+Size): (re)start tracing with a buffer of at
+   least Size events (previous events are discarded) */
+CBOOL__PROTO(prolog_evtrace_start) {
+  tagged_t x;
+  uintmach_t size;
+  evtrace_ring_t *ring;
+
+  DEREF(x, X(0));
+  if (!TaggedIsSmall(x) || GetSmall(x) <= 0) return FALSE;
+  for (size = 1; size < (uintmach_t)GetSmall(x); size <<= 1) {}
+
+  evtrace_enabled = FALSE;
+  for (ring = evtrace_rings; ring != NULL; ring = ring->next) {
+    if (ring->size == size) break;
+  }
+  if (ring == NULL) {
+    ring = checkalloc_FLEXIBLE(evtrace_ring_t, evtrace_rec_t, size);
+    ring->size = size;
+    ring->next = evtrace_rings;
+    evtrace_rings = ring;
+  }
+  evtrace_next = 0;
+  __atomic_store_n(&evtrace_ring, ring, __ATOMIC_RELEASE);
+  evtrace_enabled = TRUE;
+  CBOOL__PROCEED;
+}
+
+/* '$evtrace_stop' */
+CBOOL__PROTO(prolog_evtrace_stop) {
+  evtrace_enabled = FALSE;
+  CBOOL__PROCEED;
+}
+
+/* '$evtrace_event'(+Ph, +Name, +Arg): user event, Ph is b, e, or i */
+CBOOL__PROTO(prolog_evtrace_event) {
+  tagged_t ph, name, arg;
+  char c;
+
+  if (!evtrace_enabled) CBOOL__PROCEED;
+  DEREF(ph, X(0));
+  DEREF(name, X(1));
+  DEREF(arg, X(2));
+  if (!TaggedIsATM(ph) || !TaggedIsATM(name) || !TaggedIsSmall(arg)) return FALSE;
+  switch (GetString(ph)[0]) {
+  case 'b': c = EVT_PH_BEGIN; break;
+  case 'e': c = EVT_PH_END; break;
+  case 'i': c = EVT_PH_INSTANT; break;
+  default: return FALSE;
+  }
+  evtrace__emit(EVT_USER, c, name, GetSmall(arg));
+  CBOOL__PROCEED;
+}
+
+static void evtrace__write_json_string(FILE *out, const char *s) {
+  fputc('"', out);
+  for (; *s; s++) {
+    unsigned char ch = (unsigned char)*s;
+    if (ch == '"' || ch == '\\') {
+      fputc('\\', out);
+      fputc(ch, out);
+    } else if (ch < 0x20) {
+      fprintf(out, "\\u%04x", ch);
+    } else {
+      fputc(ch, out);
+    }
+  }
+  fputc('"', out);
+}
+
+/* '$evtrace_dump'(+File): write the events in the buffer to File (in
+   Chrome trace format) */
+CBOOL__PROTO(prolog_evtrace_dump) {
+  tagged_t x;
+  FILE *out;
+  evtrace_ring_t *ring;
+  uintmach_t i, start, end;
+  bool_t first = TRUE;
+  int pid = (int)getpid();
+
+  DEREF(x, X(0));
+  if (!TaggedIsATM(x)) return FALSE;
+  out = fopen(GetString(x), "w");
+  if (out == NULL) return FALSE;
+
+  ring = __atomic_load_n(&evtrace_ring, __ATOMIC_ACQUIRE);
+  if (ring == NULL) {
+    start = end = 0;
+  } else {
+    end = evtrace_next;
+    start = (end > ring->size ? end - ring->size : 0);
+  }
+  fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (i = start; i < end; i++) {
+    evtrace_rec_t *r = &ring->recs[i & (ring->size-1)];
+    if (!first) fprintf(out, ",\n");
+    first = FALSE;
+    fprintf(out, "{\"name\":");
+    if (r->kind == EVT_USER && r->name != (tagged_t)0) {
+      evtrace__write_json_string(out, GetString(r->name));
+    } else {
+      evtrace__write_json_string(out, evtrace_kind_name[r->kind]);
+    }
+    fprintf(out, ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIdm ",\"pid\":%d,\"tid\":%u",
+            (r->kind == EVT_USER ? "user" : "engine"),
+            r->ph,
+            (intmach_t)r->ts,
+            pid,
+            (unsigned)r->tid);
+    if (r->ph == EVT_PH_INSTANT) fprintf(out, ",\"s\":\"t\"");
+    fprintf(out, ",\"args\":{\"arg\":%" PRIdm "}}", r->arg);
+  }
+  fprintf(out, "\n]}\n");
+  fclose(out);
+  CBOOL__PROCEED;
+}
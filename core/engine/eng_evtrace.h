@@ -0,0 +1,43 @@
+/*
+ *  eng_evtrace.h
+ *
+ *  Ring-buffered event tracer (Chrome trace format output).
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#ifndef _CIAO_ENG_EVTRACE_H
+#define _CIAO_ENG_EVTRACE_H
+
+/* Event kinds (keep in sync with evtrace_kind_name[] in eng_evtrace.c) */
+#define EVT_GC             0 /* heap garbage collection */
+#define EVT_SHIFT_HEAP     1 /* heap expansion */
+#define EVT_SHIFT_STACK    2 /* (environment) stack expansion */
+#define EVT_SHIFT_CHOICE   3 /* choice/trail expansion */
+#define EVT_GOAL           4 /* goal executed by a thread (eng_call) */
+#define EVT_CONC_WAIT      5 /* wait on a concurrent predicate */
+#define EVT_TABLE_COMPLETE 6 /* completion of a (tabling) generator */
+#define EVT_USER           7 /* user defined (name is an atom) */
+
+/* Event phases (as in the Chrome trace format) */
+#define EVT_PH_BEGIN   'B'
+#define EVT_PH_END     'E'
+#define EVT_PH_INSTANT 'i'
+
+extern volatile bool_t evtrace_enabled;
+
+void evtrace__emit(int kind, char ph, tagged_t name, intmach_t arg);
+
+/* Record an event (a single predicted branch when disabled) */
+#define EVTRACE(KIND, PH, ARG) do { \
+  if (__builtin_expect(evtrace_enabled, 0)) { \
+    evtrace__emit((KIND), (PH), (tagged_t)0, (ARG)); \
+  } \
+} while(0)
+
+CBOOL__PROTO(prolog_evtrace_start);
+CBOOL__PROTO(prolog_evtrace_stop);
+CBOOL__PROTO(prolog_evtrace_event);
+CBOOL__PROTO(prolog_evtrace_dump);
+
+#endif /* _CIAO_ENG_EVTRACE_H */
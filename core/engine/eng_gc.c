@@ -14,6 +14,7 @@
 #include <ciao/timing.h>
 #endif
 #include <ciao/io_basic.h>
+#include <ciao/eng_evtrace.h>
 
 /* TODO: some benchmarks report issues with this, debug */
 //#define PARANOID_GC_DEBUG 1
@@ -514,6 +515,7 @@ CVOID__PROTO(choice_overflow, intmach_t pad, bool_t remove_trail_uncond) {
     tagged_t *newtr;
     intmach_t mincount, newcount, oldcount, trail_reloc_factor, choice_reloc_factor;
     
+    EVTRACE(EVT_SHIFT_CHOICE, EVT_PH_BEGIN, ChoiceCharDifference(Choice_Start,Choice_End));
     {
       mincount = pad - ChoiceCharDifference(choice_top,G->trail_top);
       oldcount = ChoiceCharDifference(Choice_Start,Choice_End);
@@ -577,6 +579,7 @@ CVOID__PROTO(choice_overflow, intmach_t pad, bool_t remove_trail_uncond) {
       AssignRelocPtr(b->trail_top, trail_reloc_factor);
       b = ChoiceCont(b);
     }
+    EVTRACE(EVT_SHIFT_CHOICE, EVT_PH_END, newcount);
   }
 
   if (shallow_try) { /* ShallowTry was on */
@@ -627,6 +630,7 @@ CVOID__PROTO(stack_overflow) {
   UpdateLocalTop(w->choice,G->frame);
 
   count = StackCharSize();
+  EVTRACE(EVT_SHIFT_STACK, EVT_PH_BEGIN, count);
   newh = REALLOC_AREA(Stack_Start, count, 2*count);
   count = 2*StackCharSize();
   DEBUG__TRACE(debug_gc, "Thread %" PRIdm " is reallocing STACK from %p to %p\n", (intmach_t)Thread_Id, Stack_Start, newh);
@@ -639,6 +643,7 @@ CVOID__PROTO(stack_overflow) {
   /* Final adjustments */
   Stack_Start = newh; /* new low bound */
   Stack_End = (tagged_t *)StackCharOffset(newh, count); /* new high bound */
+  EVTRACE(EVT_SHIFT_STACK, EVT_PH_END, count);
 #if defined(USE_GC_STATS)          
   ciao_stats.ss_local++;
   tick0 = RunTickFunc()-tick0;
@@ -786,6 +791,7 @@ CVOID__PROTO(heap_overflow, intmach_t pad) {
     mincount = pad - HeapCharAvailable(G->heap_top);
     oldcount = HeapCharSize();
     newcount = oldcount + (oldcount<mincount ? mincount : oldcount);
+    EVTRACE(EVT_SHIFT_HEAP, EVT_PH_BEGIN, oldcount);
 
     newh = REALLOC_AREA(Heap_Start, oldcount, newcount);
     DEBUG__TRACE(debug_gc, "Thread %" PRIdm " is reallocing HEAP from %p to %p\n", (intmach_t)Thread_Id, Heap_Start, newh);
@@ -805,6 +811,7 @@ CVOID__PROTO(heap_overflow, intmach_t pad) {
 
     Heap_Start = newh; /* new low bound */
     Heap_End = HeapCharOffset(newh, newcount); /* new high bound */
+    EVTRACE(EVT_SHIFT_HEAP, EVT_PH_END, newcount);
 
     UnsetEvent();
     UnsetCIntEvent();
@@ -2070,6 +2077,7 @@ CVOID__PROTO(gc__heap_collect) {
   DEBUG__TRACE(debug_gc, "Thread %" PRIdm " enters gc__heap_collect\n", (intmach_t)Thread_Id);
 
   GetFrameTop(newa, w->choice, G->frame);
+  EVTRACE(EVT_GC, EVT_PH_BEGIN, HeapCharUsed(G->heap_top));
 
 #if defined(USE_GC_STATS)
   intmach_t hz = HeapCharUsed(G->heap_top); /* current heap size */
@@ -2224,6 +2232,7 @@ CVOID__PROTO(gc__heap_collect) {
                  ((flt64_t)ciao_stats.gc_tick)/RunClockFreq(ciao_stats));
   }
 #endif
+  EVTRACE(EVT_GC, EVT_PH_END, HeapCharUsed(G->heap_top));
 }
 
 /* --------------------------------------------------------------------------- */
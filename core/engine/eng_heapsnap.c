@@ -0,0 +1,748 @@
+/*
+ *  eng_heapsnap.c
+ *
+ *  Heap snapshots (heap graph dump) and retained size analysis.
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <ciao/eng.h>
+#include <ciao/eng_gc.h>
+#include <ciao/eng_registry.h>
+#include <ciao/eng_lockstat.h>
+#include <ciao/eng_heapsnap.h>
+
+/* A snapshot is a text file describing the graph of heap objects
+   (structures, list cells, attributed variables, and boxed numbers)
+   reachable from the roots of the current worker:
+
+     ciao-heapsnap 1
+     N <id> <bytes> <label>    heap object (label is Name/Arity)
+     E <id> <id>               reference between heap objects
+     R <id> <kind> <label>     root (kind is frame, choice, trail,
+                               global or debugger; label is the
+                               predicate owning the frame or choice)
+
+   Object ids are cell offsets from the heap start. Unlike the
+   marking phase of gc__heap_collect, the walk does not modify the
+   heap, so it can be done at any point. Unbound variables are not
+   objects (they are part of the object that contains them).
+
+   The analysis computes the dominator tree of the graph (from a
+   virtual root connected to all roots) with the iterative algorithm
+   of Cooper, Harvey, and Kennedy, and the retained size of each
+   object (the bytes that would be freed if it were unreachable). */
+
+/* --------------------------------------------------------------------------- */
+/* Predicate of a code address (for roots) */
+
+typedef struct code_range_ code_range_t;
+struct code_range_ {
+  char *start;
+  char *end;
+  definition_t *pred;
+};
+
+typedef struct heapsnap_ heapsnap_t;
+struct heapsnap_ {
+  FILE *out;
+  /* code ranges of (incore) clauses, sorted */
+  code_range_t *ranges;
+  intmach_t ranges_count;
+  intmach_t ranges_size;
+  /* visited heap cells and frames (one bit per cell) */
+  unsigned char *heap_seen;
+  intmach_t heap_seen_size;
+  unsigned char *stack_seen;
+  intmach_t stack_seen_size;
+  /* pending heap objects (tagged references) */
+  tagged_t *pending;
+  intmach_t pending_count;
+  intmach_t pending_size;
+};
+
+static void heapsnap__add_range(heapsnap_t *s, char *start, char *end, definition_t *pred) {
+  if (s->ranges_count == s->ranges_size) {
+    intmach_t size = s->ranges_size * 2;
+    s->ranges = checkrealloc_ARRAY(code_range_t, s->ranges_size, size, s->ranges);
+    s->ranges_size = size;
+  }
+  s->ranges[s->ranges_count].start = start;
+  s->ranges[s->ranges_count].end = end;
+  s->ranges[s->ranges_count].pred = pred;
+  s->ranges_count++;
+}
+
+static int heapsnap__compare_range(const void *arg1, const void *arg2) {
+  const code_range_t *r1 = (const code_range_t *)arg1;
+  const code_range_t *r2 = (const code_range_t *)arg2;
+  if (r1->start < r2->start) return -1;
+  if (r1->start > r2->start) return 1;
+  return 0;
+}
+
+static void heapsnap__collect_ranges(heapsnap_t *s) {
+  hashtab_t *table;
+  intmach_t j, n;
+
+  s->ranges_size = 1024;
+  s->ranges_count = 0;
+  s->ranges = checkalloc_ARRAY(code_range_t, s->ranges_size);
+
+  Wait_Acquire_slock_stat(prolog_predicates_l, LOCKSTAT_PREDICATES);
+  table = *predicates_location;
+  n = HASHTAB_SIZE(table);
+  for (j = 0; j < n; j++) {
+    definition_t *d = (definition_t *)table->node[j].value.as_ptr;
+    emul_info_t *cl;
+    if (d == NULL || d->predtyp > ENTER_FASTCODE_INDEXED) continue;
+    if (d->code.incoreinfo == NULL) continue;
+    for (cl = d->code.incoreinfo->clauses; cl != NULL; cl = cl->next) {
+      heapsnap__add_range(s, (char *)cl, (char *)cl + cl->objsize, d);
+    }
+  }
+  Release_slock(prolog_predicates_l);
+
+  qsort(s->ranges, s->ranges_count, sizeof(code_range_t), heapsnap__compare_range);
+}
+
+static definition_t *heapsnap__pred_at(heapsnap_t *s, char *p) {
+  intmach_t lo = 0;
+  intmach_t hi = s->ranges_count - 1;
+  while (lo <= hi) {
+    intmach_t mid = (lo + hi) / 2;
+    code_range_t *r = &s->ranges[mid];
+    if (p < r->start) {
+      hi = mid - 1;
+    } else if (p >= r->end) {
+      lo = mid + 1;
+    } else {
+      return r->pred;
+    }
+  }
+  return NULL;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Heap walk */
+
+#define SEEN_TEST(MAP, I) ((MAP)[(I)>>3] & (1<<((I)&7)))
+#define SEEN_SET(MAP, I) ((MAP)[(I)>>3] |= (1<<((I)&7)))
+
+static void heapsnap__write_label(FILE *out, const char *name, intmach_t arity) {
+  for (; *name; name++) {
+    if (*name == '\n') {
+      fputs("\\n", out);
+    } else {
+      fputc(*name, out);
+    }
+  }
+  fprintf(out, "/%" PRIdm, arity);
+}
+
+static void heapsnap__write_pred(FILE *out, definition_t *d) {
+  if (d == NULL) {
+    fputc('-', out);
+  } else {
+    heapsnap__write_label(out, GetString(FuncName(d)), FuncArity(d));
+  }
+}
+
+/* Start of the heap object referenced by (dereferenced) T, or NULL */
+static CFUN__PROTO(heapsnap__object, tagged_t *, tagged_t t) {
+  tagged_t *p;
+  if (TaggedIsLST(t)) {
+    p = TagpPtr(LST, t);
+  } else if (TaggedIsSTR(t)) {
+    p = TagpPtr(STR, t);
+  } else if (TaggedIsCVA(t)) {
+    p = TagpPtr(CVA, t);
+  } else {
+    return NULL;
+  }
+  /* (terms outside the heap, e.g., in tables, are ignored) */
+  if (p < Heap_Start || p >= G->heap_top) return NULL;
+  return p;
+}
+
+/* Dereferenced value of a root or argument cell */
+#define HEAPSNAP_DEREF(T) ({ \
+  tagged_t m_t = (T); \
+  if (IsVar(m_t)) { DEREF(m_t, m_t); } \
+  m_t; \
+})
+
+/* Enqueue the object referenced by T (starting at P) */
+static CVOID__PROTO(heapsnap__push, heapsnap_t *s, tagged_t t, tagged_t *p) {
+  intmach_t i = p - Heap_Start;
+  if (SEEN_TEST(s->heap_seen, i)) return;
+  SEEN_SET(s->heap_seen, i);
+  if (s->pending_count == s->pending_size) {
+    intmach_t size = s->pending_size * 2;
+    s->pending = checkrealloc_ARRAY(tagged_t, s->pending_size, size, s->pending);
+    s->pending_size = size;
+  }
+  s->pending[s->pending_count++] = t;
+}
+
+static CVOID__PROTO(heapsnap__root, heapsnap_t *s, tagged_t t, const char *kind, definition_t *pred) {
+  tagged_t *p;
+  if (!IsHeapPtr(t)) return;
+  t = HEAPSNAP_DEREF(t);
+  p = CFUN__EVAL(heapsnap__object, t);
+  if (p == NULL) return;
+  fprintf(s->out, "R %" PRIdm " %s ", (intmach_t)(p - Heap_Start), kind);
+  heapsnap__write_pred(s->out, pred);
+  fputc('\n', s->out);
+  CVOID__CALL(heapsnap__push, s, t, p);
+}
+
+/* Write the objects reachable from the pending ones */
+static CVOID__PROTO(heapsnap__walk, heapsnap_t *s) {
+  while (s->pending_count > 0) {
+    tagged_t t = s->pending[--s->pending_count];
+    tagged_t *p = CFUN__EVAL(heapsnap__object, t);
+    tagged_t *args;
+    intmach_t id = p - Heap_Start;
+    intmach_t arity, i;
+
+    if (TaggedIsLST(t)) {
+      fprintf(s->out, "N %" PRIdm " %" PRIdm " ./2\n", id, (intmach_t)(2*sizeof(tagged_t)));
+      args = p;
+      arity = 2;
+    } else if (TaggedIsSTR(t)) {
+      tagged_t f = *p;
+      if (FunctorIsBlob(f)) { /* boxed number */
+        intmach_t size = BlobFunctorSizeAligned(f)+2*sizeof(functor_t);
+        fprintf(s->out, "N %" PRIdm " %" PRIdm " %s/0\n", id, size,
+                FunctorIsFloat(f) ? "$float" : "$bignum");
+        continue;
+      }
+      arity = Arity(f);
+      fprintf(s->out, "N %" PRIdm " %" PRIdm " ", id, (intmach_t)((arity+1)*sizeof(tagged_t)));
+      heapsnap__write_label(s->out, GetString(SetArity(f, 0)), arity);
+      fputc('\n', s->out);
+      args = p+1;
+    } else { /* attributed variable */
+      fprintf(s->out, "N %" PRIdm " %" PRIdm " $attv/0\n", id, (intmach_t)(3*sizeof(tagged_t)));
+      args = p+1;
+      arity = 2;
+    }
+
+    for (i = 0; i < arity; i++) {
+      tagged_t u = HEAPSNAP_DEREF(args[i]);
+      tagged_t *q = CFUN__EVAL(heapsnap__object, u);
+      if (q == NULL) continue;
+      fprintf(s->out, "E %" PRIdm " %" PRIdm "\n", id, (intmach_t)(q - Heap_Start));
+      CVOID__CALL(heapsnap__push, s, u, q);
+    }
+  }
+}
+
+/* Roots in the frame chain starting at FRAME (whose size is given by
+   INSN), until a frame that has been already visited */
+static CVOID__PROTO(heapsnap__frames, heapsnap_t *s, frame_t *frame, bcp_t insn) {
+  while (frame != NULL && OffStacktop(frame, Stack_Start)) {
+    intmach_t i = (tagged_t *)frame - (tagged_t *)Stack_Start;
+    intmach_t size;
+    definition_t *pred;
+    tagged_t *ptr;
+    if (SEEN_TEST(s->stack_seen, i)) return;
+    SEEN_SET(s->stack_seen, i);
+    size = FrameSize(insn);
+    pred = heapsnap__pred_at(s, (char *)insn);
+    for (ptr = (tagged_t *)StackCharOffset(frame, size); ptr != frame->x; ) {
+      ptr -= StackDir;
+      CVOID__CALL(heapsnap__root, s, *ptr, "frame", pred);
+    }
+    CVOID__CALL(heapsnap__walk, s);
+    insn = frame->next_insn;
+    frame = frame->frame;
+  }
+}
+
+/* '$heap_snapshot'(+File): write the heap graph of the current worker
+   to File */
+CBOOL__PROTO(prolog_heap_snapshot) {
+  tagged_t x;
+  heapsnap_t s;
+  choice_t *cp;
+  tagged_t *tr;
+#if !defined(OPTIM_COMP) && !defined(USE_DEEP_FLAGS)
+  choice_t *B = w->choice;
+#endif
+
+  DEREF(x, X(0));
+  if (!TaggedIsATM(x)) return FALSE;
+  s.out = fopen(GetString(x), "w");
+  if (s.out == NULL) return FALSE;
+  fprintf(s.out, "ciao-heapsnap 1\n");
+
+  heapsnap__collect_ranges(&s);
+  s.heap_seen_size = ((G->heap_top - Heap_Start) >> 3) + 1;
+  s.heap_seen = checkalloc_ARRAY(unsigned char, s.heap_seen_size);
+  memset(s.heap_seen, 0, s.heap_seen_size);
+  s.stack_seen_size = (((tagged_t *)Stack_End - (tagged_t *)Stack_Start) >> 3) + 1;
+  s.stack_seen = checkalloc_ARRAY(unsigned char, s.stack_seen_size);
+  memset(s.stack_seen, 0, s.stack_seen_size);
+  s.pending_size = 1024;
+  s.pending_count = 0;
+  s.pending = checkalloc_ARRAY(tagged_t, s.pending_size);
+
+  /* Special registers */
+#if defined(USE_GLOBAL_VARS)
+  CVOID__CALL(heapsnap__root, &s, GLOBAL_VARS_ROOT, "global", NULL);
+  CVOID__CALL(heapsnap__walk, &s);
+#endif
+#if !defined(OPTIM_COMP)
+  CVOID__CALL(heapsnap__root, &s, Current_Debugger_State, "debugger", NULL);
+  CVOID__CALL(heapsnap__walk, &s);
+#endif
+
+  /* Active frames */
+  CVOID__CALL(heapsnap__frames, &s, G->frame, G->next_insn);
+
+  /* Choicepoints (arguments of alternatives, and frames preserved
+     for backtracking); the arguments of the newest one are not saved
+     yet in shallow mode */
+  for (cp = w->choice; ChoiceYounger(cp, InitialChoice); cp = ChoiceCont(cp)) {
+    if (cp != w->choice || !IsShallowTry()) {
+      definition_t *pred = NULL;
+      if (cp->next_alt->clause != NULL) {
+        pred = heapsnap__pred_at(&s, (char *)cp->next_alt->clause);
+      }
+      intmach_t i;
+      for (i = 0; i < ChoiceArity(cp); i++) {
+        CVOID__CALL(heapsnap__root, &s, cp->x[i], "choice", pred);
+      }
+      CVOID__CALL(heapsnap__walk, &s);
+    }
+    CVOID__CALL(heapsnap__frames, &s, cp->frame, cp->next_insn);
+  }
+
+  /* Trail entries that are not variables (undo goals and setarg) */
+  for (tr = Trail_Start; TrailYounger(G->trail_top, tr); tr += TrailDir) {
+    if (*tr == 0 || IsVar(*tr)) continue;
+    CVOID__CALL(heapsnap__root, &s, *tr, "trail", NULL);
+  }
+  CVOID__CALL(heapsnap__walk, &s);
+
+  checkdealloc_ARRAY(tagged_t, s.pending_size, s.pending);
+  checkdealloc_ARRAY(unsigned char, s.stack_seen_size, s.stack_seen);
+  checkdealloc_ARRAY(unsigned char, s.heap_seen_size, s.heap_seen);
+  checkdealloc_ARRAY(code_range_t, s.ranges_size, s.ranges);
+  if (fclose(s.out) != 0) return FALSE;
+  CBOOL__PROCEED;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Analysis of snapshots */
+
+/* Interned labels */
+typedef struct hs_labels_ hs_labels_t;
+struct hs_labels_ {
+  char **names;
+  intmach_t count;
+  intmach_t size;
+  intmach_t *index; /* hash table (open addressing) of label numbers, -1 if free */
+  intmach_t index_size;
+};
+
+static uintmach_t hs__hash(const char *str) {
+  uintmach_t h = 5381;
+  for (; *str; str++) h = h * 33 + (unsigned char)*str;
+  return h;
+}
+
+static void hs__labels_init(hs_labels_t *l) {
+  intmach_t i;
+  l->size = 256;
+  l->count = 0;
+  l->names = checkalloc_ARRAY(char *, l->size);
+  l->index_size = 512;
+  l->index = checkalloc_ARRAY(intmach_t, l->index_size);
+  for (i = 0; i < l->index_size; i++) l->index[i] = -1;
+}
+
+static void hs__labels_free(hs_labels_t *l) {
+  intmach_t i;
+  for (i = 0; i < l->count; i++) {
+    checkdealloc_ARRAY(char, strlen(l->names[i])+1, l->names[i]);
+  }
+  checkdealloc_ARRAY(char *, l->size, l->names);
+  checkdealloc_ARRAY(intmach_t, l->index_size, l->index);
+}
+
+static intmach_t hs__label(hs_labels_t *l, const char *name) {
+  uintmach_t mask = l->index_size - 1;
+  uintmach_t i = hs__hash(name) & mask;
+  intmach_t k;
+
+  while ((k = l->index[i]) != -1) {
+    if (strcmp(l->names[k], name) == 0) return k;
+    i = (i + 1) & mask;
+  }
+  if (l->count == l->size) {
+    l->names = checkrealloc_ARRAY(char *, l->size, 2*l->size, l->names);
+    l->size *= 2;
+  }
+  k = l->count++;
+  l->names[k] = checkalloc_ARRAY(char, strlen(name)+1);
+  strcpy(l->names[k], name);
+  l->index[i] = k;
+  if (2*l->count > l->index_size) { /* rehash */
+    intmach_t j;
+    checkdealloc_ARRAY(intmach_t, l->index_size, l->index);
+    l->index_size *= 2;
+    l->index = checkalloc_ARRAY(intmach_t, l->index_size);
+    for (j = 0; j < l->index_size; j++) l->index[j] = -1;
+    mask = l->index_size - 1;
+    for (j = 0; j < l->count; j++) {
+      i = hs__hash(l->names[j]) & mask;
+      while (l->index[i] != -1) i = (i + 1) & mask;
+      l->index[i] = j;
+    }
+  }
+  return k;
+}
+
+typedef struct hs_node_ hs_node_t;
+struct hs_node_ {
+  intmach_t id;
+  intmach_t size;
+  intmach_t label;
+};
+
+typedef struct hs_pair_ hs_pair_t;
+struct hs_pair_ {
+  intmach_t a;
+  intmach_t b;
+};
+
+/* Growable array of pairs */
+static void hs__push_pair(hs_pair_t **v, intmach_t *count, intmach_t *size, intmach_t a, intmach_t b) {
+  if (*count == *size) {
+    *v = checkrealloc_ARRAY(hs_pair_t, *size, 2*(*size), *v);
+    *size *= 2;
+  }
+  (*v)[*count].a = a;
+  (*v)[*count].b = b;
+  (*count)++;
+}
+
+static int hs__compare_node(const void *arg1, const void *arg2) {
+  const hs_node_t *n1 = (const hs_node_t *)arg1;
+  const hs_node_t *n2 = (const hs_node_t *)arg2;
+  if (n1->id < n2->id) return -1;
+  if (n1->id > n2->id) return 1;
+  return 0;
+}
+
+/* Index of the node with the given id, or -1 */
+static intmach_t hs__find(hs_node_t *nodes, intmach_t n, intmach_t id) {
+  intmach_t lo = 0;
+  intmach_t hi = n - 1;
+  while (lo <= hi) {
+    intmach_t mid = (lo + hi) / 2;
+    if (id < nodes[mid].id) {
+      hi = mid - 1;
+    } else if (id > nodes[mid].id) {
+      lo = mid + 1;
+    } else {
+      return mid;
+    }
+  }
+  return -1;
+}
+
+/* Adjacency lists (compressed) */
+static void hs__csr(intmach_t n, hs_pair_t *edges, intmach_t m, bool_t reverse,
+                    intmach_t **start_, intmach_t **adj_) {
+  intmach_t *start = checkalloc_ARRAY(intmach_t, n+1);
+  intmach_t *adj = checkalloc_ARRAY(intmach_t, m > 0 ? m : 1);
+  intmach_t i;
+  for (i = 0; i <= n; i++) start[i] = 0;
+  for (i = 0; i < m; i++) start[(reverse ? edges[i].b : edges[i].a)+1]++;
+  for (i = 0; i < n; i++) start[i+1] += start[i];
+  for (i = 0; i < m; i++) {
+    intmach_t from = reverse ? edges[i].b : edges[i].a;
+    intmach_t to = reverse ? edges[i].a : edges[i].b;
+    adj[start[from]++] = to;
+  }
+  for (i = n; i > 0; i--) start[i] = start[i-1];
+  start[0] = 0;
+  *start_ = start;
+  *adj_ = adj;
+}
+
+static intmach_t hs__intersect(intmach_t *idom, intmach_t *po, intmach_t b1, intmach_t b2) {
+  while (b1 != b2) {
+    while (po[b1] < po[b2]) b1 = idom[b1];
+    while (po[b2] < po[b1]) b2 = idom[b2];
+  }
+  return b1;
+}
+
+/* Summary for a label */
+typedef struct hs_stat_ hs_stat_t;
+struct hs_stat_ {
+  intmach_t label;
+  intmach_t count;
+  intmach_t shallow;
+  intmach_t retained;
+};
+
+static int hs__compare_stat(const void *arg1, const void *arg2) {
+  const hs_stat_t *s1 = (const hs_stat_t *)arg1;
+  const hs_stat_t *s2 = (const hs_stat_t *)arg2;
+  /* decreasing retained size, unused labels at the end */
+  if (s1->retained > s2->retained) return -1;
+  if (s1->retained < s2->retained) return 1;
+  if (s1->count > s2->count) return -1;
+  if (s1->count < s2->count) return 1;
+  return 0;
+}
+
+/* Heap cells for each element of the lists (assuming boxed integers) */
+#define HEAPSNAP_ELEM_CELLS (LSTCELLS+3+3*(LSTCELLS+3))
+
+static CFUN__PROTO(heapsnap__stat_list, tagged_t, hs_labels_t *l, hs_stat_t *stats, intmach_t n) {
+  tagged_t list = atom_nil;
+  intmach_t i;
+  for (i = n-1; i >= 0; i--) {
+    tagged_t x;
+    tagged_t *h;
+    MakeLST(x, IntmachToTagged(stats[i].retained), atom_nil);
+    MakeLST(x, IntmachToTagged(stats[i].shallow), x);
+    MakeLST(x, IntmachToTagged(stats[i].count), x);
+    h = G->heap_top;
+    HeapPush(h, functor_minus);
+    HeapPush(h, GET_ATOM(l->names[stats[i].label]));
+    HeapPush(h, x);
+    G->heap_top = h;
+    MakeLST(list, Tagp(STR, h-3), list);
+  }
+  return list;
+}
+
+#define HS_LINE_MAX 4096
+
+/* '$heap_snapshot_analyze'(+File, +N, -Total, -ByFunctor, -ByRoot):
+   Total is the size of the reachable heap; ByFunctor and ByRoot are
+   lists of Label-[Count,Shallow,Retained] with the N labels (0 for
+   all) with largest retained sizes. For functors, the retained size
+   counts the objects that are not immediately dominated by an object
+   with the same functor (e.g., the first cell of a list). For roots,
+   it counts the objects only retained by roots with that label. */
+CBOOL__PROTO(prolog_heap_snapshot_analyze) {
+  tagged_t x, y;
+  FILE *in;
+  char line[HS_LINE_MAX];
+  hs_labels_t labels;
+  hs_node_t *nodes;
+  intmach_t n, nodes_size;
+  hs_pair_t *edges, *roots;
+  intmach_t m, edges_size, r, roots_size;
+  intmach_t *succ_start, *succ, *pred_start, *pred;
+  intmach_t *po, *order, *idom, *retained;
+  intmach_t *stack, *stack_ix;
+  hs_stat_t *by_functor, *by_root;
+  intmach_t total, top, i, j, k, sp;
+  bool_t changed;
+  tagged_t l1, l2;
+
+  DEREF(x, X(0));
+  DEREF(y, X(1));
+  if (!TaggedIsATM(x) || !TaggedIsSmall(y) || GetSmall(y) < 0) return FALSE;
+  top = GetSmall(y);
+  in = fopen(GetString(x), "r");
+  if (in == NULL) return FALSE;
+  if (fgets(line, HS_LINE_MAX, in) == NULL ||
+      strncmp(line, "ciao-heapsnap 1", 15) != 0) {
+    fclose(in);
+    return FALSE;
+  }
+
+  /* Read the graph */
+  hs__labels_init(&labels);
+  nodes_size = 1024; n = 0;
+  nodes = checkalloc_ARRAY(hs_node_t, nodes_size);
+  edges_size = 1024; m = 0;
+  edges = checkalloc_ARRAY(hs_pair_t, edges_size);
+  roots_size = 64; r = 0;
+  roots = checkalloc_ARRAY(hs_pair_t, roots_size);
+  while (fgets(line, HS_LINE_MAX, in) != NULL) {
+    long long a, b;
+    int pos;
+    char *nl = strchr(line, '\n');
+    if (nl != NULL) *nl = '\0';
+    if (line[0] == 'N' && sscanf(line, "N %lld %lld %n", &a, &b, &pos) == 2) {
+      if (n == nodes_size) {
+        nodes = checkrealloc_ARRAY(hs_node_t, nodes_size, 2*nodes_size, nodes);
+        nodes_size *= 2;
+      }
+      nodes[n].id = a;
+      nodes[n].size = b;
+      nodes[n].label = hs__label(&labels, line+pos);
+      n++;
+    } else if (line[0] == 'E' && sscanf(line, "E %lld %lld", &a, &b) == 2) {
+      hs__push_pair(&edges, &m, &edges_size, a, b);
+    } else if (line[0] == 'R' && sscanf(line, "R %lld %n", &a, &pos) == 1) {
+      hs__push_pair(&roots, &r, &roots_size, a, hs__label(&labels, line+pos));
+    }
+  }
+  fclose(in);
+
+  /* Map ids to node numbers; node n is the virtual root */
+  qsort(nodes, n, sizeof(hs_node_t), hs__compare_node);
+  k = 0;
+  for (i = 0; i < m; i++) {
+    intmach_t a = hs__find(nodes, n, edges[i].a);
+    intmach_t b = hs__find(nodes, n, edges[i].b);
+    if (a < 0 || b < 0) continue;
+    edges[k].a = a;
+    edges[k].b = b;
+    k++;
+  }
+  m = k;
+  k = 0;
+  for (i = 0; i < r; i++) {
+    intmach_t a = hs__find(nodes, n, roots[i].a);
+    if (a < 0) continue;
+    roots[k].a = a;
+    roots[k].b = roots[i].b;
+    hs__push_pair(&edges, &m, &edges_size, n, a);
+    k++;
+  }
+  r = k;
+  hs__csr(n+1, edges, m, FALSE, &succ_start, &succ);
+  hs__csr(n+1, edges, m, TRUE, &pred_start, &pred);
+
+  /* Postorder numbering (depth-first from the virtual root) */
+  po = checkalloc_ARRAY(intmach_t, n+1);
+  order = checkalloc_ARRAY(intmach_t, n+1);
+  stack = checkalloc_ARRAY(intmach_t, n+1);
+  stack_ix = checkalloc_ARRAY(intmach_t, n+1);
+  for (i = 0; i <= n; i++) po[i] = -2; /* -2: unvisited, -1: in progress */
+  k = 0;
+  sp = 0;
+  stack[sp] = n;
+  stack_ix[sp] = succ_start[n];
+  po[n] = -1;
+  sp++;
+  while (sp > 0) {
+    intmach_t v = stack[sp-1];
+    if (stack_ix[sp-1] < succ_start[v+1]) {
+      intmach_t u = succ[stack_ix[sp-1]++];
+      if (po[u] == -2) {
+        po[u] = -1;
+        stack[sp] = u;
+        stack_ix[sp] = succ_start[u];
+        sp++;
+      }
+    } else {
+      po[v] = k;
+      order[k++] = v;
+      sp--;
+    }
+  }
+
+  /* Immediate dominators */
+  idom = checkalloc_ARRAY(intmach_t, n+1);
+  for (i = 0; i <= n; i++) idom[i] = -1;
+  idom[n] = n;
+  do {
+    changed = FALSE;
+    for (j = k-2; j >= 0; j--) { /* reverse postorder, except the root */
+      intmach_t v = order[j];
+      intmach_t new_idom = -1;
+      for (i = pred_start[v]; i < pred_start[v+1]; i++) {
+        intmach_t p = pred[i];
+        if (idom[p] == -1) continue;
+        new_idom = (new_idom == -1 ? p : hs__intersect(idom, po, p, new_idom));
+      }
+      if (idom[v] != new_idom) {
+        idom[v] = new_idom;
+        changed = TRUE;
+      }
+    }
+  } while (changed);
+
+  /* Retained sizes (dominators come later in postorder) */
+  retained = checkalloc_ARRAY(intmach_t, n+1);
+  for (i = 0; i < n; i++) retained[i] = nodes[i].size;
+  retained[n] = 0;
+  for (j = 0; j < k-1; j++) {
+    intmach_t v = order[j];
+    retained[idom[v]] += retained[v];
+  }
+  total = retained[n];
+
+  /* Summaries */
+  by_functor = checkalloc_ARRAY(hs_stat_t, labels.count);
+  by_root = checkalloc_ARRAY(hs_stat_t, labels.count);
+  for (i = 0; i < labels.count; i++) {
+    by_functor[i].label = by_root[i].label = i;
+    by_functor[i].count = by_root[i].count = 0;
+    by_functor[i].shallow = by_root[i].shallow = 0;
+    by_functor[i].retained = by_root[i].retained = 0;
+  }
+  for (j = 0; j < k-1; j++) {
+    intmach_t v = order[j];
+    hs_stat_t *st = &by_functor[nodes[v].label];
+    st->count++;
+    st->shallow += nodes[v].size;
+    if (idom[v] == n || nodes[idom[v]].label != nodes[v].label) {
+      st->retained += retained[v];
+    }
+  }
+  for (i = 0; i < r; i++) {
+    intmach_t v = roots[i].a;
+    hs_stat_t *st = &by_root[roots[i].b];
+    st->count++;
+    if (idom[v] == n && stack_ix[v] != -1) { /* (count each object once) */
+      st->shallow += nodes[v].size;
+      st->retained += retained[v];
+      stack_ix[v] = -1;
+    }
+  }
+  qsort(by_functor, labels.count, sizeof(hs_stat_t), hs__compare_stat);
+  qsort(by_root, labels.count, sizeof(hs_stat_t), hs__compare_stat);
+
+  checkdealloc_ARRAY(intmach_t, n+1, retained);
+  checkdealloc_ARRAY(intmach_t, n+1, idom);
+  checkdealloc_ARRAY(intmach_t, n+1, stack_ix);
+  checkdealloc_ARRAY(intmach_t, n+1, stack);
+  checkdealloc_ARRAY(intmach_t, n+1, order);
+  checkdealloc_ARRAY(intmach_t, n+1, po);
+  checkdealloc_ARRAY(intmach_t, m > 0 ? m : 1, pred);
+  checkdealloc_ARRAY(intmach_t, n+2, pred_start);
+  checkdealloc_ARRAY(intmach_t, m > 0 ? m : 1, succ);
+  checkdealloc_ARRAY(intmach_t, n+2, succ_start);
+  checkdealloc_ARRAY(hs_pair_t, roots_size, roots);
+  checkdealloc_ARRAY(hs_pair_t, edges_size, edges);
+  checkdealloc_ARRAY(hs_node_t, nodes_size, nodes);
+
+  /* Build the result */
+  {
+    intmach_t nf, nr;
+    for (nf = 0; nf < labels.count && by_functor[nf].count > 0; nf++) {}
+    for (nr = 0; nr < labels.count && by_root[nr].count > 0; nr++) {}
+    if (top > 0 && nf > top) nf = top;
+    if (top > 0 && nr > top) nr = top;
+    TEST_HEAP_OVERFLOW(G->heap_top, (nf+nr+1)*HEAPSNAP_ELEM_CELLS*sizeof(tagged_t)+CONTPAD, 5);
+    l1 = CFUN__EVAL(heapsnap__stat_list, &labels, by_functor, nf);
+    l2 = CFUN__EVAL(heapsnap__stat_list, &labels, by_root, nr);
+  }
+  checkdealloc_ARRAY(hs_stat_t, labels.count, by_root);
+  checkdealloc_ARRAY(hs_stat_t, labels.count, by_functor);
+  hs__labels_free(&labels);
+
+  CBOOL__CALL(cunify, IntmachToTagged(total), X(2));
+  CBOOL__CALL(cunify, l1, X(3));
+  CBOOL__LASTUNIFY(l2, X(4));
+}
@@ -0,0 +1,15 @@
+/*
+ *  eng_heapsnap.h
+ *
+ *  Heap snapshots (heap graph dump) and retained size analysis.
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#ifndef _CIAO_ENG_HEAPSNAP_H
+#define _CIAO_ENG_HEAPSNAP_H
+
+CBOOL__PROTO(prolog_heap_snapshot);
+CBOOL__PROTO(prolog_heap_snapshot_analyze);
+
+#endif /* _CIAO_ENG_HEAPSNAP_H */
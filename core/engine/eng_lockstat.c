@@ -0,0 +1,161 @@
+/*
+ *  eng_lockstat.c
+ *
+ *  Lock contention statistics for engine locks.
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <ciao/eng.h>
+#include <ciao/eng_gc.h>
+#include <ciao/eng_registry.h>
+#include <ciao/stream_basic.h>
+#include <ciao/eng_lockstat.h>
+
+/* Counters are shared by all threads and updated with atomic
+   operations (only when enabled). An acquisition is contended when
+   the lock could not be taken at the first try; the wait time is the
+   wall time until it was acquired. */
+
+intmach_t goal_from_thread_id(THREAD_ID id); /* concurrency.c */
+
+static const char *lockstat_site_name[] = {
+  "mem_mng",
+  "wam_list",
+  "atom_id",
+  "predicates",
+  "atom",
+  "conc_pred",
+  "conc_wait"
+};
+
+volatile bool_t lockstat_enabled = FALSE; /* Shared */
+lockstat_t lockstat[LOCKSTAT_SITES]; /* Shared */
+
+void init_lockstat(void) {
+  memset(lockstat, 0, sizeof(lockstat));
+}
+
+/* (done for each option) */
+bool_t lockstat__get_opt(const char *arg) {
+  if (strcmp(arg, "--lockstats") == 0) {
+    lockstat_enabled = TRUE;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+void lockstat__contended(int site, inttime_t t0) {
+  lockstat_t *s = &lockstat[site];
+  inttime_t wait = walltick() - t0;
+  inttime_t max;
+
+  __atomic_add_fetch(&s->contended, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&s->wait_total, wait, __ATOMIC_RELAXED);
+  max = s->wait_max;
+  while (wait > max &&
+         !__atomic_compare_exchange_n(&s->wait_max, &max, wait, FALSE,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+/* Blocking waits (on a condition) since t0, contended if they took
+   any measurable time */
+void lockstat__waited(int site, inttime_t t0) {
+  if (walltick() > t0) lockstat__contended(site, t0);
+  __atomic_add_fetch(&lockstat[site].acquired, 1, __ATOMIC_RELAXED);
+}
+
+void lockstat__holder(int site, THREAD_ID holder) {
+  lockstat[site].last_holder = holder;
+  lockstat[site].has_holder = TRUE;
+}
+
+void lockstat__acquire_root(int_info_t *root) {
+  if (!Try_Acquire_lock(root->clause_insertion_cond.cond_lock)) {
+    THREAD_ID holder = root->clause_insertion_holder;
+    inttime_t t0 = walltick();
+    Wait_Acquire_Cond_lock(root->clause_insertion_cond);
+    lockstat__contended(LOCKSTAT_CONC_PRED, t0);
+    lockstat__holder(LOCKSTAT_CONC_PRED, holder);
+  }
+  __atomic_add_fetch(&lockstat[LOCKSTAT_CONC_PRED].acquired, 1, __ATOMIC_RELAXED);
+  root->clause_insertion_holder = Thread_Id;
+}
+
+/* Print a summary (for eng_status/0) */
+CVOID__PROTO(print_lockstat) {
+  FILE *u_o = Output_Stream_Ptr->streamfile;
+  int i;
+
+  fprintf(u_o, "Lock statistics (%s):\n", lockstat_enabled ? "on" : "off");
+  fprintf(u_o, "  %-12s %12s %12s %14s %14s\n",
+          "Site", "Acquired", "Contended", "Wait (ms)", "Max wait (ms)");
+  for (i = 0; i < LOCKSTAT_SITES; i++) {
+    lockstat_t *s = &lockstat[i];
+    fprintf(u_o, "  %-12s %12" PRIum " %12" PRIum " %14.3f %14.3f",
+            lockstat_site_name[i], s->acquired, s->contended,
+            (flt64_t)s->wait_total/1000, (flt64_t)s->wait_max/1000);
+    if (s->has_holder) {
+      fprintf(u_o, "  (last holder: Goal Id %" PRIdm ")",
+              goal_from_thread_id(s->last_holder));
+    }
+    fprintf(u_o, "\n");
+  }
+}
+
+/* '$lockstat_set'(+OnOff) */
+CBOOL__PROTO(prolog_lockstat_set) {
+  tagged_t x;
+  DEREF(x, X(0));
+  if (x == atom_on) {
+    lockstat_enabled = TRUE;
+  } else if (x == atom_off) {
+    lockstat_enabled = FALSE;
+  } else {
+    return FALSE;
+  }
+  CBOOL__PROCEED;
+}
+
+/* '$lockstat_get'(-OnOff) */
+CBOOL__PROTO(prolog_lockstat_get) {
+  CBOOL__LASTUNIFY(lockstat_enabled ? atom_on : atom_off, X(0));
+}
+
+/* '$lockstat_reset' */
+CBOOL__PROTO(prolog_lockstat_reset) {
+  init_lockstat();
+  CBOOL__PROCEED;
+}
+
+/* Heap cells for each element of the list (assuming boxed integers) */
+#define LOCKSTAT_ELEM_CELLS (LSTCELLS+3+4*(LSTCELLS+3))
+
+/* '$lockstat_usage'(-List): List is a list of
+   Site-[Acquired,Contended,WaitTime,MaxWaitTime] (times in
+   microseconds) */
+CBOOL__PROTO(prolog_lockstat_usage) {
+  tagged_t list, x;
+  tagged_t *h;
+  int i;
+
+  TEST_HEAP_OVERFLOW(G->heap_top, LOCKSTAT_SITES*LOCKSTAT_ELEM_CELLS*sizeof(tagged_t)+CONTPAD, 1);
+  list = atom_nil;
+  for (i = LOCKSTAT_SITES-1; i >= 0; i--) {
+    lockstat_t *s = &lockstat[i];
+    MakeLST(x, IntmachToTagged((intmach_t)s->wait_max), atom_nil);
+    MakeLST(x, IntmachToTagged((intmach_t)s->wait_total), x);
+    MakeLST(x, IntmachToTagged((intmach_t)s->contended), x);
+    MakeLST(x, IntmachToTagged((intmach_t)s->acquired), x);
+    h = G->heap_top;
+    HeapPush(h, functor_minus);
+    HeapPush(h, GET_ATOM((char *)lockstat_site_name[i]));
+    HeapPush(h, x);
+    G->heap_top = h;
+    MakeLST(list, Tagp(STR, h-3), list);
+  }
+  CBOOL__LASTUNIFY(list, X(0));
+}
@@ -0,0 +1,81 @@
+/*
+ *  eng_lockstat.h
+ *
+ *  Lock contention statistics for engine locks.
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#ifndef _CIAO_ENG_LOCKSTAT_H
+#define _CIAO_ENG_LOCKSTAT_H
+
+#include <ciao/timing.h>
+
+/* Lock sites (keep in sync with lockstat_site_name[] in eng_lockstat.c) */
+#define LOCKSTAT_MEM_MNG    0 /* mem_mng_l (memory manager) */
+#define LOCKSTAT_WAM_LIST   1 /* wam_list_l (pool of free workers) */
+#define LOCKSTAT_ATOM_ID    2 /* atom_id_l (atom table) */
+#define LOCKSTAT_PREDICATES 3 /* prolog_predicates_l (predicate table) */
+#define LOCKSTAT_ATOM       4 /* atom_lock_l (atom based locks, all atoms) */
+#define LOCKSTAT_CONC_PRED  5 /* clause_insertion_cond lock (concurrent predicates) */
+#define LOCKSTAT_CONC_WAIT  6 /* blocking wait for clauses (concurrent predicates) */
+#define LOCKSTAT_SITES      7
+
+typedef struct lockstat_ lockstat_t;
+struct lockstat_ {
+  volatile uintmach_t acquired;  /* acquisitions */
+  volatile uintmach_t contended; /* acquisitions that had to wait */
+  volatile inttime_t wait_total; /* total wait time (microsecs) */
+  volatile inttime_t wait_max;   /* max wait time (microsecs) */
+  volatile bool_t has_holder;
+  volatile THREAD_ID last_holder; /* holder on the last contended acquisition */
+} __attribute__((aligned(64))); /* avoid false sharing between sites */
+
+extern volatile bool_t lockstat_enabled;
+extern lockstat_t lockstat[LOCKSTAT_SITES];
+
+void init_lockstat(void);
+bool_t lockstat__get_opt(const char *arg);
+void lockstat__contended(int site, inttime_t t0);
+void lockstat__waited(int site, inttime_t t0);
+void lockstat__holder(int site, THREAD_ID holder);
+
+#define LOCKSTAT__ACQUIRE(TRY, WAIT, SITE) do { \
+  if (__builtin_expect(lockstat_enabled, 0)) { \
+    if (!(TRY)) { \
+      inttime_t lockstat__t0 = walltick(); \
+      WAIT; \
+      lockstat__contended((SITE), lockstat__t0); \
+    } \
+    __atomic_add_fetch(&lockstat[(SITE)].acquired, 1, __ATOMIC_RELAXED); \
+  } else { \
+    WAIT; \
+  } \
+} while(0)
+
+/* Like Wait_Acquire_slock() and Wait_Acquire_lock(), counting
+   acquisitions and waits on SITE when lock statistics are enabled
+   (otherwise the cost is a single predicted branch) */
+#define Wait_Acquire_slock_stat(p, SITE) \
+  LOCKSTAT__ACQUIRE(Try_Acquire_slock(p), Wait_Acquire_slock(p), SITE)
+#define Wait_Acquire_lock_stat(p, SITE) \
+  LOCKSTAT__ACQUIRE(Try_Acquire_lock(p), Wait_Acquire_lock(p), SITE)
+
+/* Like Cond_Begin() on the clause insertion lock of ROOT, also
+   recording the holder of the lock (for contention reports) */
+void lockstat__acquire_root(int_info_t *root);
+#define Cond_Begin_root_stat(ROOT) do { \
+  if (__builtin_expect(lockstat_enabled, 0)) { \
+    lockstat__acquire_root(ROOT); \
+  } else { \
+    Cond_Begin((ROOT)->clause_insertion_cond); \
+  } \
+} while(0)
+
+CVOID__PROTO(print_lockstat);
+CBOOL__PROTO(prolog_lockstat_set);
+CBOOL__PROTO(prolog_lockstat_get);
+CBOOL__PROTO(prolog_lockstat_reset);
+CBOOL__PROTO(prolog_lockstat_usage);
+
+#endif /* _CIAO_ENG_LOCKSTAT_H */
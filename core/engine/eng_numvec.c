@@ -0,0 +1,241 @@
+/*
+ *  eng_numvec.c
+ *
+ *  Packed numeric vectors (homogeneous unboxed arrays on the heap).
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#include <string.h>
+
+#include <ciao/eng.h>
+#include <ciao/eng_gc.h>
+#include <ciao/eng_bignum.h>
+#include <ciao/eng_registry.h>
+#include <ciao/eng_numvec.h>
+
+/* A vector is the term '$numvec'(Type, Len, Data), where Data is a
+   single blob with the packed elements. The blob is a bignum (so that
+   GC, copy_term/2, the database, etc. treat it as an opaque number)
+   whose last word is a guard (1) that keeps it canonical for any
+   contents:
+
+     [F] [w_1 ... w_n] [1] [F]     F = BlobFunctorBignum(n+1)
+
+   The element data starts at the first word (aligned to the tagged
+   word size) and it can be read and written in place (e.g., from
+   foreign code). */
+
+CFUN__PROTO(c_list_length, int, tagged_t list); /* system.c */
+
+static tagged_t functor_Dnumvec;
+static tagged_t numvec_type_atom[NUMVEC_TYPES];
+
+static const char *numvec_type_name[NUMVEC_TYPES] = {
+  "int8",
+  "int16",
+  "int32",
+  "int64",
+  "float64"
+};
+
+static const intmach_t numvec_elem_size[NUMVEC_TYPES] = {
+  sizeof(int8_t),
+  sizeof(int16_t),
+  sizeof(int32_t),
+  sizeof(int64_t),
+  sizeof(flt64_t)
+};
+
+void init_numvec(void) {
+  int i;
+  functor_Dnumvec = deffunctor("$numvec", 3);
+  for (i = 0; i < NUMVEC_TYPES; i++) {
+    numvec_type_atom[i] = GET_ATOM((char *)numvec_type_name[i]);
+  }
+}
+
+/* Data words (at least one) */
+intmach_t numvec_words(int type, intmach_t len) {
+  intmach_t words = (len*numvec_elem_size[type]+sizeof(tagged_t)-1)/sizeof(tagged_t);
+  return words > 0 ? words : 1;
+}
+
+static int numvec_type(tagged_t t) {
+  int i;
+  for (i = 0; i < NUMVEC_TYPES; i++) {
+    if (numvec_type_atom[i] == t) return i;
+  }
+  return -1;
+}
+
+/* Create a zero-filled vector (Pre: NUMVEC_CELLS(type,len) heap cells
+   are available) */
+CFUN__PROTO(numvec_make, tagged_t, int type, intmach_t len, void **data) {
+  intmach_t words = numvec_words(type, len);
+  tagged_t f = (tagged_t)BlobFunctorBignum(words+1);
+  tagged_t *h = G->heap_top;
+  tagged_t blob;
+
+  blob = Tagp(STR, h);
+  HeapPush(h, f);
+  *data = (void *)h;
+  memset(h, 0, words*sizeof(tagged_t));
+  h += words;
+  HeapPush(h, (tagged_t)1); /* guard */
+  HeapPush(h, f);
+  HeapPush(h, functor_Dnumvec);
+  HeapPush(h, numvec_type_atom[type]);
+  HeapPush(h, MakeSmall(len));
+  HeapPush(h, blob);
+  G->heap_top = h;
+  return Tagp(STR, h-4);
+}
+
+/* Get the type, length, and data of a vector (dereferenced), or -1
+   if t is not a vector */
+int numvec_decomp(tagged_t t, intmach_t *len, void **data) {
+  tagged_t x;
+  tagged_t f;
+  int type;
+
+  if (!TaggedIsSTR(t) || TaggedToHeadfunctor(t) != functor_Dnumvec) return -1;
+  DerefArg(x, t, 1);
+  type = numvec_type(x);
+  if (type < 0) return -1;
+  DerefArg(x, t, 2);
+  if (!TaggedIsSmall(x) || GetSmall(x) < 0) return -1;
+  *len = GetSmall(x);
+  DerefArg(x, t, 3);
+  if (!TaggedIsSTR(x)) return -1;
+  f = TaggedToHeadfunctor(x);
+  if (!FunctorIsBlob(f) || FunctorIsFloat(f)) return -1;
+  /* (LargeArity counts the functor and the guard) */
+  if (LargeArity(f) - 2 < numvec_words(type, *len)) return -1;
+  *data = (void *)TaggedToArg(x, 1);
+  return type;
+}
+
+/* Element i as a term (Pre: enough heap for a boxed number) */
+static CFUN__PROTO(numvec_elem, tagged_t, int type, void *data, intmach_t i) {
+  switch (type) {
+  case NUMVEC_INT8: return MakeSmall(((int8_t *)data)[i]);
+  case NUMVEC_INT16: return MakeSmall(((int16_t *)data)[i]);
+  case NUMVEC_INT32: return IntmachToTagged((intmach_t)((int32_t *)data)[i]);
+  case NUMVEC_INT64: return IntmachToTagged((intmach_t)((int64_t *)data)[i]);
+  default: return BoxFloat(((flt64_t *)data)[i]);
+  }
+}
+
+/* '$numvec_new'(+Type, +Len, -Vector) */
+CBOOL__PROTO(prolog_numvec_new) {
+  tagged_t t;
+  int type;
+  intmach_t len;
+  void *data;
+
+  DEREF(t, X(0));
+  type = numvec_type(t);
+  if (type < 0) CBOOL__FAIL;
+  DEREF(t, X(1));
+  if (!TaggedIsSmall(t) || GetSmall(t) < 0) CBOOL__FAIL;
+  len = GetSmall(t);
+  TEST_HEAP_OVERFLOW(G->heap_top, NUMVEC_CELLS(type, len)*sizeof(tagged_t)+CONTPAD, 3);
+  t = CFUN__EVAL(numvec_make, type, len, &data);
+  CBOOL__LASTUNIFY(t, X(2));
+}
+
+/* '$list_to_numvec'(+Type, +List, -Vector) */
+CBOOL__PROTO(prolog_list_to_numvec) {
+  ERR__FUNCTOR("numvec:list_to_numvec", 3);
+  tagged_t t, car, cdr;
+  int type;
+  intmach_t len, i, v;
+  void *data;
+
+  DEREF(t, X(0));
+  type = numvec_type(t);
+  if (type < 0) CBOOL__FAIL;
+  len = CFUN__EVAL(c_list_length, X(1));
+  if (len < 0) ERROR_IN_ARG(X(1), 2, ERR_type_error(list));
+  TEST_HEAP_OVERFLOW(G->heap_top, NUMVEC_CELLS(type, len)*sizeof(tagged_t)+CONTPAD, 3);
+  t = CFUN__EVAL(numvec_make, type, len, &data);
+
+  DEREF(cdr, X(1));
+  for (i = 0; i < len; i++) {
+    DerefCar(car, cdr);
+    if (type == NUMVEC_FLOAT64) {
+      if (!IsNumber(car)) ERROR_IN_ARG(car, 2, ERR_type_error(number));
+      ((flt64_t *)data)[i] = TaggedToFloat(car);
+    } else {
+      if (!IsInteger(car)) ERROR_IN_ARG(car, 2, ERR_type_error(integer));
+      if (!IsIntegerFix(car)) {
+        BUILTIN_ERROR(bn_positive(TaggedToBignum(car)) ? ERR_representation_error(max_integer) : ERR_representation_error(min_integer), car, 2);
+      }
+      v = TaggedToIntmach(car);
+      switch (type) {
+      case NUMVEC_INT8:
+        if (v < INT8_MIN) BUILTIN_ERROR(ERR_representation_error(min_integer), car, 2);
+        if (v > INT8_MAX) BUILTIN_ERROR(ERR_representation_error(max_integer), car, 2);
+        ((int8_t *)data)[i] = (int8_t)v;
+        break;
+      case NUMVEC_INT16:
+        if (v < INT16_MIN) BUILTIN_ERROR(ERR_representation_error(min_integer), car, 2);
+        if (v > INT16_MAX) BUILTIN_ERROR(ERR_representation_error(max_integer), car, 2);
+        ((int16_t *)data)[i] = (int16_t)v;
+        break;
+      case NUMVEC_INT32:
+        if (v < INT32_MIN) BUILTIN_ERROR(ERR_representation_error(min_integer), car, 2);
+        if (v > INT32_MAX) BUILTIN_ERROR(ERR_representation_error(max_integer), car, 2);
+        ((int32_t *)data)[i] = (int32_t)v;
+        break;
+      default:
+        ((int64_t *)data)[i] = (int64_t)v;
+      }
+    }
+    DerefCdr(cdr, cdr);
+  }
+  CBOOL__LASTUNIFY(t, X(2));
+}
+
+/* Heap cells for each list element (assuming boxed numbers) */
+#define NUMVEC_ELEM_CELLS (LSTCELLS+4)
+
+/* '$numvec_to_list'(+Vector, -List) */
+CBOOL__PROTO(prolog_numvec_to_list) {
+  tagged_t t, list;
+  int type;
+  intmach_t len, i;
+  void *data;
+
+  DEREF(t, X(0));
+  if (numvec_decomp(t, &len, &data) < 0) CBOOL__FAIL;
+  TEST_HEAP_OVERFLOW(G->heap_top, len*NUMVEC_ELEM_CELLS*sizeof(tagged_t)+CONTPAD, 2);
+  /* (data may have been moved by GC) */
+  DEREF(t, X(0));
+  type = numvec_decomp(t, &len, &data);
+  list = atom_nil;
+  for (i = len-1; i >= 0; i--) {
+    MakeLST(list, CFUN__EVAL(numvec_elem, type, data, i), list);
+  }
+  CBOOL__LASTUNIFY(list, X(1));
+}
+
+/* '$numvec_get'(+Vector, +Index, -Elem) (zero-based, fails if out of
+   range) */
+CBOOL__PROTO(prolog_numvec_get) {
+  tagged_t t;
+  int type;
+  intmach_t len, i;
+  void *data;
+
+  TEST_HEAP_OVERFLOW(G->heap_top, NUMVEC_ELEM_CELLS*sizeof(tagged_t)+CONTPAD, 3);
+  DEREF(t, X(0));
+  type = numvec_decomp(t, &len, &data);
+  if (type < 0) CBOOL__FAIL;
+  DEREF(t, X(1));
+  if (!TaggedIsSmall(t)) CBOOL__FAIL;
+  i = GetSmall(t);
+  if (i < 0 || i >= len) CBOOL__FAIL;
+  CBOOL__LASTUNIFY(CFUN__EVAL(numvec_elem, type, data, i), X(2));
+}
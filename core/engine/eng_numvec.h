@@ -0,0 +1,34 @@
+/*
+ *  eng_numvec.h
+ *
+ *  Packed numeric vectors (homogeneous unboxed arrays on the heap).
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#ifndef _CIAO_ENG_NUMVEC_H
+#define _CIAO_ENG_NUMVEC_H
+
+/* Element types */
+#define NUMVEC_INT8 0
+#define NUMVEC_INT16 1
+#define NUMVEC_INT32 2
+#define NUMVEC_INT64 3
+#define NUMVEC_FLOAT64 4
+#define NUMVEC_TYPES 5
+
+/* Heap cells for a vector of LEN elements of type TYPE ('$numvec'/3
+   structure, plus blob functors and guard word) */
+#define NUMVEC_CELLS(TYPE, LEN) (7 + numvec_words((TYPE), (LEN)))
+
+void init_numvec(void);
+intmach_t numvec_words(int type, intmach_t len);
+CFUN__PROTO(numvec_make, tagged_t, int type, intmach_t len, void **data);
+int numvec_decomp(tagged_t t, intmach_t *len, void **data);
+
+CBOOL__PROTO(prolog_numvec_new);
+CBOOL__PROTO(prolog_list_to_numvec);
+CBOOL__PROTO(prolog_numvec_to_list);
+CBOOL__PROTO(prolog_numvec_get);
+
+#endif /* _CIAO_ENG_NUMVEC_H */
@@ -3,11 +3,12 @@
 #define __USE_GNU
 # include <dlfcn.h>
 #endif
-#if !defined(OPTIM_COMP) && defined(ABSMACH_OPT__profile_calls)
+#if !defined(OPTIM_COMP)
 #include <ciao/timing.h>
 #endif
 
 #include <ciao/eng_profile.h>
+#include <ciao/eng_gc.h>
 
 /* --------------------------------------------------------------------------- */
 /* Get profiling options */
@@ -301,3 +302,297 @@ CBOOL__PROTO(prolog_profile_reset) {
 #endif
   CBOOL__PROCEED;
 }
+
+/* --------------------------------------------------------------------------- */
+/* Call statistics */
+
+/* Lightweight alternative to profile_calls that is compiled in all
+   engines. Counters are kept in a private table per worker (no
+   synchronization in the fast path) and merged on read. When
+   callstats_period is N>1 only one of each N calls is recorded (with
+   weight N). */
+
+#if !defined(OPTIM_COMP)
+#include <stdlib.h>
+#include <string.h>
+
+volatile intmach_t callstats_flags = 0; /* Shared */
+volatile intmach_t callstats_period = 1; /* Shared */
+
+typedef struct callstats_entry_ callstats_entry_t;
+struct callstats_entry_ {
+  definition_t *pred;
+  intmach_t calls;
+  inttime_t time; /* microsecs */
+};
+
+struct callstats_ {
+  SLOCK lock; /* (re)allocation of table vs. readers */
+  intmach_t countdown; /* calls until next sample */
+  intmach_t size; /* table size (power of 2) */
+  intmach_t count; /* used entries */
+  callstats_entry_t *table;
+  definition_t *last_pred; /* last sampled predicate (for time) */
+  inttime_t last_tick;
+  callstats_t *next; /* next in callstats_list */
+};
+
+#define CALLSTATS_INITIAL_SIZE 256
+#define CALLSTATS_HASH(F) ((uintmach_t)(F)>>4)
+
+static callstats_t *callstats_list = NULL; /* Shared, locked */
+static SLOCK callstats_list_l;
+
+void init_callstats(void) {
+  Init_slock(callstats_list_l);
+}
+
+/* (done for each option) */
+bool_t callstats__get_opt(const char *arg) {
+  if (strcmp(arg, "--callstats") == 0) {
+    callstats_flags |= CALLSTATS_FLAG_CALLS;
+    return TRUE;
+  } else if (strcmp(arg, "--callstats-time") == 0) {
+    callstats_flags |= CALLSTATS_FLAG_CALLS | CALLSTATS_FLAG_TIME;
+    return TRUE;
+  } else if (strncmp(arg, "--callstats-period=", 19) == 0) {
+    intmach_t period = atol(arg+19);
+    callstats_period = (period < 1 ? 1 : period);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+static callstats_entry_t *callstats__alloc_table(intmach_t size) {
+  callstats_entry_t *table;
+  table = checkalloc_ARRAY(callstats_entry_t, size);
+  memset(table, 0, size*sizeof(callstats_entry_t));
+  return table;
+}
+
+/* Attach a new (empty) table to the worker */
+static CFUN__PROTO(callstats__attach, callstats_t *) {
+  callstats_t *cs;
+  cs = checkalloc_TYPE(callstats_t);
+  Init_slock(cs->lock);
+  cs->countdown = callstats_period;
+  cs->size = CALLSTATS_INITIAL_SIZE;
+  cs->count = 0;
+  cs->table = callstats__alloc_table(cs->size);
+  cs->last_pred = NULL;
+  cs->last_tick = 0;
+  Wait_Acquire_slock(callstats_list_l);
+  cs->next = callstats_list;
+  callstats_list = cs;
+  Release_slock(callstats_list_l);
+  w->misc->callstats = cs;
+  return cs;
+}
+
+/* Find (or insert) the entry for f (in a table with free entries) */
+static callstats_entry_t *callstats__find(callstats_entry_t *table,
+                                          intmach_t size,
+                                          definition_t *f) {
+  uintmach_t mask = size-1;
+  uintmach_t i = CALLSTATS_HASH(f) & mask;
+  for (;;) {
+    callstats_entry_t *e = &table[i];
+    if (e->pred == f || e->pred == NULL) return e;
+    i = (i+1) & mask;
+  }
+}
+
+/* Double the table size (only called by the owner) */
+static void callstats__grow(callstats_t *cs) {
+  intmach_t i;
+  intmach_t size = cs->size<<1;
+  callstats_entry_t *table = callstats__alloc_table(size);
+  for (i = 0; i < cs->size; i++) {
+    callstats_entry_t *e = &cs->table[i];
+    if (e->pred != NULL) *callstats__find(table, size, e->pred) = *e;
+  }
+  Wait_Acquire_slock(cs->lock);
+  checkdealloc_ARRAY(callstats_entry_t, cs->size, cs->table);
+  cs->table = table;
+  cs->size = size;
+  Release_slock(cs->lock);
+}
+
+static callstats_entry_t *callstats__lookup(callstats_t *cs, definition_t *f) {
+  callstats_entry_t *e = callstats__find(cs->table, cs->size, f);
+  if (e->pred == NULL) {
+    if ((cs->count+1)*4 > cs->size*3) { /* keep load factor <= 0.75 */
+      callstats__grow(cs);
+      e = callstats__find(cs->table, cs->size, f);
+    }
+    cs->count++;
+    e->pred = f;
+  }
+  return e;
+}
+
+CVOID__PROTO(callstats__hook, definition_t *f) {
+  callstats_t *cs = w->misc->callstats;
+  callstats_entry_t *e;
+
+  if (cs == NULL) cs = CFUN__EVAL(callstats__attach);
+  if (--cs->countdown > 0) return;
+  cs->countdown = callstats_period;
+
+  e = callstats__lookup(cs, f);
+  e->calls += callstats_period;
+  if ((callstats_flags & CALLSTATS_FLAG_TIME) != 0) {
+    inttime_t now = walltick();
+    if (cs->last_pred != NULL) {
+      callstats__lookup(cs, cs->last_pred)->time += now - cs->last_tick;
+    }
+    cs->last_pred = f;
+    cs->last_tick = now;
+  }
+}
+
+/* Apply fn to each per-worker table, with its lock acquired */
+static void callstats__foreach(void (*fn)(callstats_t *, void *), void *data) {
+  callstats_t *cs;
+  Wait_Acquire_slock(callstats_list_l);
+  for (cs = callstats_list; cs != NULL; cs = cs->next) {
+    Wait_Acquire_slock(cs->lock);
+    fn(cs, data);
+    Release_slock(cs->lock);
+  }
+  Release_slock(callstats_list_l);
+}
+
+static void callstats__restart_one(callstats_t *cs, void *data) {
+  cs->countdown = callstats_period;
+  cs->last_pred = NULL;
+}
+
+static void callstats__reset_one(callstats_t *cs, void *data) {
+  intmach_t i;
+  for (i = 0; i < cs->size; i++) {
+    cs->table[i].calls = 0;
+    cs->table[i].time = 0;
+  }
+  cs->last_pred = NULL;
+}
+
+typedef struct callstats_merge_ callstats_merge_t;
+struct callstats_merge_ {
+  intmach_t size;
+  intmach_t count;
+  callstats_entry_t *table;
+};
+
+static void callstats__merge_one(callstats_t *cs, void *data) {
+  callstats_merge_t *m = (callstats_merge_t *)data;
+  intmach_t i;
+  for (i = 0; i < cs->size; i++) {
+    callstats_entry_t *e = &cs->table[i];
+    callstats_entry_t *me;
+    if (e->pred == NULL || e->calls == 0) continue;
+    if ((m->count+1)*4 > m->size*3) {
+      intmach_t j;
+      intmach_t size = m->size<<1;
+      callstats_entry_t *table = callstats__alloc_table(size);
+      for (j = 0; j < m->size; j++) {
+        if (m->table[j].pred != NULL) {
+          *callstats__find(table, size, m->table[j].pred) = m->table[j];
+        }
+      }
+      checkdealloc_ARRAY(callstats_entry_t, m->size, m->table);
+      m->table = table;
+      m->size = size;
+    }
+    me = callstats__find(m->table, m->size, e->pred);
+    if (me->pred == NULL) {
+      me->pred = e->pred;
+      m->count++;
+    }
+    me->calls += e->calls;
+    me->time += e->time;
+  }
+}
+
+static int callstats__compare(const void *arg1, const void *arg2) {
+  const callstats_entry_t *e1 = (const callstats_entry_t *)arg1;
+  const callstats_entry_t *e2 = (const callstats_entry_t *)arg2;
+  /* decreasing number of calls, entries with no pred at the end */
+  if (e1->calls > e2->calls) return -1;
+  if (e1->calls < e2->calls) return 1;
+  return 0;
+}
+
+/* '$callstats_set'(+Flags, +Period) */
+CBOOL__PROTO(prolog_callstats_set) {
+  tagged_t x, y;
+  DEREF(x,X(0));
+  DEREF(y,X(1));
+  if (!TaggedIsSmall(x) || !TaggedIsSmall(y)) return FALSE;
+  if (GetSmall(y) < 1) return FALSE;
+  callstats_flags = 0;
+  callstats_period = GetSmall(y);
+  callstats__foreach(callstats__restart_one, NULL);
+  callstats_flags = GetSmall(x);
+  CBOOL__PROCEED;
+}
+
+/* '$callstats_get'(-Flags, -Period) */
+CBOOL__PROTO(prolog_callstats_get) {
+  CBOOL__CALL(cunify, MakeSmall(callstats_flags), X(0));
+  CBOOL__LASTUNIFY(MakeSmall(callstats_period), X(1));
+}
+
+/* '$callstats_reset' */
+CBOOL__PROTO(prolog_callstats_reset) {
+  callstats__foreach(callstats__reset_one, NULL);
+  CBOOL__PROCEED;
+}
+
+/* Heap cells for each element of the list (assuming boxed integers) */
+#define CALLSTATS_ELEM_CELLS (LSTCELLS+3+3+3+3+3)
+
+/* '$callstats_top'(+N, -List): List is a list of Name/Arity-Calls-Time
+   (time in microseconds) for the N predicates with most calls, in
+   decreasing order. N=0 returns all the recorded predicates. */
+CBOOL__PROTO(prolog_callstats_top) {
+  tagged_t x, list, t;
+  intmach_t n, i;
+  callstats_merge_t m;
+
+  DEREF(x,X(0));
+  if (!TaggedIsSmall(x) || GetSmall(x) < 0) return FALSE;
+  n = GetSmall(x);
+
+  m.size = CALLSTATS_INITIAL_SIZE;
+  m.count = 0;
+  m.table = callstats__alloc_table(m.size);
+  callstats__foreach(callstats__merge_one, &m);
+
+  qsort(m.table, m.size, sizeof(callstats_entry_t), callstats__compare);
+  if (n == 0 || n > m.count) n = m.count;
+
+  TEST_HEAP_OVERFLOW(G->heap_top, n*CALLSTATS_ELEM_CELLS*sizeof(tagged_t)+CONTPAD, 2);
+  list = atom_nil;
+  for (i = n-1; i >= 0; i--) {
+    callstats_entry_t *e = &m.table[i];
+    tagged_t calls = IntmachToTagged(e->calls);
+    tagged_t time = IntmachToTagged((intmach_t)e->time);
+    tagged_t *h = G->heap_top;
+    HeapPush(h, functor_slash);
+    HeapPush(h, FuncName(e->pred));
+    HeapPush(h, MakeSmall(FuncArity(e->pred)));
+    HeapPush(h, functor_minus);
+    HeapPush(h, Tagp(STR, h-4));
+    HeapPush(h, calls);
+    HeapPush(h, functor_minus);
+    HeapPush(h, Tagp(STR, h-4));
+    HeapPush(h, time);
+    t = Tagp(STR, h-3);
+    G->heap_top = h;
+    MakeLST(list, t, list);
+  }
+  checkdealloc_ARRAY(callstats_entry_t, m.size, m.table);
+  CBOOL__LASTUNIFY(list, X(1));
+}
+#endif
@@ -76,6 +76,29 @@ CBOOL__PROTO(prolog_profile_flags_get);
 CBOOL__PROTO(prolog_profile_dump);
 CBOOL__PROTO(prolog_profile_reset);
 
+/* --------------------------------------------------------------------------- */
+/* Call statistics (available in all engines, disabled by default) */
+
+/* Note: keep in sync with table in profile.pl */
+#define CALLSTATS_FLAG_CALLS 0x1 /* count (sampled) calls */
+#define CALLSTATS_FLAG_TIME  0x2 /* measure rough walltime */
+
+extern volatile intmach_t callstats_flags;
+extern volatile intmach_t callstats_period;
+
+void init_callstats(void);
+bool_t callstats__get_opt(const char *arg);
+CVOID__PROTO(callstats__hook, definition_t *f);
+
+/* Disabled: a single (predicted) branch per call */
+#define PRED_CALLSTATS(Y) \
+  if (__builtin_expect(callstats_flags != 0, 0)) { CVOID__CALL(callstats__hook, (Y)); }
+
+CBOOL__PROTO(prolog_callstats_set);
+CBOOL__PROTO(prolog_callstats_get);
+CBOOL__PROTO(prolog_callstats_reset);
+CBOOL__PROTO(prolog_callstats_top);
+
 #endif /* !defined(OPTIM_COMP) */
 
 #endif /* _CIAO_ENG_PROFILE_H */
@@ -25,6 +25,10 @@
 
 #include <ciao/eng_registry.h>
 #include <ciao/eng_profile.h>
+#include <ciao/eng_evtrace.h>
+#include <ciao/eng_lockstat.h>
+#include <ciao/eng_heapsnap.h>
+#include <ciao/eng_numvec.h>
 
 /* (only for registering) */
 #include <ciao/rune.h>
@@ -130,6 +134,9 @@ SLOCK    worker_id_pool_l;
    identifiers.  */
 SLOCK    atom_id_l;
 
+/* Count for new global variable ids (see internals.c) */
+SLOCK    gvar_ids_l;
+
 bool_t in_abort_context = FALSE;
 
 /* Event Tracing Flags etc */
@@ -241,6 +248,9 @@ tagged_t functor_Dhandler;
 tagged_t functor_Dsetarg;
 tagged_t functor_Dsetargstr;
 tagged_t functor_large;
+tagged_t functor_rat;
+tagged_t functor_plus;
+tagged_t functor_times;
 tagged_t functor_long;
 
 tagged_t functor_active;
@@ -273,11 +283,11 @@ try_node_t *address_nd_fake_choicept;
 tagged_t functor_forward_trail;
 double trail_time;
 tagged_t *global_table;
-tagged_t *tabling_stack;
+__thread tagged_t *tabling_stack;
 tagged_t *global_table_free;
-tagged_t *tabling_stack_free;
+__thread tagged_t *tabling_stack_free;
 tagged_t *global_table_end;
-tagged_t *tabling_stack_end;
+__thread tagged_t *tabling_stack_end;
 #endif
 
 #if defined(PARBACK)
@@ -466,6 +476,7 @@ intmach_t lookup_atom_idx(char *str) {
                                 count,
                                 2*count,
                                 (tagged_t *)atmtab);
+    MEMCAT_INC(MEMCAT_ATOMS, count*sizeof(hashtab_node_t *));
 
 #if defined(ATOMGC)      /* Clean up the upper part of the new atom table */
     for (i = count; i < 2*count; i++)
@@ -473,6 +484,7 @@ intmach_t lookup_atom_idx(char *str) {
     new_table->next_index = count;
 #endif
 
+    MEMCAT_DEC(MEMCAT_HASHTAB, HASHTAB_CHARSIZE(size));
     checkdealloc_FLEXIBLE(hashtab_t,
                           hashtab_node_t,
                           size,
@@ -669,6 +681,7 @@ atom_t *new_atom_check(char *str,
   prolog_chars = (char *)ALIGN_TO(sizeof(tagged_t), (uintptr_t)prolog_chars);
   if (prolog_chars+len > prolog_chars_end) {             /* Out of bounds */
     prolog_chars = checkalloc_ARRAY(char, MAX(MIN_MEM_CHUNK_SIZE, len));
+    MEMCAT_INC(MEMCAT_ATOMS, MAX(MIN_MEM_CHUNK_SIZE, len));
     prolog_chars_end = prolog_chars + MAX(MIN_MEM_CHUNK_SIZE, len);
   }
   
@@ -793,7 +806,7 @@ definition_t *define_c_mod_predicate(char *module,
   mod_tagpname = GET_ATOM(mod_pname);
   key = SetArity(mod_tagpname, arity);
 
-  Wait_Acquire_slock(prolog_predicates_l);
+  Wait_Acquire_slock_stat(prolog_predicates_l, LOCKSTAT_PREDICATES);
 
   keyval = (hashtab_node_t *)hashtab_get(prolog_predicates,key);
 
@@ -920,6 +933,7 @@ void init_locks(void){
   Init_slock(mem_mng_l);
   Init_slock(worker_id_pool_l);
   Init_slock(atom_id_l);
+  Init_slock(gvar_ids_l);
   Init_slock(wam_list_l);
 
 #if defined(ANDPARALLEL)
@@ -966,6 +980,10 @@ CBOOL__PROTO(prolog_unifyOC);
 /* internals.c */
 CBOOL__PROTO(prolog_global_vars_set_root);
 CBOOL__PROTO(prolog_global_vars_get_root);
+CBOOL__PROTO(prolog_gvar);
+CBOOL__PROTO(prolog_gvar_keys);
+CBOOL__PROTO(prolog_gvar_released);
+CBOOL__PROTO(prolog_sample);
 CBOOL__PROTO(prompt);
 CBOOL__PROTO(unknown);
 CBOOL__PROTO(setarg);
@@ -1043,6 +1061,8 @@ CBOOL__PROTO(prolog_format_print_float);
 CBOOL__PROTO(prolog_format_print_integer);
 CBOOL__PROTO(raw_copy_stdout);
 CBOOL__PROTO(prolog_set_unbuf);
+CBOOL__PROTO(prolog_copy_stream);
+CBOOL__PROTO(prolog_read_bytes);
 CBOOL__PROTO(prolog_input_wait);
 /* arithmetic.c */
 CBOOL__PROTO(bu2_numeq, tagged_t x0, tagged_t x1);
@@ -1085,10 +1105,15 @@ CFUN__PROTO(fu1_sqrt, tagged_t, tagged_t x0);
 CFUN__PROTO(fu1_sin, tagged_t, tagged_t x0);
 CFUN__PROTO(fu1_cos, tagged_t, tagged_t x0);
 CFUN__PROTO(fu1_atan, tagged_t, tagged_t x0);
+CFUN__PROTO(fu2_rdiv, tagged_t, tagged_t x0, tagged_t x1);
+CFUN__PROTO(fu1_rational, tagged_t, tagged_t x0);
+CFUN__PROTO(fu1_rationalize, tagged_t, tagged_t x0);
 CBOOL__PROTO(prolog_lsb);
 CBOOL__PROTO(prolog_msb);
 CBOOL__PROTO(prolog_popcount);
 CBOOL__PROTO(prolog_getbit);
+CBOOL__PROTO(prolog_linear_add);
+CBOOL__PROTO(prolog_linear_rows);
 /* term_compare.c */
 CBOOL__PROTO(bu2_lexeq, tagged_t x0, tagged_t x1);
 CBOOL__PROTO(bu2_lexge, tagged_t x0, tagged_t x1);
@@ -1155,6 +1180,7 @@ CBOOL__PROTO(prolog_unlock_predicate_x);
 /* system.c */
 CBOOL__PROTO(prolog_using_windows);
 CBOOL__PROTO(prolog_exec);
+CBOOL__PROTO(prolog_process_pump);
 CBOOL__PROTO(prolog_wait);
 CBOOL__PROTO(prolog_kill);
 CBOOL__PROTO(prolog_unix_cd);
@@ -1275,6 +1301,10 @@ static void define_functions(void)
   deffunction_nobtin("sin",1,(void *)fu1_sin);
   deffunction_nobtin("cos",1,(void *)fu1_cos);
   deffunction_nobtin("atan",1,(void *)fu1_atan);
+  deffunction_nobtin("rdiv",2,(void *)fu2_rdiv);
+  deffunction_nobtin("rat",2,(void *)fu2_rdiv); /* (non-canonical rat/2) */
+  deffunction_nobtin("rational",1,(void *)fu1_rational);
+  deffunction_nobtin("rationalize",1,(void *)fu1_rationalize);
 
   /* 41 & 42 are 68 & 79 in SICStus 2.1 */
   deffunction("ARG FUNCTION",2,(void *)fu2_arg,41);
@@ -1293,6 +1323,7 @@ void init_once(void) {
 
   i = eng_cfg_getenv("ATMTABSIZE",ATMTABSIZE);
   atmtab = checkalloc_ARRAY(hashtab_node_t *, i);
+  MEMCAT_INC(MEMCAT_ATOMS, i*sizeof(hashtab_node_t *));
 
   ciao_atoms = new_switch_on_key(2*i,NULL);
 
@@ -1439,8 +1470,13 @@ void init_once(void) {
   functor_Dsetarg = deffunctor("internals:$setarg",4);
   functor_Dsetargstr = deffunctor("$$$setargstr$$$",1); // (users should not create this!)
   functor_large = deffunctor("large",2);
+  functor_rat = deffunctor("rat",2);
+  functor_plus = deffunctor("+",2);
+  functor_times = deffunctor("*",2);
   functor_long = deffunctor("long",1);
 
+  init_numvec();
+
 
   functor_active = deffunctor("active", 4);
   functor_pending = deffunctor("pending", 4);
@@ -1549,6 +1585,10 @@ void init_once(void) {
   define_c_mod_predicate("internals","$set_property",2,set_property);
   define_c_mod_predicate("internals","$global_vars_get_root", 1, prolog_global_vars_get_root);
   define_c_mod_predicate("internals","$global_vars_set_root", 1, prolog_global_vars_set_root);
+  define_c_mod_predicate("internals","$gvar", 4, prolog_gvar);
+  define_c_mod_predicate("internals","$gvar_keys", 2, prolog_gvar_keys);
+  define_c_mod_predicate("internals","$gvar_released", 1, prolog_gvar_released);
+  define_c_mod_predicate("internals","$sample", 2, prolog_sample);
 #if defined(ATOMGC)
   define_c_mod_predicate("internals","$erase_atom", 1, prolog_erase_atom);
 #endif
@@ -1608,6 +1648,8 @@ void init_once(void) {
   define_c_mod_predicate("compressed_bytecode","copyLZ",1,raw_copy_stdout); /* TODO: remove on next bootstrap promotion */
   define_c_mod_predicate("io_basic","$raw_copy_stdout",1,raw_copy_stdout);
   define_c_mod_predicate("io_basic","$set_unbuf",1,prolog_set_unbuf);
+  define_c_mod_predicate("io_basic","$copy_stream",3,prolog_copy_stream);
+  define_c_mod_predicate("io_basic","$read_bytes",3,prolog_read_bytes);
   define_c_mod_predicate("io_basic","$input_wait",3,prolog_input_wait);
   define_c_mod_predicate("io_basic","$format_print_float",3,prolog_format_print_float);
   define_c_mod_predicate("io_basic","$format_print_integer",3,prolog_format_print_integer);
@@ -1629,6 +1671,29 @@ void init_once(void) {
   define_c_mod_predicate("internals","$profile_flags_set",1,prolog_profile_flags_set);
   define_c_mod_predicate("internals","$profile_dump",0,prolog_profile_dump);
   define_c_mod_predicate("internals","$profile_reset",0,prolog_profile_reset);
+  define_c_mod_predicate("internals","$callstats_set",2,prolog_callstats_set);
+  define_c_mod_predicate("internals","$callstats_get",2,prolog_callstats_get);
+  define_c_mod_predicate("internals","$callstats_reset",0,prolog_callstats_reset);
+  define_c_mod_predicate("internals","$callstats_top",2,prolog_callstats_top);
+
+                                /* eng_evtrace.h */
+
+  define_c_mod_predicate("internals","$evtrace_start",1,prolog_evtrace_start);
+  define_c_mod_predicate("internals","$evtrace_stop",0,prolog_evtrace_stop);
+  define_c_mod_predicate("internals","$evtrace_event",3,prolog_evtrace_event);
+  define_c_mod_predicate("internals","$evtrace_dump",1,prolog_evtrace_dump);
+
+                                /* eng_heapsnap.h */
+
+  define_c_mod_predicate("internals","$heap_snapshot",1,prolog_heap_snapshot);
+  define_c_mod_predicate("internals","$heap_snapshot_analyze",5,prolog_heap_snapshot_analyze);
+
+                                /* eng_numvec.h */
+
+  define_c_mod_predicate("internals","$numvec_new",3,prolog_numvec_new);
+  define_c_mod_predicate("internals","$list_to_numvec",3,prolog_list_to_numvec);
+  define_c_mod_predicate("internals","$numvec_to_list",2,prolog_numvec_to_list);
+  define_c_mod_predicate("internals","$numvec_get",3,prolog_numvec_get);
 
                                 /* qread.c */
 
@@ -1651,6 +1716,7 @@ void init_once(void) {
   define_c_mod_predicate("system","fd_dup",2,prolog_fd_dup);
   define_c_mod_predicate("system","fd_close",1,prolog_fd_close);
   define_c_mod_predicate("internals","$exec",9,prolog_exec);
+  define_c_mod_predicate("internals","$process_pump",6,prolog_process_pump);
   define_c_mod_predicate("system","wait",2,prolog_wait);
   define_c_mod_predicate("system","kill",2,prolog_kill);
   define_c_mod_predicate("internals","$unix_argv",1,prolog_unix_argv);
@@ -1734,6 +1800,7 @@ void init_once(void) {
   define_c_mod_predicate("internals","$program_usage",1,program_usage);
   define_c_mod_predicate("internals","$internal_symbol_usage",1,internal_symbol_usage);
   define_c_mod_predicate("internals","$total_usage",1,total_usage);
+  define_c_mod_predicate("internals","$memory_report",4,prolog_memory_report);
 
   /* eng_gc.c */
   define_c_mod_predicate("internals","$termheap_usage",1,termheap_usage);
@@ -1741,6 +1808,7 @@ void init_once(void) {
   define_c_mod_predicate("internals","$trail_usage",1,trail_usage);
   define_c_mod_predicate("internals","$choice_usage",1,choice_usage);
   define_c_mod_predicate("internals","$stack_shift_usage",1,stack_shift_usage);
+  define_c_mod_predicate("internals","$lockstat_usage",1,prolog_lockstat_usage);
   define_c_mod_predicate("internals","$gc_mode",2,gc_mode);
   define_c_mod_predicate("internals","$gc_trace",2,gc_trace);
   define_c_mod_predicate("internals","$gc_margin",2,gc_margin);
@@ -1784,6 +1852,8 @@ void init_once(void) {
   define_c_mod_predicate("arithmetic","$msb",2,prolog_msb);
   define_c_mod_predicate("arithmetic","$popcount",2,prolog_popcount);
   define_c_mod_predicate("arithmetic","$getbit",3,prolog_getbit);
+  define_c_mod_predicate("arithmetic","$linear_add",6,prolog_linear_add);
+  define_c_mod_predicate("arithmetic","$linear_rows",3,prolog_linear_rows);
 
   /* concurrency.c */
   define_c_mod_predicate("concurrency","$eng_call",6,prolog_eng_call);
@@ -1794,6 +1864,9 @@ void init_once(void) {
   define_c_mod_predicate("concurrency","$eng_kill",1,prolog_eng_kill);
   define_c_mod_predicate("concurrency","$eng_killothers",0,prolog_eng_killothers);
   define_c_mod_predicate("concurrency","$eng_status",0,prolog_eng_status);
+  define_c_mod_predicate("concurrency","$lockstat_set",1,prolog_lockstat_set);
+  define_c_mod_predicate("concurrency","$lockstat_get",1,prolog_lockstat_get);
+  define_c_mod_predicate("concurrency","$lockstat_reset",0,prolog_lockstat_reset);
   define_c_mod_predicate("concurrency","$eng_self",2,prolog_eng_self);
   define_c_mod_predicate("concurrency","lock_atom",1,prolog_lock_atom);
   define_c_mod_predicate("concurrency","unlock_atom",1,prolog_unlock_atom);
@@ -1882,6 +1955,8 @@ CVOID__PROTO(local_init_each_time) {
     w->heap_top = ptr;
     GLOBAL_VARS_ROOT = Tagp(STR,ptr2);
   }
+  /* (keys from a previous thread or execution are forgotten) */
+  release_gvars(Arg);
 #endif
 
   /* Setup initial frame */
@@ -1981,7 +2056,7 @@ SLOCK    wam_list_l;
 worker_t *free_wam(void) {
   worker_t *free_wam;
 
-  Wait_Acquire_slock(wam_list_l);
+  Wait_Acquire_slock_stat(wam_list_l, LOCKSTAT_WAM_LIST);
   if (wam_list) {
     free_wam = wam_list;
     wam_list = Next_Worker(free_wam);
@@ -1997,7 +2072,7 @@ worker_t *free_wam(void) {
 CVOID__PROTO(release_wam)
 {
   local_init_each_time(Arg);
-  Wait_Acquire_slock(wam_list_l);
+  Wait_Acquire_slock_stat(wam_list_l, LOCKSTAT_WAM_LIST);
   Next_Worker(Arg) = wam_list;
   wam_list = Arg;
   Release_slock(wam_list_l);
@@ -2071,6 +2146,13 @@ worker_t *create_wam_storage(void) {
 
   w = checkalloc_FLEXIBLE(worker_t, tagged_t, reg_bank_size);
   w->misc = checkalloc_TYPE(misc_info_t);
+  w->misc->callstats = NULL;
+  w->misc->gvars = NULL;
+  w->misc->gvars_count = 0;
+  w->misc->samples = NULL;
+#if defined(TABLING)
+  w->misc->last_node_tr = NULL; /* (initialized on first tabled call) */
+#endif
   w->streams = checkalloc_TYPE(io_streams_t);
   w->debugger_info = checkalloc_TYPE(debugger_state_t);
 
@@ -2256,3 +2338,129 @@ CBOOL__PROTO(total_usage)
   CBOOL__LASTUNIFY(X(0),x);
 }
 
+/* Memory used by the code of a predicate (clauses, indices, and
+   auxiliary structures), computed on demand */
+static intmach_t pred_mem_usage(definition_t *d) {
+  intmach_t size = 0;
+  if (d->predtyp == ENTER_INTERPRETED) {
+    int_info_t *root = d->code.intinfo;
+    instance_t *i;
+    if (root == NULL) return 0;
+    size += sizeof(int_info_t);
+    Cond_Begin(root->clause_insertion_cond);
+    for (i = root->first; i != NULL; i = i->forward) {
+      size += i->objsize;
+    }
+    if (root->indexer != NULL) {
+      size += HASHTAB_CHARSIZE(HASHTAB_SIZE(root->indexer));
+    }
+    Release_Cond_lock(root->clause_insertion_cond);
+  } else if (d->predtyp <= ENTER_FASTCODE_INDEXED) {
+    incore_info_t *info = d->code.incoreinfo;
+    emul_info_t *cl;
+    if (info == NULL) return 0;
+    size += sizeof(incore_info_t);
+    for (cl = info->clauses; cl != NULL; cl = cl->next) {
+      size += cl->objsize;
+    }
+    if (info->othercase != NULL) {
+      size += HASHTAB_CHARSIZE(HASHTAB_SIZE(info->othercase));
+    }
+  }
+  return size;
+}
+
+typedef struct pred_mem_ pred_mem_t;
+struct pred_mem_ {
+  definition_t *pred;
+  intmach_t size;
+};
+
+static int pred_mem_compare(const void *arg1, const void *arg2) {
+  const pred_mem_t *e1 = (const pred_mem_t *)arg1;
+  const pred_mem_t *e2 = (const pred_mem_t *)arg2;
+  /* decreasing size */
+  if (e1->size > e2->size) return -1;
+  if (e1->size < e2->size) return 1;
+  return 0;
+}
+
+/* Heap cells for each element of the lists (assuming boxed integers) */
+#define MEMREPORT_ELEM_CELLS (LSTCELLS+3+3+4)
+
+/* '$memory_report'(-Total, -Live, -Categories, -Predicates): Total is
+   the memory obtained from the OS, Live the memory currently
+   allocated, Categories a list of Category-Bytes, and Predicates a
+   list of Name/Arity-Bytes (in decreasing order) for predicates with
+   code. The "other" category is what is not attributed to any of the
+   rest (e.g., memory areas of workers, temporary buffers). */
+CBOOL__PROTO(prolog_memory_report) {
+  tagged_t list, t;
+  tagged_t *h;
+  hashtab_t *table;
+  pred_mem_t *preds;
+  intmach_t cats[MEMCAT_N];
+  intmach_t live, n, count, j, i;
+
+  /* Categories (snapshot) */
+  live = mem_live_count;
+  cats[MEMCAT_OTHER] = live;
+  for (i = 1; i < MEMCAT_N; i++) {
+    cats[i] = mem_cat_count[i];
+    cats[MEMCAT_OTHER] -= cats[i];
+  }
+  if (cats[MEMCAT_OTHER] < 0) cats[MEMCAT_OTHER] = 0;
+
+  /* Predicates */
+  Wait_Acquire_slock_stat(prolog_predicates_l, LOCKSTAT_PREDICATES);
+  table = *predicates_location;
+  n = HASHTAB_SIZE(table);
+  preds = checkalloc_ARRAY(pred_mem_t, n);
+  count = 0;
+  for (j = 0; j < n; j++) {
+    definition_t *d = (definition_t *)table->node[j].value.as_ptr;
+    intmach_t size;
+    if (d == NULL || d->predtyp == ENTER_UNDEFINED) continue;
+    size = pred_mem_usage(d);
+    if (size == 0) continue;
+    preds[count].pred = d;
+    preds[count].size = size;
+    count++;
+  }
+  Release_slock(prolog_predicates_l);
+  qsort(preds, count, sizeof(pred_mem_t), pred_mem_compare);
+
+  TEST_HEAP_OVERFLOW(G->heap_top, (count+MEMCAT_N)*MEMREPORT_ELEM_CELLS*sizeof(tagged_t)+CONTPAD, 4);
+
+  list = atom_nil;
+  for (i = count-1; i >= 0; i--) {
+    t = IntmachToTagged(preds[i].size);
+    h = G->heap_top;
+    HeapPush(h, functor_slash);
+    HeapPush(h, FuncName(preds[i].pred));
+    HeapPush(h, MakeSmall(FuncArity(preds[i].pred)));
+    HeapPush(h, functor_minus);
+    HeapPush(h, Tagp(STR, h-4));
+    HeapPush(h, t);
+    G->heap_top = h;
+    MakeLST(list, Tagp(STR, h-3), list);
+  }
+  checkdealloc_ARRAY(pred_mem_t, n, preds);
+  CBOOL__CALL(cunify, list, X(3));
+
+  list = atom_nil;
+  for (i = MEMCAT_N-1; i >= 0; i--) {
+    t = IntmachToTagged(cats[i]);
+    h = G->heap_top;
+    HeapPush(h, functor_minus);
+    HeapPush(h, GET_ATOM((char *)mem_cat_name[i]));
+    HeapPush(h, t);
+    G->heap_top = h;
+    MakeLST(list, Tagp(STR, h-3), list);
+  }
+  CBOOL__CALL(cunify, list, X(2));
+
+  CBOOL__CALL(cunify, IntmachToTagged(total_mem_count), X(0));
+  CBOOL__LASTUNIFY(IntmachToTagged(live), X(1));
+}
+
@@ -32,6 +32,7 @@ CBOOL__PROTO(program_usage);
 CBOOL__PROTO(internal_symbol_usage);
 CBOOL__PROTO(statistics);
 CBOOL__PROTO(total_usage);
+CBOOL__PROTO(prolog_memory_report);
 worker_t *create_wam_storage(void);
 CVOID__PROTO(create_wam_areas);
 CVOID__PROTO(reinitialize_wam_areas);
@@ -14,6 +14,7 @@
 #include <ciao/eng_start.h>
 #include <ciao/qread.h>
 #include <ciao/eng_profile.h>
+#include <ciao/eng_lockstat.h>
 #include <ciao/timing.h>
 #endif
 #include <ciao/os_defs.h>
@@ -220,6 +221,8 @@ void engine_set_opts(const char **optv, int optc, const char **boot_path) {
 #if defined(ABSMACH_OPT__profilecc) || defined(ABSMACH_OPT__profile_calls)
     } else if (profile__get_opt(optv[i])) { /* Profile option */
 #endif
+    } else if (callstats__get_opt(optv[i])) { /* Call statistics option */
+    } else if (lockstat__get_opt(optv[i])) { /* Lock statistics option */
 #if defined(DEBUG_TRACE)
     } else if (debug_trace__get_opt(optv[i])) { /* Debug trace option */
 #endif
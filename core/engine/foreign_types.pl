@@ -372,6 +372,91 @@
     from_c      = ciao_mk_c_double_list,
     compound    = yes ]).
 
+:- ttr_match(in_c_int8_vec, (c_int8_vec, ground, ground)).
+:- ttr_match(go_c_int8_vec, (c_int8_vec, term, ground)).
+:- ttr_def(in_c_int8_vec, [
+    ctype_decl  = pointer(int8_t),
+    ctype_call  = pointer(int8_t),
+    check       = ciao_is_c_int8_vec,
+    exception   = usage_fault("foreign interface: numeric vector of the wrong type (needed $numvec/3)"),
+    to_c        = ciao_get_c_int8_vec ]).
+:- ttr_def(go_c_int8_vec, [
+    ctype_decl  = pointer(int8_t),
+    ctype_res   = pointer(int8_t),
+    ctype_call  = pointer(pointer(int8_t)),
+    call_cref   = yes,
+    from_c      = ciao_mk_c_int8_vec,
+    free        = ciao_free,
+    compound    = yes ]).
+
+:- ttr_match(in_c_int16_vec, (c_int16_vec, ground, ground)).
+:- ttr_match(go_c_int16_vec, (c_int16_vec, term, ground)).
+:- ttr_def(in_c_int16_vec, [
+    ctype_decl  = pointer(int16_t),
+    ctype_call  = pointer(int16_t),
+    check       = ciao_is_c_int16_vec,
+    exception   = usage_fault("foreign interface: numeric vector of the wrong type (needed $numvec/3)"),
+    to_c        = ciao_get_c_int16_vec ]).
+:- ttr_def(go_c_int16_vec, [
+    ctype_decl  = pointer(int16_t),
+    ctype_res   = pointer(int16_t),
+    ctype_call  = pointer(pointer(int16_t)),
+    call_cref   = yes,
+    from_c      = ciao_mk_c_int16_vec,
+    free        = ciao_free,
+    compound    = yes ]).
+
+:- ttr_match(in_c_int32_vec, (c_int32_vec, ground, ground)).
+:- ttr_match(go_c_int32_vec, (c_int32_vec, term, ground)).
+:- ttr_def(in_c_int32_vec, [
+    ctype_decl  = pointer(int32_t),
+    ctype_call  = pointer(int32_t),
+    check       = ciao_is_c_int32_vec,
+    exception   = usage_fault("foreign interface: numeric vector of the wrong type (needed $numvec/3)"),
+    to_c        = ciao_get_c_int32_vec ]).
+:- ttr_def(go_c_int32_vec, [
+    ctype_decl  = pointer(int32_t),
+    ctype_res   = pointer(int32_t),
+    ctype_call  = pointer(pointer(int32_t)),
+    call_cref   = yes,
+    from_c      = ciao_mk_c_int32_vec,
+    free        = ciao_free,
+    compound    = yes ]).
+
+:- ttr_match(in_c_int64_vec, (c_int64_vec, ground, ground)).
+:- ttr_match(go_c_int64_vec, (c_int64_vec, term, ground)).
+:- ttr_def(in_c_int64_vec, [
+    ctype_decl  = pointer(int64_t),
+    ctype_call  = pointer(int64_t),
+    check       = ciao_is_c_int64_vec,
+    exception   = usage_fault("foreign interface: numeric vector of the wrong type (needed $numvec/3)"),
+    to_c        = ciao_get_c_int64_vec ]).
+:- ttr_def(go_c_int64_vec, [
+    ctype_decl  = pointer(int64_t),
+    ctype_res   = pointer(int64_t),
+    ctype_call  = pointer(pointer(int64_t)),
+    call_cref   = yes,
+    from_c      = ciao_mk_c_int64_vec,
+    free        = ciao_free,
+    compound    = yes ]).
+
+:- ttr_match(in_c_double_vec, (c_double_vec, ground, ground)).
+:- ttr_match(go_c_double_vec, (c_double_vec, term, ground)).
+:- ttr_def(in_c_double_vec, [
+    ctype_decl  = pointer(double),
+    ctype_call  = pointer(double),
+    check       = ciao_is_c_double_vec,
+    exception   = usage_fault("foreign interface: numeric vector of the wrong type (needed $numvec/3)"),
+    to_c        = ciao_get_c_double_vec ]).
+:- ttr_def(go_c_double_vec, [
+    ctype_decl  = pointer(double),
+    ctype_res   = pointer(double),
+    ctype_call  = pointer(pointer(double)),
+    call_cref   = yes,
+    from_c      = ciao_mk_c_double_vec,
+    free        = ciao_free,
+    compound    = yes ]).
+
 :- ttr_match(go_any_term, (any_term, term, ground)).
 :- ttr_def(go_any_term, [
     ctype_decl  = ciao_term,
@@ -16,6 +16,8 @@
 %   8 - exceptions.pl (intercept/send_signal)
 %   10 - CHR package (chr/hprolog.pl)
 %   11 - global_vars module
+%   12 - rtchecks_rt module (memo of checked terms)
+%   13 - rtchecks_send module (stack of calls)
 % ---------------------------------------------------------------------------
 
 % NOTE: It is possible to replace '$setarg'/4 by attributed varibles.
@@ -40,6 +42,20 @@
 :- impl_defined('$global_vars_set_root'/1). % TODO: deprecate
 :- endif.
 
+% Keys of global variables (see library(global_vars))
+:- export('$gvar'/4). % internal predicate
+:- export('$gvar_keys'/2). % internal predicate
+:- export('$gvar_released'/1). % internal predicate
+:- if(defined(optim_comp)).
+:- '$props'('$gvar'/4, [impnat=cbool(prolog_gvar)]).
+:- '$props'('$gvar_keys'/2, [impnat=cbool(prolog_gvar_keys)]).
+:- '$props'('$gvar_released'/1, [impnat=cbool(prolog_gvar_released)]).
+:- else.
+:- impl_defined('$gvar'/4).
+:- impl_defined('$gvar_keys'/2).
+:- impl_defined('$gvar_released'/1).
+:- endif.
+
 % naive implementation of mutable variables based on setarg
 % TODO: I could place mutable type info here
 % :- export('$mutvar_init'/2).
@@ -28,6 +28,7 @@
 #include <ciao/eng_gc.h>
 #include <ciao/timing.h>
 #include <ciao/eng_profile.h>
+#include <ciao/eng_evtrace.h>
 
 CBOOL__PROTO(stack_shift_usage);
 CBOOL__PROTO(termheap_usage);
@@ -279,6 +280,7 @@ module_t *new_module(tagged_t mod_atm)
   module_t *mod;
 
   mod = checkalloc_TYPE(module_t);
+  MEMCAT_INC(MEMCAT_PREDS, sizeof(module_t));
   mod->printname = mod_atm;
   mod->properties.is_static = FALSE;
   return mod;
@@ -338,6 +340,7 @@ definition_t *new_functor(tagged_t tagpname, int arity)
     */
 
   func = checkalloc_TYPE(definition_t);
+  MEMCAT_INC(MEMCAT_PREDS, sizeof(definition_t));
   /* Initialize all fields to 0 */
   for (i=0; i<sizeof(definition_t); i++) {
     ((char *)func)[i] = 0;
@@ -584,6 +587,7 @@ static void incore_insert(try_node_t **t0,
 
   /* Init the try_node to insert. */
   t = checkalloc_TYPE(try_node_t);
+  MEMCAT_INC(MEMCAT_CODE, sizeof(try_node_t));
   t->arity = effar;
 
   /* Last "next" is num. of clauses: we are inserting at the end of the chain */
@@ -620,6 +624,7 @@ static try_node_t *incore_copy(try_node_t *from)
     copy = fail_alt;
   } else {
     copy = t = checkalloc_TYPE(try_node_t);
+    MEMCAT_INC(MEMCAT_CODE, sizeof(try_node_t));
     t->arity = from->arity;
     t->clause = from->clause;
     t->emul_p = from->emul_p;
@@ -631,6 +636,7 @@ static try_node_t *incore_copy(try_node_t *from)
     while (!TRY_NODE_IS_NULL(from)) {
       t0 = t;
       t0->next = t = checkalloc_TYPE(try_node_t);
+      MEMCAT_INC(MEMCAT_CODE, sizeof(try_node_t));
       t->arity = from->arity;
       t->clause = from->clause;
       t->emul_p = from->emul_p;
@@ -669,6 +675,7 @@ hashtab_t *new_switch_on_key(intmach_t size,
   hashtab_t *sw;
 
   sw = checkalloc_FLEXIBLE(hashtab_t, hashtab_node_t, size);
+  MEMCAT_INC(MEMCAT_HASHTAB, HASHTAB_CHARSIZE(size));
 
   sw->mask = SizeToMask(size);
   sw->count = 0;
@@ -701,6 +708,7 @@ void expand_sw_on_key(hashtab_t **psw,
   }
 
   if (deletep) {
+    MEMCAT_DEC(MEMCAT_HASHTAB, HASHTAB_CHARSIZE(size));
     checkdealloc_FLEXIBLE(hashtab_t,
                           hashtab_node_t,
                           size,
@@ -755,6 +763,7 @@ static void trychain_free(try_node_t *t) {
 
   for (t1=t; !TRY_NODE_IS_NULL(t1); t1=t2) {
     t2=t1->next;
+    MEMCAT_DEC(MEMCAT_CODE, sizeof(try_node_t));
     checkdealloc_TYPE(try_node_t, t1);
   }
 }
@@ -776,6 +785,7 @@ static void free_hashtab_trychain(hashtab_t *sw) {
     }
   }
 
+  MEMCAT_DEC(MEMCAT_HASHTAB, HASHTAB_CHARSIZE(size));
   checkdealloc_FLEXIBLE(hashtab_t,
                         hashtab_node_t,
                         size,
@@ -784,6 +794,7 @@ static void free_hashtab_trychain(hashtab_t *sw) {
 
 static void free_emulinfo(emul_info_t *cl)
 {
+  MEMCAT_DEC(MEMCAT_CODE, cl->objsize);
   checkdealloc_FLEXIBLE_S(emul_info_t, objsize, cl);
 }
 
@@ -796,6 +807,7 @@ static void incoreinfo_free(incore_info_t *p) {
     cl1 = cl->next;
     free_emulinfo(cl);
   }
+  MEMCAT_DEC(MEMCAT_CODE, sizeof(incore_info_t));
   checkdealloc_TYPE(incore_info_t, p);
 }
 
@@ -910,14 +922,17 @@ static void free_info(enter_instr_t enter_instr, char *info)
         for (n = int_info->first; n; n=m) {
           m=n->forward;
           n->rank = ERRORTAG;
+          MEMCAT_DEC(MEMCAT_DYNAMIC, n->objsize);
           checkdealloc_FLEXIBLE_S(instance_t, objsize, n);
         }
         
+        MEMCAT_DEC(MEMCAT_HASHTAB, HASHTAB_CHARSIZE(size));
         checkdealloc_FLEXIBLE(hashtab_t,
                               hashtab_node_t,
                               size,
                               int_info->indexer);
         
+        MEMCAT_DEC(MEMCAT_DYNAMIC, sizeof(int_info_t));
         checkdealloc_TYPE(int_info_t, info);
         break;
       }
@@ -925,6 +940,7 @@ static void free_info(enter_instr_t enter_instr, char *info)
       {
         hashtab_t *sw = (hashtab_t *)info;
         intmach_t size = HASHTAB_SIZE(sw);
+        MEMCAT_DEC(MEMCAT_HASHTAB, HASHTAB_CHARSIZE(size));
         checkdealloc_FLEXIBLE(hashtab_t,
                               hashtab_node_t,
                               size,
@@ -1052,6 +1068,7 @@ CBOOL__PROTO(define_predicate)
       incore_info_t *d;
       
       d = checkalloc_TYPE(incore_info_t);
+      MEMCAT_INC(MEMCAT_CODE, sizeof(incore_info_t));
       
       d->clauses = NULL;
       d->clauses_tail = &d->clauses;
@@ -1253,6 +1270,7 @@ void trychain_drain_marked(try_node_t **tfirst, tagged_t mark) {
         try_node_t *tnext;
         tnext = t->next;
         /* free the node */
+        MEMCAT_DEC(MEMCAT_CODE, sizeof(try_node_t));
         checkdealloc_TYPE(try_node_t, t);
         t = tnext; /* advance forward */
       } else {
@@ -1697,9 +1715,11 @@ THREAD_RES_T startgoal(THREAD_ARG wo)
            goal_desc, (intmach_t)X(0));
 #endif
 
+  EVTRACE(EVT_GOAL, EVT_PH_BEGIN, goal_desc->goal_number);
   wam(Arg, goal_desc);    /* segfault patch -- jf */
   w = goal_desc->worker_registers;
   wam_result = w->misc->exit_code;
+  EVTRACE(EVT_GOAL, EVT_PH_END, goal_desc->goal_number);
 
 #if defined(DEBUG_TRACE) && defined(USE_THREADS)
   if (debug_threads)
@@ -1832,6 +1852,195 @@ CBOOL__PROTO(prolog_global_vars_get_root) {
 }
 #endif
 
+/* --------------------------------------------------------------------------- */
+/* Keys of global variables (see library(global_vars)) */
+
+/* Each worker maps (Module, Key) pairs to entries in a table of
+   modules with a table of keys each (both indexed by atoms). The
+   values are not stored here: backtrackable values are kept in the
+   heap (at index 'slot' of the global variables area, which is dense
+   for each worker) and non-backtrackable values in the database
+   (under 'id', unique in the process). */
+
+struct gvar_ {
+  intmach_t slot;
+  intmach_t id;
+};
+
+static intmach_t gvar_last_id = 0; /* (shared, see gvar_ids_l) */
+
+/* Ids of the global variables of released workers, whose
+   non-backtrackable values are still in the database (see
+   '$gvar_released'/1) (shared, see gvar_ids_l) */
+static intmach_t *gvar_released = NULL;
+static intmach_t gvar_released_count = 0;
+static intmach_t gvar_released_size = 0;
+
+#define GVARS_TABLE_SIZE 8
+
+/* Free the table of global variables of the worker */
+CVOID__PROTO(release_gvars) {
+  hashtab_t *mods = w->misc->gvars;
+  hashtab_t *keys;
+  gvar_t *v;
+  intmach_t i, j;
+
+  if (mods == NULL) return;
+  Wait_Acquire_slock(gvar_ids_l);
+  for (i = HASHTAB_SIZE(mods)-1; i >= 0; i--) {
+    if (!mods->node[i].key) continue;
+    keys = (hashtab_t *)mods->node[i].value.as_ptr;
+    for (j = HASHTAB_SIZE(keys)-1; j >= 0; j--) {
+      if (!keys->node[j].key) continue;
+      v = (gvar_t *)keys->node[j].value.as_ptr;
+      if (gvar_released_count == gvar_released_size) {
+        if (gvar_released_size == 0) {
+          gvar_released_size = 32;
+          gvar_released = checkalloc_ARRAY(intmach_t, gvar_released_size);
+        } else {
+          gvar_released = checkrealloc_ARRAY(intmach_t, gvar_released_size,
+                                             2*gvar_released_size, gvar_released);
+          gvar_released_size *= 2;
+        }
+      }
+      gvar_released[gvar_released_count++] = v->id;
+      checkdealloc_TYPE(gvar_t, v);
+    }
+    checkdealloc_FLEXIBLE(hashtab_t, hashtab_node_t, HASHTAB_SIZE(keys), keys);
+  }
+  Release_slock(gvar_ids_l);
+  checkdealloc_FLEXIBLE(hashtab_t, hashtab_node_t, HASHTAB_SIZE(mods), mods);
+  w->misc->gvars = NULL;
+  w->misc->gvars_count = 0;
+}
+
+/* '$gvar_released'(-Ids): Ids is the list of ids of the global
+   variables released (by any worker) since the last call, so that
+   their non-backtrackable values can be removed */
+CBOOL__PROTO(prolog_gvar_released) {
+  intmach_t *ids;
+  intmach_t count, size, i;
+  tagged_t list;
+
+  Wait_Acquire_slock(gvar_ids_l);
+  ids = gvar_released;
+  count = gvar_released_count;
+  size = gvar_released_size;
+  gvar_released = NULL;
+  gvar_released_count = 0;
+  gvar_released_size = 0;
+  Release_slock(gvar_ids_l);
+
+  list = atom_nil;
+  if (ids != NULL) {
+    /* (ids may be bignums) */
+    TEST_HEAP_OVERFLOW(G->heap_top, count*(LSTCELLS+4)*sizeof(tagged_t)+CONTPAD, 1);
+    for (i = 0; i < count; i++) {
+      MakeLST(list, IntmachToTagged(ids[i]), list);
+    }
+    checkdealloc_ARRAY(intmach_t, size, ids);
+  }
+  CBOOL__LASTUNIFY(list, X(0));
+}
+
+/* '$gvar'(+Module, +Key, -Slot, -Id): Slot and Id of the global
+   variable Key of Module (created if needed). Fails if Key is not an
+   atom. */
+CBOOL__PROTO(prolog_gvar) {
+  hashtab_node_t *node;
+  hashtab_t **keys;
+  gvar_t *v;
+
+  DEREF(X(0), X(0));
+  DEREF(X(1), X(1));
+  if (!TaggedIsATM(X(0)) || !TaggedIsATM(X(1))) CBOOL__FAIL;
+
+  if (w->misc->gvars == NULL) {
+    w->misc->gvars = new_switch_on_key(GVARS_TABLE_SIZE, NULL);
+  }
+  node = hashtab_lookup(&w->misc->gvars, X(0));
+  if (node->value.as_ptr == NULL) {
+    node->value.as_ptr = new_switch_on_key(GVARS_TABLE_SIZE, NULL);
+  }
+  keys = (hashtab_t **)&node->value.as_ptr;
+  node = hashtab_lookup(keys, X(1));
+  v = (gvar_t *)node->value.as_ptr;
+  if (v == NULL) {
+    v = checkalloc_TYPE(gvar_t);
+    v->slot = ++w->misc->gvars_count;
+    Wait_Acquire_slock(gvar_ids_l);
+    v->id = ++gvar_last_id;
+    Release_slock(gvar_ids_l);
+    node->value.as_ptr = v;
+  }
+
+  CBOOL__UnifyCons(MakeSmall(v->slot), X(2));
+  CBOOL__LASTUNIFY(IntmachToTagged(v->id), X(3));
+}
+
+/* '$gvar_keys'(+Module, -Keys): Keys is the list of keys of the
+   global variables of Module (in no particular order) */
+CBOOL__PROTO(prolog_gvar_keys) {
+  hashtab_node_t *node;
+  hashtab_t *keys;
+  tagged_t list;
+  intmach_t i;
+
+  DEREF(X(0), X(0));
+  list = atom_nil;
+  if (TaggedIsATM(X(0)) && w->misc->gvars != NULL) {
+    node = hashtab_get(w->misc->gvars, X(0));
+    if (node->key) {
+      keys = (hashtab_t *)node->value.as_ptr;
+      ENSURE_HEAP_LST(keys->count, 2);
+      for (i = HASHTAB_SIZE(keys)-1; i >= 0; i--) {
+        if (!keys->node[i].key) continue;
+        MakeLST(list, keys->node[i].key, list);
+      }
+    }
+  }
+  CBOOL__LASTUNIFY(list, X(1));
+}
+
+/* ------------------------------------------------------------------------- */
+/* Sampling counters (see library(rtchecks/rtchecks_rt)) */
+
+/* Each worker keeps a counter for each key (indexed by atoms) */
+
+#define SAMPLES_TABLE_SIZE 8
+
+/* '$sample'(+Key, +N): succeeds on the first of every N calls with
+   the atom Key (always if N =< 1). The counters are not undone on
+   backtracking. */
+CBOOL__PROTO(prolog_sample) {
+  hashtab_node_t *node;
+  intmach_t *count;
+  intmach_t n;
+
+  DEREF(X(0), X(0));
+  DEREF(X(1), X(1));
+  if (!TaggedIsATM(X(0)) || !TaggedIsSmall(X(1))) CBOOL__FAIL;
+  n = GetSmall(X(1));
+  if (n <= 1) CBOOL__PROCEED;
+
+  if (w->misc->samples == NULL) {
+    w->misc->samples = new_switch_on_key(SAMPLES_TABLE_SIZE, NULL);
+  }
+  node = hashtab_lookup(&w->misc->samples, X(0));
+  count = (intmach_t *)node->value.as_ptr;
+  if (count == NULL) {
+    count = checkalloc_TYPE(intmach_t);
+    *count = 0;
+    node->value.as_ptr = count;
+  }
+  if (*count > 0) {
+    (*count)--;
+    CBOOL__FAIL;
+  }
+  *count = n - 1;
+  CBOOL__PROCEED;
+}
+
 /* ------------------------------------------------------------------------- */
 /* BUILTIN C PREDICATES */
 
@@ -48,6 +48,8 @@ CBOOL__PROTO(gc_mode);
 CBOOL__PROTO(gc_trace);
 CBOOL__PROTO(gc_margin);
 
+CVOID__PROTO(release_gvars);
+
 #define FLT64_ALIGNED_BLOB_SIZE (4*sizeof(tagged_t))
 
 typedef bignum_size_t (*bn_fun2_t)(bignum_t *x, bignum_t *y, bignum_t *z, bignum_t *zmax);
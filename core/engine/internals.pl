@@ -257,6 +257,61 @@ compiling_mode(unprofiled).
 
 :- export('$profile_reset'/0).
 :- impl_defined('$profile_reset'/0).
+
+:- export('$callstats_set'/2).
+:- trust pred '$callstats_set'(Flags, Period) : (int(Flags), int(Period)).
+:- impl_defined('$callstats_set'/2).
+
+:- export('$callstats_get'/2).
+:- trust pred '$callstats_get'(Flags, Period) => (int(Flags), int(Period)).
+:- impl_defined('$callstats_get'/2).
+
+:- export('$callstats_reset'/0).
+:- impl_defined('$callstats_reset'/0).
+
+:- export('$callstats_top'/2).
+:- trust pred '$callstats_top'(N, L) : int(N) => list(L).
+:- impl_defined('$callstats_top'/2).
+
+:- export('$evtrace_start'/1).
+:- trust pred '$evtrace_start'(Size) : int(Size).
+:- impl_defined('$evtrace_start'/1).
+
+:- export('$evtrace_stop'/0).
+:- impl_defined('$evtrace_stop'/0).
+
+:- export('$evtrace_event'/3).
+:- trust pred '$evtrace_event'(Ph, Name, Arg) : (atm(Ph), atm(Name), int(Arg)).
+:- impl_defined('$evtrace_event'/3).
+
+:- export('$evtrace_dump'/1).
+:- trust pred '$evtrace_dump'(File) : atm(File).
+:- impl_defined('$evtrace_dump'/1).
+
+:- export('$heap_snapshot'/1).
+:- trust pred '$heap_snapshot'(File) : atm(File).
+:- impl_defined('$heap_snapshot'/1).
+
+:- export('$heap_snapshot_analyze'/5).
+:- trust pred '$heap_snapshot_analyze'(File, N, Total, ByFunctor, ByRoot)
+   : (atm(File), int(N)) => (int(Total), list(ByFunctor), list(ByRoot)).
+:- impl_defined('$heap_snapshot_analyze'/5).
+
+:- export('$numvec_new'/3).
+:- trust pred '$numvec_new'(Type, Len, Vector) : (atm(Type), int(Len)).
+:- impl_defined('$numvec_new'/3).
+
+:- export('$list_to_numvec'/3).
+:- trust pred '$list_to_numvec'(Type, List, Vector) : (atm(Type), list(List)).
+:- impl_defined('$list_to_numvec'/3).
+
+:- export('$numvec_to_list'/2).
+:- trust pred '$numvec_to_list'(Vector, List) => list(List).
+:- impl_defined('$numvec_to_list'/2).
+
+:- export('$numvec_get'/3).
+:- trust pred '$numvec_get'(Vector, I, X) : int(I) => num(X).
+:- impl_defined('$numvec_get'/3).
 :- endif.
 
 % ---------------------------------------------------------------------------
@@ -553,6 +608,16 @@ setarg_mode(true).
 :- impl_defined('$eq'/2).
 :- endif.
 
+:- export('$sample'/2).
+:- if(defined(optim_comp)).
+:- '$props'('$sample'/2, [impnat=cbool(prolog_sample)]).
+:- else.
+:- trust pred '$sample'(Key, N) : atm * int
+   # "Succeeds on the first of every @var{N} calls with @var{Key}
+   (the counters are not undone on backtracking).".
+:- impl_defined('$sample'/2).
+:- endif.
+
 % % (for gauge.pl profiler)
 % :- export('$emulated_clause_counters'/4).
 % :- trust pred '$emulated_clause_counters'/4.
@@ -660,6 +725,13 @@ int_list3([I1,I2,I3]) :- int(I1), int(I2), int(I3).
 :- trust pred '$stack_shift_usage'(Usage) => int_list3(Usage).
 :- impl_defined('$stack_shift_usage'/1).
 :- endif.
+:- export('$lockstat_usage'/1).
+:- if(defined(optim_comp)).
+:- '$props'('$lockstat_usage'/1, [impnat=cbool(prolog_lockstat_usage)]).
+:- else.
+:- trust pred '$lockstat_usage'(Usage) => list(Usage).
+:- impl_defined('$lockstat_usage'/1).
+:- endif.
 
 :- export('$program_usage'/1).
 :- if(defined(optim_comp)).
@@ -682,6 +754,14 @@ int_list3([I1,I2,I3]) :- int(I1), int(I2), int(I3).
 :- trust pred '$total_usage'(Usage) => int_list2(Usage).
 :- impl_defined('$total_usage'/1).
 :- endif.
+:- export('$memory_report'/4).
+:- if(defined(optim_comp)).
+:- '$props'('$memory_report'/4, [impnat=cbool(prolog_memory_report)]).
+:- else.
+:- trust pred '$memory_report'(Total, Live, Categories, Predicates)
+   => (int(Total), int(Live), list(Categories), list(Predicates)).
+:- impl_defined('$memory_report'/4).
+:- endif.
 
 :- if(defined(optim_comp)).
 % :- export('$max_arity'/1).
@@ -819,6 +899,14 @@ true_fail(fail).
 :- impl_defined('$exec'/9).
 :- endif.
 
+:- export('$process_pump'/6).
+:- if(defined(optim_comp)).
+:- '$props'('$process_pump'/6, [impnat=cbool(prolog_process_pump)]).
+:- else.
+:- trust pred '$process_pump'/6. % (see system.c for details)
+:- impl_defined('$process_pump'/6).
+:- endif.
+
 % ---------------------------------------------------------------------------
 :- doc(section, "Module initialization (both static and dynamic)").
 % (as part the 'module' object operations)
@@ -59,9 +59,6 @@ static inline int c_getc(FILE *f) {
 }
 #endif
 
-#define BYTE_EOF       (-1)
-#define BYTE_PAST_EOF  (-2)
-
 static CFUN__PROTO(readrune, c_rune_t, stream_node_t *s, int op_type, definition_t *pred_address);
 static CVOID__PROTO(writerune, c_rune_t r, stream_node_t *s);
 static CVOID__PROTO(writerunen, c_rune_t r, int i, stream_node_t *s);
@@ -1240,6 +1237,36 @@ CVOID__PROTO(print_string, stream_node_t *stream, char *p) {
   fflush(fileptr);
 }
 
+/* Like print_string() for the len bytes at p (which may include NUL
+   bytes), without flushing the stream */
+CVOID__PROTO(print_bytes, stream_node_t *stream, const char *p, size_t len) {
+  FILE *fileptr = stream->streamfile;
+  size_t i;
+
+  if (stream->isatty) {
+    stream = root_stream_ptr;
+    for (i = 0; i < len; i++) {
+      /* ignore errors on tty */
+      putc(p[i],fileptr);
+      inc_counts((unsigned char)p[i],stream);
+    }
+  } else if (stream->streammode != 's') { /* not a socket */
+    if (fwrite(p, 1, len, fileptr) < len) {
+      IO_ERROR("fwrite() in print_bytes()");
+    }
+    for (i = 0; i < len; i++) {
+      inc_counts((unsigned char)p[i],stream);
+    }
+  } else { /* a socket */
+    for (i = 0; i < len; i++) {
+      inc_counts((unsigned char)p[i],stream);
+    }
+    if (write(TaggedToIntmach(stream->label), p, len) < 0) {
+      IO_ERROR("write() in print_bytes()");
+    }
+  }
+}
+
 /* From HVA/SVA to NUM (for printing) */
 CFUN__PROTO(var_address, tagged_t, tagged_t term) {
   intval_t n;
@@ -1762,6 +1789,199 @@ CBOOL__PROTO(raw_copy_stdout) {
 }
 #endif
 
+/* --------------------------------------------------------------------------- */
+/* Bulk byte I/O (copy_stream/3, read_bytes/3, etc.) */
+
+/* Read at most n bytes from s into buf. Unless 'partial', stop before
+   only at the end of the stream. Return the number of bytes read (0 at
+   the end of the stream), BYTE_PAST_EOF if s was already past the end,
+   or BYTES_IO_ERROR (with errno set). */
+CFUN__PROTO(readbytes, intmach_t, stream_node_t *s, unsigned char *buf,
+                   intmach_t n, bool_t partial) {
+  intmach_t count = 0;
+  int i;
+
+  if (s->isatty) { /* byte by byte (for prompts) */
+    while (count < n) {
+      i = CFUN__EVAL(readbyte, s, GET, NULL);
+      if (i < 0) break;
+      buf[count++] = i;
+      if (partial && i == '\n') break;
+    }
+    return count;
+  }
+
+  if (s->pending_rune != RUNE_VOID) { /* There is a char returned by peek */
+    i = s->pending_rune;
+    s->pending_rune = RUNE_VOID;
+    if (i < 0) {
+      if (s->streammode == 's') s->socket_eof = TRUE;
+      return 0;
+    }
+    buf[count++] = i;
+  }
+
+  if (s->streammode != 's') { /* not a socket */
+    FILE *f = s->streamfile;
+    if (count == 0 && feof(f)) {
+      return BYTE_PAST_EOF; /* attempt to read past end of stream */
+    }
+    count += fread(buf+count, 1, n-count, f);
+    if (count < n && ferror(f)) return BYTES_IO_ERROR;
+    return count;
+  } else { /* a socket (read directly from the descriptor) */
+    int fildes = TaggedToIntmach(s->label);
+    ssize_t r;
+
+    if (count == 0 && s->socket_eof) {
+      return BYTE_PAST_EOF; /* attempt to read past end of stream */
+    }
+    while (count < n) {
+      r = read(fildes, (void *)(buf+count), n-count);
+      if (r < 0) {
+        if (errno == EINTR) continue;
+        return BYTES_IO_ERROR;
+      }
+      if (r == 0) {
+        s->socket_eof = TRUE;
+        break;
+      }
+      count += r;
+      if (partial) break;
+    }
+    return count;
+  }
+}
+
+/* Write n bytes from buf into s (counted as put_byte/2 does). Return
+   FALSE on errors. */
+static CFUN__PROTO(writebytes, bool_t, stream_node_t *s, unsigned char *buf,
+                   intmach_t n) {
+  intmach_t i;
+
+  if (s->isatty) {
+    /* ignore errors on tty */
+    fwrite(buf, 1, n, s->streamfile);
+    s = root_stream_ptr;
+  } else if (s->streammode != 's') { /* not a socket */
+    if (fwrite(buf, 1, n, s->streamfile) != (size_t)n) return FALSE;
+  } else { /* a socket */
+    int fildes = TaggedToIntmach(s->label);
+    ssize_t r;
+    for (i = 0; i < n; i += r) {
+      r = write(fildes, (void *)(buf+i), n-i);
+      if (r < 0) {
+        if (errno == EINTR) { r = 0; continue; }
+        return FALSE;
+      }
+    }
+  }
+  for (i = 0; i < n; i++) inc_counts(buf[i], s);
+  return TRUE;
+}
+
+/* '$copy_stream'(+InS, +OutS, -Copied): copy all the bytes of InS
+   (until the end of the stream) into OutS */
+CBOOL__PROTO(prolog_copy_stream) {
+  ERR__FUNCTOR("io_basic:$copy_stream", 3);
+  int errcode;
+  stream_node_t *in, *out;
+  unsigned char *buf;
+  intmach_t n, copied;
+
+  in = stream_to_ptr_check(X(0), 'r', &errcode);
+  if (!in) {
+    BUILTIN_ERROR(errcode,X(0),1);
+  }
+  out = stream_to_ptr_check(X(1), 'w', &errcode);
+  if (!out) {
+    BUILTIN_ERROR(errcode,X(1),2);
+  }
+
+  buf = checkalloc_ARRAY(unsigned char, BULKIO_BUFSIZE);
+  copied = 0;
+  for (;;) {
+    /* (partial reads, so that data from sockets is sent as it comes) */
+    n = CFUN__EVAL(readbytes, in, buf, BULKIO_BUFSIZE, TRUE);
+    if (n <= 0) break;
+    if (!CFUN__EVAL(writebytes, out, buf, n)) {
+      n = BYTES_IO_ERROR;
+      break;
+    }
+    copied += n;
+    /* (short reads from files only happen at the end) */
+    if (n < BULKIO_BUFSIZE && in->streammode != 's' && !in->isatty) break;
+  }
+  checkdealloc_ARRAY(unsigned char, BULKIO_BUFSIZE, buf);
+
+  if (n == BYTES_IO_ERROR) {
+    IO_ERROR("read() or write() in '$copy_stream'/3");
+  }
+  if (n == BYTE_PAST_EOF) {
+    BUILTIN_ERROR(ERR_permission_error(access, past_end_of_stream),X(0),1);
+  }
+  TEST_HEAP_OVERFLOW(G->heap_top, 4*sizeof(tagged_t)+CONTPAD, 3);
+  CBOOL__LASTUNIFY(IntmachToTagged(copied), X(2));
+}
+
+/* '$read_bytes'(+Stream, +N, -Bytes): Bytes is the list of the next N
+   bytes of Stream (less if the end of the stream is found before), or
+   of all the remaining bytes if N is -1 */
+CBOOL__PROTO(prolog_read_bytes) {
+  ERR__FUNCTOR("io_basic:$read_bytes", 3);
+  int errcode;
+  stream_node_t *s;
+  tagged_t t, list;
+  unsigned char *buf;
+  intmach_t n, size, len, r, i;
+
+  s = stream_to_ptr_check(X(0), 'r', &errcode);
+  if (!s) {
+    BUILTIN_ERROR(errcode,X(0),1);
+  }
+  DEREF(t, X(1));
+  if (TaggedIsSmall(t)) {
+    n = GetSmall(t);
+  } else if (IsInteger(t)) { /* (larger than any list) */
+    n = bn_positive(TaggedToBignum(t)) ? -1 : 0;
+  } else {
+    ERROR_IN_ARG(t, 2, ERR_type_error(integer));
+  }
+  if (n == 0 || n < -1) {
+    CBOOL__LASTUNIFY(atom_nil, X(2));
+  }
+
+  /* Read into a buffer that grows as needed */
+  size = (n > 0 && n < BULKIO_BUFSIZE) ? n : BULKIO_BUFSIZE;
+  buf = checkalloc_ARRAY(unsigned char, size);
+  len = 0;
+  for (;;) {
+    r = CFUN__EVAL(readbytes, s, buf+len, size-len, FALSE);
+    if (r < 0) break;
+    len += r;
+    if (len < size || len == n) break; /* end of stream or done */
+    i = (n > 0 && size*2 > n) ? n : size*2;
+    buf = checkrealloc_ARRAY(unsigned char, size, i, buf);
+    size = i;
+  }
+  if (r < 0) {
+    checkdealloc_ARRAY(unsigned char, size, buf);
+    if (r == BYTES_IO_ERROR) {
+      IO_ERROR("read() in '$read_bytes'/3");
+    }
+    BUILTIN_ERROR(ERR_permission_error(access, past_end_of_stream),X(0),1);
+  }
+
+  /* Build the list with a single heap reservation */
+  TEST_HEAP_OVERFLOW(G->heap_top, len*LSTCELLS*sizeof(tagged_t)+CONTPAD, 3);
+  list = atom_nil;
+  for (i = len-1; i >= 0; i--) {
+    MakeLST(list, MakeSmall(buf[i]), list);
+  }
+  checkdealloc_ARRAY(unsigned char, size, buf);
+  CBOOL__LASTUNIFY(list, X(2));
+}
+
 /* --------------------------------------------------------------------------- */
 
 // TODO:[oc-merge] merge stream_wait.pl into io_basic.pl
@@ -31,6 +31,7 @@ CVOID__PROTO(display_term, tagged_t term, stream_node_t *stream, bool_t quoted);
 })
 
 CVOID__PROTO(print_string, stream_node_t *stream, char *p);
+CVOID__PROTO(print_bytes, stream_node_t *stream, const char *p, size_t len);
 
 /* --------------------------------------------------------------------------- */
 
@@ -40,6 +41,18 @@ CVOID__PROTO(print_string, stream_node_t *stream, char *p);
 
 #define RUNE_ERROR 0xFFFD /* Unicode Replacement character */
 
+#define BYTE_EOF       (-1)
+#define BYTE_PAST_EOF  (-2)
+
+/* --------------------------------------------------------------------------- */
+/* Bulk byte I/O */
+
+#define BULKIO_BUFSIZE 65536
+#define BYTES_IO_ERROR (-3)
+
+CFUN__PROTO(readbytes, intmach_t, stream_node_t *s, unsigned char *buf,
+            intmach_t n, bool_t partial);
+
 /* --------------------------------------------------------------------------- */
 
 #if defined(USE_MULTIBYTES)
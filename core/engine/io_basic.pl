@@ -491,3 +491,17 @@ is_ascii([C|Cs]) :- integer(C), C>=0, C<0x80, is_ascii(Cs).
 :- else.
 :- impl_defined('$raw_copy_stdout'/1).
 :- endif.
+
+:- export('$copy_stream'/3). % internal predicate
+:- if(defined(optim_comp)).
+:- '$props'('$copy_stream'/3, [impnat=cbool(prolog_copy_stream)]).
+:- else.
+:- impl_defined('$copy_stream'/3).
+:- endif.
+
+:- export('$read_bytes'/3). % internal predicate
+:- if(defined(optim_comp)).
+:- '$props'('$read_bytes'/3, [impnat=cbool(prolog_read_bytes)]).
+:- else.
+:- impl_defined('$read_bytes'/3).
+:- endif.
@@ -25,6 +25,7 @@
 /* Spin locks: fast, but make a busy-wait */
 #define Init_slock(p)          
 #define Wait_Acquire_slock(p)  
+#define Try_Acquire_slock(p)   TRUE
 #define Release_slock(p)       
 #define Destroy_slock(p)       
 #define SLock_is_unset(p)      1
@@ -32,6 +33,7 @@
 /* non spin locks: should suspend the thread, but are possibly slower */
 #define Init_lock(p)          
 #define Wait_Acquire_lock(p)  
+#define Try_Acquire_lock(p)   TRUE
 #define Release_lock(p)       
 #define Destroy_lock(p)       
 #define Lock_is_unset(p)      1
@@ -172,6 +174,11 @@ do { if (mips_try_lock(p)) break;                               \
     }
 #endif
 
+#if defined(mips)
+#define Try_Acquire_slock(p)      FALSE /* (always takes the slow path) */
+#else
+#define Try_Acquire_slock(p)      (aswap((LockOffSet(p)),1)==0)
+#endif
 #define Release_slock(p)          *(LockOffSet(p))=0
 #define Destroy_slock(p)          p.lock_pt = NULL /* Force error afterwards */
 #define SLock_is_unset(p)         *(LockOffSet(p))==0
@@ -220,6 +227,7 @@ typedef pthread_mutex_t LOCK;
 
 #define Init_lock(p)         pthread_mutex_init(&p, NULL)
 #define Wait_Acquire_lock(p) pthread_mutex_lock(&p)
+#define Try_Acquire_lock(p)  (pthread_mutex_trylock(&p) == 0)
 #define Release_lock(p)      pthread_mutex_unlock(&p)
 #define Destroy_lock(p)      pthread_mutex_destroy(&p)
 #define Lock_is_unset(p)     lock_is_unset(&p)
@@ -249,6 +257,7 @@ typedef CRITICAL_SECTION LOCK;
 
 #define Init_lock(p)         InitializeCriticalSection(&p)
 #define Wait_Acquire_lock(p) EnterCriticalSection(&p)
+#define Try_Acquire_lock(p)  TryEnterCriticalSection(&p)
 #define Release_lock(p)      LeaveCriticalSection(&p)
 #define Destroy_lock(p)      DeleteCriticalSection(&p)
 #define Lock_is_unset(p)     lock_is_unset(&p)
@@ -280,6 +289,7 @@ typedef SLOCK LOCK;
 
 #define Init_lock(p)          Init_slock(p)
 #define Wait_Acquire_lock(p)  Wait_Acquire_slock(p)  
+#define Try_Acquire_lock(p)   Try_Acquire_slock(p)
 #define Release_lock(p)       Release_slock(p)       
 #define Destroy_lock(p)       Destroy_slock(p)       
 #define Lock_is_unset(p)      SLock_is_unset(p)      
@@ -294,6 +304,7 @@ typedef LOCK SLOCK;
 
 #define Init_slock(p)          Init_lock(p)
 #define Wait_Acquire_slock(p)  Wait_Acquire_lock(p)  
+#define Try_Acquire_slock(p)   Try_Acquire_lock(p)
 #define Release_slock(p)       Release_lock(p)       
 #define Destroy_slock(p)       Destroy_lock(p)       
 #define SLock_is_unset(p)      Lock_is_unset(p)      
@@ -308,12 +319,14 @@ typedef LOCK  int;
 
 #define Init_slock(p)          
 #define Wait_Acquire_slock(p)  
+#define Try_Acquire_slock(p)   TRUE
 #define Release_slock(p)       
 #define Destroy_slock(p)       
 #define SLock_is_unset(p)      1
 
 #define Init_lock(p)          
 #define Wait_Acquire_lock(p)  
+#define Try_Acquire_lock(p)   TRUE
 #define Release_lock(p)       
 #define Destroy_lock(p)       
 #define Lock_is_unset(p)      1
@@ -762,12 +762,14 @@ CBOOL__PROTO(make_bytecode_object) {
                         char,
                         (bsize + counter_cnt*sizeof(intmach_t)),
                         object);
+  MEMCAT_INC(MEMCAT_CODE, object->objsize);
 #else
   checkalloc_FLEXIBLE_S(emul_info_t,
                         objsize,
                         char,
                         bsize,
                         object);
+  MEMCAT_INC(MEMCAT_CODE, object->objsize);
 #endif
 
   object->next = NULL;
@@ -1017,12 +1019,14 @@ static CVOID__PROTO(load_dbnode32,
                         char,
                         (codelength + counter_cnt*sizeof(intmach_t)),
                         db);
+  MEMCAT_INC(MEMCAT_CODE, db->objsize);
 #else
   checkalloc_FLEXIBLE_S(emul_info_t,
                         objsize,
                         char,
                         codelength,
                         db);
+  MEMCAT_INC(MEMCAT_CODE, db->objsize);
 #endif
 
   getbytecode32(Arg,f,(bcp_t)db->emulcode,codelength);
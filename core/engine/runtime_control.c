@@ -16,6 +16,7 @@
 
 #include <ciao/timing.h>
 #include <ciao/io_basic.h>
+#include <ciao/eng_lockstat.h>
 
 #include <string.h>
 
@@ -118,7 +119,7 @@ CBOOL__PROTO(prolog_new_atom) {
     BUILTIN_ERROR(ERR_uninstantiation_error,X(0),1);
   }
 
-  Wait_Acquire_slock(atom_id_l);
+  Wait_Acquire_slock_stat(atom_id_l, LOCKSTAT_ATOM_ID);
 
   previous_atoms_count = ciao_atoms->count;
   do {
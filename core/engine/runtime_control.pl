@@ -204,6 +204,10 @@
     : gc_option(GC_option) => gc_option * gc_result
    # "Gather information about garbage collection.".
 
+:- pred statistics(Lock_option, Lock_result)
+    : lock_option(Lock_option) => lock_option * lock_result
+   # "Gather information about contention on engine locks.".
+
 :- pred statistics(Symbol_option, Symbol_result) 
     : symbol_option(Symbol_option) => symbol_option * symbol_result
    # "Gather information about number of symbols and predicates.".
@@ -241,6 +245,8 @@ statistics(heap, L) :- statistics(program, L).
 statistics(garbage_collection, L) :- '$gc_usage'(L).
 statistics(stack_shifts, L) :- '$stack_shift_usage'(L).
 
+statistics(lock_contention, L) :- '$lockstat_usage'(L).
+
 % ---------------------------------------------------------------------------
 % Regtypes for statistics/0, statistics/2
 
@@ -299,6 +305,13 @@ memory_option(choice).
 gc_option(garbage_collection).
 gc_option(stack_shifts).
 
+:- doc(doinclude, lock_option/1).
+:- export(lock_option/1).
+:- prop lock_option(M) + regtype # "@var{M} is an option to get
+   information about lock contention. @includedef{lock_option/1}".
+
+lock_option(lock_contention).
+
 :- doc(doinclude, symbol_option/1).
 :- export(symbol_option/1).
 :- prop symbol_option(M) + regtype # "@var{M} is an option to get
@@ -367,11 +380,67 @@ gc_result([A, B, C]):- int(A), int(B), int(C).
 
 symbol_result([A, B]):- int(A), int(B).
 
+:- doc(doinclude, lock_result/1).
+:- export(lock_result/1).
+:- prop lock_result(Result) + regtype # "@var{Result} is a list of
+   @tt{Site-[Acquired,Contended,WaitTime,MaxWaitTime]} elements, one
+   for each instrumented engine lock site (e.g., @tt{mem_mng} for the
+   memory manager, @tt{atom} for @pred{lock_atom/1}, @tt{conc_pred}
+   for concurrent predicates). Times are in microseconds. Counters
+   are only updated while lock statistics are enabled (see
+   @pred{eng_lock_stats/1} in @lib{concurrency} or the
+   @tt{--lockstats} engine option).".
+
+lock_result([]).
+lock_result([Site-[A, B, C, D]|R]) :-
+    atm(Site), int(A), int(B), int(C), int(D),
+    lock_result(R).
+
  %% memory_option(core).
  %% memory_option(heap).
 
 % ---------------------------------------------------------------------------
 
+:- export(memory_report/1).
+:- pred memory_report(Report) => memory_report_result(Report)
+   # "@var{Report} is a breakdown of the memory allocated by the
+     engine, by subsystem and by predicate. Sizes of predicates are
+     computed when this predicate is called.".
+
+memory_report(Report) :-
+    '$memory_report'(Total, Live, Categories, Predicates),
+    Report = [total(Total), live(Live),
+              categories(Categories), predicates(Predicates)].
+
+:- doc(doinclude, memory_report_result/1).
+:- export(memory_report_result/1).
+:- prop memory_report_result(Report) + regtype # "@var{Report} is a list
+   @tt{[total(Total), live(Live), categories(Categories),
+   predicates(Predicates)]}. @var{Total} is the memory (in bytes)
+   obtained by the engine memory manager and @var{Live} the memory
+   currently allocated. @var{Categories} is a list of
+   @tt{Category-Bytes} elements for each subsystem: @tt{stacks}
+   (memory areas of workers), @tt{atoms} (atom names and table),
+   @tt{predicates} (predicate and module descriptors), @tt{code}
+   (compiled clauses), @tt{dynamic} (clauses of dynamic and data
+   predicates), @tt{hashtables} (indices and symbol tables),
+   @tt{streams}, @tt{tabling} (tables and tabling stacks), and
+   @tt{other} (everything not attributed to the previous ones).
+   @var{Predicates} is a list of @tt{Name/Arity-Bytes} elements, in
+   decreasing order of size, with the memory used by the clauses and
+   indices of each predicate.".
+
+memory_report_result([total(T), live(L), categories(Cs), predicates(Ps)]) :-
+    int(T), int(L), memory_categories(Cs), memory_predicates(Ps).
+
+memory_categories([]).
+memory_categories([C-B|Cs]) :- atm(C), int(B), memory_categories(Cs).
+
+memory_predicates([]).
+memory_predicates([N/A-B|Ps]) :- atm(N), int(A), int(B), memory_predicates(Ps).
+
+% ---------------------------------------------------------------------------
+
 :- use_module(engine(io_basic), [display/1]).
 
 :- export(time/1).
@@ -67,6 +67,7 @@ void init_streams(void) {
 #endif
 
   root_stream_ptr = checkalloc_TYPE(stream_node_t);
+  MEMCAT_INC(MEMCAT_STREAMS, sizeof(stream_node_t));
   root_stream_ptr->label=ERRORTAG;
   root_stream_ptr->streamname=ERRORTAG;
   root_stream_ptr->forward=root_stream_ptr;
@@ -108,6 +109,7 @@ stream_node_t *new_stream(tagged_t streamname,
   stream_node_t *s;
 
   s = checkalloc_TYPE(stream_node_t);
+  MEMCAT_INC(MEMCAT_STREAMS, sizeof(stream_node_t));
   s->streamname = streamname;
   s->streammode = streammode[0];
   s->pending_rune = RUNE_VOID;
@@ -475,6 +477,7 @@ CBOOL__PROTO(prolog_close) {
     }
   }
 
+  MEMCAT_DEC(MEMCAT_STREAMS, sizeof(stream_node_t));
   checkdealloc_TYPE(stream_node_t, stream);
   Release_lock(stream_list_l);
 
@@ -71,6 +71,7 @@
 #include <netdb.h>
 #include <sys/wait.h>
 #include <pwd.h>
+#include <poll.h>
 #endif
 
 #endif /* defined(_WIN32) || defined(_WIN64) -- top-level MSVC vs POSIX guard */
@@ -3084,6 +3085,205 @@ CBOOL__PROTO(prolog_exec) {
   }
 }
 
+/* --------------------------------------------------------------------------- */
+/* Pump for in-memory process channels (see process_channel.pl) */
+
+/* (max number of bytes written or read at each step) */
+#define PUMP_CHUNK 65536
+
+typedef struct pump_sink_ pump_sink_t;
+struct pump_sink_ {
+  intmach_t count;
+  intmach_t capacity;
+  unsigned char *data;
+};
+
+/* Read at most PUMP_CHUNK bytes from fd into s. Returns the number of
+   bytes read, 0 at EOF, or -1 on errors */
+static intmach_t pump_sink_read(pump_sink_t *s, int fd) {
+  intmach_t capacity;
+  intmach_t r;
+
+  if (s->count + PUMP_CHUNK > s->capacity) {
+    capacity = s->capacity == 0 ? PUMP_CHUNK : s->capacity * 2;
+    while (capacity < s->count + PUMP_CHUNK) capacity *= 2;
+    if (s->data == NULL) {
+      s->data = checkalloc_ARRAY(unsigned char, capacity);
+    } else {
+      s->data = checkrealloc_ARRAY(unsigned char, s->capacity, capacity, s->data);
+    }
+    s->capacity = capacity;
+  }
+  do {
+    r = read(fd, s->data + s->count, PUMP_CHUNK);
+  } while (r < 0 && errno == EINTR);
+  if (r > 0) s->count += r;
+  return r;
+}
+
+/* Close the parent's end of the child input, so that the child sees
+   EOF. The descriptor is replaced by /dev/null (instead of closed) so
+   that the Prolog stream that owns it can be closed as usual. Returns
+   FALSE on errors */
+static bool_t pump_close_input(int fd) {
+  int null_fd;
+
+  null_fd = open("/dev/null", O_WRONLY);
+  if (null_fd < 0) return FALSE;
+  if (dup2(null_fd, fd) < 0) {
+    close(null_fd);
+    return FALSE;
+  }
+  close(null_fd);
+  return TRUE;
+}
+
+/* Feed in_data to in_fd while draining out_fd and err_fd until EOF,
+   without blocking on any of them (a descriptor is ignored if it is
+   -1). Returns FALSE on errors */
+static bool_t process_pump(int in_fd, unsigned char *in_data, intmach_t in_n,
+                           int out_fd, pump_sink_t *out,
+                           int err_fd, pump_sink_t *err) {
+  intmach_t in_pos = 0, len, r;
+#if defined(_WIN32) || defined(_WIN64)
+  /* TODO(MinGW): no poll(), transfer each descriptor in sequence */
+  while (in_fd >= 0 && in_pos < in_n) {
+    len = in_n - in_pos;
+    if (len > PUMP_CHUNK) len = PUMP_CHUNK;
+    r = write(in_fd, in_data + in_pos, len);
+    if (r <= 0) break;
+    in_pos += r;
+  }
+  if (in_fd >= 0 && !pump_close_input(in_fd)) return FALSE;
+  while (out_fd >= 0 && (r = pump_sink_read(out, out_fd)) > 0) {}
+  if (out_fd >= 0 && r < 0) return FALSE;
+  while (err_fd >= 0 && (r = pump_sink_read(err, err_fd)) > 0) {}
+  if (err_fd >= 0 && r < 0) return FALSE;
+  return TRUE;
+#else
+  struct pollfd fds[3];
+  int n, i, flags;
+
+  if (in_fd >= 0) {
+    if (in_n == 0) {
+      if (!pump_close_input(in_fd)) return FALSE;
+      in_fd = -1;
+    } else {
+      /* (partial writes instead of blocking when the pipe is full) */
+      flags = fcntl(in_fd, F_GETFL);
+      if (flags < 0 || fcntl(in_fd, F_SETFL, flags | O_NONBLOCK) < 0) return FALSE;
+    }
+  }
+  while (in_fd >= 0 || out_fd >= 0 || err_fd >= 0) {
+    n = 0;
+    if (in_fd >= 0) { fds[n].fd = in_fd; fds[n].events = POLLOUT; n++; }
+    if (out_fd >= 0) { fds[n].fd = out_fd; fds[n].events = POLLIN; n++; }
+    if (err_fd >= 0) { fds[n].fd = err_fd; fds[n].events = POLLIN; n++; }
+    if (poll(fds, n, -1) < 0) {
+      if (errno == EINTR) continue;
+      return FALSE;
+    }
+    for (i = 0; i < n; i++) {
+      if (fds[i].revents == 0) continue;
+      if (fds[i].fd == in_fd) {
+        len = in_n - in_pos;
+        if (len > PUMP_CHUNK) len = PUMP_CHUNK;
+        r = write(in_fd, in_data + in_pos, len);
+        if (r > 0) {
+          in_pos += r;
+          if (in_pos < in_n) continue;
+        } else if (r < 0 && (errno == EINTR || errno == EAGAIN)) {
+          continue;
+        } else if (r < 0 && errno != EPIPE) {
+          return FALSE;
+        }
+        /* (all data sent, or the child closed its input) */
+        if (!pump_close_input(in_fd)) return FALSE;
+        in_fd = -1;
+      } else {
+        r = pump_sink_read(fds[i].fd == out_fd ? out : err, fds[i].fd);
+        if (r < 0) return FALSE;
+        if (r > 0) continue;
+        if (fds[i].fd == out_fd) out_fd = -1; else err_fd = -1;
+      }
+    }
+  }
+  return TRUE;
+#endif
+}
+
+/* File descriptor of the stream t (or -1 if it is []) */
+static int pump_fd(tagged_t t, int mode) {
+  stream_node_t *s;
+
+  DEREF(t, t);
+  s = stream_to_ptr(t, mode);
+  return s == NULL ? -1 : fileno(s->streamfile);
+}
+
+/* '$process_pump'(+InS, +InBytes, +OutS, +ErrS, -OutBytes, -ErrBytes):
+   write InBytes to the stream InS while reading OutBytes and ErrBytes
+   from the streams OutS and ErrS until EOF (a stream is ignored if it
+   is []). Fails on system errors. */
+CBOOL__PROTO(prolog_process_pump) {
+  ERR__FUNCTOR("internals:$process_pump", 6);
+  int in_fd, out_fd, err_fd;
+  intmach_t in_n, i;
+  unsigned char *in_data;
+  pump_sink_t out, err;
+  tagged_t t, head, list;
+  bool_t ok;
+
+  in_fd = pump_fd(X(0), 'w');
+  out_fd = pump_fd(X(2), 'r');
+  err_fd = pump_fd(X(3), 'r');
+
+  /* Copy the input bytes */
+  in_n = 0;
+  DEREF(list, X(1));
+  while (TaggedIsLST(list)) {
+    DEREF(head, *TaggedToCar(list));
+    if (!TaggedIsSmall(head) || GetSmall(head) < 0 || GetSmall(head) > 255) {
+      BUILTIN_ERROR(ERR_type_error(byte), head, 2);
+    }
+    in_n++;
+    DEREF(list, *TaggedToCdr(list));
+  }
+  if (list != atom_nil) {
+    BUILTIN_ERROR(ERR_type_error(list), X(1), 2);
+  }
+  in_data = in_n == 0 ? NULL : checkalloc_ARRAY(unsigned char, in_n);
+  DEREF(list, X(1));
+  for (i = 0; i < in_n; i++) {
+    DEREF(head, *TaggedToCar(list));
+    in_data[i] = GetSmall(head);
+    DEREF(list, *TaggedToCdr(list));
+  }
+
+  out.count = 0; out.capacity = 0; out.data = NULL;
+  err.count = 0; err.capacity = 0; err.data = NULL;
+  ok = process_pump(in_fd, in_data, in_n, out_fd, &out, err_fd, &err);
+  if (in_data != NULL) checkdealloc_ARRAY(unsigned char, in_n, in_data);
+
+  list = atom_nil;
+  t = atom_nil;
+  if (ok) {
+    /* Build both lists with a single heap reservation */
+    TEST_HEAP_OVERFLOW(G->heap_top, (out.count+err.count)*LSTCELLS*sizeof(tagged_t)+CONTPAD, 6);
+    for (i = out.count-1; i >= 0; i--) {
+      MakeLST(list, MakeSmall(out.data[i]), list);
+    }
+    for (i = err.count-1; i >= 0; i--) {
+      MakeLST(t, MakeSmall(err.data[i]), t);
+    }
+  }
+  if (out.data != NULL) checkdealloc_ARRAY(unsigned char, out.capacity, out.data);
+  if (err.data != NULL) checkdealloc_ARRAY(unsigned char, err.capacity, err.data);
+  CBOOL__TEST(ok);
+  CBOOL__UNIFY(list, X(4));
+  CBOOL__LASTUNIFY(t, X(5));
+}
+
 #if defined(_WIN32) || defined(_WIN64)
 #define SHELL_ENV_NAME "COMSPEC"
 #else
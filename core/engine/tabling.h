@@ -22,19 +22,23 @@ extern tagged_t functor_forward_trail;
 
 extern double trail_time;
 
+/* The global table (tries, generators, and answers) is shared by all
+   threads, the tabling stack (frozen consumers) is private to each
+   thread */
 extern tagged_t *global_table;
-extern tagged_t *tabling_stack;
+extern __thread tagged_t *tabling_stack;
 
 extern tagged_t *global_table_free;
-extern tagged_t *tabling_stack_free;
+extern __thread tagged_t *tabling_stack_free;
 extern tagged_t *global_table_end;
-extern tagged_t *tabling_stack_end;
+extern __thread tagged_t *tabling_stack_end;
 
 #define TABLING_STK_TOP tabling_stack_free
 
 #define INIT_GLOBAL_TABLE                                               \
   {                                                                     \
     global_table = (tagged_t*) checkalloc (GLOBAL_TABLE_SIZE * sizeof(tagged_t*)); \
+    MEMCAT_INC(MEMCAT_TABLING, GLOBAL_TABLE_SIZE * sizeof(tagged_t*)); \
     global_table_free = global_table;                                   \
     global_table_end = global_table + GLOBAL_TABLE_SIZE;                \
   }
@@ -42,15 +46,18 @@ extern tagged_t *tabling_stack_end;
 #define INIT_TABLING_STACK                                              \
   {                                                                     \
     tabling_stack = (tagged_t*) checkalloc (TABLING_STK_SIZE * sizeof(tagged_t*)); \
+    MEMCAT_INC(MEMCAT_TABLING, TABLING_STK_SIZE * sizeof(tagged_t*));  \
     tabling_stack_free = tabling_stack;                                 \
     tabling_stack_end = tabling_stack + TABLING_STK_SIZE;               \
   }
 
+/* (lock-free, the pointer is bumped atomically) */
 #define ALLOC_GLOBAL_TABLE(PTR,PTR_TYPE,SIZE)                           \
   {                                                                     \
-    (PTR) = (PTR_TYPE)global_table_free;                                \
-    global_table_free += (SIZE) / sizeof(tagged_t*);                    \
-    if (global_table_free >= global_table_end)                          \
+    (PTR) = (PTR_TYPE)__atomic_fetch_add(&global_table_free,            \
+                                         ((SIZE) / sizeof(tagged_t*)) * sizeof(tagged_t), \
+                                         __ATOMIC_RELAXED);             \
+    if ((tagged_t *)(PTR) + (SIZE) / sizeof(tagged_t*) >= global_table_end) \
       fprintf(stderr, "Global table memory exhausted\n");               \
   }
 
@@ -5,6 +5,8 @@
  *  Copyright (C) 2020-2024 The Ciao Development Team
  */
 
+#include <string.h>
+
 #include <ciao/eng.h>
 #if !defined(OPTIM_COMP)
 #include <ciao/basiccontrol.h>
@@ -481,29 +483,47 @@ CBOOL__PROTO(prolog_unifiable) {
   CBOOL__LASTUNIFY(X(2), t);
 }  
 
+/* ------------------------------------------------------------------------- */
+/* Argument stack (see eng.h) */
+
+void argstk__grow(argstk_t *s) {
+  intmach_t size = 2*s->size;
+  if (s->base == s->initial) {
+    s->base = checkalloc_ARRAY(argblk_t, size);
+    memcpy(s->base, s->initial, s->size*sizeof(argblk_t));
+  } else {
+    s->base = checkrealloc_ARRAY(argblk_t, s->size, size, s->base);
+  }
+  s->size = size;
+}
+
 /* ------------------------------------------------------------------------- */
 /* Deref variable v occurs in term x */
 /* (needed for unifyOC) */
 
 #if defined(UNIFY_OC_INLINE)
-static CBOOL__PROTO(var_occurs, tagged_t v, tagged_t x1);
+static CBOOL__PROTO(var_occurs_aux, argstk_t *s, tagged_t v, tagged_t x1);
+
+static CBOOL__PROTO(var_occurs, tagged_t v, tagged_t x1) {
+  argstk_t s;
+  bool_t result;
+  ARGSTK__INIT(s);
+  result = CBOOL__SUCCEED(var_occurs_aux,&s,v,x1);
+  ARGSTK__FREE(s);
+  return result;
+}
 
-static CBOOL__PROTO(var_occurs_args_aux, 
-                    tagged_t v,
+/* Get the next argument to visit (x1), push the rest of the block */
+static CVOID__PROTO(var_occurs_args_aux, 
+                    argstk_t *s,
                     arity_t arity,
                     tagged_t *pt1,
                     tagged_t *x1) {
-  tagged_t t1 = ~0;
-  for (; arity>0; --arity) {
-    t1 = *pt1;
-    if (arity > 1 && CBOOL__SUCCEED(var_occurs,v,t1)) CBOOL__PROCEED;
-    pt1++;
-  }
-  *x1 = t1;
-  CBOOL__FAIL;
+  if (arity > 1) ARGSTK__PUSH(*s, pt1+1, pt1+1, arity-1);
+  *x1 = *pt1;
 }
 
-static CBOOL__PROTO(var_occurs, tagged_t v, tagged_t x1) {
+static CBOOL__PROTO(var_occurs_aux, argstk_t *s, tagged_t v, tagged_t x1) {
   tagged_t u;
 
  in:
@@ -519,21 +539,16 @@ static CBOOL__PROTO(var_occurs, tagged_t v, tagged_t x1) {
   if (TaggedIsATM(u)) goto lose;
   if (TaggedIsSmall(u)) goto lose;
   if (TaggedIsLST(u)) {
-    if (!CBOOL__SUCCEED(var_occurs_args_aux,v,2,TaggedToCar(u),&x1)) {
-      goto in;
-    } else {
-      goto win;
-    }
+    CVOID__CALL(var_occurs_args_aux,s,2,TaggedToCar(u),&x1);
+    goto in;
   } else { /* structure. */
     tagged_t t1;
     t1=TaggedToHeadfunctor(u);
     if (FunctorIsBlob(t1)) { /* large number */
       goto lose;
-    } if (!CBOOL__SUCCEED(var_occurs_args_aux,v,Arity(t1),TaggedToArg(u,1),&x1)) {
-      goto in;
-    } else {
-      goto win;
     }
+    CVOID__CALL(var_occurs_args_aux,s,Arity(t1),TaggedToArg(u,1),&x1);
+    goto in;
   }
 
  var:
@@ -542,6 +557,13 @@ static CBOOL__PROTO(var_occurs, tagged_t v, tagged_t x1) {
  win:
   CBOOL__PROCEED;
  lose:
+  if (!ARGSTK__EMPTY(*s)) {
+    tagged_t *pt1;
+    intmach_t arity;
+    ARGSTK__POP(*s, pt1, pt1, arity); /* (single block) */
+    CVOID__CALL(var_occurs_args_aux,s,arity,pt1,&x1);
+    goto in;
+  }
   CBOOL__FAIL;
 }
 #endif
@@ -551,9 +573,10 @@ static CBOOL__PROTO(var_occurs, tagged_t v, tagged_t x1) {
 
 #if defined(UNIFY_OC_INLINE)
 static CBOOL__PROTO(cunifyOC_args_aux,
-                    arity_t arity, tagged_t *pt1, tagged_t *pt2,
+                    argstk_t *s, arity_t arity, tagged_t *pt1, tagged_t *pt2,
                     tagged_t *x1, tagged_t *x2);
-static CBOOL__PROTO(cunifyOC_aux, tagged_t x1, tagged_t x2);
+static CBOOL__PROTO(cunifyOC_aux, argstk_t *s, tagged_t x1, tagged_t x2);
+static CBOOL__PROTO(cunifyOC_top, tagged_t x1, tagged_t x2);
 
 /* Unify the argument lists of two compund terms. (with occurs-check)
  * pt1 - first argument list.
@@ -565,7 +588,12 @@ CBOOL__PROTO(cunifyOC_args,
              tagged_t *pt1,
              tagged_t *pt2) {
   tagged_t x1, x2;
-  return (CBOOL__SUCCEED(cunifyOC_args_aux,arity,pt1,pt2,&x1,&x2) && CBOOL__SUCCEED(cunifyOC_aux,x1,x2));
+  argstk_t s;
+  bool_t result;
+  ARGSTK__INIT(s);
+  result = (CBOOL__SUCCEED(cunifyOC_args_aux,&s,arity,pt1,pt2,&x1,&x2) && CBOOL__SUCCEED(cunifyOC_aux,&s,x1,x2));
+  ARGSTK__FREE(s);
+  return result;
 }
 
 // TODO:[oc-merge] which one is right?
@@ -575,7 +603,11 @@ CBOOL__PROTO(cunifyOC_args,
 #define UNIF_DerefVar DerefSw_HVAorCVAorSVA_Other
 #endif
 
+/* Find the next pair of arguments to unify (x1 and x2). If it is not
+   the last one, the rest of the block is pushed on the argument
+   stack. */
 static CBOOL__PROTO(cunifyOC_args_aux, 
+                    argstk_t *s,
                     arity_t arity,
                     tagged_t *pt1,
                     tagged_t *pt2,
@@ -589,6 +621,13 @@ static CBOOL__PROTO(cunifyOC_args_aux,
 #else
   VALUETRAIL__TEST_OVERFLOW(2*CHOICEPAD);
 #endif
+  /* Skip identical words (the whole block if it is bitwise identical) */
+  if (arity == 0 || pt1 == pt2) goto identical;
+  for (; *pt1 == *pt2; --arity) {
+    if (arity == 1) goto identical;
+    pt1++;
+    pt2++;
+  }
   for (; arity>0; --arity) {
     t1 = *pt1;
     t2 = *pt2;
@@ -606,8 +645,11 @@ static CBOOL__PROTO(cunifyOC_args_aux,
         goto next;
       }
     noforward:
-      if (arity>1 && !CBOOL__SUCCEED(cunifyOC_aux,t1,t2))
-        CBOOL__FAIL;
+      if (arity>1) {
+        /* unify this pair first, resume the rest later */
+        ARGSTK__PUSH(*s, pt1+1, pt2+1, arity-1);
+        break;
+      }
       goto next;
     }
   next:
@@ -622,6 +664,10 @@ static CBOOL__PROTO(cunifyOC_args_aux,
   VALUETRAIL__TEST_OVERFLOW(CHOICEPAD);
 #endif
   CBOOL__PROCEED;
+ identical:
+  *x1 = atom_nil;
+  *x2 = atom_nil;
+  CBOOL__PROCEED;
 }
 #endif 
 
@@ -642,9 +688,9 @@ static CBOOL__PROTO(cunifyOC_args_aux,
 
 CBOOL__PROTO(cunifyOC, tagged_t x1, tagged_t x2) {
 #if defined(UNIFY_OC_INLINE)
-  /* Use a recursive version of Robinson's 1965 unification algorithm
-     with inline occurs-check */
-  CBOOL__LASTCALL(cunifyOC_aux,x1,x2);
+  /* Use an (iterative) version of Robinson's 1965 unification
+     algorithm with inline occurs-check */
+  CBOOL__LASTCALL(cunifyOC_top,x1,x2);
 #else
   /* Otherwise, check cyclic later. This may be less efficient than
      the first algorithm depending on cost of cyclic term checks,
@@ -659,7 +705,16 @@ CBOOL__PROTO(cunifyOC, tagged_t x1, tagged_t x2) {
 #define OccurCheck(U,V,OCCUR) \
   { if (CBOOL__SUCCEED(var_occurs, (U), (V))) { OCCUR; } }
 
-static CBOOL__PROTO(cunifyOC_aux, tagged_t x1, tagged_t x2) {
+static CBOOL__PROTO(cunifyOC_top, tagged_t x1, tagged_t x2) {
+  argstk_t s;
+  bool_t result;
+  ARGSTK__INIT(s);
+  result = CBOOL__SUCCEED(cunifyOC_aux,&s,x1,x2);
+  ARGSTK__FREE(s);
+  return result;
+}
+
+static CBOOL__PROTO(cunifyOC_aux, argstk_t *s, tagged_t x1, tagged_t x2) {
   tagged_t u, v;
 
  in:
@@ -689,7 +744,7 @@ static CBOOL__PROTO(cunifyOC_aux, tagged_t x1, tagged_t x2) {
       goto lose; /* fail */
     }, {
       /* LST x LST */
-      CBOOL__CALL(cunifyOC_args_aux,2,TaggedToCar(u),TaggedToCar(v),&x1,&x2);
+      if (!CBOOL__SUCCEED(cunifyOC_args_aux,s,2,TaggedToCar(u),TaggedToCar(v),&x1,&x2)) goto lose;
       goto in;
     }, {
       /* STR x STR */
@@ -707,7 +762,7 @@ static CBOOL__PROTO(cunifyOC_aux, tagged_t x1, tagged_t x2) {
 #endif
           goto win;
         } else { /* STRStruct x STRStruct */
-          CBOOL__CALL(cunifyOC_args_aux, Arity(t1), TaggedToArg(u,1), TaggedToArg(v,1), &x1, &x2);
+          if (!CBOOL__SUCCEED(cunifyOC_args_aux, s, Arity(t1), TaggedToArg(u,1), TaggedToArg(v,1), &x1, &x2)) goto lose;
           goto in;
         }
       }
@@ -769,6 +824,13 @@ static CBOOL__PROTO(cunifyOC_aux, tagged_t x1, tagged_t x2) {
   BindSVA(u,v);
 
  win:
+  if (!ARGSTK__EMPTY(*s)) {
+    tagged_t *pt1, *pt2;
+    intmach_t arity;
+    ARGSTK__POP(*s, pt1, pt2, arity);
+    if (!CBOOL__SUCCEED(cunifyOC_args_aux,s,arity,pt1,pt2,&x1,&x2)) goto lose;
+    goto in;
+  }
   CBOOL__PROCEED;
 
  lose:
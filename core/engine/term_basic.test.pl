@@ -0,0 +1,87 @@
+:- module(_, [], [assertions]).
+
+:- doc(title, "Tests for term_basic.pl").
+
+:- use_module(library(iso_misc), [unify_with_occurs_check/2]).
+
+% ---------------------------------------------------------------------------
+% Unification of deep terms (deeper than the C stack would allow for a
+% recursive traversal)
+
+depth(1000000).
+
+% Nested in the first argument
+left_deep(0, T, T) :- !.
+left_deep(N, T0, T) :- N1 is N - 1, left_deep(N1, f(T0, a), T).
+
+% Nested in the last argument
+right_deep(0, T, T) :- !.
+right_deep(N, T0, T) :- N1 is N - 1, right_deep(N1, g(a, T0), T).
+
+:- export(test_unify_left_deep/0).
+:- test test_unify_left_deep # "Unification of terms deeply nested in
+   the first argument".
+test_unify_left_deep :-
+    depth(N),
+    left_deep(N, X, A),
+    left_deep(N, z, B),
+    left_deep(N, y, C),
+    A = B,
+    X == z,
+    \+ B = C.
+
+:- export(test_unify_right_deep/0).
+:- test test_unify_right_deep # "Unification of terms deeply nested in
+   the last argument".
+test_unify_right_deep :-
+    depth(N),
+    right_deep(N, X, A),
+    right_deep(N, z, B),
+    right_deep(N, y, C),
+    A = B,
+    X == z,
+    \+ B = C.
+
+:- export(test_occurs_deep/0).
+:- test test_occurs_deep # "Unification with occurs check of deep
+   terms".
+test_occurs_deep :-
+    depth(N),
+    left_deep(N, X, A),
+    \+ unify_with_occurs_check(X, A),
+    left_deep(N, Y, B),
+    left_deep(N, Z, C),
+    unify_with_occurs_check(B, C),
+    Y == Z,
+    right_deep(N, W, D),
+    \+ unify_with_occurs_check(W, D).
+
+% ---------------------------------------------------------------------------
+% Unification of terms with shared subterms
+
+% A term of size 2^N as a graph of size N
+shared(0, T, T) :- !.
+shared(N, T0, T) :- N1 is N - 1, shared(N1, f(T0, T0), T).
+
+:- export(test_unify_shared/0).
+:- test test_unify_shared # "Unification of terms that share their
+   subterms".
+test_unify_shared :-
+    shared(100, X, T),
+    A = h(T, T),
+    B = h(T, T),
+    A = B,
+    var(X),
+    unify_with_occurs_check(A, B),
+    var(X),
+    \+ unify_with_occurs_check(X, A).
+
+% ---------------------------------------------------------------------------
+% Order of the bindings
+
+:- export(test_unify_order/0).
+:- test test_unify_order # "Arguments are unified left to right".
+test_unify_order :-
+    f(X, Y, X, g(Y)) = f(A, B, B, g(c)),
+    X == c, Y == c, A == c, B == c,
+    \+ f(a, _, b) = f(_, c, a).
@@ -52,11 +52,11 @@ CFUN__PROTO(fu2_compare, tagged_t, tagged_t x1, tagged_t x2) {
   }
 }
 
-static CFUN__PROTO(compare__2, int, tagged_t x1, tagged_t x2);
-static CFUN__PROTO(compare__args, int,
-                   arity_t arity,
-                   tagged_t *pt1, tagged_t *pt2,
-                   tagged_t *x1, tagged_t *x2);
+static CFUN__PROTO(compare__2, int, argstk_t *s, tagged_t x1, tagged_t x2);
+static CVOID__PROTO(compare__args,
+                    argstk_t *s, arity_t arity,
+                    tagged_t *pt1, tagged_t *pt2,
+                    tagged_t *x1, tagged_t *x2);
 
 /* help function for builtin compare/3
  * returns -1 if u @< v
@@ -64,7 +64,11 @@ static CFUN__PROTO(compare__args, int,
  * returns +1 if u @> v
  */
 static CFUN__PROTO(compare__1, int, tagged_t x1, tagged_t x2) {
-  int result = CFUN__EVAL(compare__2,x1,x2);
+  argstk_t s;
+  int result;
+  ARGSTK__INIT(s);
+  result = CFUN__EVAL(compare__2,&s,x1,x2);
+  ARGSTK__FREE(s);
   VALUETRAIL__UNDO();
   CFUN__PROCEED(result);
 }
@@ -85,26 +89,32 @@ static CFUN__PROTO(compare__1, int, tagged_t x1, tagged_t x2) {
     urank = 4; \
   })
 
-static CFUN__PROTO(compare__2, int, tagged_t x1, tagged_t x2) {
+/* Iterative: the arguments of complex terms that remain to be
+   compared are kept in the argument stack (when the current pair is
+   equal, continue with the next pending argument) */
+#define COMPARE_RESULT(R) do { result = (R); goto done; } while(0)
+
+static CFUN__PROTO(compare__2, int, argstk_t *s, tagged_t x1, tagged_t x2) {
   tagged_t u;
   tagged_t v;
   tagged_t *pt1;
   tagged_t *pt2;
   int i, j, urank, vrank;
+  int result;
 
  in:
   u=x1;
   v=x2;
   DerefSw_HVAorCVAorSVA_Other(u,{ goto var_x; },{});
-  DerefSw_HVAorCVAorSVA_Other(v,{ CFUN__PROCEED(1); },{});
-  if (u==v) return 0;
+  DerefSw_HVAorCVAorSVA_Other(v,{ COMPARE_RESULT(1); },{});
+  if (u==v) COMPARE_RESULT(0);
   if (TaggedIsSmall(u) && TaggedIsSmall(v)) goto var_var;
 
   GetRank(u, urank);
   GetRank(v, vrank);
 
-  if (urank<vrank) CFUN__PROCEED(-1);
-  if (urank>vrank) CFUN__PROCEED(1);
+  if (urank<vrank) COMPARE_RESULT(-1);
+  if (urank>vrank) COMPARE_RESULT(1);
   /* same rank */
   switch (urank) {
   case 1: /* FLO, FLO */
@@ -113,9 +123,9 @@ static CFUN__PROTO(compare__2, int, tagged_t x1, tagged_t x2) {
       flt64_t f2 = TaggedToFloat(v);
 
       if (f1<f2) {
-        CFUN__PROCEED(-1);
+        COMPARE_RESULT(-1);
       } else if (f1>f2) {
-        CFUN__PROCEED(1);
+        COMPARE_RESULT(1);
       } else {
         /* otherwise, compare bits (this is lexicographical ordering) */
         union {
@@ -129,25 +139,25 @@ static CFUN__PROTO(compare__2, int, tagged_t x1, tagged_t x2) {
         u2.f = -u2.f;
 #if LOG2_bignum_size == 5
         if (u1.p[0] == u2.p[0]) {
-          CFUN__PROCEED(u1.p[1] < u2.p[1] ? -1 : u1.p[1] > u2.p[1] ? 1 : 0);
+          COMPARE_RESULT(u1.p[1] < u2.p[1] ? -1 : u1.p[1] > u2.p[1] ? 1 : 0);
         } else {
-          CFUN__PROCEED(u1.p[0] < u2.p[0] ? -1 : /*u1.p[0] > u2.p[0] ?*/ 1 /*: 0*/);
+          COMPARE_RESULT(u1.p[0] < u2.p[0] ? -1 : /*u1.p[0] > u2.p[0] ?*/ 1 /*: 0*/);
         }
 #elif LOG2_bignum_size == 6
-        CFUN__PROCEED(u1.p[0] < u2.p[0] ? -1 : u1.p[0] > u2.p[0] ? 1 : 0);
+        COMPARE_RESULT(u1.p[0] < u2.p[0] ? -1 : u1.p[0] > u2.p[0] ? 1 : 0);
 #endif
       }
     }
   case 2: /* INT, INT */
     {
       if (TaggedIsSmall(u)&&TaggedIsSmall(v)) {
-        CFUN__PROCEED(u<v ? -1 : u>v);
+        COMPARE_RESULT(u<v ? -1 : u>v);
       } else if (TaggedIsSmall(u)) {
-        CFUN__PROCEED(bn_positive(TaggedToBignum(v)) ? -1 : 1);
+        COMPARE_RESULT(bn_positive(TaggedToBignum(v)) ? -1 : 1);
       } else if (TaggedIsSmall(v)) {
-        CFUN__PROCEED(bn_positive(TaggedToBignum(u)) ? 1 : -1);
+        COMPARE_RESULT(bn_positive(TaggedToBignum(u)) ? 1 : -1);
       } else {
-        CFUN__PROCEED(bn_compare(TaggedToBignum(u),TaggedToBignum(v)));
+        COMPARE_RESULT(bn_compare(TaggedToBignum(u),TaggedToBignum(v)));
       }
     }
   case 3: /* ATM, ATM */
@@ -156,11 +166,10 @@ static CFUN__PROTO(compare__2, int, tagged_t x1, tagged_t x2) {
     DecompComplex(u, pt1, i);
     DecompComplex(v, pt2, j);
     if (u==v) {
-      int result = CFUN__EVAL(compare__args,i,pt1,pt2,&x1,&x2);
-      if (result != 0) CFUN__PROCEED(result);
+      CVOID__CALL(compare__args,s,i,pt1,pt2,&x1,&x2);
       goto in;
     } else if (i!=j) {
-      CFUN__PROCEED(i<j ? -1 : 1);
+      COMPARE_RESULT(i<j ? -1 : 1);
     } else {
       goto compare_uv;
     }
@@ -173,26 +182,36 @@ static CFUN__PROTO(compare__2, int, tagged_t x1, tagged_t x2) {
     unsigned char *vp = (unsigned char *)GetString(v);
 
     while ((u = *up++) && (v = *vp++)) {
-      if (u!=v) CFUN__PROCEED((u<v ? -1 : 1));
+      if (u!=v) COMPARE_RESULT((u<v ? -1 : 1));
     }
-    CFUN__PROCEED(u ? 1 : v ? -1 : 0);
+    COMPARE_RESULT(u ? 1 : v ? -1 : 0);
   }
 
  var_x:
   DerefSw_HVAorCVAorSVA_Other(v, {
     goto var_var;
   },{
-    CFUN__PROCEED(-1);
+    COMPARE_RESULT(-1);
   });
  var_var:
-  CFUN__PROCEED(u<v ? -1 : u>v ? 1 : 0);
+  COMPARE_RESULT(u<v ? -1 : u>v ? 1 : 0);
+
+ done:
+  if (result == 0 && !ARGSTK__EMPTY(*s)) {
+    ARGSTK__POP(*s, pt1, pt2, i);
+    CVOID__CALL(compare__args,s,i,pt1,pt2,&x1,&x2);
+    goto in;
+  }
+  CFUN__PROCEED(result);
 }
 
-static CFUN__PROTO(compare__args, int,
-                   arity_t arity,
-                   tagged_t *pt1, tagged_t *pt2,
-                   tagged_t *x1, tagged_t *x2) {
-  int result;
+/* Find the next pair of arguments to compare (x1 and x2). If it is
+   not the last one, the rest of the block is pushed on the argument
+   stack. */
+static CVOID__PROTO(compare__args,
+                    argstk_t *s, arity_t arity,
+                    tagged_t *pt1, tagged_t *pt2,
+                    tagged_t *x1, tagged_t *x2) {
   tagged_t t1 = ~0; /* Avoid compiler complaints */
   tagged_t t2 = ~0;
   
@@ -204,7 +223,14 @@ static CFUN__PROTO(compare__args, int,
 #else
   VALUETRAIL__TEST_OVERFLOW(2*CHOICEPAD);
 #endif
-  for (result=0; !result && arity>0; --arity) {
+  /* Skip identical words (the whole block if it is bitwise identical) */
+  if (arity == 0 || pt1 == pt2) goto identical;
+  for (; *pt1 == *pt2; --arity) {
+    if (arity == 1) goto identical;
+    pt1++;
+    pt2++;
+  }
+  for (; arity>0; --arity) {
     t1 = *pt1;
     t2 = *pt2;
     /* TODO: share with code from unify_args_loop in engine/absmach_def.pl */
@@ -229,16 +255,18 @@ static CFUN__PROTO(compare__args, int,
         }, { goto noforward; });
       }
     noforward:
-      if (arity>1 && t1!=t2) result = CFUN__EVAL(compare__2,t1,t2);
+      if (arity>1 && t1!=t2) {
+        /* compare this pair first, resume the rest later */
+        ARGSTK__PUSH(*s, pt1+1, pt2+1, arity-1);
+        break;
+      }
     }
     pt1++;
     pt2++;
   }
   
-  if (!result) {
-    *x1 = t1;
-    *x2 = t2;
-  }
+  *x1 = t1;
+  *x2 = t2;
 
 #if defined(OPTIM_COMP)
   /* TODO: remove.. it seems to be unnecessary */
@@ -246,6 +274,8 @@ static CFUN__PROTO(compare__args, int,
 #else
   VALUETRAIL__TEST_OVERFLOW(CHOICEPAD);
 #endif
-
-  CFUN__PROCEED(result);
+  CVOID__PROCEED;
+ identical:
+  *x1 = atom_nil;
+  *x2 = atom_nil;
 }
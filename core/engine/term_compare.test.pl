@@ -0,0 +1,75 @@
+:- module(_, [], [assertions]).
+
+:- doc(title, "Tests for term_compare.pl").
+
+% ---------------------------------------------------------------------------
+% Comparison of deep terms (deeper than the C stack would allow for a
+% recursive traversal)
+
+depth(1000000).
+
+% Nested in the first argument
+left_deep(0, T, T) :- !.
+left_deep(N, T0, T) :- N1 is N - 1, left_deep(N1, f(T0, a), T).
+
+% Nested in the last argument
+right_deep(0, T, T) :- !.
+right_deep(N, T0, T) :- N1 is N - 1, right_deep(N1, g(a, T0), T).
+
+:- export(test_compare_left_deep/0).
+:- test test_compare_left_deep # "Comparison of terms deeply nested in
+   the first argument".
+test_compare_left_deep :-
+    depth(N),
+    left_deep(N, b, A),
+    left_deep(N, b, B),
+    left_deep(N, c, C),
+    A == B,
+    A \== C,
+    compare(O1, A, C), O1 == (<),
+    compare(O2, C, B), O2 == (>),
+    compare(O3, A, B), O3 == (=).
+
+:- export(test_compare_right_deep/0).
+:- test test_compare_right_deep # "Comparison of terms deeply nested in
+   the last argument".
+test_compare_right_deep :-
+    depth(N),
+    right_deep(N, b, A),
+    right_deep(N, b, B),
+    right_deep(N, c, C),
+    A == B,
+    A \== C,
+    compare(O1, A, C), O1 == (<),
+    compare(O2, C, B), O2 == (>),
+    compare(O3, A, B), O3 == (=).
+
+% ---------------------------------------------------------------------------
+% Comparison of terms with shared subterms
+
+% A term of size 2^N as a graph of size N
+shared(0, T, T) :- !.
+shared(N, T0, T) :- N1 is N - 1, shared(N1, f(T0, T0), T).
+
+:- export(test_compare_shared/0).
+:- test test_compare_shared # "Comparison of terms that share their
+   subterms".
+test_compare_shared :-
+    shared(100, x, T),
+    A = h(T, T, a),
+    B = h(T, T, b),
+    A \== B,
+    compare(O1, A, B), O1 == (<),
+    compare(O2, h(T, T), h(T, T)), O2 == (=).
+
+% ---------------------------------------------------------------------------
+% Standard order
+
+:- export(test_compare_order/0).
+:- test test_compare_order # "Arguments are compared left to right".
+test_compare_order :-
+    compare(O1, f(a, c), f(b, a)), O1 == (<),
+    compare(O2, f(g(a), b), f(g(a), a)), O2 == (>),
+    compare(O3, f(X, b), f(X, a)), O3 == (>),
+    compare(O4, [1, 2, 3], [1, 2]), O4 == (>),
+    compare(O5, g(a), f(a, a)), O5 == (<).
@@ -367,10 +367,19 @@ is_c_list_prop(c_uint8_list(ListVar), c_uint8, ListVar).
 is_c_list_prop(c_int_list(ListVar), c_int, ListVar).
 is_c_list_prop(c_double_list(ListVar), c_double, ListVar).
 
+% (size_of/3 is optional for vectors, only needed for output ones)
+is_c_vec_prop(c_int8_vec(VecVar), c_int8, VecVar).
+is_c_vec_prop(c_int16_vec(VecVar), c_int16, VecVar).
+is_c_vec_prop(c_int32_vec(VecVar), c_int32, VecVar).
+is_c_vec_prop(c_int64_vec(VecVar), c_int64, VecVar).
+is_c_vec_prop(c_double_vec(VecVar), c_double, VecVar).
+
 valid_size_of_property(Arguments, ListVar, SizeVar, DP) :-
     \+ nocontainsx(Arguments, ListVar), 
     \+ nocontainsx(Arguments, SizeVar), 
-    ( is_c_list_prop(ListProp, _CType, ListVar),
+    ( ( is_c_list_prop(ListProp, _CType, ListVar)
+      ; is_c_vec_prop(ListProp, _CType, ListVar)
+      ),
       \+ nocontainsx(DP, ListProp) ->
         true
     ; fail
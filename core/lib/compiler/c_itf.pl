@@ -133,6 +133,7 @@ define_flag(rtchecks_asrloc,         [yes, no],                yes).
 define_flag(rtchecks_predloc,        [yes, no],                yes).
 define_flag(rtchecks_callloc,        [no, literal, predicate], predicate).
 define_flag(rtchecks_namefmt,        [short, long],            long).
+define_flag(rtchecks_sample,         integer,                  1).
 
 % Keep asertions after reading
 % TODO: This is a temporary hack for assertions/assrt_lib. It needs better integration.
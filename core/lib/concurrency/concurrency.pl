@@ -246,6 +246,40 @@ eng_status :- '$eng_status'.
 :- impl_defined('$eng_status'/0).
 :- endif.
 
+% ---------------------------------------------------------------------------
+:- export(eng_lock_stats/1).
+:- pred eng_lock_stats(OnOff) : var => atm(OnOff)
+   # "@var{OnOff} is @tt{on} if contention statistics are being
+   collected for engine locks (atom locks, concurrent predicates,
+   memory manager, etc.), and @tt{off} otherwise.".
+:- pred eng_lock_stats(OnOff) : atm
+   # "Enable (@tt{on}) or disable (@tt{off}) the collection of
+   contention statistics for engine locks. The statistics are printed
+   by @pred{eng_status/0} and available through
+   @tt{statistics(lock_contention, L)}.".
+
+eng_lock_stats(OnOff) :- var(OnOff), !, '$lockstat_get'(OnOff).
+eng_lock_stats(OnOff) :- '$lockstat_set'(OnOff).
+
+:- export(eng_lock_stats_reset/0).
+:- pred eng_lock_stats_reset
+   # "Reset the engine lock contention counters.".
+
+eng_lock_stats_reset :- '$lockstat_reset'.
+
+:- if(defined(optim_comp)).
+:- '$props'('$lockstat_set'/1, [impnat=cbool(prolog_lockstat_set)]).
+:- '$props'('$lockstat_get'/1, [impnat=cbool(prolog_lockstat_get)]).
+:- '$props'('$lockstat_reset'/0, [impnat=cbool(prolog_lockstat_reset)]).
+:- else.
+:- trust pred '$lockstat_set'(OnOff) : atm(OnOff).
+:- impl_defined('$lockstat_set'/1).
+:- trust pred '$lockstat_get'(OnOff) => atm(OnOff).
+:- impl_defined('$lockstat_get'/1).
+:- trust pred '$lockstat_reset'.
+:- impl_defined('$lockstat_reset'/0).
+:- endif.
+
 % ---------------------------------------------------------------------------
 :- export(eng_goal_id/1).
 :- pred eng_goal_id(?GoalId)
@@ -267,10 +267,50 @@ c_int_list(List) :- list(c_int,List).
 :- regtype c_double_list(List) # "@var{List} is a list of @regtype{c_double/1}.".
 c_double_list(List) :- list(c_double,List).
 
+:- export(c_int8_vec/1).
+:- regtype c_int8_vec(V) # "@var{V} is a packed numeric vector (see
+   @lib{numvec}) of C @tt{int8_t} elements. Input vectors are passed to C
+   as a pointer to the vector data, which can be read and filled in
+   place. Output vectors are copied from a C array and need a
+   @prop{size_of/3} property.".
+c_int8_vec('$numvec'(int8, N, Data)) :- int(N), int(Data).
+
+:- export(c_int16_vec/1).
+:- regtype c_int16_vec(V) # "@var{V} is a packed numeric vector (see
+   @lib{numvec}) of C @tt{int16_t} elements. Input vectors are passed to C
+   as a pointer to the vector data, which can be read and filled in
+   place. Output vectors are copied from a C array and need a
+   @prop{size_of/3} property.".
+c_int16_vec('$numvec'(int16, N, Data)) :- int(N), int(Data).
+
+:- export(c_int32_vec/1).
+:- regtype c_int32_vec(V) # "@var{V} is a packed numeric vector (see
+   @lib{numvec}) of C @tt{int32_t} elements. Input vectors are passed to C
+   as a pointer to the vector data, which can be read and filled in
+   place. Output vectors are copied from a C array and need a
+   @prop{size_of/3} property.".
+c_int32_vec('$numvec'(int32, N, Data)) :- int(N), int(Data).
+
+:- export(c_int64_vec/1).
+:- regtype c_int64_vec(V) # "@var{V} is a packed numeric vector (see
+   @lib{numvec}) of C @tt{int64_t} elements. Input vectors are passed to C
+   as a pointer to the vector data, which can be read and filled in
+   place. Output vectors are copied from a C array and need a
+   @prop{size_of/3} property.".
+c_int64_vec('$numvec'(int64, N, Data)) :- int(N), int(Data).
+
+:- export(c_double_vec/1).
+:- regtype c_double_vec(V) # "@var{V} is a packed numeric vector (see
+   @lib{numvec}) of C @tt{double} elements. Input vectors are passed to C
+   as a pointer to the vector data, which can be read and filled in
+   place. Output vectors are copied from a C array and need a
+   @prop{size_of/3} property.".
+c_double_vec('$numvec'(float64, N, Data)) :- int(N), int(Data).
+
 :- export(size_of/3).
 :- prop size_of(Name,ListVar,SizeVar)
-   # "For predicate @var{Name}, the size of the list argument
-   @var{ListVar}, is given by the argument of type integer
+   # "For predicate @var{Name}, the size of the list (or vector)
+   argument @var{ListVar}, is given by the argument of type integer
    @var{SizeVar}.".
 size_of(_,_,_).
 
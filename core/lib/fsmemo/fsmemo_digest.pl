@@ -0,0 +1,15 @@
+:- module(fsmemo_digest, [file_digest/2], [foreign_interface, assertions, isomodes]).
+
+:- doc(title, "Content digests for fsmemo").
+:- doc(author, "The Ciao Development Team").
+
+:- doc(module, "Digests of the contents of files, used by
+   @lib{fsmemo} to detect changes in the data of tasks.").
+
+:- trust pred file_digest(in(File), go(Digest)) ::
+    atm * any_term + (foreign(fsmemo_file_digest), returns(Digest))
+   # "@var{Digest} is an atom that identifies the contents of
+   @var{File} (its size and a 64-bit FNV-1a hash), or @tt{''} if the
+   file cannot be read (or there is not enough memory).".
+
+:- use_foreign_source(fsmemo_digest_c).
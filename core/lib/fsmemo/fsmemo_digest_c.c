@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <ciao_prolog.h>
+
+#define DIGEST_BUFSIZE 65536
+
+/* Size and 64-bit FNV-1a hash of the contents of a file, as an atom
+   ('' if the file cannot be read) */
+ciao_term fsmemo_file_digest(char *file) {
+  FILE *f;
+  unsigned char *buf;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  uint64_t size = 0;
+  size_t i, n;
+  char digest[64];
+
+  digest[0] = '\0';
+  if ((f = fopen(file, "rb")) == NULL) return ciao_atom(digest);
+  if ((buf = (unsigned char *)malloc(DIGEST_BUFSIZE)) == NULL) {
+    fclose(f);
+    return ciao_atom(digest);
+  }
+  while ((n = fread(buf, 1, DIGEST_BUFSIZE, f)) > 0) {
+    for (i = 0; i < n; i++) {
+      hash ^= buf[i];
+      hash *= 0x100000001b3ULL;
+    }
+    size += n;
+  }
+  if (!ferror(f)) {
+    snprintf(digest, sizeof(digest), "%llu-%016llx",
+             (unsigned long long)size, (unsigned long long)hash);
+  }
+  free(buf);
+  fclose(f);
+  return ciao_atom(digest);
+}
@@ -11,7 +11,8 @@ This package offers a minimalistic interface to execute tasks with
 file-based memoization. Tasks produce output in files and take as
 input files or the output of other tasks. Tasks are memoized (not
 recomputed unless their input data has changed). Detection of changes
-in data is approximated by timestamps.
+in data is approximated by timestamps, optionally refined with digests
+of the file contents (see below).
 
 Definition of a task:
 @begin{verbatim}
@@ -29,12 +30,27 @@ We assume that:
 
 The @pred{fsmemo_call/1} predicate schedules and runs the tasks
 preserving the dependency order.
+
+The @pred{fsmemo_call/2} predicate accepts options to run independent
+tasks in parallel (@tt{jobs(N)}) and to keep a @em{manifest} file with
+the digests of the contents of the results and dependencies of each
+task (@tt{manifest(File)}). Tasks whose dependencies and result have
+the same contents as recorded in the manifest are not run again, even
+if their timestamps say otherwise (e.g., after touching a file or
+after a dependency is recomputed with the same result):
+
+@begin{verbatim}
+   fsmemo_call([all], [jobs(4), manifest('/path/to/build.manifest')])
+@end{verbatim}
+
+Tasks running in parallel are executed in different threads, so their
+code must be thread-safe.
 ").
 
 :- doc(bug, "Use nested syntax? E.g., task(A,B).deps(Deps) :- ...").
 :- doc(bug, "Document predicates, exceptions").
 :- doc(bug, "Do not use find_file/2").
 :- doc(bug, "Improve documentation").
-:- doc(bug, "Add locks and parallel execution, etc. (reuse existing
-   parallelism and memoization/tabling features in Ciao)").
+:- doc(bug, "Add locks (e.g., for several processes sharing the
+   same manifest)").
 
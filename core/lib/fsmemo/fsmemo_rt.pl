@@ -6,7 +6,11 @@
 :- use_module(library(port_reify), [once_port_reify/2, port_call/1]).
 :- use_module(library(system), [file_exists/1]).
 :- use_module(library(compiler/up_to_date), [up_to_date/2]).
-:- use_module(library(lists), [member/2]).
+:- use_module(library(lists), [member/2, select/3]).
+:- use_module(library(concurrency), [eng_call/4, eng_wait/1, eng_release/1]).
+:- use_module(library(fastrw), [fast_read/2, fast_write/2]).
+:- use_module(engine(stream_basic), [open/3, close/1]).
+:- use_module(library(fsmemo/fsmemo_digest), [file_digest/2]).
 
 :- include(library(fsmemo/fsmemo_defs)).
 
@@ -28,16 +32,52 @@ clean_status :-
    the dependency order and reusing already computed results.".
 
 fsmemo_call(Tasks) :-
+    fsmemo_call(Tasks, []).
+
+:- export(fsmemo_call/2).
+:- pred fsmemo_call(Tasks, Opts) # "Like @pred{fsmemo_call/1}, with
+   the options @var{Opts}:
+   @begin{itemize}
+   @item @tt{jobs(N)}: run up to @var{N} independent tasks in parallel
+     (each in its own engine and thread). Default is 1.
+   @item @tt{manifest(File)}: keep in @var{File} the digests of the
+     contents of the result and the dependencies of each task run, and
+     skip tasks whose dependencies have the same contents as in the
+     last run (even if their timestamps have changed).
+   @end{itemize}".
+
+fsmemo_call(Tasks, Opts) :-
+    ( member(jobs(Jobs), Opts) -> true ; Jobs = 1 ),
+    ( member(manifest(Manifest), Opts) -> load_manifest(Manifest)
+    ; clean_memo
+    ),
     clean_status,
-    once_port_reify(schedule_tasks(Tasks, Bs, []), Port),
-    clean_status,
-%       ( member(B, Bs), display(B), nl, fail ; true ),
+    once_port_reify(schedule_tasks(Tasks, Nodes, []), Port),
+    ( Port = success -> true ; clean_status ),
     port_call(Port),
-    run_tasks(Bs).
+%       ( member(B, Nodes), display(B), nl, fail ; true ),
+    once_port_reify(run_tasks(Nodes, Jobs), RunPort),
+    ( var(Manifest) -> true ; save_manifest(Manifest) ),
+    clean_status,
+    clean_memo,
+    port_call(RunPort).
 
-run_tasks([]).
-run_tasks([Task|Tasks]) :-
-    run_task(Task), run_tasks(Tasks).
+% Nodes are node(Task, Key, DepKeys), in dependency order
+
+run_tasks(Nodes, Jobs) :-
+    Jobs > 1, !,
+    run_par(Nodes, Jobs, 0, none).
+run_tasks(Nodes, _) :-
+    run_seq(Nodes).
+
+run_seq([]).
+run_seq([Node|Nodes]) :-
+    ( unchanged(Node) -> true
+    ; Node = node(Task, _, _),
+      run_task(Task),
+      task_done(Node)
+    ),
+    run_seq(Nodes).
 
 run_task(Task) :-
     ( Task = true -> true
@@ -45,6 +85,144 @@ run_task(Task) :-
     ; throw(error(failed(Task), fsmemo_call/1))
     ).
 
+% ---------------------------------------------------------------------------
+% Parallel execution
+
+:- concurrent job_result/2.
+:- data job/2.
+
+% Run the nodes in Pending (with Running tasks running and at most
+% Jobs at the same time). Error is the first exception raised by a
+% task (no more tasks are started after it).
+run_par([], _, 0, Error) :- !,
+    ( Error = none -> true
+    ; throw(Error)
+    ).
+run_par(Pending, Jobs, Running, Error) :-
+    Error = none,
+    Running < Jobs,
+    select(Node, Pending, Pending1),
+    ready(Node), !,
+    ( unchanged(Node) ->
+        Running1 = Running
+    ; start_job(Node),
+      Running1 is Running + 1
+    ),
+    run_par(Pending1, Jobs, Running1, Error).
+run_par(Pending, Jobs, Running, Error) :-
+    Running > 0, !,
+    wait_job(Node, Result),
+    Running1 is Running - 1,
+    ( Result = ok ->
+        task_done(Node),
+        Error1 = Error
+    ; Error = none ->
+        Result = exception(Error1)
+    ; Error1 = Error
+    ),
+    ( Error1 = none -> Pending1 = Pending
+    ; Pending1 = [] % (do not wait for pending tasks)
+    ),
+    run_par(Pending1, Jobs, Running1, Error1).
+
+% All the dependencies of the task are computed
+ready(node(_, _, DepKeys)) :-
+    \+ ( member(DepKey, DepKeys),
+         task_status(DepKey, Status),
+         ( Status = processed ; Status = running ) ).
+
+start_job(Node) :-
+    Node = node(Task, Key, _),
+    set_status(Key, running),
+    eng_call(job(Key, Task), create, create, GoalId),
+    assertz_fact(job(Node, GoalId)).
+
+job(Key, Task) :-
+    catch((run_task(Task), Result = ok), E, Result = exception(E)),
+    assertz_fact(job_result(Key, Result)).
+
+wait_job(Node, Result) :-
+    retract_fact(job_result(Key, Result)), !,
+    Node = node(_, Key, _),
+    retract_fact(job(Node, GoalId)), !,
+    eng_wait(GoalId),
+    eng_release(GoalId).
+
+% ---------------------------------------------------------------------------
+% Content digests
+
+:- data manifest_file/1.
+:- data memo/3. % memo(Key, Digest, DepDigests)
+:- data digest_cache/2.
+
+clean_memo :-
+    retractall_fact(manifest_file(_)),
+    retractall_fact(memo(_, _, _)),
+    retractall_fact(digest_cache(_, _)).
+
+% The task result and its dependencies have the same contents as in
+% the last run (the task is marked as done)
+unchanged(node(_, Key, DepKeys)) :-
+    memo(Key, Digest, DepDigests), !,
+    Digest \== '',
+    key_digest(Key, Digest),
+    dep_digests(DepKeys, DepDigests),
+    set_status(Key, done).
+
+task_done(node(_, Key, DepKeys)) :-
+    set_status(Key, done),
+    ( current_fact(manifest_file(_)) ->
+        retractall_fact(digest_cache(Key, _)),
+        key_digest(Key, Digest),
+        dep_digests(DepKeys, DepDigests),
+        retractall_fact(memo(Key, _, _)),
+        assertz_fact(memo(Key, Digest, DepDigests))
+    ; true
+    ).
+
+dep_digests([], []).
+dep_digests([DepKey|DepKeys], [DepKey-Digest|DepDigests]) :-
+    key_digest(DepKey, Digest),
+    dep_digests(DepKeys, DepDigests).
+
+key_digest(Key, Digest) :-
+    ( current_fact(digest_cache(Key, Digest0)) -> true
+    ; key_to_file(Key, File),
+      file_digest(File, Digest0),
+      assertz_fact(digest_cache(Key, Digest0))
+    ),
+    Digest = Digest0.
+
+load_manifest(File) :-
+    clean_memo,
+    assertz_fact(manifest_file(File)),
+    ( file_exists(File) ->
+        open(File, read, S),
+        ( fast_read(S, '$fsmemo'(1)) -> load_memo(S) ; true ),
+        close(S)
+    ; true
+    ).
+
+% (fast_read/2 fails at the end of the file)
+load_memo(S) :-
+    ( fast_read(S, memo(Key, Digest, DepDigests)) ->
+        assertz_fact(memo(Key, Digest, DepDigests)),
+        load_memo(S)
+    ; true
+    ).
+
+save_manifest(File) :-
+    open(File, write, S),
+    fast_write(S, '$fsmemo'(1)),
+    ( current_fact(memo(Key, Digest, DepDigests)),
+        fast_write(S, memo(Key, Digest, DepDigests)),
+        fail
+    ; true
+    ),
+    close(S).
+
+% ---------------------------------------------------------------------------
+
 % Schedule tasks
 schedule_tasks([], R, R) :- !.
 schedule_tasks([Task|Tasks], R1, R) :- !,
@@ -80,7 +258,7 @@ schedule_task(Task, R1, R) :-
           NewStatus = done, % No need to recompute
           R2 = R
       ; NewStatus = processed,
-        R2 = [Task|R]
+        R2 = [node(Task, Key, DepKeys)|R]
       ),
       set_status(Key, NewStatus)
     ).
@@ -144,7 +144,7 @@ standard_ops :-
     op( 550, xfx,[(:)]),
     op( 500, yfx,[(+),(-),(/\),(\/),(#)]),
     op( 500,  fy,[(++),(--)]),
-    op( 400, yfx,[(*),(/),(//),(rem),(mod),(<<),(>>)]),
+    op( 400, yfx,[(*),(/),(//),(rem),(mod),(rdiv),(<<),(>>)]),
     op( 200,  fy,[(+),(-),(\)]),
     op( 200, xfx,['**']),
     op( 200, xfy,[(^)]).
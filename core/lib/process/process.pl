@@ -25,6 +25,8 @@
      primitives otherwise.
    @item Channels connected to in-memory terms are transmited via pipes
      or temporary files (when needed to avoid deadlock problems).
+     Strings, lines, and lists of atoms are sent and received at the
+     same time by a pump that polls the pipes.
    @item Deadlock problems may still appear if the user specifies two
      or more @tt{pipe(_)} channels for the same process (data must be
      send/received concurrently).
@@ -47,9 +49,6 @@
 :- doc(bug, "(feature) Support more IPC primitives (file locks,
    semaphores, shared memory, etc.).").
 
-:- doc(bug, "(feature) Fix asynchronous data transmission using POSIX
-   @tt{select}? We may avoid temporary files then.").
-
 :- doc(bug, "(feature) Complete support for daemons (see example)").
 %
 %  Example of daemon (missing: close parent IO, change dir, etc.)
@@ -230,12 +229,12 @@ process_call(Cmd, Args, Opts) :-
     % Environment variables
     parse_env(Opts, Env),
     % Send input (synchronous before process creation)
-    send_input(sync, InChannelB),
+    send_input(sync, InChannelB, OutChannelB, ErrChannelB),
     % Call process
     process_call__(Cmd, Args, InChannelB, OutChannelB, ErrChannelB,
                    Env, Cwd, SetSid, Pid),
     % Send input (asynchronous after process creation)
-    send_input(async, InChannelB),
+    send_input(async, InChannelB, OutChannelB, ErrChannelB),
     % The process handler
     PCall = pcall(Cmd, Args, Opts2),
     Process = '$process'(_Joined, OnReturn, Pid,
@@ -355,14 +354,11 @@ process_join(Process) :-
     % Mark the process as joined (so that it is not waited twice)
     Joined = yes,
     % Receive output (asynchronous before process termination)
-    % TODO: use this when possible for efficiency
-    receive_output(async, OutChannelB),
-    receive_output(async, ErrChannelB),
+    receive_output(async, InChannelB, OutChannelB, ErrChannelB),
     % Wait for zombie process (if needed) and get return code
     once_port_reify(do_wait(Pid, ReturnCode), WaitR),
     % Receive output (synchronous after process termination)
-    receive_output(sync, OutChannelB),
-    receive_output(sync, ErrChannelB),
+    receive_output(sync, InChannelB, OutChannelB, ErrChannelB),
     % Cleanup temporaries due to channel file-based bindings
     cleanup_binding(InChannelB),
     cleanup_binding(OutChannelB),
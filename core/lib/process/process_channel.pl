@@ -15,9 +15,6 @@
 %   - merge with getopts (for argument serialization)
 %
 
-:- doc(bug, "(feature) Asynchronous data transfer is not really
-   asynchronous").
-
 % ---------------------------------------------------------------------------
 
 :- use_module(library(lists), [append/3]).
@@ -25,6 +22,7 @@
 
 :- use_module(engine(stream_basic)).
 :- use_module(engine(io_basic)).
+:- use_module(engine(internals), ['$process_pump'/6]).
 :- use_module(library(system), [
     file_exists/1,
     mktemp_in_tmp/2,
@@ -37,7 +35,6 @@
 % ===========================================================================
 
 :- doc(section, "Channel bindings (for sync/async data transfer)").
-% TODO: async transfer is not really async
 
 :- export(process_channel/1).
 :- regtype process_channel(Channel) # "A communication channel for
@@ -82,6 +79,11 @@ term_channel(line(_)).
 term_channel(atmlist(_)).
 term_channel(terms(_)).
 
+% A term channel that is transmitted as bytes by the pump
+pump_channel(string(_)).
+pump_channel(line(_)).
+pump_channel(atmlist(_)).
+
 % ---------------------------------------------------------------------------
 
 :- export(channel_bindings/2).
@@ -89,12 +91,11 @@ term_channel(terms(_)).
    # "Create channel bindings (taking into account pipes)".
 channel_bindings(Channels, ChannelBinds) :-
     count_pipes(Channels, Pipes0),
-    channel_bindings_(Channels, ChannelBinds, Pipes0, _Pipes).
+    channel_bindings_(Channels, ChannelBinds, Pipes0-no, _Pipes).
 
 channel_bindings_([], [], Pipes, Pipes).
 channel_bindings_([Channel|Channels], [ChannelBind|ChannelBinds], Pipes0, Pipes) :-
-    channel_binding(Channel, ChannelBind, Pipes0, PipesN),
-    Pipes1 is Pipes0 + PipesN,
+    channel_binding(Channel, ChannelBind, Pipes0, Pipes1),
     channel_bindings_(Channels, ChannelBinds, Pipes1, Pipes).
 
 % Pipes is the number of pipe(_) channels in Channels
@@ -118,10 +119,18 @@ count_pipes_([_|Channels], Pipes0, Pipes) :-
 %   efficiency); terms can be written to temporary files; but
 %   pipes (when used as message queues) CANNOT be written to
 %   temporary files without introducing changes in semantics.
+%
+%   Term channels that are just bytes (strings, lines, and lists of
+%   atoms) are transmited by a pump (see internals:'$process_pump'/6)
+%   that writes the standard input and reads the standard output and
+%   error at the same time (polling the pipes), so that the child
+%   process never blocks on a full pipe. All the pipes of the pump
+%   count as a single pipe.
 
 % Create an appropriate transmission channel for each user channel.
 % Temporary files may be used to avoid deadlocks (see the
-% corresponding bug).
+% corresponding bug), when some other pipe (a pipe(_) channel, or a
+% pipe for terms(_) or for the pump) is already used.
 %
 % The pair of channels is called a channel binding, described as:
 %
@@ -135,6 +144,9 @@ count_pipes_([_|Channels], Pipes0, Pipes) :-
 %     TrMode: automatic transmission mode (w.r.t. the parent process)
 %
 %       @begin{itemize}
+%       @item @tt{TrMode=pump}: transmission by the pump, after the
+%         child process starts (if there is only input) or before the
+%         child process terminates
 %       @item @tt{TrMode=async}: asynchronous transmission (pipe-based)
 %         (send) after the child process starts
 %         (receive) before the child process terminates
@@ -144,24 +156,27 @@ count_pipes_([_|Channels], Pipes0, Pipes) :-
 %       @item @tt{TrMode=none}: no automatic transmission from the
 %         parent process
 %       @end{itemize}
+%
+% The state of the pipes is CurrPipes-Pump, where CurrPipes is the
+% number of pipes in use and Pump is yes if the pump uses one of them.
 
-channel_binding(Channel, ChannelB, CurrPipes, PipesN) :-
+channel_binding(Channel, ChannelB, CurrPipes-Pump, Pipes) :-
     term_channel(Channel),
     !,
-    ( CurrPipes = 0 -> % no pipe is being used yet
-        % Select a pipe channel
-        Channel2 = pipe(_),
-        Tmp = no,
-        ChannelB = '$binding'(Channel, Channel2, Tmp, async, _Res),
-        PipesN = 1
+    ( pump_channel(Channel),
+      ( CurrPipes = 0 ; Pump = yes ) -> % join the pump
+        ChannelB = '$binding'(Channel, pipe(_), no, pump, _Res),
+        ( Pump = yes -> Pipes = CurrPipes-Pump ; Pipes = 1-yes )
+    ; CurrPipes = 0 -> % no pipe is being used yet
+        ChannelB = '$binding'(Channel, pipe(_), no, async, _Res),
+        Pipes = 1-Pump
     ; % Use a temporary file
       % TODO: check umask?
-      mktemp_in_tmp('ciao-channel-XXXXXX', File), Tmp = yes,
-      Channel2 = file(File),
-      ChannelB = '$binding'(Channel, Channel2, Tmp, sync, _Res),
-      PipesN = 0
+      mktemp_in_tmp('ciao-channel-XXXXXX', File),
+      ChannelB = '$binding'(Channel, file(File), yes, sync, _Res),
+      Pipes = CurrPipes-Pump
     ).
-channel_binding(Channel, ChannelB, _CurrPipes, 0) :-
+channel_binding(Channel, ChannelB, Pipes, Pipes) :-
     Res = success, % (no transfer)
     ChannelB = '$binding'(Channel, Channel, no, none, Res).
 
@@ -180,35 +195,133 @@ binding_port_call('$binding'(_Channel, _Channel2, _Tmp, _TrMode, Res)) :-
 
 % ---------------------------------------------------------------------------
 
-:- export(send_input/2).
-:- pred send_input(Mode, ChannelBinding)
-   # "Send input through channel binding
-     @var{ChannelBinding}. Transfer status is internally stored (see
+:- export(send_input/4).
+:- pred send_input(Mode, InChannelB, OutChannelB, ErrChannelB)
+   # "Send input through the standard input channel binding
+     @var{InChannelB}, before the child process starts
+     (@var{Mode}=@tt{sync}) or after it starts
+     (@var{Mode}=@tt{async}). Input for the pump is delayed to
+     @pred{receive_output/4} if some output is also received by the
+     pump. Transfer status is internally stored (see
      @pred{binding_port_call/1}).".
 
-send_input(Mode, '$binding'(Channel, Channel2, _, Mode, Res)) :- !,
+send_input(sync, InB, _OutB, _ErrB) :-
+    send_input_(sync, InB).
+send_input(async, InB, OutB, ErrB) :-
+    ( pending_pump(InB), \+ pending_pump(OutB), \+ pending_pump(ErrB) ->
+        pump(InB, OutB, ErrB)
+    ; true
+    ),
+    send_input_(async, InB).
+
+send_input_(Mode, '$binding'(Channel, Channel2, _, Mode, Res)) :- !,
     ( Channel2 = pipe(Stream) ->
         once_port_reify(write_channel(Stream, Channel), Res)
     ; Channel2 = file(File) ->
         once_port_reify(write_channel_to_file(File, Channel), Res)
     ; Res = success
     ).
-send_input(_, _).
-
-:- export(receive_output/2).
-:- pred receive_output(Mode, ChannelBinding)
-   # "Receive output from channel binding
-     @var{ChannelBinding}. Transfer status is internally stored (see
-     @pred{binding_port_call/1}).".
+send_input_(_, _).
+
+:- export(receive_output/4).
+:- pred receive_output(Mode, InChannelB, OutChannelB, ErrChannelB)
+   # "Receive output from the standard output and error channel
+     bindings @var{OutChannelB} and @var{ErrChannelB}, before the
+     child process terminates (@var{Mode}=@tt{async}, together with
+     any pending input for the pump) or after it terminates
+     (@var{Mode}=@tt{sync}). Transfer status is internally stored
+     (see @pred{binding_port_call/1}).".
+
+receive_output(sync, _InB, OutB, ErrB) :-
+    receive_output_(sync, OutB),
+    receive_output_(sync, ErrB).
+receive_output(async, InB, OutB, ErrB) :-
+    ( ( pending_pump(OutB) ; pending_pump(ErrB) ) ->
+        pump(InB, OutB, ErrB)
+    ; true
+    ),
+    receive_output_(async, OutB),
+    receive_output_(async, ErrB).
 
-receive_output(Mode, '$binding'(Channel, Channel2, _, Mode, Res)) :- !,
+receive_output_(Mode, '$binding'(Channel, Channel2, _, Mode, Res)) :- !,
     ( Channel2 = pipe(Stream) ->
         once_port_reify(read_channel(Stream, Channel), Res)
     ; Channel2 = file(File) ->
         once_port_reify(read_channel_from_file(File, Channel), Res)
     ; Res = success
     ).
-receive_output(_, _).
+receive_output_(_, _).
+
+% ---------------------------------------------------------------------------
+
+pending_pump('$binding'(_, _, _, pump, Res)) :- var(Res).
+
+% Transmit all the pending channels for the pump at the same time
+pump(InB, OutB, ErrB) :-
+    pump_input(InB, InS, InData, InR),
+    pump_output(OutB, OutS),
+    pump_output(ErrB, ErrS),
+    ( '$process_pump'(InS, InData, OutS, ErrS, OutData, ErrData) ->
+        R = success
+    ; R = exception(error(system_error, '$process_pump'/6)),
+      OutData = [], ErrData = []
+    ),
+    pump_input_done(InB, InR, R),
+    pump_output_done(OutB, R, OutData),
+    pump_output_done(ErrB, R, ErrData).
+
+% (InR is the result of obtaining the input bytes, or none)
+pump_input(ChannelB, Stream, Data, InR) :-
+    ChannelB = '$binding'(Channel, pipe(Stream), _, _, _),
+    pending_pump(ChannelB),
+    !,
+    once_port_reify(channel_to_bytes(Channel, Data0), InR),
+    ( InR = success -> Data = Data0
+    ; Data = [] % (just close the input)
+    ).
+pump_input(_, [], [], none).
+
+pump_output(ChannelB, Stream) :-
+    ChannelB = '$binding'(_, pipe(Stream), _, _, _),
+    pending_pump(ChannelB),
+    !.
+pump_output(_, []).
+
+pump_input_done(_, none, _) :- !.
+pump_input_done('$binding'(_, pipe(Stream), _, _, Res), InR, R) :-
+    close(Stream),
+    ( InR = success -> Res = R ; Res = InR ).
+
+pump_output_done(ChannelB, R, Data) :-
+    ChannelB = '$binding'(Channel, pipe(Stream), _, _, Res),
+    pending_pump(ChannelB),
+    !,
+    close(Stream),
+    ( R = success ->
+        once_port_reify(bytes_to_channel(Data, Channel), Res)
+    ; Res = R
+    ).
+pump_output_done(_, _, _).
+
+% Bytes for the channel (same as write_channel/2)
+channel_to_bytes(string(Term), Term).
+channel_to_bytes(line(Term), Bytes) :-
+    append(Term, [0'\n], Bytes).
+channel_to_bytes(atmlist(Term), Bytes) :-
+    atoms_to_lines(Term, Bytes).
+
+:- export(bytes_to_channel/2).
+:- pred bytes_to_channel(Bytes, Channel)
+   # "Unify the term channel @var{Channel} (@tt{string}, @tt{line},
+     or @tt{atmlist}) with the contents @var{Bytes} (same as
+     @pred{read_channel/2}).".
+
+bytes_to_channel(Bytes, string(Term)) :-
+    Term = Bytes.
+bytes_to_channel(Bytes, line(Term)) :-
+    no_tr_nl(Bytes, Term).
+bytes_to_channel(Bytes, atmlist(Term)) :-
+    lines_to_atoms(Bytes, Term).
 
 % ---------------------------------------------------------------------------
 
@@ -314,6 +427,30 @@ read_lines(Stream, Xs) :-
     ).
 read_lines(_, []).
 
+% lines (as read_lines/2) as individual atoms
+lines_to_atoms([], []) :- !.
+lines_to_atoms(Bytes, [X|Xs]) :-
+    bytes_line(Bytes, L, Bytes1),
+    atom_codes(X, L),
+    lines_to_atoms(Bytes1, Xs).
+
+% (like get_line/2, a line ends at a new line character or at the
+% end, ignoring trailing carriage returns)
+bytes_line([], [], []).
+bytes_line([0'\n|Bytes], [], Bytes) :- !.
+bytes_line([0'\r|Bytes0], L, Bytes) :- !,
+    bytes_line(Bytes0, L0, Bytes),
+    ( L0 = [] -> L = [] ; L = [0'\r|L0] ).
+bytes_line([C|Bytes0], [C|L], Bytes) :-
+    bytes_line(Bytes0, L, Bytes).
+
+% individual atoms as lines (as write_lines/2)
+atoms_to_lines([], []).
+atoms_to_lines([X|Xs], Bytes) :-
+    atom_codes(X, L),
+    append(L, [0'\n|Bytes0], Bytes),
+    atoms_to_lines(Xs, Bytes0).
+
 % write individual atoms as lines
 write_lines(_, []) :- !.
 write_lines(Stream, [X|Xs0]) :-
@@ -0,0 +1,218 @@
+:- module(_, [], [assertions, regtypes, isomodes, foreign_interface]).
+
+:- doc(title, "Shared memory channels").
+
+:- doc(author, "The Ciao Development Team").
+
+:- doc(module, "This module provides message channels between
+   processes (see @lib{process}) based on ring buffers in POSIX shared
+   memory. Messages are terms (in the format of @pred{fast_write/1},
+   see @lib{fastrw}) or lists of bytes, which are copied directly to
+   and from the shared memory, without system calls (except to block
+   when the ring is full or empty).
+
+   A channel is created with @pred{shm_channel_create/3} and opened by
+   name from other processes with @pred{shm_channel_open/2}. Channels
+   are also inherited by processes created with
+   @pred{process_fork/2}. For example:
+
+@begin{verbatim}
+?- shm_channel_create('/mychan', [], Ch),
+   process_fork((shm_channel_send(Ch, hello(world)),
+                 shm_channel_finish(Ch)), [background(P)]),
+   shm_channel_receive(Ch, X),
+   shm_channel_receive(Ch, Y),
+   process_join(P),
+   shm_channel_close(Ch),
+   shm_channel_unlink('/mychan').
+
+X = hello(world),
+Y = end_of_file ?
+@end{verbatim}
+
+   By default channels have a single producer and a single consumer
+   at a time (lock-free). Use the @tt{mpmc} option for several
+   producers and consumers.
+").
+
+:- doc(bug, "Blocking on a full or empty ring is implemented with
+   futexes on Linux and by yielding the processor in other
+   systems.").
+:- doc(bug, "Waiting processes are not interrupted by Prolog
+   signals.").
+:- doc(bug, "Terms with more than 1024 variables or functors with
+   arity greater than 255 cannot be sent (as in @lib{fastrw}).").
+
+% ---------------------------------------------------------------------------
+
+:- use_module(library(lists), [length/2]).
+
+% ---------------------------------------------------------------------------
+
+:- export(shm_channel/1).
+:- regtype shm_channel/1 # "A shared memory channel handler".
+shm_channel('$shm_channel'(Addr)) :- address(Addr).
+
+:- export(shm_channel_option/1).
+:- regtype shm_channel_option/1 # "Options for
+   @pred{shm_channel_create/3}".
+:- doc(shm_channel_option/1, "
+   @begin{description}
+   @item{@tt{size(Bytes)}} size of the ring (at least @var{Bytes},
+     rounded to a power of two; 1MB by default). Each message takes
+     its size plus 4 bytes, rounded to 8 bytes, and must fit in the
+     ring.
+   @item{@tt{mpmc}} allow several producers and consumers at the same
+     time.
+   @end{description}
+").
+shm_channel_option(size(Bytes)) :- int(Bytes).
+shm_channel_option(mpmc).
+
+:- export(shm_channel_create/3).
+:- pred shm_channel_create(+Name, +Opts, -Ch)
+   : ( atm(Name), list(shm_channel_option, Opts) ) => shm_channel(Ch)
+   # "Create a new channel @var{Ch} with the shared memory object
+      @var{Name} (which must start with @tt{/} and must not exist).".
+
+shm_channel_create(Name, Opts, Ch) :-
+    ( member_opt(size(Size), Opts) -> true ; Size = 1048576 ),
+    ( member_opt(mpmc, Opts) -> Flags = 1 ; Flags = 0 ),
+    shm_channel_create_c(Name, Size, Flags, Addr),
+    check_addr(Addr, shm_channel_create(Name, Opts, Ch)),
+    Ch = '$shm_channel'(Addr).
+
+member_opt(X, [Y|Ys]) :- ( X = Y -> true ; member_opt(X, Ys) ).
+
+:- export(shm_channel_open/2).
+:- pred shm_channel_open(+Name, -Ch) : atm(Name) => shm_channel(Ch)
+   # "Open the existing channel @var{Ch} with the shared memory object
+      @var{Name}.".
+
+shm_channel_open(Name, Ch) :-
+    shm_channel_open_c(Name, Addr),
+    check_addr(Addr, shm_channel_open(Name, Ch)),
+    Ch = '$shm_channel'(Addr).
+
+check_addr(Addr, Goal) :-
+    ( null(Addr) ->
+        functor(Goal, N, A),
+        throw(error(system_error(shm_channel(Goal)), N/A))
+    ; true
+    ).
+
+:- export(shm_channel_close/1).
+:- pred shm_channel_close(+Ch) : shm_channel(Ch)
+   # "Release the channel @var{Ch} in this process (which must not be
+      used afterwards). The shared memory object is not removed (see
+      @pred{shm_channel_unlink/1}).".
+
+shm_channel_close('$shm_channel'(Addr)) :-
+    shm_channel_close_c(Addr).
+
+:- export(shm_channel_unlink/1).
+:- pred shm_channel_unlink(+Name) : atm(Name)
+   # "Remove the shared memory object @var{Name}. Processes that
+      already opened it can still use it.".
+
+shm_channel_unlink(Name) :-
+    shm_channel_unlink_c(Name, Ok),
+    ( Ok =:= 1 -> true
+    ; throw(error(system_error(shm_channel(shm_channel_unlink(Name))),
+                  shm_channel_unlink/1))
+    ).
+
+:- export(shm_channel_finish/1).
+:- pred shm_channel_finish(+Ch) : shm_channel(Ch)
+   # "No more messages will be sent through @var{Ch}. Pending messages
+      can still be received, and then receivers get
+      @tt{end_of_file}.".
+
+shm_channel_finish('$shm_channel'(Addr)) :-
+    shm_channel_finish_c(Addr).
+
+% ---------------------------------------------------------------------------
+
+:- export(shm_channel_send/2).
+:- pred shm_channel_send(+Ch, @Term) : shm_channel(Ch)
+   # "Send a copy of @var{Term} through @var{Ch} (waiting while the ring
+      is full).".
+
+shm_channel_send(Ch, Term) :-
+    Ch = '$shm_channel'(Addr),
+    shm_channel_send_c(Addr, Term, R),
+    check_send(R, shm_channel_send(Ch, Term)).
+
+:- export(shm_channel_receive/2).
+:- pred shm_channel_receive(+Ch, ?Term) : shm_channel(Ch)
+   # "Receive the next message of @var{Ch} as a term (waiting while the
+      ring is empty). @var{Term} is @tt{end_of_file} if the channel is
+      finished and there are no more messages.".
+
+shm_channel_receive(Ch, Term) :-
+    Ch = '$shm_channel'(Addr),
+    shm_channel_receive_c(Addr, R),
+    ( R = ok(Term0) -> Term = Term0
+    ; R = end_of_file -> Term = end_of_file
+    ; throw(error(syntax_error(fast_read), shm_channel_receive/2))
+    ).
+
+:- export(shm_channel_send_bytes/2).
+:- pred shm_channel_send_bytes(+Ch, +Bytes) : ( shm_channel(Ch), list(Bytes) )
+   # "Send the list of bytes @var{Bytes} through @var{Ch} (waiting while
+      the ring is full).".
+
+shm_channel_send_bytes(Ch, Bytes) :-
+    Ch = '$shm_channel'(Addr),
+    length(Bytes, N),
+    shm_channel_send_bytes_c(Addr, N, Bytes, R),
+    check_send(R, shm_channel_send_bytes(Ch, Bytes)).
+
+:- export(shm_channel_receive_bytes/2).
+:- pred shm_channel_receive_bytes(+Ch, ?Bytes) : shm_channel(Ch)
+   # "Receive the next message of @var{Ch} as a list of bytes (waiting
+      while the ring is empty). @var{Bytes} is @tt{end_of_file} if the
+      channel is finished and there are no more messages.".
+
+shm_channel_receive_bytes('$shm_channel'(Addr), Bytes) :-
+    shm_channel_receive_bytes_c(Addr, Bytes).
+
+check_send(R, Goal) :-
+    ( R =:= 1 -> true
+    ; functor(Goal, N, A),
+      ( R =:= 0 -> % (too large or cannot be encoded)
+          arg(2, Goal, Msg),
+          throw(error(representation_error(shm_channel_message(Msg)), N/A))
+      ; throw(error(permission_error(output, shm_channel, Goal), N/A))
+      )
+    ).
+
+% ---------------------------------------------------------------------------
+
+:- trust pred shm_channel_create_c(in(Name), in(Size), in(Flags), go(Addr)) ::
+    atm * c_size * c_int * address
+    + (foreign(shm_channel_create), returns(Addr)).
+:- trust pred shm_channel_open_c(in(Name), go(Addr)) ::
+    atm * address
+    + (foreign(shm_channel_open), returns(Addr)).
+:- trust pred shm_channel_close_c(in(Addr)) ::
+    address + foreign(shm_channel_close).
+:- trust pred shm_channel_unlink_c(in(Name), go(Ok)) ::
+    atm * c_int + (foreign(shm_channel_unlink), returns(Ok)).
+:- trust pred shm_channel_finish_c(in(Addr)) ::
+    address + foreign(shm_channel_finish).
+:- trust pred shm_channel_send_c(in(Addr), in(Term), go(R)) ::
+    address * any_term * c_int
+    + (foreign(shm_channel_send), returns(R)).
+:- trust pred shm_channel_receive_c(in(Addr), go(R)) ::
+    address * any_term
+    + (foreign(shm_channel_receive), returns(R)).
+:- trust pred shm_channel_send_bytes_c(in(Addr), in(N), in(Bytes), go(R)) ::
+    address * c_size * c_uint8_list * c_int
+    + (foreign(shm_channel_send_bytes), size_of(Bytes, N), returns(R)).
+:- trust pred shm_channel_receive_bytes_c(in(Addr), go(Bytes)) ::
+    address * any_term
+    + (foreign(shm_channel_receive_bytes), returns(Bytes)).
+
+:- use_foreign_source(shm_channel_c).
+:- use_foreign_library(['LINUXi686', 'LINUXx86_64'], [rt]).
@@ -0,0 +1,614 @@
+/* Shared memory channels (see shm_channel.pl) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#include <ciao_prolog.h>
+
+/* --------------------------------------------------------------------------- */
+/* Blocking */
+
+/* Wait while *addr == val (or until woken up), and wake up all the
+   waiters on addr. Without futexes, waiting just yields the CPU. */
+
+#if defined(__linux__)
+static void shm_wait(_Atomic uint32_t *addr, uint32_t val) {
+  syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT, val, NULL, NULL, 0);
+}
+
+static void shm_wake(_Atomic uint32_t *addr) {
+  syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+#else
+static void shm_wait(_Atomic uint32_t *addr, uint32_t val) {
+  if (atomic_load(addr) == val) sched_yield();
+}
+
+static void shm_wake(_Atomic uint32_t *addr) {
+}
+#endif
+
+/* Mutex for several producers or consumers (0: unlocked, 1: locked,
+   2: locked with waiters) */
+
+static void shm_lock(_Atomic uint32_t *m) {
+  uint32_t c = 0;
+
+  if (atomic_compare_exchange_strong(m, &c, 1)) return;
+  if (c != 2) c = atomic_exchange(m, 2);
+  while (c != 0) {
+    shm_wait(m, 2);
+    c = atomic_exchange(m, 2);
+  }
+}
+
+static void shm_unlock(_Atomic uint32_t *m) {
+  if (atomic_exchange(m, 0) == 2) shm_wake(m);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Ring buffer */
+
+/* The shared memory object is a header followed by a ring of
+   capacity bytes (a power of two). head and tail are the (never
+   decreasing) positions of the next byte to read and write. Each
+   message is a 4 byte length followed by its bytes, padded to 8
+   bytes (messages may wrap around the end of the ring). */
+
+#define SHM_MAGIC 0x6d687363 /* "cshm" */
+#define SHM_MPMC 1
+#define SHM_HEADER_SIZE 256
+#define SHM_ALIGN(N) (((N) + 7) & ~(uint64_t)7)
+
+typedef struct shm_header_ shm_header_t;
+struct shm_header_ {
+  uint32_t magic;
+  uint32_t flags;
+  uint64_t capacity;
+  _Alignas(64) _Atomic uint64_t head;
+  _Atomic uint32_t space_seq; /* (changes when head changes) */
+  _Atomic uint32_t writers_waiting;
+  _Atomic uint32_t recv_lock;
+  _Alignas(64) _Atomic uint64_t tail;
+  _Atomic uint32_t data_seq; /* (changes when tail or finished change) */
+  _Atomic uint32_t readers_waiting;
+  _Atomic uint32_t send_lock;
+  _Atomic uint32_t finished;
+};
+
+typedef struct shm_channel_ shm_channel_t;
+struct shm_channel_ {
+  shm_header_t *h;
+  unsigned char *ring;
+  size_t map_size;
+  /* (buffer for encoding and decoding terms) */
+  size_t count;
+  size_t capacity;
+  unsigned char *buf;
+};
+
+static shm_channel_t *shm_map(int fd, size_t map_size) {
+  shm_channel_t *ch;
+  void *p;
+
+  p = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) return NULL;
+  ch = (shm_channel_t *)calloc(1, sizeof(shm_channel_t));
+  if (ch == NULL) {
+    munmap(p, map_size);
+    return NULL;
+  }
+  ch->h = (shm_header_t *)p;
+  ch->ring = (unsigned char *)p + SHM_HEADER_SIZE;
+  ch->map_size = map_size;
+  return ch;
+}
+
+/* Create the shared memory object name for a ring of (at least) size
+   bytes. Returns NULL on errors (including an existing name) */
+shm_channel_t *shm_channel_create(char *name, size_t size, int flags) {
+  shm_channel_t *ch;
+  uint64_t capacity = 4096;
+  int fd;
+
+  while (capacity < size) capacity *= 2;
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) return NULL;
+  if (ftruncate(fd, SHM_HEADER_SIZE + capacity) < 0) {
+    close(fd);
+    shm_unlink(name);
+    return NULL;
+  }
+  ch = shm_map(fd, SHM_HEADER_SIZE + capacity);
+  close(fd);
+  if (ch == NULL) {
+    shm_unlink(name);
+    return NULL;
+  }
+  /* (the object is zero filled) */
+  ch->h->flags = flags;
+  ch->h->capacity = capacity;
+  ch->h->magic = SHM_MAGIC;
+  return ch;
+}
+
+/* Open an existing shared memory object. Returns NULL on errors */
+shm_channel_t *shm_channel_open(char *name) {
+  shm_channel_t *ch;
+  struct stat st;
+  int fd;
+
+  fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) return NULL;
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size <= SHM_HEADER_SIZE) {
+    close(fd);
+    return NULL;
+  }
+  ch = shm_map(fd, st.st_size);
+  close(fd);
+  if (ch == NULL) return NULL;
+  if (ch->h->magic != SHM_MAGIC ||
+      SHM_HEADER_SIZE + ch->h->capacity != ch->map_size) {
+    munmap(ch->h, ch->map_size);
+    free(ch);
+    return NULL;
+  }
+  return ch;
+}
+
+void shm_channel_close(shm_channel_t *ch) {
+  munmap(ch->h, ch->map_size);
+  free(ch->buf);
+  free(ch);
+}
+
+int shm_channel_unlink(char *name) {
+  return shm_unlink(name) == 0;
+}
+
+/* No more messages will be sent (receivers get end_of_file once the
+   ring is empty) */
+void shm_channel_finish(shm_channel_t *ch) {
+  shm_header_t *h = ch->h;
+
+  atomic_store(&h->finished, 1);
+  atomic_fetch_add(&h->data_seq, 1);
+  shm_wake(&h->data_seq);
+  atomic_fetch_add(&h->space_seq, 1);
+  shm_wake(&h->space_seq);
+}
+
+static void ring_put(shm_channel_t *ch, uint64_t pos, const void *src, size_t n) {
+  uint64_t cap = ch->h->capacity;
+  size_t off = pos & (cap - 1);
+  size_t n1 = cap - off;
+
+  if (n <= n1) {
+    memcpy(ch->ring + off, src, n);
+  } else {
+    memcpy(ch->ring + off, src, n1);
+    memcpy(ch->ring, (const unsigned char *)src + n1, n - n1);
+  }
+}
+
+static void ring_get(shm_channel_t *ch, uint64_t pos, void *dst, size_t n) {
+  uint64_t cap = ch->h->capacity;
+  size_t off = pos & (cap - 1);
+  size_t n1 = cap - off;
+
+  if (n <= n1) {
+    memcpy(dst, ch->ring + off, n);
+  } else {
+    memcpy(dst, ch->ring + off, n1);
+    memcpy((unsigned char *)dst + n1, ch->ring, n - n1);
+  }
+}
+
+/* Send a message. Returns 1 on success, 0 if the message does not fit
+   in the ring, and -1 if the channel is finished */
+static int ring_send(shm_channel_t *ch, const unsigned char *data, size_t n) {
+  shm_header_t *h = ch->h;
+  uint64_t need = SHM_ALIGN(n + 4), head, tail;
+  uint32_t len = n, seq;
+  int res = 1;
+
+  if (need > h->capacity || n > UINT32_MAX) return 0;
+  if (h->flags & SHM_MPMC) shm_lock(&h->send_lock);
+  tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+  for (;;) {
+    if (atomic_load(&h->finished)) { res = -1; goto out; }
+    seq = atomic_load(&h->space_seq);
+    head = atomic_load_explicit(&h->head, memory_order_acquire);
+    if (h->capacity - (tail - head) >= need) break;
+    atomic_fetch_add(&h->writers_waiting, 1);
+    if (atomic_load(&h->head) == head) shm_wait(&h->space_seq, seq);
+    atomic_fetch_sub(&h->writers_waiting, 1);
+  }
+  ring_put(ch, tail, &len, 4);
+  ring_put(ch, tail + 4, data, n);
+  atomic_store_explicit(&h->tail, tail + need, memory_order_release);
+  atomic_fetch_add(&h->data_seq, 1);
+  if (atomic_load(&h->readers_waiting)) shm_wake(&h->data_seq);
+ out:
+  if (h->flags & SHM_MPMC) shm_unlock(&h->send_lock);
+  return res;
+}
+
+/* Wait for a message and leave its position and length in *pos and *n
+   (the receive lock is held on success). Returns 0 if the channel is
+   finished and empty */
+static int ring_recv_begin(shm_channel_t *ch, uint64_t *pos, size_t *n) {
+  shm_header_t *h = ch->h;
+  uint64_t head, tail;
+  uint32_t len, seq;
+
+  if (h->flags & SHM_MPMC) shm_lock(&h->recv_lock);
+  head = atomic_load_explicit(&h->head, memory_order_relaxed);
+  for (;;) {
+    seq = atomic_load(&h->data_seq);
+    tail = atomic_load_explicit(&h->tail, memory_order_acquire);
+    if (tail != head) break;
+    if (atomic_load(&h->finished)) {
+      if (h->flags & SHM_MPMC) shm_unlock(&h->recv_lock);
+      return 0;
+    }
+    atomic_fetch_add(&h->readers_waiting, 1);
+    if (atomic_load(&h->tail) == head) shm_wait(&h->data_seq, seq);
+    atomic_fetch_sub(&h->readers_waiting, 1);
+  }
+  ring_get(ch, head, &len, 4);
+  *pos = head + 4;
+  *n = len;
+  return 1;
+}
+
+static void ring_recv_end(shm_channel_t *ch, uint64_t pos, size_t n) {
+  shm_header_t *h = ch->h;
+
+  atomic_store_explicit(&h->head, pos + SHM_ALIGN(n + 4) - 4, memory_order_release);
+  atomic_fetch_add(&h->space_seq, 1);
+  if (atomic_load(&h->writers_waiting)) shm_wake(&h->space_seq);
+  if (h->flags & SHM_MPMC) shm_unlock(&h->recv_lock);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Messages as bytes */
+
+int shm_channel_send_bytes(shm_channel_t *ch, size_t n, unsigned char *data) {
+  return ring_send(ch, data, n);
+}
+
+ciao_term shm_channel_receive_bytes(shm_channel_t *ch) {
+  ciao_term t;
+  uint64_t pos;
+  size_t n, off;
+
+  if (!ring_recv_begin(ch, &pos, &n)) return ciao_atom("end_of_file");
+  off = pos & (ch->h->capacity - 1);
+  if (off + n <= ch->h->capacity) {
+    t = ciao_mk_c_uint8_list(ciao_implicit_ctx, ch->ring + off, n);
+  } else {
+    unsigned char *data = (unsigned char *)malloc(n);
+    if (data == NULL) {
+      ring_recv_end(ch, pos, n);
+      return ciao_atom("end_of_file");
+    }
+    ring_get(ch, pos, data, n);
+    t = ciao_mk_c_uint8_list(ciao_implicit_ctx, data, n);
+    free(data);
+  }
+  ring_recv_end(ch, pos, n);
+  return t;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Messages as terms, in the format of fast_write/1 (see
+   engine/io_basic.c) */
+
+#define FASTRW_VERSION 'C'
+#define FASTRW_MAX_VARS 1024
+
+typedef struct vars_ vars_t;
+struct vars_ {
+  int count;
+  ciao_term vars[FASTRW_MAX_VARS];
+};
+
+static int buf_put(shm_channel_t *ch, const void *src, size_t n) {
+  size_t capacity;
+  unsigned char *buf;
+
+  if (ch->count + n > ch->capacity) {
+    capacity = ch->capacity == 0 ? 4096 : ch->capacity * 2;
+    while (capacity < ch->count + n) capacity *= 2;
+    buf = (unsigned char *)realloc(ch->buf, capacity);
+    if (buf == NULL) return 0;
+    ch->buf = buf;
+    ch->capacity = capacity;
+  }
+  memcpy(ch->buf + ch->count, src, n);
+  ch->count += n;
+  return 1;
+}
+
+static int buf_byte(shm_channel_t *ch, unsigned char c) {
+  return buf_put(ch, &c, 1);
+}
+
+/* (a string ended by 0) */
+static int buf_string(shm_channel_t *ch, const char *s) {
+  return buf_put(ch, s, strlen(s) + 1);
+}
+
+static int encode_term(shm_channel_t *ch, ciao_term t, vars_t *vs) {
+  char *s;
+  int i, a, r;
+
+  for (;;) {
+    if (ciao_is_variable(t)) {
+      char id[16];
+      for (i = 0; i < vs->count; i++) {
+        if (ciao_equal(vs->vars[i], t)) break;
+      }
+      if (i == vs->count) {
+        if (vs->count == FASTRW_MAX_VARS) return 0;
+        vs->vars[vs->count++] = t;
+      }
+      snprintf(id, sizeof(id), "%d", i);
+      return buf_byte(ch, '_') && buf_string(ch, id);
+    } else if (ciao_is_number(t)) {
+      s = ciao_get_number_chars(t);
+      r = buf_byte(ch, ciao_is_integer(t) ? 'I' : 'F') && buf_string(ch, s);
+      ciao_free(s);
+      return r;
+    } else if (ciao_is_empty_list(t)) {
+      return buf_byte(ch, ']');
+    } else if (ciao_is_atom(t)) {
+      return buf_byte(ch, 'A') && buf_string(ch, ciao_atom_name(t));
+    } else if (ciao_is_list(t)) {
+      /* (iterate on the tail) */
+      if (!buf_byte(ch, '[') || !encode_term(ch, ciao_list_head(t), vs)) return 0;
+      t = ciao_list_tail(t);
+    } else {
+      a = ciao_structure_arity(t);
+      if (a > 255) return 0;
+      if (!buf_byte(ch, 'S') || !buf_string(ch, ciao_structure_name(t)) ||
+          !buf_byte(ch, a)) return 0;
+      for (i = 1; i < a; i++) {
+        if (!encode_term(ch, ciao_structure_arg(t, i), vs)) return 0;
+      }
+      /* (iterate on the last argument) */
+      t = ciao_structure_arg(t, a);
+    }
+  }
+}
+
+/* Send a term. Returns 1 on success, 0 if it cannot be encoded or does
+   not fit in the ring, and -1 if the channel is finished */
+int shm_channel_send(shm_channel_t *ch, ciao_term t) {
+  vars_t *vs;
+  int r;
+
+  vs = (vars_t *)malloc(sizeof(vars_t));
+  if (vs == NULL) return 0;
+  vs->count = 0;
+  ch->count = 0;
+  r = buf_byte(ch, FASTRW_VERSION) && encode_term(ch, t, vs);
+  free(vs);
+  if (!r) return 0;
+  return ring_send(ch, ch->buf, ch->count);
+}
+
+typedef struct decoder_ decoder_t;
+struct decoder_ {
+  const unsigned char *p;
+  const unsigned char *end;
+  vars_t vs;
+};
+
+/* (a string ended by 0, or NULL) */
+static const char *decode_string(decoder_t *d) {
+  const char *s = (const char *)d->p;
+  const unsigned char *z;
+
+  z = memchr(d->p, 0, d->end - d->p);
+  if (z == NULL) return NULL;
+  d->p = z + 1;
+  return s;
+}
+
+/* Pending terms of decode_term(), waiting for their last argument
+   (or tail) */
+#define PENDING_STR 0  /* structure */
+#define PENDING_LST 1  /* list cell */
+#define PENDING_CODES 2 /* string of codes */
+
+typedef struct pending_ pending_t;
+struct pending_ {
+  int kind;
+  const char *name; /* (STR) */
+  int arity; /* (STR) */
+  ciao_term *args; /* (STR, the first arity-1 arguments) */
+  ciao_term head; /* (LST) */
+  const unsigned char *cs; /* (CODES) */
+  int len; /* (CODES) */
+};
+
+typedef struct pendings_ pendings_t;
+struct pendings_ {
+  pending_t *items;
+  size_t count;
+  size_t capacity;
+};
+
+static pending_t *pendings_push(pendings_t *ps, int kind) {
+  pending_t *items;
+  size_t capacity;
+
+  if (ps->count == ps->capacity) {
+    capacity = ps->capacity == 0 ? 16 : ps->capacity * 2;
+    items = (pending_t *)realloc(ps->items, capacity * sizeof(pending_t));
+    if (items == NULL) return NULL;
+    ps->items = items;
+    ps->capacity = capacity;
+  }
+  ps->items[ps->count].kind = kind;
+  ps->items[ps->count].args = NULL;
+  return &ps->items[ps->count++];
+}
+
+static void pendings_free(pendings_t *ps) {
+  size_t i;
+  for (i = 0; i < ps->count; i++) free(ps->items[i].args);
+  free(ps->items);
+}
+
+/* Returns 0 on errors. Like encode_term(), it iterates on the last
+   argument of structures (and the tails of lists), so that it does
+   not recurse on long lists or right-nested terms. */
+static ciao_term decode_term(decoder_t *d) {
+  pendings_t ps;
+  pending_t *pd;
+  const char *s;
+  ciao_term t, *args;
+  int i, a;
+
+  ps.items = NULL;
+  ps.count = 0;
+  ps.capacity = 0;
+  for (;;) {
+    /* Decode the next term, or push it as pending */
+    t = 0;
+    if (d->p >= d->end) goto error;
+    switch (*d->p++) {
+    case ']':
+      t = ciao_empty_list();
+      break;
+    case '[':
+      if ((t = decode_term(d)) == 0) goto error;
+      if ((pd = pendings_push(&ps, PENDING_LST)) == NULL) goto error;
+      pd->head = t;
+      continue;
+    case '_':
+      if ((s = decode_string(d)) == NULL) goto error;
+      i = atoi(s);
+      if (i == d->vs.count && i < FASTRW_MAX_VARS) {
+        d->vs.vars[d->vs.count++] = ciao_var();
+      }
+      if (i >= d->vs.count) goto error;
+      t = d->vs.vars[i];
+      break;
+    case 'I':
+    case 'F':
+      if ((s = decode_string(d)) == NULL) goto error;
+      t = ciao_put_number_chars((char *)s);
+      break;
+    case 'A':
+      if ((s = decode_string(d)) == NULL) goto error;
+      t = ciao_atom(s);
+      break;
+    case '"':
+      {
+        /* (a string of codes in 1..255 followed by the tail) */
+        const unsigned char *cs = d->p;
+        if (decode_string(d) == NULL) goto error;
+        if ((pd = pendings_push(&ps, PENDING_CODES)) == NULL) goto error;
+        pd->cs = cs;
+        pd->len = (d->p - cs) - 1;
+        continue;
+      }
+    case 'S':
+      if ((s = decode_string(d)) == NULL || d->p >= d->end) goto error;
+      a = *d->p++;
+      if (a == 0) {
+        t = ciao_atom(s);
+        break;
+      }
+      args = (ciao_term *)malloc(a * sizeof(ciao_term));
+      if (args == NULL) goto error;
+      for (i = 0; i < a - 1; i++) {
+        if ((args[i] = decode_term(d)) == 0) { free(args); goto error; }
+      }
+      if ((pd = pendings_push(&ps, PENDING_STR)) == NULL) { free(args); goto error; }
+      pd->name = s;
+      pd->arity = a;
+      pd->args = args;
+      continue;
+    default:
+      goto error;
+    }
+    /* Complete the pending terms with t */
+    while (ps.count > 0) {
+      pd = &ps.items[--ps.count];
+      switch (pd->kind) {
+      case PENDING_LST:
+        t = ciao_list(pd->head, t);
+        break;
+      case PENDING_CODES:
+        for (i = pd->len; i > 0; i--) {
+          t = ciao_list(ciao_mk_c_int(pd->cs[i-1]), t);
+        }
+        break;
+      default: /* PENDING_STR */
+        pd->args[pd->arity - 1] = t;
+        t = ciao_structure_a(pd->name, pd->arity, pd->args);
+        free(pd->args);
+        break;
+      }
+    }
+    free(ps.items);
+    return t;
+  }
+ error:
+  pendings_free(&ps);
+  return 0;
+}
+
+/* Receive a term as ok(Term) (end_of_file if the channel is finished
+   and empty, or error if the message is not a term) */
+ciao_term shm_channel_receive(shm_channel_t *ch) {
+  decoder_t *d;
+  ciao_term t;
+  uint64_t pos;
+  size_t n, off;
+  const unsigned char *data;
+
+  if (!ring_recv_begin(ch, &pos, &n)) return ciao_atom("end_of_file");
+  off = pos & (ch->h->capacity - 1);
+  t = 0;
+  if (off + n <= ch->h->capacity) {
+    data = ch->ring + off; /* (decode in place) */
+  } else {
+    ch->count = 0;
+    if (!buf_put(ch, ch->ring + off, ch->h->capacity - off) ||
+        !buf_put(ch, ch->ring, n - (ch->h->capacity - off))) {
+      data = NULL;
+    } else {
+      data = ch->buf;
+    }
+  }
+  d = (decoder_t *)malloc(sizeof(decoder_t));
+  if (d != NULL && data != NULL && n > 0 && data[0] == FASTRW_VERSION) {
+    d->p = data + 1;
+    d->end = data + n;
+    d->vs.count = 0;
+    t = decode_term(d);
+  }
+  free(d);
+  ring_recv_end(ch, pos, n);
+  if (t == 0) return ciao_atom("error");
+  return ciao_structure("ok", 1, t);
+}
@@ -397,6 +397,13 @@ For an example of a system library that uses this feature see the
                      format.
   @end{itemize}
 
+@item @code{rtchecks_sample}: An integer @var{N}. If greater than 1,
+  the assertions of each predicate are only checked on the first of
+  every @var{N} calls to it (the counters are kept for each
+  thread). This reduces the overhead of run-time checks (e.g., to
+  keep them enabled in testing deployments) at the cost of missing
+  some violations. Default is 1 (check all calls).
+
 @end{itemize}
 
 ").
@@ -9,7 +9,10 @@
             add_info_rtsignal/4,
             call_stack/2,
             rtc_inst/2,
-            rtc_compat/2
+            rtc_compat/2,
+            rtc_list/1,
+            rtc_list/2,
+            rtc_sample/2
             % non_prop_check/3,
             % compat/1,
             % inst/1,
@@ -18,10 +21,12 @@
         [assertions, nortchecks, hiord]).
 
 :- use_module(engine(hiord_rt), ['$meta_call'/1]).
+:- use_module(engine(internals), [
+    '$global_vars_get'/2, '$global_vars_set'/2, '$setarg'/4, '$sample'/2]).
 :- use_module(engine(attributes)).
 :- use_module(library(terms_vars), [varset/2]).
 :- use_module(library(freeze), [freeze/2]).
-:- use_module(engine(basic_props_rtc)). % [compat_*/1]
+:- use_module(engine(basic_props_rtc)). % [rtc_*/1, compat_*/1]
 :- use_module(library(terms_check), [instance/2]).
 
 :- reexport(library(rtchecks/rtchecks_send)).
@@ -104,6 +109,7 @@ rtc_compat_('basic_props:num'(A) , _   ) :- !, compat_num(A).
 rtc_compat_('basic_props:flt'(A) , _   ) :- !, compat_flt(A).
 rtc_compat_('basic_props:struct'(A) , _) :- !, compat_struct(A).
 %
+rtc_compat_(Goal,Args) :- ground(Args), !, \+ \+ '$meta_call'(Goal).
 rtc_compat_(Goal,Args) :- \+ non_compat(Goal,Args). % TODO: fix non_compat/2
 
 non_compat(Goal                    , Args) :-
@@ -156,8 +162,15 @@ rtc_inst('$:'(Goal),Args) :- !, rtc_inst_(Goal,Args).
 rtc_inst_('term_typing:var'(A)   , _   ) :- !, var(A).
 rtc_inst_('term_typing:nonvar'(A), _   ) :- !, nonvar(A).
 rtc_inst_('terms_check:instance'(A,B), _   ) :- !, instance(A,B).
+rtc_inst_(Goal,_   ) :- memo_hit(Goal), !.
+rtc_inst_(Goal,Args) :- ground(Args), !, % (only local variables to bind)
+    \+ \+ '$meta_call'(Goal),
+    ( atomic_list(Args) -> true ; memo_add(Goal) ).
 rtc_inst_(Goal,Args) :- \+ non_inst(Goal,Args).
 
+atomic_list([]).
+atomic_list([X|Xs]) :- atomic(X), atomic_list(Xs).
+
 non_inst(Goal                   , Args) :- % TODO: fix
 % A generic implementation of non_inst/2
     varset(Args, VS),
@@ -186,29 +199,122 @@ combine_attributes('$cut_fail'(V1, C), '$cut_fail'(V2, C)) :-
     fail.
 
 
+% ---------------------------------------------------------------------------
+% Memo of checked terms
+
+% The last successful instance checks of large terms are kept in a
+% small table (in the heap, with backtrackable assignment), so that
+% checking again the same term (usually, the same data passed along
+% several calls) takes constant time (== compares the addresses of
+% the terms first). Only properties closed under instantiation are
+% recorded: those of ground terms and list/1 and list/2 (below).
+
+memo_hit(Check) :-
+    '$global_vars_get'(12, Memo),
+    Memo = '$rtc_memo'(_, E1, E2, E3, E4),
+    ( E1 == Check -> true
+    ; E2 == Check -> true
+    ; E3 == Check -> true
+    ; E4 == Check
+    ).
+
+memo_add(Check) :-
+    '$global_vars_get'(12, Memo0),
+    ( Memo0 = '$rtc_memo'(I, _, _, _, _) ->
+        Memo = Memo0
+    ; Memo = '$rtc_memo'(1, 0, 0, 0, 0),
+      '$global_vars_set'(12, Memo),
+      I = 1
+    ),
+    I1 is I + 1,
+    '$setarg'(I1, Memo, Check, on),
+    I2 is I mod 4 + 1,
+    '$setarg'(1, Memo, I2, on).
+
+% ---------------------------------------------------------------------------
+% Instance checks for lists (see rtchecks_rt_propimpl)
+
+:- doc(rtc_list(L), "@var{L} is a list (deterministic version of
+   @pred{list/1} for run-time checks).").
+
+rtc_list(L) :- memo_hit(list(L)), !.
+rtc_list(L) :-
+    rtc_list_(L),
+    ( large_list(L) -> memo_add(list(L)) ; true ).
+
+rtc_list_(L) :- var(L), !, fail.
+rtc_list_([]).
+rtc_list_([_|Xs]) :- rtc_list_(Xs).
+
+:- doc(rtc_list(T, L), "@var{L} is a list of elements of the basic
+   type @var{T} (deterministic version of @pred{list/2} for run-time
+   checks, where @var{T} is one of @tt{int}, @tt{nnegint}, @tt{flt},
+   @tt{num}, @tt{atm}, @tt{struct}, or @tt{gnd}).").
+
+rtc_list(T, L) :- memo_hit(list(T, L)), !.
+rtc_list(T, L) :-
+    rtc_list_of(L, T),
+    ( large_list(L) -> memo_add(list(T, L)) ; true ).
+
+rtc_list_of(L, _) :- var(L), !, fail.
+rtc_list_of([], _).
+rtc_list_of([X|Xs], T) :- rtc_type(T, X), rtc_list_of(Xs, T).
+
+rtc_type(int, X) :- rtc_int(X).
+rtc_type(nnegint, X) :- rtc_nnegint(X).
+rtc_type(flt, X) :- rtc_flt(X).
+rtc_type(num, X) :- rtc_num(X).
+rtc_type(atm, X) :- rtc_atm(X).
+rtc_type(struct, X) :- rtc_struct(X).
+rtc_type(gnd, X) :- rtc_gnd(X).
+
+% (not worth recording the check of shorter lists)
+large_list([_,_,_,_,_,_,_,_,_,_,_,_,_,_,_,_|_]).
+
+% ---------------------------------------------------------------------------
+
+:- doc(rtc_sample(Key, N), "Succeeds on the first of every @var{N}
+   calls with @var{Key} (see the @tt{rtchecks_sample} flag).").
+
+rtc_sample(Key, N) :- '$sample'(Key, N).
+
+% ---------------------------------------------------------------------------
+
 :- push_prolog_flag(multi_arity_warnings, off).
 
-:- meta_predicate disj_neg_prop(list(goal), ?, ?).
+% Exit is fail and PropName is the name of the first property that
+% does not hold, or Exit is true if all of them hold. Checks do not
+% bind the variables of the predicate, and their effects (i.e., the
+% memo of checked terms) are kept.
 
-disj_neg_prop([CheckProp|CheckProps], [PropName0|PropNames], PropName) :-
-    (\+ CheckProp),
-    PropName = PropName0
-    ;
-    disj_neg_prop(CheckProps, PropNames, PropName).
+:- meta_predicate check_props(list(goal), ?, ?, ?).
 
-:- meta_predicate disj_neg_prop(list(goal)).
+check_props([], _, _, true).
+check_props([CheckProp|CheckProps], [PropName0|PropNames], PropName, Exit) :-
+    ( call(CheckProp) ->
+        check_props(CheckProps, PropNames, PropName, Exit)
+    ; PropName = PropName0,
+      Exit = fail
+    ).
 
-disj_neg_prop([CheckProp|CheckProps]) :- (\+ CheckProp) ; disj_neg_prop(CheckProps).
+:- meta_predicate check_props(list(goal), ?).
+
+check_props([], true).
+check_props([CheckProp|CheckProps], Exit) :-
+    ( call(CheckProp) ->
+        check_props(CheckProps, Exit)
+    ; Exit = fail
+    ).
 
 :- pop_prolog_flag(multi_arity_warnings).
 
 :- meta_predicate checkc(list(goal), ?, ?, ?).
 checkc(CheckProps, PropNames, PropName, Exit) :-
-    disj_neg_prop(CheckProps, PropNames, PropName) -> Exit = fail ; Exit = true.
+    check_props(CheckProps, PropNames, PropName, Exit).
 
 :- meta_predicate checkc(list(goal), ?).
 checkc(CheckProps, Exit) :-
-    disj_neg_prop(CheckProps) -> Exit = fail ; Exit = true.
+    check_props(CheckProps, Exit).
 
 :- meta_predicate checkif(?, ?, ?, ?, list(goal), ?, ?).
 checkif(fail, _,       _,        _,    _,          _,      _).
@@ -217,7 +323,8 @@ checkif(true, ErrType, PredName, Dict, CheckProps, NProps, AsrLocs) :-
 
 :- meta_predicate rtcheck(?, ?, ?, list(goal), ?, ?).
 rtcheck(ErrType, PredName, Dict, CheckProps, NProps, AsrLocs) :-
-    ( disj_neg_prop(CheckProps, NProps, PropName-ActualProp) ->
+    check_props(CheckProps, NProps, PropName-ActualProp, Exit),
+    ( Exit = fail ->
         send_rtcheck(ErrType, PredName, Dict, PropName, ActualProp, AsrLocs)
     ; true
     ).
@@ -236,6 +343,8 @@ rtcheck_(_Check, PropName, PredName, Dict, Loc) :-
     send_rtcheck(pp_check, PredName, Dict, PropName, [], [pploc(Loc)]).
 
 :- meta_predicate call_stack(goal, ?).
+% (rtchecks_tr.pl expands it inline)
 call_stack(Goal, Pos) :-
-    intercept(Goal, rtcheck(Type, PredName, Dict, PropName, Valid, Poss),
-        send_rtcheck(Type, PredName, Dict, PropName, Valid, [Pos|Poss])).
\ No newline at end of file
+    push_call_stack(Pos, Stack),
+    call(Goal),
+    pop_call_stack(Stack).
\ No newline at end of file
@@ -0,0 +1,88 @@
+:- module(_, [], [assertions, nativeprops, datafacts, rtchecks]).
+
+:- doc(title, "Tests for rtchecks_rt.pl").
+
+:- use_module(library(rtchecks/rtchecks_rt), [rtc_sample/2, rtc_list/1, rtc_list/2]).
+:- use_module(library(lists), [length/2]).
+:- use_module(library(aggregates), [findall/3]).
+:- use_module(library(between), [between/3]).
+:- use_module(engine(internals), ['$global_vars_get'/2]).
+
+% (the checks of the predicates below are done on 1 of every 2 calls)
+:- set_prolog_flag(rtchecks_sample, 2).
+
+% ---------------------------------------------------------------------------
+
+:- export(test_sample/0).
+:- test test_sample # "rtc_sample/2 succeeds on the first of every N calls".
+test_sample :-
+    sampled(test_sample_a, 3, 7, Ns),
+    Ns == [1,4,7],
+    sampled(test_sample_b, 1, 3, Ms), % (independent counters)
+    Ms == [1,2,3].
+
+sampled(Key, N, Calls, Ns) :-
+    findall(I, (between(1, Calls, I), rtc_sample(Key, N)), Ns).
+
+% ---------------------------------------------------------------------------
+
+:- pred bad_calls(X) : int(X).
+bad_calls(_).
+
+:- entry fused(X, _) : int(X).
+:- pred fused(X, Y) : int(X) => atm(Y).
+fused(X, X).
+
+via(X, Y) :- fused(X, Y). % (skips the entry checks)
+
+:- export(test_sample_checks/0).
+:- test test_sample_checks # "With rtchecks_sample = 2 only half of
+   the calls are checked".
+test_sample_checks :-
+    violations(bad_calls(a), 6, N1), N1 == 3,
+    % (the checks of both steps are done in the same sampled calls)
+    violations(fused(1, _), 6, N2), N2 == 3,
+    violations(fused(a, _), 6, N3), N3 == 6, % (entry and calls)
+    violations(via(a, _), 6, N4), N4 == 3.
+
+% (the violations are reported with a signal)
+:- data violation/0.
+
+violations(Goal, Calls, N) :-
+    retractall_fact(violation),
+    ( between(1, Calls, _),
+        intercept(Goal, rtcheck(_, _, _, _, _, _), assertz_fact(violation)),
+        fail
+    ; true
+    ),
+    findall(x, violation, Xs),
+    length(Xs, N).
+
+% ---------------------------------------------------------------------------
+
+:- export(test_memo/0).
+:- test test_memo # "Checks of large lists are memoized".
+test_memo :-
+    numlist(100, L),
+    \+ memo_has(list(L)),
+    rtc_list(L),
+    memo_has(list(L)),
+    rtc_list(int, L),
+    memo_has(list(int, L)),
+    memo_has(list(L)), % (still there, 4 entries)
+    \+ rtc_list(atm, L),
+    \+ memo_has(list(atm, L)),
+    % (short lists are not recorded)
+    rtc_list([1,2,3]),
+    \+ memo_has(list([1,2,3])).
+
+memo_has(Check) :-
+    '$global_vars_get'(12, Memo),
+    Memo = '$rtc_memo'(_, E1, E2, E3, E4),
+    ( E1 == Check -> true
+    ; E2 == Check -> true
+    ; E3 == Check -> true
+    ; E4 == Check
+    ).
+
+numlist(N, L) :- findall(I, between(1, N, I), L).
@@ -100,3 +100,6 @@
 :- rtc_impl(basic_props:gnd/1, basic_props_rtc:rtc_gnd/1).
 
 :- rtc_impl(basic_props:cgoal/1, basic_props_rtc:rtc_cgoal/1).
+
+% (see rtchecks_rt, list/2 is treated as a special case in rtchecks_tr.pl)
+:- rtc_impl(basic_props:list/1, rtchecks_rt:rtc_list/1).
@@ -1,6 +1,8 @@
-:- module(_, [send_rtcheck/6, send_comp_rtcheck/3], [assertions, nortchecks, dcg]).
+:- module(_, [send_rtcheck/6, send_comp_rtcheck/3,
+    push_call_stack/2, pop_call_stack/1], [assertions, nortchecks, dcg]).
 
 :- use_module(engine(attributes)).
+:- use_module(engine(internals), ['$global_vars_get'/2, '$global_vars_set'/2]).
 :- use_module(library(terms_vars)).
 :- use_module(library(hiordlib), [foldl/4]).
 :- use_module(library(lists)).
@@ -15,7 +17,13 @@ pretty_attribute(Var) -->
     ; []
     ).
 
-send_rtcheck(ErrType, PredName, Dict, PropName, ActualProp0, AsrLocs) :-
+% (the locators of the stack of calls go before AsrLocs)
+send_rtcheck(ErrType, PredName, Dict, PropName, ActualProp, AsrLocs0) :-
+    '$global_vars_get'(13, Stack),
+    stack_locs(Stack, AsrLocs0, AsrLocs),
+    send_rtcheck_(ErrType, PredName, Dict, PropName, ActualProp, AsrLocs).
+
+send_rtcheck_(ErrType, PredName, Dict, PropName, ActualProp0, AsrLocs) :-
     % expose_attributes(ActualProp0, ActualProp),
     pretty_attributes(ActualProp0, Atts),
     append(ActualProp0, Atts, ActualProp),
@@ -23,5 +31,27 @@ send_rtcheck(ErrType, PredName, Dict, PropName, ActualProp0, AsrLocs) :-
     send_signal(E, Intercepted),
     ( Intercepted = false -> throw(E) ; true ). % throw if no handler
 
+% (completed with add_info_rtsignal/4)
 send_comp_rtcheck(PredName, PropName, ActualProp) :-
-    send_rtcheck(comp, PredName, [], PropName, [ActualProp], []).
+    send_rtcheck_(comp, PredName, [], PropName, [ActualProp], []).
+
+% ---------------------------------------------------------------------------
+% Stack of calls
+
+% The locators of the calls being executed (innermost first) are kept
+% in a global variable (the reserved slot 13, 0 for the empty stack),
+% which is pushed and popped with backtrackable assignment around the
+% call (so that it is restored on backtracking into the call and on
+% exceptions).
+
+push_call_stack(Pos, Stack) :-
+    '$global_vars_get'(13, Stack),
+    '$global_vars_set'(13, [Pos|Stack]).
+
+pop_call_stack(Stack) :-
+    '$global_vars_set'(13, Stack).
+
+% (outermost first)
+stack_locs(0, Locs, Locs) :- !.
+stack_locs([Pos|Stack], Locs0, Locs) :-
+    stack_locs(Stack, [Pos|Locs0], Locs).
@@ -463,8 +463,9 @@ process_body(Dict, Pred, F, A, Body0, Body) :-
         functor(Pred, F, A)
     ).
 
+% (call_stack/2 from rtchecks_rt, inlined)
 put_call_stack(Goal0, Pos, Goal) :-
-    Goal = call_stack(Goal0, Pos).
+    Goal = (push_call_stack(Pos, Stack), Goal0, pop_call_stack(Stack)).
 
 calllit_expansion(PDict, PredName, Loc, Goal0, Goal) :-
     calllit_expansion_(Goal0, PDict, PredName, Loc, Goal).
@@ -530,11 +531,10 @@ record_goal_alias(Head0, Head, M) :-
 %%      "check success pos",               /
 %%      "check compat pos..."             /
 %%
-% TODO: LocStack outdated?
-%% call_stack(Goal, Loc) :-
-%%      intercept(Goal,
-%%          rtcheck(LocStack, ...),
-%%          send_signal(rtcheck([Loc|LocStack], ...))).
+%% call_stack(Goal, Loc) :-  (inlined)
+%%      push_call_stack(Loc, Stack),
+%%      Goal,
+%%      pop_call_stack(Stack).
 %%
 %% 'pred$rtc1' :-
 %%      body.
@@ -700,27 +700,52 @@ generate_rtchecks(Assertions, Pred, PDict, PLoc, UsePosLoc, Lits, Goal) :-
     lists_to_lits(Goal0, Lits),
     !.
 
+% The checks of both steps are fused in a single wrapper for Pred
+% (with a single sampling counter). The wrapper of step two is still
+% needed for the calls renamed by record_goal_alias/3 (which skip the
+% checks of step one).
 generate_rtchecks(_F, A, M, Assertions, Pred, PDict, PLoc, UsePosLoc, Pred2) -->
-    { generate_step1_rtchecks(Assertions, Pred, PLoc, UsePosLoc, Body0, Body01) },
+    { generate_step1_rtchecks(Assertions, Pred, PLoc, UsePosLoc, Body0, Body01),
+      generate_step2_rtchecks(Assertions, Pred, PDict, PLoc, UsePosLoc, Body1, Body12),
+      ( Body1 \== Body12 ->
+          rename_head('1', A, Pred, Pred2),
+          Body12 = Pred2,
+          lists_to_lits(Body1, Lits1)
+      ; Pred2 = Pred1
+      )
+    },
     ( { Body0 \== Body01 } ->
         { rename_head('0', A, Pred, Pred1),
           record_goal_alias(Pred, Pred1, M),
-          Body01 = Pred1,
-          lists_to_lits(Body0, Lits0)
+          ( Body1 \== Body12 ->
+              % (inline a copy of the checks of step two)
+              copy_term(Pred-Pred2-Lits1, Pred-Pred2-Body01)
+          ; Body01 = Pred1
+          ),
+          lists_to_lits(Body0, Lits0),
+          sample_checks(Pred, M, Lits0, Pred2, SLits0)
         },
-        [(Pred :- Lits0)]
+        [(Pred :- SLits0)]
     ; {Pred = Pred1}
     ),
-    { generate_step2_rtchecks(Assertions, Pred, PDict, PLoc, UsePosLoc, Body1, Body12) },
     ( { Body1 \== Body12 } ->
-        { rename_head('1', A, Pred, Pred2),
-          Body12 = Pred2,
-          lists_to_lits(Body1, Lits1)
-        },
-        [(Pred1 :- Lits1)]
-    ; {Pred1 = Pred2}
+        { sample_checks(Pred1, M, Lits1, Pred2, SLits1) },
+        [(Pred1 :- SLits1)]
+    ; []
     ).
 
+% When the flag rtchecks_sample is N > 1, the checks of each wrapper
+% Head are done only on the first of every N calls (the other calls
+% go directly to Next).
+sample_checks(Head, M, Lits, Next, SLits) :-
+    current_prolog_flag(rtchecks_sample, N),
+    N > 1, !,
+    functor(Head, F, A),
+    atom_number(NA, A),
+    atom_concat([M, ':', F, '/', NA], Key),
+    SLits = (rtc_sample(Key, N) -> Lits ; Next).
+sample_checks(_, _, Lits, _, Lits).
+
 current_assertion(Pred0, M,
         assr(Pred, Status, Type, Compat, Call, Succ, Comp, Loc,
             PredName, CompatName, CallName, SuccName, CompName, Dict)) :-
@@ -1126,6 +1151,10 @@ get_check_prop(Prop, comp, _, RtcProp) :-
 
 get_check_prop(mshare(Vs,Sh),_,_,rtc_mshare(Vs2,Sh2)) :- !,
     mshare_tr(Vs,Sh,Vs2,Sh2).
+get_check_prop(list(T,L),Type,_,rtc_list(T,L)) :-
+    (Type = calls ; Type = success),
+    atom(T),
+    rtc_list_type(T), !.
 
 get_check_prop(Prop,Check,RelevantVars,RtcProp) :-
     varset(Prop,PropVars),
@@ -1177,6 +1206,20 @@ zip([A|As],[B|Bs],[A-B|ABs]) :-
     zip(As,Bs,ABs).
 zip([],[],[]).
 
+% The property list/2 is also treated as a special case: lists of
+% basic types are checked with rtc_list/2 (which walks the list
+% deterministically and keeps a memo of large checked lists, see
+% library(rtchecks/rtchecks_rt)) instead of the generic instance
+% check of a higher-order property.
+
+rtc_list_type(int).
+rtc_list_type(nnegint).
+rtc_list_type(flt).
+rtc_list_type(num).
+rtc_list_type(atm).
+rtc_list_type(struct).
+rtc_list_type(gnd).
+
 %% ----------------------------------------------------------------------
 %% the code below has been desactivated since currently all rtc-modules
 %% for system properties are added by this translation to the source file
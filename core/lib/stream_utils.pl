@@ -93,15 +93,7 @@ read_string_to_end__(C, [C|L]) :- read_string_to_end_(L).
    an EOF is found.".
 
 read_bytes_to_end(Stream, Bytes) :-
-    current_input(OldIn),
-    set_input(Stream),
-    read_bytes_to_end_(Bytes),
-    set_input(OldIn).
-
-read_bytes_to_end_(L) :- get_byte(C), read_bytes_to_end__(C, L).
-
-read_bytes_to_end__(-1, []) :- !.
-read_bytes_to_end__(C, [C|L]) :- read_bytes_to_end_(L).
+    '$read_bytes'(Stream, -1, Bytes).
 
 :- pred discard_to_end(Stream) : stream(Stream)
    # "Reads in all the bytes from @var{Stream} until an EOF is found.".
@@ -122,18 +114,10 @@ discard_to_end__(_) :- discard_to_end_.
    until an EOF is found.".
 
 read_bytes(Stream, N, Bytes) :-
-    current_input(OldIn),
-    set_input(Stream),
-    read_bytes_(N, Bytes),
-    set_input(OldIn).
-
-read_bytes_(N, []) :- N =< 0, !.
-read_bytes_(N, L) :- get_byte(C), N1 is N-1, read_bytes__(C, N1, L).
-
-read_bytes__(-1, _, []) :- !.
-read_bytes__(C, N, [C|L]) :- read_bytes_(N, L).
+    ( N =< 0 -> Bytes = []
+    ; '$read_bytes'(Stream, N, Bytes)
+    ).
 
-% TODO: implement in C
 :- pred copy_stream(InS, OutS, Copied)
    : (stream(InS), stream(OutS)) => int(Copied)
    # "Copies all bytes bytes (until EOF or error) from the @var{InS}
@@ -141,15 +125,7 @@ read_bytes__(C, N, [C|L]) :- read_bytes_(N, L).
    returned in @var{Copied}".
 
 copy_stream(InS, OutS, Copied) :-
-    copy_stream_(InS, OutS, 0, Copied).
-
-copy_stream_(InS, OutS, Copied0, Copied) :-
-    get_byte(InS, C),
-    ( C = -1 -> Copied = Copied0
-    ; Copied1 is Copied0 + 1,
-      put_byte(OutS, C),
-      copy_stream_(InS, OutS, Copied1, Copied)
-    ).
+    '$copy_stream'(InS, OutS, Copied).
 
 % ---------------------------------------------------------------------------
 
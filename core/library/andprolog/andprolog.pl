@@ -0,0 +1,4 @@
+:- package(andprolog).
+
+:- include(library(andprolog/andprolog_ops)).
+:- use_module(library(andprolog/andprolog_rt)).
@@ -0,0 +1,3 @@
+:- op(950, xfy, [&, '&!']).
+:- op(950, xfx, [&>, '&!>']).
+:- op(950, xf, [<&, '<&!']).
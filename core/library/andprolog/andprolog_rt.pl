@@ -0,0 +1,323 @@
+:- module(andprolog_rt, [], [assertions, isomodes, datafacts, hiord]).
+
+:- doc(title, "And-parallel execution (runtime)").
+
+:- doc(author, "The Ciao Development Team").
+
+:- doc(stability, devel).
+
+:- doc(module, "This module implements the operators of the
+   @lib{andprolog} package on top of a fixed pool of workers, each of
+   them an engine (stack set) with its own thread (see
+   @lib{concurrency}).
+
+   A parallel conjunction @tt{A & B} @em{publishes} @tt{B} and
+   executes @tt{A}. Idle workers take published goals (the oldest
+   first) and send their answers back. When @tt{A} succeeds, the
+   publisher takes back @tt{B} if no worker took it (the newest
+   first) and executes it locally; otherwise it waits for the answers
+   of the worker. Goals are only published when there are idle
+   workers, so conjunctions run sequentially (with little overhead)
+   when all the workers are busy, which happens naturally at the
+   deeper (smaller) levels of divide-and-conquer computations.
+
+   A worker executing a goal with more than one answer keeps its
+   choice points until the publisher asks for the next answer (on
+   backtracking into the conjunction) or it backtracks over the
+   conjunction (after pruning it). Use the @tt{'&!'} variants for
+   deterministic goals: their workers are released as soon as the
+   first answer is sent.
+
+   Published goals are copied (as in @pred{assertz/1}), so they
+   should be independent of the goals running in parallel with them
+   (i.e., they should not share unbound variables). Attributes of
+   variables (e.g., constraints) are not copied. The properties
+   @pred{indep/2} and @pred{indep/1} check this at run time (e.g., in
+   conditional parallel conjunctions).").
+
+:- include(library(andprolog/andprolog_ops)).
+
+:- use_module(engine(basiccontrol), ['$metachoice'/1]).
+:- use_module(engine(internals), ['$setarg'/4]).
+:- use_module(library(odd), [undo/1]).
+:- use_module(library(concurrency), [eng_call/4]).
+:- use_module(library(system), [get_numcores/1]).
+:- use_module(library(terms_vars), [term_variables/2]).
+
+% ---------------------------------------------------------------------------
+% Operators
+
+:- export((&)/2).
+:- meta_predicate &(goal, goal).
+:- pred &(A, B) : cgoal * cgoal
+   # "Executes @var{A} and @var{B}, possibly in parallel. Its answers
+   (and their order) are those of @tt{(A, B)}.".
+
+A & B :-
+    ( publish(nondet, B, H) ->
+        local_goal(A, H),
+        join(H)
+    ; call(A),
+      call(B)
+    ).
+
+:- export(('&!')/2).
+:- meta_predicate '&!'(goal, goal).
+:- pred '&!'(A, B) : cgoal * cgoal
+   # "Like @pred{&/2}, for deterministic goals (only the first answer
+   of @var{B} is computed).".
+
+A '&!' B :-
+    ( publish(det, B, H) ->
+        local_goal(A, H),
+        join(H)
+    ; call(A),
+      local_call(det, B)
+    ).
+
+:- export((&>)/2).
+:- meta_predicate &>(goal, ?).
+:- pred &>(Goal, -Handle) : cgoal * var
+   # "Publishes @var{Goal} (which may be executed in parallel) and
+   returns a @var{Handle} to get its answers with @pred{<&/1}.".
+
+Goal &> H :-
+    publish_handle(nondet, Goal, H).
+
+:- export(('&!>')/2).
+:- meta_predicate '&!>'(goal, ?).
+:- pred '&!>'(Goal, -Handle) : cgoal * var
+   # "Like @pred{&>/2}, for deterministic goals.".
+
+Goal '&!>' H :-
+    publish_handle(det, Goal, H).
+
+:- export((<&)/1).
+:- pred <&(+Handle)
+   # "Gets the answers of the goal published with @var{Handle} (see
+   @pred{&>/2}), waiting for them if needed.".
+
+H <& :-
+    join(H).
+
+:- export(('<&!')/1).
+:- pred '<&!'(+Handle)
+   # "Like @pred{<&/1}, for handles of deterministic goals.".
+
+H '<&!' :-
+    join(H).
+
+% ---------------------------------------------------------------------------
+% Independence checks
+
+:- export(indep/2).
+:- prop indep(X, Y)
+   # "@var{X} and @var{Y} do not share unbound variables (e.g., as
+   the condition of @tt{( indep(X, Y) -> p(X) & q(Y) ; p(X), q(Y) )}).".
+
+indep(X, Y) :-
+    term_variables(X, XVs),
+    term_variables(Y, YVs),
+    % (no variable of X is bound when those of Y are)
+    \+ \+ ( bind_vars(YVs), all_vars(XVs) ).
+
+bind_vars([]).
+bind_vars(['$indep'|Vs]) :- bind_vars(Vs).
+
+all_vars([]).
+all_vars([V|Vs]) :- var(V), all_vars(Vs).
+
+:- export(indep/1).
+:- prop indep(L)
+   # "@var{L} is a list of pairs @tt{[X,Y]} such that @tt{indep(X,
+   Y)} holds for each of them.".
+
+indep([]).
+indep([[X,Y]|L]) :-
+    indep(X, Y),
+    indep(L).
+
+% ---------------------------------------------------------------------------
+% Published goals
+
+% Handle: '$and'(Id, State, Goal, Mode), State is pending until the
+% goal is joined or cancelled (then it is executed locally)
+
+publish_handle(Mode, Goal, H) :-
+    ( publish(Mode, Goal, H0) -> H = H0
+    ; H = '$and'(none, joined, Goal, Mode)
+    ).
+
+% (fails if there are no idle workers)
+publish(Mode, Goal, H) :-
+    ensure_workers,
+    current_fact_nb(idle(_)), !,
+    new_task_id(Id),
+    H = '$and'(Id, pending, Goal, Mode),
+    assertz_fact(task(Id, Mode, Goal)).
+
+:- concurrent task/3.        % task(Id, Mode, Goal)
+:- concurrent answer/2.      % answer(Id, Answer)
+:- concurrent command/2.     % command(Id, redo|cut)
+:- concurrent last_task_id/1.
+
+last_task_id(0).
+
+new_task_id(Id) :-
+    % (blocks other publishers until asserted again)
+    retract_fact(last_task_id(Id0)), !,
+    Id is Id0 + 1,
+    asserta_fact(last_task_id(Id)).
+
+% Goal executed in parallel with a published goal
+local_goal(Goal, H) :-
+    catch(Goal, E, (cancel(H), throw(E))).
+local_goal(_, H) :-
+    cancel(H),
+    fail.
+
+join(H) :-
+    H = '$and'(Id, State, Goal, Mode),
+    ( State == pending ->
+        '$setarg'(2, H, joined, off),
+        ( retract_fact_nb(task(Id, _, _)) ->
+            % (not taken by any worker)
+            local_call(Mode, Goal)
+        ; get_answers(Mode, Id, Goal)
+        )
+    ; local_call(Mode, Goal)
+    ).
+
+local_call(det, Goal) :- call(Goal), !.
+local_call(nondet, Goal) :- call(Goal).
+
+get_answers(det, Id, Goal) :-
+    wait_answer(Id, Answer),
+    det_answer(Answer, Goal).
+get_answers(nondet, Id, Goal) :-
+    wait_answer(Id, Answer),
+    nondet_answer(Answer, Id, Goal).
+
+wait_answer(Id, Answer) :-
+    retract_fact(answer(Id, Answer)), !.
+
+det_answer(last(Goal), Goal).
+det_answer(exception(E), _) :-
+    throw(E).
+
+nondet_answer(last(Goal), _, Goal).
+nondet_answer(sol(Goal0), Id, Goal) :-
+    Asked = asked(no),
+    % (release the worker if we backtrack over a pruned conjunction)
+    undo(cut_answers(Asked, Id)),
+    ( Goal = Goal0
+    ; '$setarg'(1, Asked, yes, off),
+      assertz_fact(command(Id, redo)),
+      get_answers(nondet, Id, Goal)
+    ).
+nondet_answer(exception(E), _, _) :-
+    throw(E).
+
+cut_answers(asked(no), Id) :- !,
+    assertz_fact(command(Id, cut)).
+cut_answers(_, _).
+
+% The published goal is not needed
+cancel(H) :-
+    H = '$and'(Id, State, _, _),
+    ( State == pending ->
+        '$setarg'(2, H, joined, off),
+        ( retract_fact_nb(task(Id, _, _)) ->
+            true
+        ; wait_answer(Id, Answer),
+          ( Answer = sol(_) -> assertz_fact(command(Id, cut))
+          ; true
+          )
+        )
+    ; true
+    ).
+
+% ---------------------------------------------------------------------------
+% Workers
+
+:- concurrent pool/1.        % pool(Workers)
+:- concurrent idle/1.        % idle(Worker)
+
+pool(0).
+
+:- export(set_and_workers/1).
+:- pred set_and_workers(+N) : int
+   # "Starts workers until there are at least @var{N} of them (workers
+   are never stopped). By default, the number of CPU cores minus one
+   workers are started on the first parallel conjunction.".
+
+set_and_workers(N) :-
+    retract_fact(pool(N0)), !, % (blocks other callers until asserted again)
+    ( N0 < N -> start_workers(N0, N), N1 = N
+    ; N1 = N0
+    ),
+    asserta_fact(pool(N1)).
+
+:- export(current_and_workers/1).
+:- pred current_and_workers(-N) : var => int
+   # "@var{N} is the number of started workers.".
+
+current_and_workers(N) :-
+    current_fact_nb(pool(N0)), !,
+    N = N0.
+
+ensure_workers :-
+    current_fact_nb(pool(N)), N > 0, !.
+ensure_workers :-
+    get_numcores(Cores),
+    ( Cores > 2 -> N is Cores - 1 ; N = 1 ),
+    set_and_workers(N).
+
+start_workers(N, N) :- !.
+start_workers(I, N) :-
+    I1 is I + 1,
+    eng_call(worker(I1), create, create, _),
+    start_workers(I1, N).
+
+worker(W) :-
+    repeat,
+      next_task(W, Id, Mode, Goal),
+      run_task(Mode, Id, Goal),
+    fail.
+
+next_task(_, Id, Mode, Goal) :-
+    retract_fact_nb(task(Id, Mode, Goal)), !.
+next_task(W, Id, Mode, Goal) :-
+    asserta_fact(idle(W)),
+    retract_fact(task(Id, Mode, Goal)), !,
+    retract_fact_nb(idle(W)), !.
+
+run_task(det, Id, Goal) :-
+    ( catch(first_answer(Goal, Answer), E, Answer = exception(E)) ->
+        assertz_fact(answer(Id, Answer))
+    ; assertz_fact(answer(Id, fail))
+    ).
+run_task(nondet, Id, Goal) :-
+    ( catch(answers(Id, Goal), E, assertz_fact(answer(Id, exception(E)))) ->
+        true
+    ; assertz_fact(answer(Id, fail))
+    ).
+
+first_answer(Goal, last(Goal)) :-
+    call(Goal), !.
+
+% Send the answers of Goal, waiting for a command after each of them
+% (unless it is the last one)
+answers(Id, Goal) :-
+    '$metachoice'(C0),
+    call(Goal),
+    '$metachoice'(C1),
+    ( C1 == C0 ->
+        assertz_fact(answer(Id, last(Goal)))
+    ; assertz_fact(answer(Id, sol(Goal))),
+      wait_command(Id, Command),
+      Command == cut
+    ).
+
+wait_command(Id, Command) :-
+    retract_fact(command(Id, Command)), !.
@@ -0,0 +1,135 @@
+:- module(_, [], [assertions, andprolog, datafacts]).
+
+:- doc(title, "Tests for andprolog_rt.pl").
+
+:- use_module(library(aggregates), [findall/3]).
+:- use_module(library(between), [between/3]).
+:- use_module(library(system), [pause/1]).
+
+% ---------------------------------------------------------------------------
+
+p(X) :- member_(X, [1,2,3]).
+q(Y) :- member_(Y, [a,b]).
+
+member_(X, [X|_]).
+member_(X, [_|Xs]) :- member_(X, Xs).
+
+workers :- set_and_workers(2).
+
+:- export(test_answers/0).
+:- test test_answers # "A & B has the answers of (A, B), in the same
+   order".
+test_answers :-
+    workers,
+    findall(X-Y, (p(X) & q(Y)), L1),
+    findall(X-Y, (p(X), q(Y)), L2),
+    L1 == L2,
+    findall(X-Y-Z, (p(X) & q(Y) & p(Z)), L3),
+    findall(X-Y-Z, (p(X), q(Y), p(Z)), L4),
+    L3 == L4.
+
+:- export(test_failure/0).
+:- test test_failure # "Failure of either goal".
+test_failure :-
+    workers,
+    \+ (fail & q(_)),
+    \+ (p(_) & fail),
+    \+ (p(X) & (q(Y), X == Y)).
+
+:- export(test_exceptions/0).
+:- test test_exceptions # "Exceptions of either goal".
+test_exceptions :-
+    workers,
+    catch((throw(a) & q(_)), E1, true), E1 == a,
+    catch((p(_) & throw(b)), E2, true), E2 == b,
+    catch((p(_) & (q(Y), Y == b, throw(c))), E3, true), E3 == c.
+
+% (nondeterministic, with enough work for a worker to take it)
+r(Y) :- between(1, 5, Y), busy(20000).
+
+busy(0) :- !.
+busy(N) :- N1 is N - 1, busy(N1).
+
+:- export(test_backtracking/0).
+:- test test_backtracking # "Backtracking into published goals with
+   several answers".
+test_backtracking :-
+    workers,
+    findall(X-Y, (p(X) & r(Y)), L1),
+    findall(X-Y, (p(X), r(Y)), L2),
+    L1 == L2.
+
+:- export(test_det/0).
+:- test test_det # "'&!' computes only the first answer of the
+   published goal".
+test_det :-
+    workers,
+    findall(X-Y, (p(X) '&!' q(Y)), L),
+    L == [1-a, 2-a, 3-a],
+    \+ (p(_) '&!' fail),
+    catch((p(_) '&!' throw(d)), E, true), E == d.
+
+:- export(test_handles/0).
+:- test test_handles # "Goals published with &> and joined with <&".
+test_handles :-
+    workers,
+    findall(X-Y, (q(Y) &> H, p(X), H <&), L1),
+    findall(X-Y, (p(X), q(Y)), L2),
+    L1 == L2,
+    findall(Y, (q(Y) '&!>' H2, H2 '<&!'), L3),
+    L3 == [a].
+
+% (as annotated by the parallelizer)
+pq(X, Y) :-
+    ( indep([[X, Y]]) -> p(X) & q(Y) ; p(X), q(Y) ).
+
+:- export(test_indep/0).
+:- test test_indep # "Independence checks".
+test_indep :-
+    indep(f(X, a), g(Y, Z)),
+    \+ indep(f(X, a), g(Y, X)),
+    indep([[X, Y], [Y, Z]]),
+    \+ indep([[X, Y], [Z, h(Z)]]),
+    var(X), var(Y), var(Z),
+    indep(f(a), g(b)),
+    findall(X1-Y1, pq(X1, Y1), L1),
+    findall(X1-Y1, (p(X1), q(Y1)), L2),
+    L1 == L2.
+
+% ---------------------------------------------------------------------------
+
+:- concurrent flag/1.
+
+% (succeeds if flag(K) is asserted in about 10 seconds)
+wait_flag(K) :- wait_flag_(K, 10).
+
+wait_flag_(K, _) :- retract_fact_nb(flag(K)), !.
+wait_flag_(K, N) :- N > 0,
+    pause(1),
+    N1 is N - 1,
+    wait_flag_(K, N1).
+
+set_flag(K) :- assertz_fact(flag(K)).
+
+% (keeps its worker until flag(go) is asserted)
+blocked(K) :-
+    set_flag(K),
+    wait_flag(go).
+
+:- export(test_release/0).
+:- test test_release # "Workers are released after backtracking over
+   pruned conjunctions".
+test_release :-
+    workers,
+    \+ ( between(1, 20, _),
+         \+ \+ (p(_) & r(_)), % (pruned)
+         fail ),
+    % (both workers must be idle to take the blocked goals)
+    blocked(1) &> H1,
+    blocked(2) &> H2,
+    ( wait_flag(1), wait_flag(2) -> R = ok ; R = busy ),
+    set_flag(go),
+    set_flag(go),
+    H1 <&,
+    H2 <&,
+    R == ok.
@@ -3,7 +3,7 @@
      abs/2,sign/2,float_integer_part/2,float_fractional_part/2,integer/2,
      truncate/2,float/2,floor/2,round/2,ceiling/2,(**)/3,(>>)/3,(<<)/3,
      (/\)/3,(\/)/3,(\)/2,(#)/3,exp/2,log/2,sqrt/2,sin/2,cos/2,atan/2,
-     gcd/3,arithfunctor/1],
+     gcd/3,rdiv/3,rational/2,rationalize/2,arithfunctor/1],
     []).
 
 -(A,B) :-
@@ -111,6 +111,15 @@ atan(A,B) :-
 gcd(A,B,C) :-
     C is gcd(A,B).
 
+rdiv(A,B,C) :-
+    C is A rdiv B.
+
+rational(A,B) :-
+    B is rational(A).
+
+rationalize(A,B) :-
+    B is rationalize(A).
+
 arithfunctor(-_) .
 arithfunctor(+_) .
 arithfunctor(--_) .
@@ -146,6 +155,9 @@ arithfunctor(sin(_)) .
 arithfunctor(cos(_)) .
 arithfunctor(atan(_)) .
 arithfunctor(gcd(_,_)) .
+arithfunctor(_ rdiv _) .
+arithfunctor(rational(_)) .
+arithfunctor(rationalize(_)) .
 
 % 
 % :- use_module(library(terms), [copy_args/3]).
@@ -3,6 +3,7 @@
 %
 
 :- use_module(library(lists)).
+:- use_module(engine(arithmetic), ['$linear_add'/6, '$linear_rows'/3]).
 
 % -------------------------------- normalization ------------------------------
 
@@ -272,92 +273,27 @@ delete_factors(>, Head1, Tail1, _,     Tail2, Difference, [0|Ks]) :-
     delete_factors([Head1|Tail1], Tail2, Difference, Ks).
 */
 
-add_linear_ff([], _, A, B, C) :- !,
-    mult_linear_factor(A, B, C).
-add_linear_ff(A, B, [], _, C) :- !,
-    mult_linear_factor(A, B, C).
-add_linear_ff([E*F|D], A, [H*I|G], B, C) :-
-    compare(J, H, E),
-    (  J= =,
-        arith_eval(A*F,K1),
-        arith_eval(B*I,K2),
-        arith_eval(K1+K2, K),
-        (  arith_eval(K1=:= -K2) ->
-            C=L
-        ;   C=[E*K|L]
-        ),
-        add_linear_ff(D, A, G, B, L)
-    ;   J= <,
-        C=[E*N|M],
-        arith_eval(A*F, N),
-        add_linear_ff(D, A, [H*I|G], B, M)
-    ;   J= >,
-        C=[H*P|O],
-        arith_eval(B*I, P),
-        add_linear_ff([E*F|D], A, G, B, O)
-    ).
+% The linear forms are merged in C (see '$linear_add'/6), with exact
+% coefficients if arith_eps/1 is 0.
+
+add_linear_ff(A, Ka, B, Kb, C) :-
+    arith_eps(Eps),
+    '$linear_add'(A, Ka, B, Kb, Eps, C).
 
 % specialized versions thereof:
 % add_linear_11(A, B, Res) :- add_linear_ff(A, 1, B, 1, Res).
 %
-add_linear_11([], A, A) :- !.
-add_linear_11(A, [], A) :- !.
-add_linear_11([E*F|D], [H*I|G], C) :-
-    compare(J, H, E),
-    (  J= =,
-        arith_eval(F, K1),
-        arith_eval(I, K2),
-        arith_eval(K1+K2, K),
-        (  arith_eval(K1=:= -K2) ->
-            C=L
-        ;   C=[E*K|L]
-        ),
-        add_linear_11(D, G, L)
-    ;   J= <,
-        C=[E*F|M],
-        add_linear_11(D, [H*I|G], M)
-    ;   J= >,
-        C=[H*I|O],
-        add_linear_11([E*F|D], G, O)
-    ).
+add_linear_11(A, B, C) :-
+    arith_eps(Eps),
+    '$linear_add'(A, 1, B, 1, Eps, C).
 
 % add_linear_1f(A, B, K, Res) :- add_linear_ff(A, 1, B, K, Res).
 %
-add_linear_1f([], A, B, C) :- !,
-    mult_linear_factor(A, B, C).
-add_linear_1f(A, [], _, A) :- !.
-add_linear_1f([E*F|D], [H*I|G], B, C) :-
-    compare(J, H, E),
-    (  J= =,
-        arith_eval(F, K1),
-        arith_eval(B*I, K2),
-        arith_eval(K1+K2, K),
-        (  arith_eval(K1=:= -K2) ->
-            C=L
-        ;   C=[E*K|L]
-        ),
-        add_linear_1f(D, G, B, L)
-    ;   J= <,
-        C=[E*F|M],
-        add_linear_1f(D, [H*I|G], B, M)
-    ;   J= >,
-        C=[H*P|O],
-        arith_eval(B*I, P),
-        add_linear_1f([E*F|D], G, B, O)
-    ).
-
-mult_linear_factor([], _, []).          % quite common
-mult_linear_factor([H|T],  K, L ) :-
-  ( arith_eval(K=:=1) ->                        % avoid to copy
-       L = [H|T]
-  ;
-       H = A*Fa,
-       arith_eval(K*Fa, Fan),
-       L = [A*Fan|T1],
-       mult_linear_factor1(T, K, T1)
-  ).
+add_linear_1f(A, B, K, C) :-
+    arith_eps(Eps),
+    '$linear_add'(A, 1, B, K, Eps, C).
 
-mult_linear_factor1([], _, []).
-mult_linear_factor1([A*Fa|As], F, [A*Fan|Afs]) :-
-  arith_eval(F*Fa, Fan),
-  mult_linear_factor1(As, F, Afs).
+% (the list is not copied if K =:= 1)
+mult_linear_factor(A, K, C) :-
+    arith_eps(Eps),
+    '$linear_add'(A, K, [], 0, Eps, C).
@@ -188,21 +188,30 @@ ph2_inc( [Col*K|Cols], De0, De1, Res) :-
      swap( Row, Col, De1)
   ).
 
-min_pos( De,     _,   _) :- var( De), !, fail.
-min_pos( [D|De], Col, M) :-
+% (only the rows where Col occurs are candidates for the exchange)
+min_pos( De, Col, M) :-
+  '$linear_rows'( De, Col, Rows),
+  min_pos_rows( Rows, Col, M).
+
+min_pos( De, Col, M0, M, Mv0) :-
+  '$linear_rows'( De, Col, Rows),
+  min_pos_rows( Rows, Col, M0, M, Mv0).
+
+min_pos_rows( De,     _,   _) :- var( De), !, fail.
+min_pos_rows( [D|De], Col, M) :-
   ( get_attribute( D, eqn_var(_,l(_),Lin,_,_)),
     get_attribute( Lin, I+H),
     arith_eval( I =< 0),                                % feasible ?
     nf_coeff_of( H, Col, K),
     arith_eval( K > 0),                                 % feasible for exchange
     arith_eval( -I/K, Mv0) ->
-      min_pos( De, Col, D, M, Mv0)
+      min_pos_rows( De, Col, D, M, Mv0)
   ;
-      min_pos( De, Col, M)
+      min_pos_rows( De, Col, M)
   ).
 
-min_pos( De,     _,   M,  M, _) :- var( De), !.
-min_pos( [D|De], Col, M0, M, Mv0) :-
+min_pos_rows( De,     _,   M,  M, _) :- var( De), !.
+min_pos_rows( [D|De], Col, M0, M, Mv0) :-
   ( get_attribute( D, eqn_var(_,l(_),Lin,_,_)),
     get_attribute( Lin, I+H),
     arith_eval( I =< 0),                                % feasible ?
@@ -213,27 +222,35 @@ min_pos( [D|De], Col, M0, M, Mv0) :-
       ( arith_zero( Mv1) ->                             % tightest
       M = D
       ;
-      min_pos( De, Col, D,  M, Mv1)
+      min_pos_rows( De, Col, D,  M, Mv1)
       )
   ;
-      min_pos( De, Col, M0, M, Mv0)
+      min_pos_rows( De, Col, M0, M, Mv0)
   ).
 
-max_neg( De,     _,   _) :- var( De), !, fail.
-max_neg( [D|De], Col, M) :-
+max_neg( De, Col, M) :-
+  '$linear_rows'( De, Col, Rows),
+  max_neg_rows( Rows, Col, M).
+
+max_neg( De, Col, M0, M, Mv0) :-
+  '$linear_rows'( De, Col, Rows),
+  max_neg_rows( Rows, Col, M0, M, Mv0).
+
+max_neg_rows( De,     _,   _) :- var( De), !, fail.
+max_neg_rows( [D|De], Col, M) :-
   ( get_attribute( D, eqn_var(_,l(_),Lin,_,_)),
     get_attribute( Lin, I+H),
     arith_eval( I =< 0),                                % feasible ?
     nf_coeff_of( H, Col, K),
     arith_eval( K < 0),                                 % feasible for exchange
     arith_eval( -I/K, Mv0) ->
-      max_neg( De, Col, D, M, Mv0)
+      max_neg_rows( De, Col, D, M, Mv0)
   ;
-      max_neg( De, Col, M)
+      max_neg_rows( De, Col, M)
   ).
 
-max_neg( De,     _,   M,  M, _) :- var( De), !.
-max_neg( [D|De], Col, M0, M, Mv0) :-
+max_neg_rows( De,     _,   M,  M, _) :- var( De), !.
+max_neg_rows( [D|De], Col, M0, M, Mv0) :-
   ( get_attribute( D, eqn_var(_,l(_),Lin,_,_)),
     get_attribute( Lin, I+H),
     arith_eval( I =< 0),                                % feasible ?
@@ -244,10 +261,10 @@ max_neg( [D|De], Col, M0, M, Mv0) :-
       ( arith_zero( Mv1) ->                             % tightest
       M = D
       ;
-      max_neg( De, Col, D,  M, Mv1)
+      max_neg_rows( De, Col, D,  M, Mv1)
       )
   ;
-      max_neg( De, Col, M0, M, Mv0)
+      max_neg_rows( De, Col, M0, M, Mv0)
   ).
 
 
@@ -195,19 +195,25 @@ solve_eq_nbs(Hom, Inh, Var, Type) :-
       true
   ).
 
-bs_00(V, _, _, _) :- var(V), !.
-bs_00([V|Vs], Mark, Inh, Hom) :-
+% back substitution of Mark only visits the rows of De where it
+% occurs (see '$linear_rows'/3)
+bs_00(De, Mark, Inh, Hom) :-
+  '$linear_rows'(De, Mark, Rows),
+  bs_00_rows(Rows, Mark, Inh, Hom).
+
+bs_00_rows(V, _, _, _) :- var(V), !.
+bs_00_rows([V|Vs], Mark, Inh, Hom) :-
     (  get_attribute(V, eqn_var(_,_,Lin,_,_)),
         get_attribute(Lin, K+L),
         nf_substitute(Mark, Inh, Hom, K, L, O, P) ->
         (  P=[] ->
             ground_meta(V, O),
-            bs_00(Vs, Mark, Inh, Hom)
+            bs_00_rows(Vs, Mark, Inh, Hom)
         ;
             update_attribute(Lin, O+P),
-            bs_00(Vs, Mark, Inh, Hom)
+            bs_00_rows(Vs, Mark, Inh, Hom)
         )
-    ;   bs_00(Vs, Mark, Inh, Hom)
+    ;   bs_00_rows(Vs, Mark, Inh, Hom)
     ).
 
 /*
@@ -218,20 +224,24 @@ bs_first_00(Hom, Inh, V) :-
   update_attribute(Lin, Inh+Hom).
 */
 
-bs_01(V,      _,    _,   _,   G1, G1) :- var(V), !.
-bs_01([V|Vs], Mark, Inh, Hom, G3, G1) :-
+bs_01(De, Mark, Inh, Hom, G3, G1) :-
+  '$linear_rows'(De, Mark, Rows),
+  bs_01_rows(Rows, Mark, Inh, Hom, G3, G1).
+
+bs_01_rows(V,      _,    _,   _,   G1, G1) :- var(V), !.
+bs_01_rows([V|Vs], Mark, Inh, Hom, G3, G1) :-
     (  get_attribute(V, eqn_var(_,_,Lin,_,Nl)),
         get_attribute(Lin, K+L),
         nf_substitute(Mark, Inh, Hom, K, L, O, P) ->
         (  P=[] ->
             ground_meta(V, O),
             collect_nls(Nl, G1, G2),
-            bs_01(Vs, Mark, Inh, Hom, G3, G2)
+            bs_01_rows(Vs, Mark, Inh, Hom, G3, G2)
         ;
             update_attribute(Lin, O+P),
-            bs_01(Vs, Mark, Inh, Hom, G3, G1)
+            bs_01_rows(Vs, Mark, Inh, Hom, G3, G1)
         )
-    ;   bs_01(Vs, Mark, Inh, Hom, G3, G1)
+    ;   bs_01_rows(Vs, Mark, Inh, Hom, G3, G1)
     ).
 
 /*
@@ -258,26 +268,30 @@ join_goals(true, G, G) :- !.
 join_goals(G, true, G) :- !.
 join_goals(A, B, (A,B)).
 
-bs_10(V,      _,    _,   _,   Infeasible) :- var(V), (Infeasible = 0 ; Infeasible = 1), !.
-bs_10([V|Vs], Mark, Inh, Hom, Infeasible) :-
+bs_10(De, Mark, Inh, Hom, Infeasible) :-
+  '$linear_rows'(De, Mark, Rows),
+  bs_10_rows(Rows, Mark, Inh, Hom, Infeasible).
+
+bs_10_rows(V,      _,    _,   _,   Infeasible) :- var(V), (Infeasible = 0 ; Infeasible = 1), !.
+bs_10_rows([V|Vs], Mark, Inh, Hom, Infeasible) :-
     (  get_attribute(V, eqn_var(_,T,Lin,_,_)),
         get_attribute(Lin, K+L),
         nf_substitute(Mark, Inh, Hom, K, L, O, P) ->
         (  P=[] ->
             guard_slack(T, O),
             ground_meta(V, O),
-            bs_10(Vs, Mark, Inh, Hom, Infeasible)
+            bs_10_rows(Vs, Mark, Inh, Hom, Infeasible)
         ;   var(Infeasible),
             T = l(_),
             arith_eval(O >= 0) ->
               Infeasible = 1,
               update_attribute(Lin, O+P),
-              bs_10(Vs, Mark, Inh, Hom, Infeasible)
+              bs_10_rows(Vs, Mark, Inh, Hom, Infeasible)
         ;
             update_attribute(Lin, O+P),
-            bs_10(Vs, Mark, Inh, Hom, Infeasible)
+            bs_10_rows(Vs, Mark, Inh, Hom, Infeasible)
         )
-    ;   bs_10(Vs, Mark, Inh, Hom, Infeasible)
+    ;   bs_10_rows(Vs, Mark, Inh, Hom, Infeasible)
     ).
 /*
 bs_first_10([], Inh, V, 0) :- !,
@@ -294,8 +308,12 @@ bs_first_10(Hom, Inh, V, Infeasible) :-
       Infeasible = 0
   ).
 */
-bs_11(V,      _,    _,   _,   G1, G1,  Infeasible) :- var(V), (Infeasible = 0 ; Infeasible = 1), !.
-bs_11([V|Vs], Mark, Inh, Hom, G3, G1, Infeasible) :-
+bs_11(De, Mark, Inh, Hom, G3, G1, Infeasible) :-
+  '$linear_rows'(De, Mark, Rows),
+  bs_11_rows(Rows, Mark, Inh, Hom, G3, G1, Infeasible).
+
+bs_11_rows(V,      _,    _,   _,   G1, G1,  Infeasible) :- var(V), (Infeasible = 0 ; Infeasible = 1), !.
+bs_11_rows([V|Vs], Mark, Inh, Hom, G3, G1, Infeasible) :-
     (  get_attribute(V, eqn_var(_,T,Lin,_,Nl)),
         get_attribute(Lin, K+L),
         nf_substitute(Mark, Inh, Hom, K, L, O, P) ->
@@ -303,18 +321,18 @@ bs_11([V|Vs], Mark, Inh, Hom, G3, G1, Infeasible) :-
             guard_slack(T, O),
             collect_nls(Nl, G1, G2),
             ground_meta(V, O),
-            bs_11(Vs, Mark, Inh, Hom, G3, G2, Infeasible)
+            bs_11_rows(Vs, Mark, Inh, Hom, G3, G2, Infeasible)
         ;   var(Infeasible),
             T = l(_),
             arith_eval(O >= 0) ->
               Infeasible = 1,
               update_attribute(Lin, O+P),
-              bs_11(Vs, Mark, Inh, Hom, G3, G1, Infeasible)
+              bs_11_rows(Vs, Mark, Inh, Hom, G3, G1, Infeasible)
         ;
             update_attribute(Lin, O+P),
-            bs_11(Vs, Mark, Inh, Hom, G3, G1, Infeasible)
+            bs_11_rows(Vs, Mark, Inh, Hom, G3, G1, Infeasible)
         )
-    ;   bs_11(Vs, Mark, Inh, Hom, G3, G1, Infeasible)
+    ;   bs_11_rows(Vs, Mark, Inh, Hom, G3, G1, Infeasible)
     ).
 /*
 bs_first_11([], Inh, V, G2, G1, 0) :- !,
@@ -356,15 +374,19 @@ swap(Dep, Indep, Deps, Ins) :-
   get_attribute(Indep, eqn_var(_,_,ILin,_,_)),
   update_attribute(ILin, Inh1+Hom1).
 
-swap_bs(V, _, _, _) :- var(V), !.
-swap_bs([V|Vs], Mark, Inh, Hom) :-
+swap_bs(De, Mark, Inh, Hom) :-
+  '$linear_rows'(De, Mark, Rows),
+  swap_bs_rows(Rows, Mark, Inh, Hom).
+
+swap_bs_rows(V, _, _, _) :- var(V), !.
+swap_bs_rows([V|Vs], Mark, Inh, Hom) :-
     (  get_attribute(V, eqn_var(_,_,Lin,_,_)),
         get_attribute(Lin, K+L),
         nf_substitute(Mark, Inh, Hom, K, L, O, P) ->
             update_attribute(Lin, O+P),
-            swap_bs(Vs, Mark, Inh, Hom)
+            swap_bs_rows(Vs, Mark, Inh, Hom)
     ;
-            swap_bs(Vs, Mark, Inh, Hom)
+            swap_bs_rows(Vs, Mark, Inh, Hom)
     ).
 
 % ----------------------------------- crossref --------------------------------------
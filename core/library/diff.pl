@@ -1,4 +1,4 @@
-:- module(diff, [diff/4, patch/3, diff_item/1], [assertions, hiord, regtypes]).
+:- module(diff, [diff/4, patch/3, diff_item/1], [assertions, hiord, regtypes, foreign_interface]).
 
 :- doc(title, "Diff algorithm").
 :- doc(author, "Isabel Garcia-Contreras").
@@ -20,6 +20,16 @@ This 'greedy' algorithm that computes the number
 differences has complexity O((N+M)D) in both time and space. With M
 and N the lenghts of the input lists and D the number of changes.
 
+When the comparison predicate is @pred{==/2} (or @pred{=/2} on ground
+lists) the algorithm is executed in C over integers that identify the
+elements (equal elements are numbered in O((N+M)log(N+M)) time). The
+C version needs O(N+M+D^2) space and produces exactly the same
+changes. When D is too large to keep the O(D^2) trace (above
+4000 changes or so), it switches to the linear space refinement
+described in the same article, which produces a minimal list of
+changes that may differ from the one of the greedy algorithm when
+there are several of them.
+
 @section{Pseudocode}
 
 This pseudocode is copied from the original article, where:
@@ -92,12 +102,16 @@ yes
    diff).").
 
 :- use_module(library(lists), [length/2, reverse/2]).
+:- use_module(library(sort), [keysort/2]).
 
 :- meta_predicate diff(?, ?, pred(2), ?).
 :- pred diff(Ls1, Ls2, Compare, Diff) : (list(Ls1), list(Ls2)) => list(diff_item, Diff)
     #"@var{Diff} are the changes needed to transform @var{Ls1}
     into @var{Ls2}.".
 
+diff(As, Bs, Compare, Diff) :-
+    native_compare(Compare, As, Bs), !,
+    native_diff(As, Bs, Diff).
 diff(As, Bs, Compare, Diff) :-
     loop(Bs, As, Compare, _, Stop),
     Stop = stop(diag(_, [], [], RevDiff)),
@@ -194,6 +208,75 @@ samediag_([A|As],[B|Bs],Compare,As2,Bs2,X,X2) :-
     samediag_(As,Bs,Compare,As2,Bs2,X1,X2).
 samediag_(As,Bs,_,As,Bs,X,X).
 
+% --------------------------------------------------
+% Native diff
+
+% Compare is ==/2, or =/2 and the lists are ground (the elements can
+% be numbered)
+native_compare('$:'('PAEnv'(_, 'PA'(_, ''(X, Y), Body))), As, Bs) :-
+    nonvar(Body),
+    ( Body = 'term_compare:=='(X0, Y0) -> true
+    ; Body = 'term_basic:='(X0, Y0) -> ground(As), ground(Bs)
+    ),
+    X0 == X, Y0 == Y.
+
+native_diff(As, Bs, Diff) :-
+    element_ids(As, Bs, IdsA, IdsB, N, M),
+    diff_c(N, IdsA, M, IdsB, _, Ops, Ok),
+    ( Ok =:= 1 -> true
+    ; throw(error(resource_error(memory), diff/4))
+    ),
+    ops_diff(Ops, As, 0, Bs, 0, Diff).
+
+% IdsA and IdsB are the integers that identify the elements of As and
+% Bs (of lengths N and M)
+element_ids(As, Bs, IdsA, IdsB, N, M) :-
+    id_pairs(As, IdsA, Ps, Ps1, 0, N),
+    id_pairs(Bs, IdsB, Ps1, [], 0, M),
+    keysort(Ps, Sorted),
+    number_ids(Sorted, 0).
+
+id_pairs([], [], Ps, Ps, N, N).
+id_pairs([X|Xs], [Id|Ids], [X-Id|Ps], Ps0, N0, N) :-
+    N1 is N0 + 1,
+    id_pairs(Xs, Ids, Ps, Ps0, N1, N).
+
+number_ids([], _).
+number_ids([X-Id|Ps], Id) :-
+    same_ids(Ps, X, Id, Ps1),
+    Id1 is Id + 1,
+    number_ids(Ps1, Id1).
+
+same_ids([Y-Id|Ps], X, Id, Ps1) :- Y == X, !,
+    same_ids(Ps, X, Id, Ps1).
+same_ids(Ps, _, _, Ps).
+
+% Ops are triples Kind, Pos, Index (see diff_c.c); IA and IB are the
+% indexes of the first elements of As and Bs
+ops_diff([], _, _, _, _, []).
+ops_diff([Kind, Pos, I|Ops], As, IA, Bs, IB, [Op|Diff]) :-
+    ( Kind =:= 0 ->
+        drop(IA, I, As, As1),
+        As1 = [X|_],
+        Op = del(Pos, X),
+        ops_diff(Ops, As1, I, Bs, IB, Diff)
+    ; drop(IB, I, Bs, Bs1),
+      Bs1 = [X|_],
+      Op = ins(Pos, X),
+      ops_diff(Ops, As, IA, Bs1, I, Diff)
+    ).
+
+drop(I, I, Xs, Xs) :- !.
+drop(I0, I, [_|Xs], Xs1) :-
+    I1 is I0 + 1,
+    drop(I1, I, Xs, Xs1).
+
+:- trust pred diff_c(in(N), in(IdsA), in(M), in(IdsB), go(L), go(Ops), go(Ok)) ::
+    c_size * c_int_list * c_size * c_int_list * c_size * c_int_list * c_int
+    + (foreign, size_of(IdsA, N), size_of(IdsB, M), size_of(Ops, L), returns(Ok)).
+
+:- use_foreign_source(diff_c).
+
 % --------------------------------------------------
 :- pred patch(Ls, Diff, LNew) : (list(Ls), list(Diff, diff_item)) => list(LNew)
     #"Apply a list of changes (@var{Diff}) onto a @var{Ls}.".
@@ -0,0 +1,85 @@
+:- module(_, [], [assertions]).
+
+:- doc(title, "Tests for diff.pl").
+
+:- use_module(library(diff)).
+:- use_module(library(lists), [length/2]).
+:- use_module(library(between), [between/3]).
+:- use_module(library(random), [random/3, srandom/1]).
+
+% ---------------------------------------------------------------------------
+
+% (not ==/2, so that the Prolog implementation is used)
+eq(X, Y) :- X == Y.
+
+% Lists of elements taken from a small alphabet (so that they have
+% long common subsequences)
+rand_list(0, []) :- !.
+rand_list(N, [X|Xs]) :-
+    random(0, 3, X),
+    N1 is N - 1,
+    rand_list(N1, Xs).
+
+rand_pair(As, Bs) :-
+    random(0, 39, N),
+    random(0, 39, M),
+    rand_list(N, As),
+    rand_list(M, Bs).
+
+:- export(test_example/0).
+:- test test_example # "The example in the documentation".
+test_example :-
+    L1 = [a,a,b,c], L2 = [b,c,d],
+    diff(L1, L2, '=', Diff),
+    Diff == [del(0,a),del(0,a),ins(2,d)],
+    patch(L1, Diff, L3),
+    L3 == L2.
+
+:- export(test_native/0).
+:- test test_native # "The native implementation (for ==/2) gives the
+   same changes as the Prolog implementation".
+test_native :-
+    srandom(1),
+    \+ ( between(1, 300, _),
+         rand_pair(As, Bs),
+         \+ same_diff(As, Bs) ).
+
+same_diff(As, Bs) :-
+    diff(As, Bs, ==, D1),
+    diff(As, Bs, eq, D2),
+    D1 == D2,
+    diff(As, Bs, =, D3),
+    D1 == D3,
+    patch(As, D1, Bs1),
+    Bs1 == Bs.
+
+:- export(test_nonground/0).
+:- test test_nonground # "=/2 on non-ground lists unifies the elements".
+test_nonground :-
+    diff([f(X), b], [f(a), c], =, Diff),
+    X == a,
+    Diff == [ins(1,c),del(2,b)].
+
+:- export(test_refinement/0).
+:- test test_refinement # "Many changes (with the linear space
+   refinement) give a minimal list of changes".
+test_refinement :-
+    N = 10000,
+    numbered(0, N, 1, As),
+    changed(As, 0, Bs),
+    diff(As, Bs, ==, Diff),
+    length(Diff, D),
+    D =:= N, % (each other element is replaced)
+    patch(As, Diff, Bs1),
+    Bs1 == Bs.
+
+numbered(I, N, _, []) :- I >= N, !.
+numbered(I, N, K, [I|Is]) :-
+    I1 is I + K,
+    numbered(I1, N, K, Is).
+
+% Replace each other element X by x(X)
+changed([], _, []).
+changed([X|Xs], P, [Y|Ys]) :-
+    ( P =:= 0 -> Y = X, P1 = 1 ; Y = x(X), P1 = 0 ),
+    changed(Xs, P1, Ys).
@@ -0,0 +1,306 @@
+/* Myers' difference algorithm for library(diff) */
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Elements are integers (equal elements have equal integers). The
+   edit script transforms src (of length ns) into dst (of length nd)
+   and is returned as a sequence of triples (kind, pos, index):
+     - (0, pos, i): delete src[i] at position pos of the output
+     - (1, pos, j): insert dst[j] at position pos of the output
+*/
+
+#define OP_DEL 0
+#define OP_INS 1
+
+typedef struct script_ script_t;
+struct script_ {
+  size_t count; /* (number of ints) */
+  size_t capacity;
+  int *ops;
+};
+
+static int script_add(script_t *s, int kind, int pos, int index) {
+  size_t capacity;
+  int *ops;
+
+  if (s->count + 3 > s->capacity) {
+    capacity = s->capacity == 0 ? 48 : s->capacity * 2;
+    ops = (int *)realloc(s->ops, capacity * sizeof(int));
+    if (ops == NULL) return 0;
+    s->ops = ops;
+    s->capacity = capacity;
+  }
+  s->ops[s->count++] = kind;
+  s->ops[s->count++] = pos;
+  s->ops[s->count++] = index;
+  return 1;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Greedy algorithm (Myers 1986, section 3), keeping the furthest
+   reaching paths of each step to recover the script. This produces
+   exactly the same script as the Prolog implementation (x indexes
+   dst, y indexes src, and diagonal k is x - y). */
+
+/* (max number of entries of the trace, 64MB) */
+#define TRACE_LIMIT (1 << 24)
+
+/* Returns 1 on success, 0 if the trace would exceed TRACE_LIMIT, -1
+   on memory errors */
+static int greedy_diff(const int *src, int ns, const int *dst, int nd,
+                       int p, script_t *s) {
+  int max = ns + nd;
+  int *v, *trace = NULL, *tr;
+  int *starts = NULL, *ops = NULL;
+  size_t tsize = 0, tcap = 0;
+  int d, k, x, y, xp, kp, end_d = -1, nops, i, res = -1;
+
+  v = (int *)malloc((2 * max + 3) * sizeof(int));
+  starts = (int *)malloc((max + 1) * sizeof(int));
+  if (v == NULL || starts == NULL) goto out;
+  v += max + 1;
+  v[1] = 0;
+  for (d = 0; d <= max; d++) {
+    for (k = -d; k <= d; k += 2) {
+      if (k == -d || (k != d && v[k - 1] < v[k + 1])) {
+        x = v[k + 1]; /* (down, delete) */
+      } else {
+        x = v[k - 1] + 1; /* (right, insert) */
+      }
+      y = x - k;
+      while (x < nd && y < ns && dst[x] == src[y]) { x++; y++; }
+      v[k] = x;
+      if (x >= nd && y >= ns) {
+        end_d = d;
+        break;
+      }
+    }
+    if (end_d >= 0) break;
+    /* Save v[-d..d] */
+    if (tsize + 2 * d + 1 > TRACE_LIMIT) {
+      res = 0;
+      goto out;
+    }
+    if (tsize + 2 * d + 1 > tcap) {
+      tcap = tcap == 0 ? 1024 : tcap * 2;
+      while (tcap < tsize + 2 * d + 1) tcap *= 2;
+      tr = (int *)realloc(trace, tcap * sizeof(int));
+      if (tr == NULL) goto out;
+      trace = tr;
+    }
+    starts[d] = tsize;
+    memcpy(trace + tsize, v - d, (2 * d + 1) * sizeof(int));
+    tsize += 2 * d + 1;
+  }
+
+  /* Walk back from the end, collecting the moves of each step */
+  nops = end_d;
+  ops = (int *)malloc((nops > 0 ? nops : 1) * 3 * sizeof(int));
+  if (ops == NULL) goto out;
+  x = nd;
+  k = nd - ns;
+  for (d = end_d; d > 0; d--) {
+    tr = trace + starts[d - 1] + (d - 1); /* (tr[k] is v[k] at step d-1) */
+    if (k == -d || (k != d && tr[k - 1] < tr[k + 1])) {
+      kp = k + 1;
+      xp = tr[kp];
+      ops[3 * (d - 1)] = OP_DEL;
+      ops[3 * (d - 1) + 1] = xp;
+      ops[3 * (d - 1) + 2] = xp - kp;
+    } else {
+      kp = k - 1;
+      xp = tr[kp];
+      ops[3 * (d - 1)] = OP_INS;
+      ops[3 * (d - 1) + 1] = xp;
+      ops[3 * (d - 1) + 2] = xp;
+    }
+    x = xp;
+    k = kp;
+  }
+  for (i = 0; i < nops; i++) {
+    if (!script_add(s, ops[3 * i], ops[3 * i + 1] + p, ops[3 * i + 2] + p)) goto out;
+  }
+  res = 1;
+ out:
+  if (v != NULL) free(v - (max + 1));
+  free(starts);
+  free(trace);
+  free(ops);
+  return res;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Linear space divide and conquer (Myers 1986, section 4b), marking
+   the deleted and inserted elements. The script is minimal, but when
+   there are several minimal scripts it may differ from the greedy
+   one. */
+
+typedef struct bisect_ bisect_t;
+struct bisect_ {
+  const int *src;
+  const int *dst;
+  char *deleted;  /* (for each element of src) */
+  char *inserted; /* (for each element of dst) */
+  int *v1;
+  int *v2;
+};
+
+static void bisect_range(bisect_t *b, int ylo, int yhi, int xlo, int xhi);
+
+/* Find the middle snake of src[ylo..yhi) and dst[xlo..xhi) (both
+   non-empty) and solve both halves */
+static void bisect_split(bisect_t *b, int ylo, int yhi, int xlo, int xhi) {
+  const int *t1 = b->dst + xlo;
+  const int *t2 = b->src + ylo;
+  int len1 = xhi - xlo, len2 = yhi - ylo;
+  int max_d = (len1 + len2 + 1) / 2;
+  int v_offset = max_d, v_length = 2 * max_d + 2;
+  int *v1 = b->v1, *v2 = b->v2;
+  int delta = len1 - len2;
+  int front = (delta % 2 != 0);
+  int k1start = 0, k1end = 0, k2start = 0, k2end = 0;
+  int d, k1, k2, k1_offset, k2_offset, x1, y1, x2, y2, i;
+
+  for (i = 0; i < v_length; i++) { v1[i] = -1; v2[i] = -1; }
+  v1[v_offset + 1] = 0;
+  v2[v_offset + 1] = 0;
+  for (d = 0; d < max_d; d++) {
+    /* Forward paths */
+    for (k1 = -d + k1start; k1 <= d - k1end; k1 += 2) {
+      k1_offset = v_offset + k1;
+      if (k1 == -d || (k1 != d && v1[k1_offset - 1] < v1[k1_offset + 1])) {
+        x1 = v1[k1_offset + 1];
+      } else {
+        x1 = v1[k1_offset - 1] + 1;
+      }
+      y1 = x1 - k1;
+      while (x1 < len1 && y1 < len2 && t1[x1] == t2[y1]) { x1++; y1++; }
+      v1[k1_offset] = x1;
+      if (x1 > len1) {
+        k1end += 2;
+      } else if (y1 > len2) {
+        k1start += 2;
+      } else if (front) {
+        k2_offset = v_offset + delta - k1;
+        if (k2_offset >= 0 && k2_offset < v_length && v2[k2_offset] != -1) {
+          x2 = len1 - v2[k2_offset];
+          if (x1 >= x2) goto split;
+        }
+      }
+    }
+    /* Reverse paths */
+    for (k2 = -d + k2start; k2 <= d - k2end; k2 += 2) {
+      k2_offset = v_offset + k2;
+      if (k2 == -d || (k2 != d && v2[k2_offset - 1] < v2[k2_offset + 1])) {
+        x2 = v2[k2_offset + 1];
+      } else {
+        x2 = v2[k2_offset - 1] + 1;
+      }
+      y2 = x2 - k2;
+      while (x2 < len1 && y2 < len2 &&
+             t1[len1 - x2 - 1] == t2[len2 - y2 - 1]) { x2++; y2++; }
+      v2[k2_offset] = x2;
+      if (x2 > len1) {
+        k2end += 2;
+      } else if (y2 > len2) {
+        k2start += 2;
+      } else if (!front) {
+        k1_offset = v_offset + delta - k2;
+        if (k1_offset >= 0 && k1_offset < v_length && v1[k1_offset] != -1) {
+          x1 = v1[k1_offset];
+          y1 = v_offset + x1 - k1_offset;
+          if (x1 >= len1 - x2) goto split;
+        }
+      }
+    }
+  }
+  /* (no common elements) */
+  for (i = ylo; i < yhi; i++) b->deleted[i] = 1;
+  for (i = xlo; i < xhi; i++) b->inserted[i] = 1;
+  return;
+ split:
+  bisect_range(b, ylo, ylo + y1, xlo, xlo + x1);
+  bisect_range(b, ylo + y1, yhi, xlo + x1, xhi);
+}
+
+static void bisect_range(bisect_t *b, int ylo, int yhi, int xlo, int xhi) {
+  int i;
+
+  /* Common prefix and suffix */
+  while (ylo < yhi && xlo < xhi && b->src[ylo] == b->dst[xlo]) { ylo++; xlo++; }
+  while (ylo < yhi && xlo < xhi && b->src[yhi - 1] == b->dst[xhi - 1]) { yhi--; xhi--; }
+  if (ylo == yhi) {
+    for (i = xlo; i < xhi; i++) b->inserted[i] = 1;
+  } else if (xlo == xhi) {
+    for (i = ylo; i < yhi; i++) b->deleted[i] = 1;
+  } else {
+    bisect_split(b, ylo, yhi, xlo, xhi);
+  }
+}
+
+static int bisect_diff(const int *src, int ns, const int *dst, int nd,
+                       int p, script_t *s) {
+  bisect_t b;
+  int i, j, res = 0;
+  int vsize = ns + nd + 4;
+
+  b.src = src;
+  b.dst = dst;
+  b.deleted = (char *)calloc(ns + 1, 1);
+  b.inserted = (char *)calloc(nd + 1, 1);
+  b.v1 = (int *)malloc(vsize * sizeof(int));
+  b.v2 = (int *)malloc(vsize * sizeof(int));
+  if (b.deleted == NULL || b.inserted == NULL || b.v1 == NULL || b.v2 == NULL) goto out;
+  bisect_range(&b, 0, ns, 0, nd);
+  /* (deletions before insertions at the same position) */
+  i = 0;
+  j = 0;
+  while (i < ns || j < nd) {
+    if (i < ns && b.deleted[i]) {
+      if (!script_add(s, OP_DEL, j + p, i + p)) goto out;
+      i++;
+    } else if (j < nd && b.inserted[j]) {
+      if (!script_add(s, OP_INS, j + p, j + p)) goto out;
+      j++;
+    } else {
+      i++;
+      j++;
+    }
+  }
+  res = 1;
+ out:
+  free(b.deleted);
+  free(b.inserted);
+  free(b.v1);
+  free(b.v2);
+  return res;
+}
+
+/* --------------------------------------------------------------------------- */
+
+/* Returns 0 on memory errors */
+int diff_c(size_t ns, int *src, size_t nd, int *dst, size_t *nops, int **ops) {
+  script_t s;
+  int p = 0, r;
+
+  s.count = 0;
+  s.capacity = 0;
+  s.ops = NULL;
+  /* (the greedy algorithm starts by skipping the common prefix) */
+  while (p < (int)ns && p < (int)nd && src[p] == dst[p]) p++;
+  r = greedy_diff(src + p, ns - p, dst + p, nd - p, p, &s);
+  if (r == 0) {
+    s.count = 0;
+    r = bisect_diff(src + p, ns - p, dst + p, nd - p, p, &s);
+  }
+  if (r <= 0) {
+    free(s.ops);
+    *nops = 0;
+    *ops = NULL;
+    return 0;
+  }
+  *nops = s.count;
+  *ops = s.ops;
+  return 1;
+}
@@ -0,0 +1,106 @@
+:- module(_, [], [assertions, regtypes]).
+
+:- doc(title, "Event tracing").
+
+:- doc(author, "The Ciao Development Team").
+
+:- doc(stability, devel).
+
+:- doc(module, "@cindex{event tracing} @cindex{timeline}
+
+   This module provides an interface to the engine event tracer,
+   which records timestamped events (per thread) into a fixed size
+   ring buffer and writes them in the Chrome trace event format
+   (JSON). The resulting file can be inspected as a timeline in
+   @tt{chrome://tracing} or @href{https://ui.perfetto.dev}{Perfetto}.
+
+   The engine emits the following events when tracing is enabled:
+
+@begin{itemize}
+@item @tt{gc}: heap garbage collection (argument: heap size in bytes)
+@item @tt{heap_shift}, @tt{stack_shift}, @tt{choice_shift}: memory
+  area expansions (argument: area size in bytes)
+@item @tt{goal}: execution of a goal in a separate thread (see
+  @lib{concurrency}; argument: goal id)
+@item @tt{conc_wait}: blocked wait on a concurrent predicate
+@item @tt{table_complete}: completion of a tabled generator (see
+  @lib{tabling})
+@end{itemize}
+
+   User events can be added with @pred{evtrace_span/2} and
+   @pred{evtrace_instant/1}:
+
+@begin{verbatim}
+?- evtrace_start, evtrace_span(solve, main), evtrace_stop,
+   evtrace_dump('trace.json').
+@end{verbatim}
+
+   When disabled, the cost of each instrumentation point is a single
+   predicted branch. Only the most recent events are kept when the
+   buffer overflows.
+").
+
+:- use_module(engine(internals), [
+    '$evtrace_start'/1,
+    '$evtrace_stop'/0,
+    '$evtrace_event'/3,
+    '$evtrace_dump'/1
+]).
+:- use_module(library(port_reify), [once_port_reify/2, port_call/1]).
+
+% ---------------------------------------------------------------------------
+
+:- export(evtrace_start/1).
+:- pred evtrace_start(Size) : int(Size)
+   # "Start tracing (in all threads), keeping at most the last
+     @var{Size} events (rounded up to a power of 2). Events from
+     previous traces are discarded.".
+
+evtrace_start(Size) :-
+    ( var(Size) -> throw(error(instantiation_error, evtrace_start/1))
+    ; integer(Size), Size > 0 -> '$evtrace_start'(Size)
+    ; throw(error(domain_error(positive_integer, Size), evtrace_start/1))
+    ).
+
+:- export(evtrace_start/0).
+:- pred evtrace_start # "Like @pred{evtrace_start/1} with a buffer
+   of 65536 events.".
+
+evtrace_start :- evtrace_start(65536).
+
+:- export(evtrace_stop/0).
+:- pred evtrace_stop # "Stop tracing (recorded events are kept).".
+
+evtrace_stop :- '$evtrace_stop'.
+
+% ---------------------------------------------------------------------------
+
+:- export(evtrace_span/2).
+:- meta_predicate evtrace_span(goal, ?).
+:- pred evtrace_span(G, Name) : (callable(G), atm(Name))
+   # "Execute @var{G} (as with @pred{once/1}) recording its
+     duration as a span named @var{Name}.".
+
+evtrace_span(G, Name) :-
+    '$evtrace_event'(b, Name, 0),
+    once_port_reify(G, Port),
+    '$evtrace_event'(e, Name, 0),
+    port_call(Port).
+
+:- export(evtrace_instant/1).
+:- pred evtrace_instant(Name) : atm(Name)
+   # "Record an instant event named @var{Name}.".
+
+evtrace_instant(Name) :- '$evtrace_event'(i, Name, 0).
+
+% ---------------------------------------------------------------------------
+
+:- export(evtrace_dump/1).
+:- pred evtrace_dump(File) : atm(File)
+   # "Write the recorded events to @var{File} in Chrome trace event
+     format.".
+
+evtrace_dump(File) :-
+    ( '$evtrace_dump'(File) -> true
+    ; throw(error(permission_error(open, source_sink, File), evtrace_dump/1))
+    ).
@@ -1,12 +1,19 @@
 :- module(fuzzy_search,
     [
         levenshtein_dist/3,
+        levenshtein_dist/4,
         damerau_lev_dist/3,
-        fuzzy_search/5
-    ],[assertions, hiord]).
-
-:- use_module(library(lists), [length/2, last/2]).
-:- use_module(library(hiordlib), [minimum/3]).
+        damerau_lev_dist/4,
+        fuzzy_search/5,
+        fuzzy_index/2,
+        fuzzy_index_add/2,
+        fuzzy_index_search/4,
+        fuzzy_index_free/1
+    ],[assertions, hiord, foreign_interface]).
+
+:- use_module(library(lists), [member/2]).
+:- use_module(library(aggregates), [findall/3]).
+:- use_module(library(sort), [keysort/2]).
 
 :- doc(author, "Isabel Garcia-Contreras").
 
@@ -46,161 +53,133 @@ D = 1 ?
 
 yes
 ?- 
+    @end{verbatim}
+
+    Distances are computed in C, with the bit-parallel algorithms of
+    Myers and Hyyro when the shorter word has at most 64
+    characters (and dynamic programming otherwise). Given a maximum
+    distance (@pred{levenshtein_dist/4}, @pred{damerau_lev_dist/4}),
+    the computation stops as soon as that distance is exceeded.
+
+    For repeated searches in a large set of words (e.g., @em{did you
+    mean} suggestions), build an index once with @pred{fuzzy_index/2}
+    and query it with @pred{fuzzy_index_search/4}, which only computes
+    the distance to a small part of the words:
+
+    @begin{verbatim}
+?- fuzzy_index([append, length, member, reverse], I),
+   fuzzy_index_search(I, lenght, 2, W).
+
+W = length ? 
     @end{verbatim}").
 
 :- meta_predicate fuzzy_search(?, pred(1), pred(3), ?, ?).
 :- pred fuzzy_search(Word, Generator, Metric,  MaxDistance, Suggestion) :
     atom * atom * atom * num * var => atom * atom * atom * num * atom
     #"Proposes atoms generated by @var{Generator} which have 
-      @var{MaxDistance} differences with @var{Word}".
+      @var{MaxDistance} differences with @var{Word}, closest first".
 fuzzy_search(Word, Generator, Metric, MaxD, X) :-
     MaxD >= 0,
-    fuzzy_search_(Word, Generator, Metric, 0, MaxD, X).
-    
-:- meta_predicate fuzzy_search_(?, pred(1), pred(3), ?, ?, ?).
-fuzzy_search_(Word, Generator, Metric, N, _, X) :-
-    Generator(X),
-    Metric(Word, X, Dist),
-    Dist =:= N.
-fuzzy_search_(Word, Generator, Metric, N, Max, X) :-
-    N < Max,
-    N1 is N+1,
-    fuzzy_search_(Word, Generator, Metric, N1, Max, X).
-    
+    findall(Dist-X0, ( Generator(X0),
+                       Metric(Word, X0, Dist),
+                       Dist =< MaxD ), Xs0),
+    keysort(Xs0, Xs), % (stable, keeps the order of Generator)
+    member(_-X, Xs).
+
 :- pred levenshtein_dist(Word1, Word2, Distance) :
     atom * atom * var => atom * atom * num
    # "Computes the levenshtein @var{Distance} between @var{Word1} and @var{Word2}".
 levenshtein_dist(W1, W2, Dist) :-
-    levenshtein_matrix_ini(W1, W2, Row),
-    last(Row, Dist).
-
-sort_words(W1, W2, W1, W2) :-
-    length(W1, L1),
-    length(W2, L2),
-    L1 < L2, !.
-sort_words(W1, W2, W2, W1).
-
-:- pred levenshtein_matrix_ini(W1, W2, Row) :
-    atom * atom * var => atom * atom * list(num)
-    #"Returns the last @var{Row} of the levenshtein matrix 
-      of words @var{W1} and @var{W2}".
-
-levenshtein_matrix_ini(W1, W2, Row) :-
-    atom_codes(W1, Ls1),
-    atom_codes(W2, Ls2),
-    sort_words(Ls1, Ls2, LShort, LLong),
-    length(LLong, N),
-    count(N, IniRow),
-    levenshtein_matrix(LLong, LShort, IniRow, 0, Row).
-
-:- pred levenshtein_matrix(W1, W2, Prev_Row, N, Row) :
-    list * list * list(num) * num * var =>
-    list * list * list(num) * num * list(num)
-    #"Computes the last @var{Row} of the levenshtein matrix 
-       of words @var{W1}, @var{W2}".
-levenshtein_matrix([], _, Prev_Row, _, Row) :- !,
-    Row = Prev_Row.
-levenshtein_matrix([L1|W1], W2, Prev_Row, N, Row) :-
-    N1 is N+1,
-    levenshtein_row(L1, W2, N1, [N|Prev_Row], NewRow),
-    levenshtein_matrix(W1, W2, NewRow, N1, Row).
-
-:- pred levenshtein_row(L1, W2, Prev_Elem, Prev_Row, New_Row) :
-    list * list * num * list(num) * var =>
-    list * list * num * list(num) * list(num)
-    #"Computes a @var{NewRow} of a levenstein Matrix given a letter (@var{L1}), 
-      the second word (@var{W2}), the previous element computed (@var{Prev_Elem}) 
-      and the @var{PrevRow}".
-levenshtein_row(L1, [L2|W2], Xi, [Xs, Xd|Prev_Row], [Dist|Row]) :- !,
-    calculate_elem(Xs, Xd, Xi, L1, L2, Dist),
-    levenshtein_row(L1, W2, Dist, [Xd|Prev_Row], Row).
-levenshtein_row(_, [], _, _ , []).
-
-calculate_elem(Xs, Xd, Xi, W1, W2, Dist) :-
-    c_substitution(W1, W2, C),
-    N1 is Xi+1,
-    N2 is Xd+1,
-    N3 is Xs+C,
-    minimum([N1, N2, N3], min_nums, Dist).
-
-min_nums(N, M) :- N @< M.
-
-c_substitution(C, C, 0) :- !.
-c_substitution(_, _, 1).
-
-% TODO: defined somewhere else?
-:- pred count(N, Lst) : num * var => num * list(num)
-    #"@var{Lst} is the list of the first @var{N} naturals starting from 1".
-count(N, Lst) :-
-    count_(1, N, Lst).
-
-count_(I, N, []) :-
-    I > N, !.
-count_(I, N, [I|L]) :-
-    I1 is I+1,
-    count_(I1, N, L).
+    fuzzy_dist(0, W1, W2, -1, Dist).
 
-% ---------------------------------------------------------------------------
-:- doc(section, "Damerau-Levenshtein").
+:- pred levenshtein_dist(Word1, Word2, MaxDistance, Distance) :
+    atom * atom * int * var => atom * atom * int * int
+   # "Like @pred{levenshtein_dist/3}, but fails (as soon as it is known)
+      if the distance is greater than @var{MaxDistance}".
+levenshtein_dist(W1, W2, MaxD, Dist) :-
+    MaxD >= 0,
+    fuzzy_dist(0, W1, W2, MaxD, Dist0),
+    Dist0 =< MaxD,
+    Dist = Dist0.
 
 :- pred damerau_lev_dist(Word1, Word2, Distance) :
     atom * atom * var => atom * atom * num
     #"Computes the Damerau-Levenshtein @var{Distance} between @var{Word1} 
-      and @var{Word2}".
+      and @var{Word2} (adjacent transpositions of characters count as
+      one edit; each substring is edited at most once)".
 damerau_lev_dist(W1, W2, Dist) :-
-    damerau_lev_matrix_ini(W1, W2, Row),
-    last(Row, Dist).
-
-:- pred damerau_lev_matrix_ini(W1, W2, Row) :
-    atom * atom * var => atom * atom * list(num)
-    #"Returns the last @var{Row} of the damerau-levenshtein matrix 
-      of words @var{W1} and @var{W2}".
-%NOTE: -1 is a "letter" out of the alphabet
-damerau_lev_matrix_ini(W1, W2, Row) :-
-    atom_codes(W1, Ls1),
-    atom_codes(W2, Ls2),
-    sort_words(Ls1, Ls2, LShort, LLong),
-    length(LLong, N),
-    N1 is N+1,
-    count(N1, IniRow),
-    N2 is N1+1,
-    count(N2, PrevIniRow),
-    damerau_lev_matrix([-1|LLong], [-1|LShort], IniRow, PrevIniRow, 0, Row).
-
-:- pred damerau_lev_matrix(W1, W2, Prev_Row, Prev_Row2, N, Row) :
-    list * list * list(num) * list(num) * num * var =>
-    list * list * list(num) * list(num) * num * list(num)
-    #"Computes the last @var{Row} of the levenshtein matrix from 
-      words @var{W1}, @var{W2}".
-
-damerau_lev_matrix([_], _, Prev_Row, _, _, Row) :- !,
-    Row = Prev_Row.
-damerau_lev_matrix([L1_1, L1|W1], W2, Prev_Row, Prev_Row2, N, Row) :-
-    N1 is N+1,
-    damerau_lev_row([L1_1, L1], W2, N1, [N|Prev_Row], [N|Prev_Row2], NewRow),
-    damerau_lev_matrix([L1|W1], W2, NewRow, [N|Prev_Row], N1, Row).
-
-:- pred damerau_lev_row(L1, W2, Prev_Elem, Prev_Row, Prev_Row2, New_Row) :
-    list * list * num * list(num) * list(num) * var =>
-    list * list * num * list(num) * list(num) * list(num)
-     #"Computes a @var{NewRow} of a levenstein Matrix given a letter (@var{L1}), 
-      the second word (@var{W2}), the previous element computed (@var{Prev_Elem})
-      and the @var{PrevRow}".
-damerau_lev_row([L1_1,L1], [L2_1,L2|W2], Xi, [Xs,Xd|Prev_Row], [Xt|Prev_Row2], [Dist|Row]):- !,
-    damerau_calculate_elem(Xs, Xd, Xi, Xt, L1, L1_1, L2, L2_1, Dist),
-    damerau_lev_row([L1_1, L1], [L2| W2], Dist, [Xd|Prev_Row], Prev_Row2 ,Row).
-damerau_lev_row(_, [_], _, _ , _, []).
-
-damerau_calculate_elem(Xs, Xd, Xi, Xt, W1, W1_1, W2, W2_1, Dist) :-
-    c_substitution(W1, W2, Cs),
-    c_transposition(W1, W2_1, W2, W1_1, Ct),
-    N1 is Xi+1,
-    N2 is Xd+1,
-    N3 is Xs+Cs,
-    N4 is Xt+Ct,
-    minimum([N1, N2, N3, N4], min_nums, Dist).
-
-c_transposition(W1, W1, W2, W2, 1) :- !.
-c_transposition(_, _, _, _, 1000000). % 1000000 should be inf
-
-:- doc(bug, "Using 1000000 as inf limits word size to 1000000-1").
+    fuzzy_dist(1, W1, W2, -1, Dist).
+
+:- pred damerau_lev_dist(Word1, Word2, MaxDistance, Distance) :
+    atom * atom * int * var => atom * atom * int * int
+   # "Like @pred{damerau_lev_dist/3}, but fails (as soon as it is known)
+      if the distance is greater than @var{MaxDistance}".
+damerau_lev_dist(W1, W2, MaxD, Dist) :-
+    MaxD >= 0,
+    fuzzy_dist(1, W1, W2, MaxD, Dist0),
+    Dist0 =< MaxD,
+    Dist = Dist0.
+
+:- trust pred fuzzy_dist(in(Kind), in(W1), in(W2), in(MaxD), go(Dist)) ::
+    c_int * atm * atm * c_int * c_int + (foreign, returns(Dist))
+    # "@var{Dist} is the distance of kind @var{Kind} (0 for Levenshtein,
+      1 for Damerau-Levenshtein) between @var{W1} and @var{W2}, or
+      @tt{MaxD+1} if @var{MaxD} >= 0 and the distance is greater.".
+
+% ---------------------------------------------------------------------------
+:- doc(section, "Indexed search").
+
+:- export(fuzzy_index/1).
+:- regtype fuzzy_index(I) # "@var{I} is an index of words for fuzzy
+   search.".
+
+fuzzy_index('$fuzzy_index'(Addr)) :- address(Addr).
+
+:- pred fuzzy_index(+Words, -Index) : list(atm) * var => list(atm) * fuzzy_index
+    # "@var{Index} is a new index (a BK-tree, with Levenshtein distance)
+      of the atoms in @var{Words}. It is kept in memory until
+      @pred{fuzzy_index_free/1} is called.".
+fuzzy_index(Words, '$fuzzy_index'(Addr)) :-
+    fuzzy_index_new(Addr),
+    ( member(W, Words),
+        fuzzy_index_add_c(Addr, W),
+        fail
+    ; true
+    ).
+
+:- pred fuzzy_index_add(+Index, +Word) : fuzzy_index * atm
+    # "Adds @var{Word} to @var{Index} (nothing is done if it is already
+      in the index).".
+fuzzy_index_add('$fuzzy_index'(Addr), Word) :-
+    fuzzy_index_add_c(Addr, Word).
+
+:- pred fuzzy_index_search(+Index, +Word, +MaxDistance, -Suggestion)
+    : fuzzy_index * atm * int * var => fuzzy_index * atm * int * atm
+    # "Enumerates the atoms in @var{Index} within Levenshtein distance
+      @var{MaxDistance} of @var{Word}, closest first (ties in
+      alphabetical order).".
+fuzzy_index_search('$fuzzy_index'(Addr), Word, MaxD, X) :-
+    MaxD >= 0,
+    fuzzy_index_search_c(Addr, Word, MaxD, Xs),
+    member(_-X, Xs).
+
+:- pred fuzzy_index_free(+Index) : fuzzy_index
+    # "Frees the memory of @var{Index}, which must not be used
+      afterwards.".
+fuzzy_index_free('$fuzzy_index'(Addr)) :-
+    fuzzy_index_free_c(Addr).
+
+:- trust pred fuzzy_index_new(go(Addr)) ::
+    address + (foreign, returns(Addr)).
+:- trust pred fuzzy_index_add_c(in(Addr), in(Word)) ::
+    address * atm + foreign(fuzzy_index_add).
+:- trust pred fuzzy_index_search_c(in(Addr), in(Word), in(MaxD), go(Xs)) ::
+    address * atm * c_int * any_term
+    + (foreign(fuzzy_index_search), returns(Xs)).
+:- trust pred fuzzy_index_free_c(in(Addr)) ::
+    address + foreign(fuzzy_index_free).
+
+:- doc(bug, "Indexes are not thread-safe: an index must not be
+   modified while other threads use it.").
+
+:- use_foreign_source(fuzzy_search_c).
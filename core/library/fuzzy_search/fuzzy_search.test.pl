@@ -0,0 +1,174 @@
+:- module(_, [], [assertions]).
+
+:- doc(title, "Tests for fuzzy_search.pl").
+
+:- use_module(library(fuzzy_search)).
+:- use_module(library(lists), [member/2, length/2, append/3]).
+:- use_module(library(aggregates), [findall/3]).
+:- use_module(library(sort), [sort/2]).
+:- use_module(library(random), [random/3, srandom/1]).
+
+% ---------------------------------------------------------------------------
+% Reference implementations (dynamic programming over code lists)
+
+ref_dist(Kind, W1, W2, D) :-
+    atom_codes(W1, A),
+    atom_codes(W2, B),
+    length(B, N),
+    numlist0(N, Row0),
+    ref_rows(A, Kind, none, B, none, Row0, 1, Row),
+    last_(Row, D).
+
+% ref_rows(As, Kind, PC, B, Row2, Row1, I, Row): Row is the last row of
+% the table, given the two previous rows (Row2 is none for the first
+% one) and the previous character PC
+ref_rows([], _, _, _, _, Row, _, Row).
+ref_rows([C|As], Kind, PC, B, Row2, Row1, I, Row) :-
+    ( Row2 = none -> Diags2 = none ; Diags2 = [none|Row2] ),
+    ref_cells(B, Kind, none, C, PC, Row1, Diags2, I, Ds),
+    I1 is I + 1,
+    ref_rows(As, Kind, C, B, Row1, [I|Ds], I1, Row).
+
+% Each cell is the minimum of a deletion, an insertion, a substitution,
+% and (for Damerau-Levenshtein, Kind = 1) a transposition of adjacent
+% characters
+ref_cells([], _, _, _, _, _, _, _, []).
+ref_cells([CB|Bs], Kind, PCB, C, PC, [Diag,Up|Ups], Diags2, Left, [D|Ds]) :-
+    ( C == CB -> Cost = 0 ; Cost = 1 ),
+    D0 is Diag + Cost,
+    min_(Up + 1, D0, D1),
+    min_(Left + 1, D1, D2),
+    ( Kind =:= 1, Diags2 = [Diag2|_], C == PCB, PC == CB ->
+        min_(Diag2 + 1, D2, D)
+    ; D = D2
+    ),
+    ( Diags2 = [_|Diags2s] -> true ; Diags2s = none ),
+    ref_cells(Bs, Kind, CB, C, PC, [Up|Ups], Diags2s, D, Ds).
+
+min_(X0, Y, Z) :- X is X0, ( X < Y -> Z = X ; Z = Y ).
+
+numlist0(N, L) :- numlist0_(0, N, L).
+numlist0_(I, N, [I|Is]) :-
+    ( I < N -> I1 is I + 1, numlist0_(I1, N, Is) ; Is = [] ).
+
+last_([X], X) :- !.
+last_([_|Xs], X) :- last_(Xs, X).
+
+% ---------------------------------------------------------------------------
+% Words
+
+% Words with few distinct characters (so that they are close), with
+% lengths around 64 (the limit for the bit-parallel algorithms)
+words(Seed, N, Ws) :-
+    srandom(Seed),
+    words_(N, Ws).
+
+words_(0, []) :- !.
+words_(N, [W|Ws]) :-
+    random(0, 39, L0),
+    ( L0 mod 4 =:= 0 -> L is 60 + L0 mod 10 ; L is L0 mod 12 ),
+    word_codes(L, Cs),
+    atom_codes(W, Cs),
+    N1 is N - 1,
+    words_(N1, Ws).
+
+word_codes(0, []) :- !.
+word_codes(L, [C|Cs]) :-
+    random(0, 3, R),
+    C is 0'a + R,
+    L1 is L - 1,
+    word_codes(L1, Cs).
+
+edge_words(['', a, b, ab, ba, abc, acb, bca, aab, baa,
+    Long1, Long2, Long3]) :-
+    length(L1, 64), fill(L1, 0'a), atom_codes(Long1, L1),
+    append(L1, "b", L2), atom_codes(Long2, L2),
+    append("b", L2, L3), atom_codes(Long3, L3).
+
+fill([], _).
+fill([C|Cs], C) :- fill(Cs, C).
+
+test_words(Ws) :-
+    edge_words(Ws0),
+    words(1, 40, Ws1),
+    append(Ws0, Ws1, Ws).
+
+% ---------------------------------------------------------------------------
+
+:- export(test_levenshtein/0).
+:- test test_levenshtein # "levenshtein_dist/3,4 agree with the
+   definition".
+test_levenshtein :-
+    test_words(Ws),
+    \+ ( member(W1, Ws), member(W2, Ws),
+          \+ check_dist(0, W1, W2) ).
+
+:- export(test_damerau/0).
+:- test test_damerau # "damerau_lev_dist/3,4 agree with the definition
+   (optimal string alignment)".
+test_damerau :-
+    test_words(Ws),
+    \+ ( member(W1, Ws), member(W2, Ws),
+          \+ check_dist(1, W1, W2) ),
+    damerau_lev_dist(ca, abc, D),
+    D == 3. % (not 2: each substring is edited at most once)
+
+:- export(test_utf8/0).
+:- test test_utf8 # "Words are compared by characters (not by bytes of
+   their UTF-8 encoding)".
+test_utf8 :-
+    levenshtein_dist('año', ano, D1), D1 == 1,
+    levenshtein_dist('', 'ñoño', D2), D2 == 4,
+    damerau_lev_dist('añó', 'aóñ', D3), D3 == 1,
+    \+ levenshtein_dist('ñ', 'ó', 0, _).
+
+check_dist(Kind, W1, W2) :-
+    ref_dist(Kind, W1, W2, D),
+    dist(Kind, W1, W2, D0),
+    D0 == D,
+    \+ ( member(Max, [0, 1, 2, 3, 10]),
+          \+ check_max_dist(Kind, W1, W2, Max, D) ).
+
+check_max_dist(Kind, W1, W2, Max, D) :-
+    ( D =< Max -> max_dist(Kind, W1, W2, Max, D0), D0 == D
+    ; \+ max_dist(Kind, W1, W2, Max, _)
+    ).
+
+dist(0, W1, W2, D) :- levenshtein_dist(W1, W2, D).
+dist(1, W1, W2, D) :- damerau_lev_dist(W1, W2, D).
+
+max_dist(0, W1, W2, Max, D) :- levenshtein_dist(W1, W2, Max, D).
+max_dist(1, W1, W2, Max, D) :- damerau_lev_dist(W1, W2, Max, D).
+
+:- export(test_fuzzy_search/0).
+:- test test_fuzzy_search # "fuzzy_search/5 enumerates the words
+   within the distance, closest first".
+test_fuzzy_search :-
+    findall(W, fuzzy_search(lenght, word, levenshtein_dist, 2, W), Ws),
+    Ws == [length, lengths]. % (ties in the order of word/1)
+
+word(length).
+word(member).
+word(strength).
+word(lengths).
+
+% ---------------------------------------------------------------------------
+
+:- export(test_index/0).
+:- test test_index # "fuzzy_index_search/4 finds the same words as a
+   linear search".
+test_index :-
+    test_words(Ws),
+    fuzzy_index(Ws, I),
+    fuzzy_index_add(I, a), % (already in the index)
+    words(2, 20, Qs),
+    ( member(Q, Qs), member(Max, [0, 1, 2, 3, 8]),
+      findall(W, fuzzy_index_search(I, Q, Max, W), Found),
+      findall(D-W, ( member(W, Ws), ref_dist(0, Q, W, D), D =< Max ), DWs),
+      sort(DWs, Sorted), % (closest first, then alphabetical)
+      findall(W, member(_-W, Sorted), Expected),
+      Found \== Expected ->
+        fuzzy_index_free(I),
+        fail
+    ; fuzzy_index_free(I)
+    ).
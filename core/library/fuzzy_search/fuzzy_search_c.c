@@ -0,0 +1,408 @@
+/* Edit distances and BK-tree index for library(fuzzy_search) */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ciao_prolog.h>
+
+#define DIST_LEVENSHTEIN 0
+#define DIST_DAMERAU 1 /* (optimal string alignment) */
+
+/* --------------------------------------------------------------------------- */
+/* Words (decoded from UTF-8 into code points) */
+
+typedef struct word_ word_t;
+struct word_ {
+  int32_t *codes;
+  int len;
+};
+
+static int word_init(word_t *word, const char *s) {
+  const unsigned char *p = (const unsigned char *)s;
+  int32_t c;
+  int n = 0;
+
+  word->codes = (int32_t *)malloc((strlen(s) + 1) * sizeof(int32_t));
+  if (word->codes == NULL) return 0;
+  while (*p) {
+    if (*p < 0x80) {
+      c = *p++;
+    } else if ((*p & 0xE0) == 0xC0 && p[1]) {
+      c = ((p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+      p += 2;
+    } else if ((*p & 0xF0) == 0xE0 && p[1] && p[2]) {
+      c = ((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+      p += 3;
+    } else if ((*p & 0xF8) == 0xF0 && p[1] && p[2] && p[3]) {
+      c = ((p[0] & 0x07) << 18) | ((p[1] & 0x3F) << 12) |
+          ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+      p += 4;
+    } else { /* (invalid byte, taken as is) */
+      c = *p++;
+    }
+    word->codes[n++] = c;
+  }
+  word->len = n;
+  return 1;
+}
+
+static void word_free(word_t *word) {
+  free(word->codes);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Bit-parallel distances (Myers 1999, Hyyro 2003), for patterns of up
+   to 64 characters */
+
+#define PEQ_DIRECT 256
+
+/* Match masks of the characters of a pattern */
+typedef struct peq_ peq_t;
+struct peq_ {
+  uint64_t direct[PEQ_DIRECT];
+  /* (characters out of the direct table, at most 64) */
+  int nother;
+  int32_t other[64];
+  uint64_t other_mask[64];
+};
+
+static void peq_init(peq_t *peq, const word_t *pat) {
+  int i, k;
+  int32_t c;
+
+  memset(peq->direct, 0, sizeof(peq->direct));
+  peq->nother = 0;
+  for (i = 0; i < pat->len; i++) {
+    c = pat->codes[i];
+    if (c >= 0 && c < PEQ_DIRECT) {
+      peq->direct[c] |= (uint64_t)1 << i;
+      continue;
+    }
+    for (k = 0; k < peq->nother; k++) {
+      if (peq->other[k] == c) break;
+    }
+    if (k == peq->nother) {
+      peq->other[k] = c;
+      peq->other_mask[k] = 0;
+      peq->nother++;
+    }
+    peq->other_mask[k] |= (uint64_t)1 << i;
+  }
+}
+
+static inline uint64_t peq_get(const peq_t *peq, int32_t c) {
+  int k;
+  if (c >= 0 && c < PEQ_DIRECT) return peq->direct[c];
+  for (k = 0; k < peq->nother; k++) {
+    if (peq->other[k] == c) return peq->other_mask[k];
+  }
+  return 0;
+}
+
+/* Distance between the pattern (with match masks peq and length m,
+   1 <= m <= 64) and text. If max >= 0 and the distance is greater
+   than max, stops as soon as it is known and returns max+1. */
+static int bitpar_dist(int kind, const peq_t *peq, int m, const word_t *text, int max) {
+  uint64_t vp = ~(uint64_t)0;
+  uint64_t vn = 0;
+  uint64_t last = (uint64_t)1 << (m - 1);
+  uint64_t eq, prev_eq = 0, d0 = 0, hp, hn, x;
+  int score = m;
+  int j, n = text->len;
+
+  for (j = 0; j < n; j++) {
+    eq = peq_get(peq, text->codes[j]);
+    if (kind == DIST_DAMERAU) {
+      x = (((~d0) & eq) << 1) & prev_eq; /* transpositions */
+      d0 = (((eq & vp) + vp) ^ vp) | eq | vn | x;
+      prev_eq = eq;
+    } else {
+      d0 = (((eq & vp) + vp) ^ vp) | eq | vn;
+    }
+    hp = vn | ~(d0 | vp);
+    hn = d0 & vp;
+    if (hp & last) score++;
+    else if (hn & last) score--;
+    /* (each remaining column decreases the score by at most 1) */
+    if (max >= 0 && score - (n - j - 1) > max) return max + 1;
+    x = (hp << 1) | 1;
+    vn = x & d0;
+    vp = (hn << 1) | ~(x | d0);
+  }
+  return score;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Dynamic programming distances (for longer words), restricted to the
+   diagonal band of width max if max >= 0 */
+
+static int dp_dist(int kind, const word_t *a, const word_t *b, int max) {
+  int m = a->len, n = b->len;
+  int i, j, lo, hi, v, best, inf, res;
+  int *rows, *r0, *r1, *r2, *t;
+
+  inf = m + n + 1;
+  if (max < 0 || max > m + n) max = m + n;
+  rows = (int *)malloc(3 * (n + 1) * sizeof(int));
+  if (rows == NULL) return -1;
+  r0 = rows; /* (row i-2) */
+  r1 = r0 + (n + 1); /* (row i-1) */
+  r2 = r1 + (n + 1); /* (row i) */
+  for (j = 0; j <= n; j++) {
+    r0[j] = inf;
+    r1[j] = j <= max ? j : inf;
+  }
+  for (i = 1; i <= m; i++) {
+    lo = i - max > 1 ? i - max : 1;
+    hi = i + max < n ? i + max : n;
+    for (j = 0; j <= n; j++) r2[j] = inf;
+    r2[0] = i <= max ? i : inf;
+    best = r2[0];
+    for (j = lo; j <= hi; j++) {
+      v = r1[j - 1] + (a->codes[i - 1] == b->codes[j - 1] ? 0 : 1);
+      if (r1[j] + 1 < v) v = r1[j] + 1;
+      if (r2[j - 1] + 1 < v) v = r2[j - 1] + 1;
+      if (kind == DIST_DAMERAU && i > 1 && j > 1 &&
+          a->codes[i - 1] == b->codes[j - 2] &&
+          a->codes[i - 2] == b->codes[j - 1] &&
+          r0[j - 2] + 1 < v) {
+        v = r0[j - 2] + 1;
+      }
+      r2[j] = v;
+      if (v < best) best = v;
+    }
+    if (best > max) { /* (the distance is greater than max) */
+      free(rows);
+      return max + 1;
+    }
+    t = r0; r0 = r1; r1 = r2; r2 = t;
+  }
+  res = r1[n] > max ? max + 1 : r1[n];
+  free(rows);
+  return res;
+}
+
+/* Distance between a and b (greater than max if max >= 0 and the
+   distance is greater than max), where pattern is NULL or the match
+   masks of a */
+static int word_dist(int kind, const word_t *a, const peq_t *pattern, const word_t *b, int max) {
+  peq_t peq;
+  int diff;
+
+  diff = a->len > b->len ? a->len - b->len : b->len - a->len;
+  if (max >= 0 && diff > max) return max + 1;
+  if (a->len == 0) return b->len;
+  if (b->len == 0) return a->len;
+  if (a->len <= 64) {
+    if (pattern == NULL) {
+      peq_init(&peq, a);
+      pattern = &peq;
+    }
+    return bitpar_dist(kind, pattern, a->len, b, max);
+  }
+  if (b->len <= 64) return word_dist(kind, b, NULL, a, max);
+  return dp_dist(kind, a, b, max);
+}
+
+int fuzzy_dist(int kind, char *s1, char *s2, int max) {
+  word_t a, b;
+  int d;
+
+  if (!word_init(&a, s1)) return -1;
+  if (!word_init(&b, s2)) {
+    word_free(&a);
+    return -1;
+  }
+  /* (use the shorter word as pattern) */
+  if (a.len <= b.len) d = word_dist(kind, &a, NULL, &b, max);
+  else d = word_dist(kind, &b, NULL, &a, max);
+  word_free(&a);
+  word_free(&b);
+  return d;
+}
+
+/* --------------------------------------------------------------------------- */
+/* BK-tree of words (with Levenshtein distance) */
+
+typedef struct bknode_ bknode_t;
+typedef struct bkchild_ bkchild_t;
+
+struct bkchild_ {
+  int dist;
+  bknode_t *node;
+};
+
+struct bknode_ {
+  char *name;
+  word_t word;
+  int maxdist; /* (max dist of children) */
+  int nchildren;
+  int capacity;
+  bkchild_t *children;
+};
+
+typedef struct bktree_ bktree_t;
+struct bktree_ {
+  bknode_t *root;
+};
+
+static bknode_t *bknode_new(const char *name, word_t *word) {
+  bknode_t *node;
+
+  node = (bknode_t *)malloc(sizeof(bknode_t));
+  if (node == NULL) return NULL;
+  node->name = strdup(name);
+  if (node->name == NULL) {
+    free(node);
+    return NULL;
+  }
+  node->word = *word;
+  node->maxdist = 0;
+  node->nchildren = 0;
+  node->capacity = 0;
+  node->children = NULL;
+  return node;
+}
+
+static void bknode_free(bknode_t *node) {
+  int i;
+  for (i = 0; i < node->nchildren; i++) bknode_free(node->children[i].node);
+  free(node->children);
+  free(node->name);
+  word_free(&node->word);
+  free(node);
+}
+
+bktree_t *fuzzy_index_new(void) {
+  bktree_t *tree;
+
+  tree = (bktree_t *)malloc(sizeof(bktree_t));
+  if (tree == NULL) return NULL;
+  tree->root = NULL;
+  return tree;
+}
+
+void fuzzy_index_free(bktree_t *tree) {
+  if (tree->root != NULL) bknode_free(tree->root);
+  free(tree);
+}
+
+/* Add a word (nothing is done if it is already in the tree) */
+void fuzzy_index_add(bktree_t *tree, char *name) {
+  bknode_t *node, *new_node;
+  bkchild_t *children;
+  word_t word;
+  peq_t peq;
+  int i, d, capacity;
+
+  if (!word_init(&word, name)) return;
+  if (tree->root == NULL) {
+    tree->root = bknode_new(name, &word);
+    if (tree->root == NULL) word_free(&word);
+    return;
+  }
+  if (word.len > 0 && word.len <= 64) peq_init(&peq, &word);
+  node = tree->root;
+  for (;;) {
+    d = word_dist(DIST_LEVENSHTEIN, &word, &peq, &node->word, -1);
+    if (d == 0) break; /* (already in the tree) */
+    for (i = 0; i < node->nchildren; i++) {
+      if (node->children[i].dist == d) break;
+    }
+    if (i < node->nchildren) {
+      node = node->children[i].node;
+      continue;
+    }
+    if (node->nchildren == node->capacity) {
+      capacity = node->capacity == 0 ? 4 : node->capacity * 2;
+      children = (bkchild_t *)realloc(node->children, capacity * sizeof(bkchild_t));
+      if (children == NULL) break;
+      node->children = children;
+      node->capacity = capacity;
+    }
+    new_node = bknode_new(name, &word);
+    if (new_node == NULL) break;
+    node->children[node->nchildren].dist = d;
+    node->children[node->nchildren].node = new_node;
+    node->nchildren++;
+    if (d > node->maxdist) node->maxdist = d;
+    return;
+  }
+  word_free(&word);
+}
+
+typedef struct match_ match_t;
+struct match_ {
+  int dist;
+  const char *name;
+};
+
+typedef struct matches_ matches_t;
+struct matches_ {
+  int count;
+  int capacity;
+  match_t *items;
+};
+
+static void bknode_search(bknode_t *node, const word_t *word, const peq_t *peq,
+                          int max, matches_t *ms) {
+  match_t *items;
+  int i, d, capacity;
+
+  /* (children at distance d' from node may contain words only if
+     |d - d'| <= max) */
+  d = word_dist(DIST_LEVENSHTEIN, word, peq, &node->word, node->maxdist + max);
+  if (d <= max) {
+    if (ms->count == ms->capacity) {
+      capacity = ms->capacity == 0 ? 16 : ms->capacity * 2;
+      items = (match_t *)realloc(ms->items, capacity * sizeof(match_t));
+      if (items == NULL) return;
+      ms->items = items;
+      ms->capacity = capacity;
+    }
+    ms->items[ms->count].dist = d;
+    ms->items[ms->count].name = node->name;
+    ms->count++;
+  }
+  for (i = 0; i < node->nchildren; i++) {
+    if (node->children[i].dist >= d - max && node->children[i].dist <= d + max) {
+      bknode_search(node->children[i].node, word, peq, max, ms);
+    }
+  }
+}
+
+static int match_cmp(const void *x, const void *y) {
+  const match_t *a = (const match_t *)x;
+  const match_t *b = (const match_t *)y;
+  if (a->dist != b->dist) return a->dist - b->dist;
+  return strcmp(a->name, b->name);
+}
+
+/* List of Dist-Word pairs for the words within distance max of name,
+   sorted by distance */
+ciao_term fuzzy_index_search(bktree_t *tree, char *name, int max) {
+  matches_t ms;
+  word_t word;
+  peq_t peq;
+  ciao_term list;
+  int i;
+
+  list = ciao_empty_list();
+  if (tree->root == NULL || max < 0) return list;
+  if (!word_init(&word, name)) return list;
+  if (word.len > 0 && word.len <= 64) peq_init(&peq, &word);
+  ms.count = 0;
+  ms.capacity = 0;
+  ms.items = NULL;
+  bknode_search(tree->root, &word, &peq, max, &ms);
+  qsort(ms.items, ms.count, sizeof(match_t), match_cmp);
+  for (i = ms.count - 1; i >= 0; i--) {
+    list = ciao_list(ciao_structure("-", 2,
+                                    ciao_mk_c_int(ms.items[i].dist),
+                                    ciao_atom(ms.items[i].name)),
+                     list);
+  }
+  free(ms.items);
+  word_free(&word);
+  return list;
+}
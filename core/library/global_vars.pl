@@ -1,4 +1,6 @@
-:- module(global_vars, [setval/2, getval/2, current/2], [hiord, assertions, datafacts]).
+:- module(global_vars, [setval/2, getval/2, current/2,
+    b_setval/2, b_getval/2, nb_setval/2, nb_getval/2],
+    [hiord, assertions, datafacts]).
 
 :- doc(title, "Backtrackable global variables").
 :- doc(author, "Jose F. Morales").
@@ -10,7 +12,7 @@
    Global variables differ from storing information using dynamic
    predicates:
    @begin{itemize}
-   @item Global variables are semantically equivalent to a dictionary 
+   @item Global variables are semantically equivalent to a dictionary
      passed around as an implicit pair of variables:
      @begin{itemize}
      @item only one value is associated to a variable at a time
@@ -19,63 +21,130 @@
      @item access cost is proportional to a unification
      @item variable sharing is preserved during assignment
      @end{itemize}
-   @item Keys of global variables are local to each module.
+   @item Keys of global variables are local to each module (and to
+     each thread).
    @item Contrary to dynamic predicates, there is no copy of
      terms. This is particularly interesting for large terms.
    @end{itemize}
 
-   The implementation is based on a globally reachable structure in
-   the heap, where each entry is allocated dynamically for each key.
-
-   Note that the current implementation has some limitations (see bug
-   entries in this module).
+   Non-backtrackable global variables (@pred{nb_setval/2} and
+   @pred{nb_getval/2}) are also provided. Their values survive
+   backtracking, at the cost of a copy of the term on each assignment
+   and read.
+
+   The implementation maps each key to a slot with a hash table in
+   the engine (with no limit on the number of modules or keys). The
+   values of the slots are kept in a vector in the heap (reachable
+   from a global root), which is assigned with backtrackable
+   destructive assignment and grown (doubling its size) when needed,
+   so that reading and assigning a variable takes constant time.
+   Non-backtrackable values are kept in the database (and removed
+   after the thread that assigned them is released).
 ").
 
 :- doc(bug, "The use of global variables may produce incorrect results
    for sharing analysis.").
 :- doc(bug, "We still do not support statically declared global variables").
-:- doc(bug, "Allocation of entries is not undone on backtracking, which
-   may exhaust available space quickly for some programs").
-:- doc(bug, "No more than 255 modules can use global variables in a program.").
-:- doc(bug, "No more than 255 global variables can be used in a module.").
-
-:- use_module(engine(internals), ['$global_vars_get'/2]).
-
-:- data(module_counter/1).
-:- data(key_counter/3).
-:- data(key/4).
-
-module_counter(1).
-
-get_info(Module, Key, I, J):-
-    key(Module, Key, I, J), !.
-get_info(Module, Key, I, J):-
-    retract_fact(key_counter(Module, I, J)), !, 
-    K is J + 1, assertz_fact(key_counter(Module, I, K)),
-    assertz_fact(key(Module, Key, I, J)).
-get_info(Module, Key, I, 1):-
-    retract_fact(module_counter(I)), 
-    J is I + 1, assertz_fact(module_counter(J)), 
-    assertz_fact(key_counter(Module, I, 2)), 
-    assertz_fact(key(Module, Key, I, 1)).
-    
-:- use_module(library(mutables)).
-
-:- use_module(engine(internals), ['$global_vars_set'/2]).
-global_array(GlobalArray) :-
-    % (See engine(internals) for reserved low level global variables)
-    ( '$global_vars_get'(11, 0) -> % (default value)
-        '$global_vars_set'(11, GlobalArray)
-    ; '$global_vars_get'(11, GlobalArray)
+
+:- use_module(engine(internals), [
+    '$global_vars_get'/2, '$global_vars_set'/2,
+    '$gvar'/4, '$gvar_keys'/2, '$gvar_released'/1, '$setarg'/4]).
+:- use_module(library(lists), [member/2]).
+
+% ---------------------------------------------------------------------------
+% Slots
+
+% The vector of slots is '$gvars'(V1, ..., Vn) (see engine(internals) for
+% reserved low level global variables). Unassigned slots contain
+% '$unset'.
+
+vector_min_size(64).
+
+% Vector with at least Slot slots
+vector(Slot, Vector) :-
+    '$global_vars_get'(11, Vector0),
+    ( Vector0 == 0 -> % (default value)
+        vector_min_size(N),
+        new_vector(Slot, N, 0, Vector0, Vector)
+    ; functor(Vector0, _, N0),
+      ( Slot =< N0 ->
+          Vector = Vector0
+      ; N is N0 * 2,
+        new_vector(Slot, N, N0, Vector0, Vector)
+      )
+    ).
+
+% Vector of size N (or larger if Slot > N) with the N0 slots of Vector0
+new_vector(Slot, N, N0, Vector0, Vector) :-
+    ( Slot > N ->
+        N1 is N * 2,
+        new_vector(Slot, N1, N0, Vector0, Vector)
+    ; functor(Vector, '$gvars', N),
+      copy_slots(1, N0, Vector0, Vector),
+      unset_slots(N0, N, Vector),
+      '$global_vars_set'(11, Vector)
+    ).
+
+copy_slots(I, N0, _, _) :- I > N0, !.
+copy_slots(I, N0, Vector0, Vector) :-
+    arg(I, Vector0, X),
+    arg(I, Vector, X),
+    I1 is I + 1,
+    copy_slots(I1, N0, Vector0, Vector).
+
+unset_slots(I, I, _) :- !.
+unset_slots(I, N, Vector) :-
+    I1 is I + 1,
+    arg(I1, Vector, '$unset'),
+    unset_slots(I1, N, Vector).
+
+% (fails if Key is not an atom)
+b_set(Key, Module, Value) :-
+    '$gvar'(Module, Key, Slot, _),
+    vector(Slot, Vector),
+    '$setarg'(Slot, Vector, Value, on).
+
+b_get(Key, Module, Value) :-
+    '$gvar'(Module, Key, Slot, Id),
+    vector(Slot, Vector),
+    arg(Slot, Vector, Value0),
+    ( Value0 == '$unset' ->
+        ( nb_value(Id, Value1) -> true
+        ; true % (fresh variable)
+        ),
+        '$setarg'(Slot, Vector, Value1, on),
+        Value = Value1
+    ; Value = Value0
+    ).
+
+:- data nb_value/2. % nb_value(Id, Value)
+
+nb_set(Key, Module, Value) :-
+    forget_released,
+    '$gvar'(Module, Key, Slot, Id),
+    retractall_fact(nb_value(Id, _)),
+    assertz_fact(nb_value(Id, Value)),
+    % (forget the backtrackable value, not undone on backtracking)
+    vector(Slot, Vector),
+    '$setarg'(Slot, Vector, '$unset', true).
+
+% Remove the values of the variables of released threads (whose ids
+% are never used again)
+forget_released :-
+    '$gvar_released'(Ids),
+    ( member(Id, Ids),
+        retractall_fact(nb_value(Id, _)),
+        fail
+    ; true
+    ).
+
+nb_get(Key, Module, Value) :-
+    '$gvar'(Module, Key, _, Id),
+    ( nb_value(Id, Value0) -> Value = Value0
+    ; true
     ).
 
-global(Module, Key, Value):-
-    get_info(Module, Key, I, J),
-    global_array(GlobalArray),
-    functor(GlobalArray, t, 255), 
-    arg(I, GlobalArray, Array), 
-    functor(Array, t, 255), 
-    arg(J, Array, Value).
+% ---------------------------------------------------------------------------
 
 :- pred setval(Name,Value) # "Associate the term @var{Value} with the
    atom @var{Name}. If @var{Name} does not refer to an existing global
@@ -86,18 +155,12 @@ global(Module, Key, Value):-
 
 :- if(defined(optim_comp)).
 :- '$context'(setval/2, module).
-setval(Key, Value) :- '$module'(M), setval_(Key, M, Value).
+setval(Key, Value) :- '$module'(M), b_set(Key, M, Value).
 :- else.
 :- meta_predicate setval(addmodule, +).
-setval(Key, M, Value) :- setval_(Key, M, Value).
+setval(Key, M, Value) :- b_set(Key, M, Value).
 :- endif.
 
-setval_(Key, _Module, _Value):-
-    \+ atom(Key), !, fail.
-setval_(Key, Module, Value):-
-    global(Module, Key, Mutable), 
-    set(Mutable, Value). 
-
 :- pred getval(Name,Value) # "Unifies @var{Value} with the current
    value of the global variable refered to by the atom @var{Name}. If
    @var{Name} does not refer to an exisiting global variable, a free
@@ -106,17 +169,59 @@ setval_(Key, Module, Value):-
 
 :- if(defined(optim_comp)).
 :- '$context'(getval/2, module).
-getval(Key, Value) :- '$module'(M), getval_(Key, M, Value).
+getval(Key, Value) :- '$module'(M), b_get(Key, M, Value).
 :- else.
 :- meta_predicate getval(addmodule, +).
-getval(Key, M, Value) :- getval_(Key, M, Value).
+getval(Key, M, Value) :- b_get(Key, M, Value).
+:- endif.
+
+:- pred b_setval(Name,Value) # "Same as @pred{setval/2}.".
+
+:- if(defined(optim_comp)).
+:- '$context'(b_setval/2, module).
+b_setval(Key, Value) :- '$module'(M), b_set(Key, M, Value).
+:- else.
+:- meta_predicate b_setval(addmodule, +).
+b_setval(Key, M, Value) :- b_set(Key, M, Value).
+:- endif.
+
+:- pred b_getval(Name,Value) # "Same as @pred{getval/2}.".
+
+:- if(defined(optim_comp)).
+:- '$context'(b_getval/2, module).
+b_getval(Key, Value) :- '$module'(M), b_get(Key, M, Value).
+:- else.
+:- meta_predicate b_getval(addmodule, +).
+b_getval(Key, M, Value) :- b_get(Key, M, Value).
+:- endif.
+
+:- pred nb_setval(Name,Value) # "Associate a copy of the term
+   @var{Value} with the atom @var{Name}. The assignment is not undone
+   on backtracking (it replaces any backtrackable value of
+   @var{Name}). If @var{Name} is not a atom the predicate silently
+   fails.".
+
+:- if(defined(optim_comp)).
+:- '$context'(nb_setval/2, module).
+nb_setval(Key, Value) :- '$module'(M), nb_set(Key, M, Value).
+:- else.
+:- meta_predicate nb_setval(addmodule, +).
+nb_setval(Key, M, Value) :- nb_set(Key, M, Value).
 :- endif.
 
-getval_(Key, _Module, _Value):-
-    \+ atom(Key), !, fail.
-getval_(Key, Module, Value):-
-    global(Module, Key, Mutable),
-    get(Mutable, Value).
+:- pred nb_getval(Name,Value) # "Unifies @var{Value} with a copy of
+   the value assigned to the global variable @var{Name} with
+   @pred{nb_setval/2}, or with a free variable if there is no such
+   value. If @var{Name} is not an atom the predicate silently
+   fails.".
+
+:- if(defined(optim_comp)).
+:- '$context'(nb_getval/2, module).
+nb_getval(Key, Value) :- '$module'(M), nb_get(Key, M, Value).
+:- else.
+:- meta_predicate nb_getval(addmodule, +).
+nb_getval(Key, M, Value) :- nb_get(Key, M, Value).
+:- endif.
 
 :- pred current(Name,Value) # "Enumerate all defined variables with
    their value. The order of enumeration is undefined.".
@@ -130,17 +235,6 @@ current(Key, M, Value) :- current_(Key, M, Value).
 :- endif.
 
 current_(Key, Module, Value):-
-    global(Module, Key, Mutable),
-    get(Mutable, Value).
-
-set(Mutable, Value):-
-    ( mutable(Mutable) ->
-        update_mutable(Value, Mutable)
-    ; create_mutable(Value, Mutable)
-    ).
-
-get(Mutable, Value):-
-    ( mutable(Mutable) ->
-        get_mutable(Value, Mutable)
-    ; create_mutable(Value, Mutable)
-    ).
+    '$gvar_keys'(Module, Keys),
+    member(Key, Keys),
+    b_get(Key, Module, Value).
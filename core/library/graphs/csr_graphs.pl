@@ -0,0 +1,259 @@
+:- module(csr_graphs, [], [assertions, regtypes, isomodes, foreign_interface]).
+
+:- doc(title, "Graphs as compact adjacency arrays").
+:- doc(author, "The Ciao Development Team").
+
+:- doc(module, "This module implements directed graphs stored in
+   compressed sparse row (CSR) arrays outside the Prolog heap, and
+   common graph algorithms on them (implemented in C). It is intended
+   for large graphs (e.g., call graphs with millions of edges), where
+   the list-based representations of @lib{ugraphs} and @lib{lgraphs}
+   (and the dynamic facts of @lib{mtarjan}) are too slow.
+
+   Graphs are built in a single pass from a ugraph or lgraph (see
+   @pred{ugraph_to_csr/2} and @pred{lgraph_to_csr/2}) or from lists of
+   vertices and edges (see @pred{edges_to_csr/3}). Vertices can be any
+   term, as in @lib{ugraphs}, and results are given in the same
+   format (e.g., vertex lists in standard order and ugraphs).
+
+   The memory used by a graph is not reclaimed automatically;
+   @pred{csr_free/1} must be called when it is no longer needed.
+   Graphs are referred to by checked handles, so that using a graph
+   after it has been released (or a term which is not a graph) raises
+   an @tt{existence_error(csr_graph, G)} exception. For example:
+
+@begin{verbatim}
+?- edges_to_csr([], [a-b,b-a,b-c], G),
+   csr_sccs(G, SCCs),
+   csr_free(G).
+
+SCCs = [[c],[a,b]] ?
+@end{verbatim}
+").
+
+% ---------------------------------------------------------------------------
+
+:- export(csr_graph/1).
+:- regtype csr_graph/1 # "A graph stored in CSR arrays.".
+% (the handle of the graph and its vertices)
+csr_graph('$csr_graph'(H, Vs)) :- int(H), list(Vs).
+
+% H and Vs are the handle and vertices of G, which must be a live graph
+graph_handle(G, Pred, H, Vs) :-
+    ( G = '$csr_graph'(H, Vs), '$csr_check'(H) -> true
+    ; throw(error(existence_error(csr_graph, G), Pred))
+    ).
+
+:- export(ugraph_to_csr/2).
+:- pred ugraph_to_csr(+UGraph, -G) => csr_graph(G)
+   # "@var{G} is the graph of the ugraph @var{UGraph} (see
+      @lib{ugraphs}).".
+
+ugraph_to_csr(UGraph, G) :-
+    ( '$csr_from_ugraph'(UGraph, 0, H, Vs) -> true
+    ; throw(error(domain_error(ugraph, UGraph), ugraph_to_csr/2))
+    ),
+    G = '$csr_graph'(H, Vs).
+
+:- export(lgraph_to_csr/2).
+:- pred lgraph_to_csr(+LGraph, -G) => csr_graph(G)
+   # "@var{G} is the weighted graph of the lgraph @var{LGraph} (see
+      @lib{lgraphs}), whose labels are the weights (numbers) of the
+      edges.".
+
+lgraph_to_csr(LGraph, G) :-
+    ( '$csr_from_ugraph'(LGraph, 1, H, Vs) -> true
+    ; throw(error(domain_error(lgraph, LGraph), lgraph_to_csr/2))
+    ),
+    G = '$csr_graph'(H, Vs).
+
+:- export(edges_to_csr/3).
+:- pred edges_to_csr(+Vertices, +Edges, -G) : (list(Vertices), list(Edges))
+   => csr_graph(G)
+   # "@var{G} is the graph with the vertices in @var{Vertices} and in
+      @var{Edges}, and the edges @tt{U-V} in @var{Edges} (in any
+      order, possibly repeated).".
+
+edges_to_csr(Vertices, Edges, G) :-
+    ( '$csr_from_edges'(Vertices, Edges, H, Vs) -> true
+    ; throw(error(domain_error(edges, Edges), edges_to_csr/3))
+    ),
+    G = '$csr_graph'(H, Vs).
+
+:- export(csr_free/1).
+:- pred csr_free(+G) : csr_graph(G)
+   # "Release the memory used by @var{G} (which cannot be used
+      afterwards).".
+
+csr_free(G) :-
+    ( G = '$csr_graph'(H, _), '$csr_free'(H) -> true
+    ; throw(error(existence_error(csr_graph, G), csr_free/1))
+    ).
+
+:- export(csr_to_ugraph/2).
+:- pred csr_to_ugraph(+G, -UGraph) : csr_graph(G)
+   # "@var{UGraph} is the ugraph of @var{G} (without weights).".
+
+csr_to_ugraph(G, UGraph) :-
+    graph_handle(G, csr_to_ugraph/2, H, Vs),
+    '$csr_to_ugraph'(H, Vs, UGraph).
+
+:- export(csr_vertices/2).
+:- pred csr_vertices(+G, -Vertices) : csr_graph(G)
+   # "@var{Vertices} are the vertices of @var{G}, in standard order.".
+
+csr_vertices(G, Vs) :-
+    graph_handle(G, csr_vertices/2, _, Vs).
+
+:- export(csr_num_vertices/2).
+:- pred csr_num_vertices(+G, -N) : csr_graph(G) => int(N)
+   # "@var{N} is the number of vertices of @var{G}.".
+
+csr_num_vertices(G, N) :-
+    graph_handle(G, csr_num_vertices/2, H, _),
+    '$csr_info'(H, N, _, _).
+
+:- export(csr_num_edges/2).
+:- pred csr_num_edges(+G, -N) : csr_graph(G) => int(N)
+   # "@var{N} is the number of edges of @var{G}.".
+
+csr_num_edges(G, N) :-
+    graph_handle(G, csr_num_edges/2, H, _),
+    '$csr_info'(H, _, N, _).
+
+:- export(csr_neighbors/3).
+:- pred csr_neighbors(+G, +V, -Neighbors) : csr_graph(G)
+   # "@var{Neighbors} are the neighbors of vertex @var{V} in @var{G}
+      (fails if @var{V} is not a vertex).".
+
+csr_neighbors(G, V, Neighbors) :-
+    graph_handle(G, csr_neighbors/3, H, Vs),
+    '$csr_neighbors'(H, Vs, V, Neighbors).
+
+:- export(csr_transpose/2).
+:- pred csr_transpose(+G, -T) : csr_graph(G) => csr_graph(T)
+   # "@var{T} is a new graph with an edge @tt{V-U} (with the same
+      weight) for each edge @tt{U-V} of @var{G}.".
+
+csr_transpose(G, T) :-
+    graph_handle(G, csr_transpose/2, H, Vs),
+    '$csr_transpose'(H, HT),
+    T = '$csr_graph'(HT, Vs).
+
+% ---------------------------------------------------------------------------
+
+:- export(csr_sccs/2).
+:- pred csr_sccs(+G, -SCCs) : csr_graph(G) => list(list, SCCs)
+   # "@var{SCCs} is the list of strongly connected components of
+      @var{G} (Tarjan's algorithm, as @pred{find_sccs/3} in
+      @lib{mtarjan}). Each component comes after all the components
+      reachable from it.".
+
+csr_sccs(G, SCCs) :-
+    graph_handle(G, csr_sccs/2, H, Vs),
+    '$csr_sccs'(H, Vs, SCCs).
+
+:- export(csr_top_sort/2).
+:- pred csr_top_sort(+G, -Sorted) : csr_graph(G) => list(Sorted)
+   # "@var{Sorted} is a list of the vertices of @var{G} where each
+      vertex comes before its neighbors. Fails if @var{G} has
+      cycles.".
+
+csr_top_sort(G, Sorted) :-
+    graph_handle(G, csr_top_sort/2, H, Vs),
+    '$csr_top_sort'(H, Vs, Sorted).
+
+:- export(csr_reachable/3).
+:- pred csr_reachable(+G, +Sources, -Reachable) : (csr_graph(G), list(Sources))
+   => list(Reachable)
+   # "@var{Reachable} are the vertices reachable from the vertices in
+      @var{Sources} (including them), in standard order. Terms in
+      @var{Sources} which are not vertices are ignored.".
+
+csr_reachable(G, Sources, Reachable) :-
+    graph_handle(G, csr_reachable/3, H, Vs),
+    '$csr_traverse'(H, Vs, 2, Sources, Reachable).
+
+:- export(csr_bfs/3).
+:- pred csr_bfs(+G, +Sources, -Visited) : (csr_graph(G), list(Sources))
+   => list(Visited)
+   # "Like @pred{csr_reachable/3}, but @var{Visited} is in
+      breadth-first order.".
+
+csr_bfs(G, Sources, Visited) :-
+    graph_handle(G, csr_bfs/3, H, Vs),
+    '$csr_traverse'(H, Vs, 0, Sources, Visited).
+
+:- export(csr_dfs/3).
+:- pred csr_dfs(+G, +Sources, -Visited) : (csr_graph(G), list(Sources))
+   => list(Visited)
+   # "Like @pred{csr_reachable/3}, but @var{Visited} is in depth-first
+      order (preorder).".
+
+csr_dfs(G, Sources, Visited) :-
+    graph_handle(G, csr_dfs/3, H, Vs),
+    '$csr_traverse'(H, Vs, 1, Sources, Visited).
+
+:- export(csr_transitive_closure/2).
+:- pred csr_transitive_closure(+G, -Closure) : csr_graph(G)
+   # "@var{Closure} is the ugraph with an edge @tt{U-V} for each path
+      (of one or more edges) from @tt{U} to @tt{V} in @var{G}. It is
+      computed with a bit set of reachable vertices for each strongly
+      connected component (i.e., memory quadratic in the number of
+      vertices).".
+
+csr_transitive_closure(G, Closure) :-
+    graph_handle(G, csr_transitive_closure/2, H, Vs),
+    '$csr_transitive_closure'(H, Vs, Closure).
+
+:- export(csr_dijkstra/3).
+:- pred csr_dijkstra(+G, +Source, -Dists) : csr_graph(G)
+   # "@var{Dists} is the list of pairs @tt{V-D} (in standard order of
+      @tt{V}) for each vertex @tt{V} reachable from @var{Source}, where
+      @tt{D} is the length of the shortest path (the sum of the
+      weights of its edges, or number of edges if @var{G} is not
+      weighted). Weights must not be negative. Fails if @var{Source}
+      is not a vertex.".
+
+csr_dijkstra(G, Source, Dists) :-
+    graph_handle(G, csr_dijkstra/3, H, Vs),
+    '$csr_info'(H, _, _, MinWeight),
+    ( MinWeight < 0 ->
+        throw(error(domain_error(non_negative_weights, G), csr_dijkstra/3))
+    ; true
+    ),
+    '$csr_dijkstra'(H, Vs, Source, Dists).
+
+% ---------------------------------------------------------------------------
+
+:- trust pred '$csr_init' + foreign_low(prolog_csr_init).
+:- initialization('$csr_init').
+
+:- trust pred '$csr_from_ugraph'(+UGraph, +Weighted, -H, -Vs)
+   :: term * int * int * list + foreign_low(prolog_csr_from_ugraph).
+:- trust pred '$csr_from_edges'(+Vertices, +Edges, -H, -Vs)
+   :: list * list * int * list + foreign_low(prolog_csr_from_edges).
+:- trust pred '$csr_free'(+H)
+   :: int + foreign_low(prolog_csr_free).
+:- trust pred '$csr_check'(+H)
+   :: int + foreign_low(prolog_csr_check).
+:- trust pred '$csr_info'(+H, -NV, -NE, -MinWeight)
+   :: int * int * int * num + foreign_low(prolog_csr_info).
+:- trust pred '$csr_transpose'(+H, -HT)
+   :: int * int + foreign_low(prolog_csr_transpose).
+:- trust pred '$csr_to_ugraph'(+H, +Vs, -UGraph)
+   :: int * list * list + foreign_low(prolog_csr_to_ugraph).
+:- trust pred '$csr_neighbors'(+H, +Vs, +V, -Neighbors)
+   :: int * list * term * list + foreign_low(prolog_csr_neighbors).
+:- trust pred '$csr_sccs'(+H, +Vs, -SCCs)
+   :: int * list * list + foreign_low(prolog_csr_sccs).
+:- trust pred '$csr_top_sort'(+H, +Vs, -Sorted)
+   :: int * list * list + foreign_low(prolog_csr_top_sort).
+:- trust pred '$csr_traverse'(+H, +Vs, +Mode, +Sources, -Visited)
+   :: int * list * int * list * list + foreign_low(prolog_csr_traverse).
+:- trust pred '$csr_transitive_closure'(+H, +Vs, -Closure)
+   :: int * list * list + foreign_low(prolog_csr_transitive_closure).
+:- trust pred '$csr_dijkstra'(+H, +Vs, +Source, -Dists)
+   :: int * list * term * list + foreign_low(prolog_csr_dijkstra).
+
+:- use_foreign_source(csr_graphs_c).
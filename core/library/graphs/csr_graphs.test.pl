@@ -0,0 +1,174 @@
+:- module(_, [], [assertions, hiord]).
+
+:- doc(title, "Tests for csr_graphs.pl").
+
+:- use_module(library(graphs/csr_graphs)).
+:- use_module(library(graphs/ugraphs), [vertices_edges_to_ugraph/3, transpose/2]).
+:- use_module(library(mtarjan), [find_sccs/3]).
+:- use_module(library(lists), [member/2, nth/3, length/2]).
+:- use_module(library(aggregates), [findall/3]).
+:- use_module(library(sort), [sort/2]).
+:- use_module(library(random), [random/3, srandom/1]).
+
+% ---------------------------------------------------------------------------
+% Pseudo-random graphs (with a fixed seed, so that tests are
+% reproducible)
+
+random_edges(0, _, []) :- !.
+random_edges(M, Max, [U-V|Es]) :-
+    random(0, Max, U),
+    random(0, Max, V),
+    M1 is M - 1,
+    random_edges(M1, Max, Es).
+
+numlist(N, N, [N]) :- !.
+numlist(I, N, [I|Is]) :- I1 is I + 1, numlist(I1, N, Is).
+
+graph(NV, NE, Seed, Vs, Es) :-
+    N1 is NV - 1,
+    numlist(0, N1, Vs),
+    srandom(Seed),
+    random_edges(NE, N1, Es).
+
+% ---------------------------------------------------------------------------
+
+:- export(test_to_ugraph/0).
+:- test test_to_ugraph # "csr_to_ugraph/2 and csr_transpose/2 agree with ugraphs".
+test_to_ugraph :-
+    graph(200, 600, 7, Vs, Es),
+    vertices_edges_to_ugraph(Vs, Es, UG),
+    transpose(UG, UGT),
+    edges_to_csr(Vs, Es, G),
+    csr_to_ugraph(G, UG2),
+    csr_transpose(G, T),
+    csr_to_ugraph(T, UGT2),
+    csr_free(T),
+    csr_free(G),
+    UG2 == UG,
+    UGT2 == UGT.
+
+:- export(test_non_atomic_vertices/0).
+:- test test_non_atomic_vertices # "Vertices which are not atoms nor small integers".
+test_non_atomic_vertices :-
+    ugraph_to_csr([f(a)-[f(b),"x"], f(b)-[], "x"-[f(a)]], G),
+    csr_neighbors(G, f(a), N1),
+    csr_neighbors(G, "x", N2),
+    ( csr_neighbors(G, f(c), _) -> fail ; true ),
+    csr_sccs(G, SCCs),
+    csr_free(G),
+    N1 == [f(b), "x"],
+    N2 == [f(a)],
+    SCCs == [[f(b)], ["x", f(a)]].
+
+:- export(test_sccs/0).
+:- test test_sccs # "csr_sccs/2 gives the components of mtarjan:find_sccs/3".
+test_sccs :-
+    graph(300, 450, 11, Vs, Es),
+    vertices_edges_to_ugraph(Vs, Es, UG),
+    find_sccs(ug_vertex(UG), ug_edge(UG), SCCs0),
+    edges_to_csr(Vs, Es, G),
+    csr_sccs(G, SCCs),
+    csr_free(G),
+    normalize_sccs(SCCs0, N0),
+    normalize_sccs(SCCs, N),
+    N == N0,
+    reverse_topological(SCCs, UG).
+
+ug_vertex(UG, V) :- member(V-_, UG).
+ug_edge(UG, U, V) :- member(U-Ns, UG), !, member(V, Ns).
+
+normalize_sccs(SCCs, N) :-
+    findall(S, (member(C, SCCs), sort(C, S)), Ss),
+    sort(Ss, N).
+
+% Each component comes after the components reachable from it
+reverse_topological(SCCs, UG) :-
+    \+ ( nth(I, SCCs, C), member(U, C),
+         member(U-Ns, UG), member(V, Ns),
+         nth(J, SCCs, D), member(V, D),
+         J > I ).
+
+:- export(test_top_sort/0).
+:- test test_top_sort # "csr_top_sort/2 on acyclic and cyclic graphs".
+test_top_sort :-
+    graph(150, 400, 3, Vs, Es0),
+    findall(U-V, (member(U-V, Es0), U < V), Es), % (acyclic)
+    edges_to_csr(Vs, Es, G),
+    csr_top_sort(G, Sorted),
+    csr_free(G),
+    sort(Sorted, Vs),
+    length(Sorted, 150),
+    \+ ( member(U-V, Es), nth(I, Sorted, U), nth(J, Sorted, V), J < I ),
+    edges_to_csr([], [a-b, b-c, c-a], G2),
+    ( csr_top_sort(G2, _) -> Cyclic = no ; Cyclic = yes ),
+    csr_free(G2),
+    Cyclic == yes.
+
+:- export(test_dijkstra/0).
+:- test test_dijkstra # "csr_dijkstra/3 agrees with Bellman-Ford".
+test_dijkstra :-
+    graph(80, 300, 5, Vs, Es),
+    findall(U-V-W, (member(U-V, Es), W is (U * 7 + V * 3) mod 10), WEs),
+    findall(U-Ns, (member(U, Vs), findall(V-W, member(U-V-W, WEs), Ns0), sort(Ns0, Ns)), LG),
+    lgraph_to_csr(LG, G),
+    csr_dijkstra(G, 0, Dists),
+    csr_free(G),
+    bellman_ford(Vs, WEs, 0, Dists0),
+    Dists == Dists0.
+
+% Distances from S (relax all edges until there are no changes)
+bellman_ford(Vs, Es, S, Dists) :-
+    findall(V-D, (member(V, Vs), ( V == S -> D = 0 ; D = inf )), D0),
+    relax_all(D0, Es, Dists0),
+    findall(V-D, (member(V-D, Dists0), D \== inf), Dists).
+
+relax_all(D0, Es, D) :-
+    relax(Es, D0, D1),
+    ( D1 == D0 -> D = D0 ; relax_all(D1, Es, D) ).
+
+relax([], D, D).
+relax([U-V-W|Es], D0, D) :-
+    member(U-DU, D0),
+    ( DU \== inf,
+      member(V-DV, D0),
+      DN is DU + W,
+      ( DV == inf -> true ; DN < DV ) ->
+        set_dist(D0, V, DN, D1)
+    ; D1 = D0
+    ),
+    relax(Es, D1, D).
+
+set_dist([], _, _, []).
+set_dist([V-_|Ds], V, D, [V-D|Ds]) :- !.
+set_dist([X|Ds], V, D, [X|Ds2]) :- set_dist(Ds, V, D, Ds2).
+
+:- export(test_traverse/0).
+:- test test_traverse # "Reachability and closure".
+test_traverse :-
+    edges_to_csr([e], [a-b, b-c, c-b, d-a], G),
+    csr_reachable(G, [b, x], R),
+    csr_bfs(G, [d], B),
+    csr_dfs(G, [d], D),
+    csr_transitive_closure(G, C),
+    csr_free(G),
+    R == [b, c],
+    B == [d, a, b, c],
+    D == [d, a, b, c],
+    C == [a-[b,c], b-[b,c], c-[b,c], d-[a,b,c], e-[]].
+
+:- export(test_stale_handle/0).
+:- test test_stale_handle # "Released and forged graphs raise an error".
+test_stale_handle :-
+    edges_to_csr([], [a-b], G),
+    csr_free(G),
+    throws(csr_sccs(G, _), error(existence_error(csr_graph, G), csr_sccs/2)),
+    throws(csr_free(G), error(existence_error(csr_graph, G), csr_free/1)),
+    G = '$csr_graph'(H, Vs),
+    H1 is H + 1,
+    F = '$csr_graph'(H1, Vs),
+    throws(csr_neighbors(F, a, _), error(existence_error(csr_graph, F), csr_neighbors/3)),
+    throws(csr_vertices(foo, _), error(existence_error(csr_graph, foo), csr_vertices/2)).
+
+throws(Goal, Error) :-
+    catch((call(Goal) -> R = succeeded ; R = failed), E, R = E),
+    R = Error.
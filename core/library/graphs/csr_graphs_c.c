@@ -0,0 +1,1107 @@
+/*
+ *  csr_graphs_c.c
+ *
+ *  Graphs as compressed sparse row arrays (see csr_graphs.pl).
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <ciao/eng.h>
+#include <ciao/eng_gc.h>
+
+CFUN__PROTO(fu2_compare, tagged_t, tagged_t x1, tagged_t x2); /* term_compare.c */
+
+/* Vertices are numbered 0..nv-1 in the standard order of their terms
+   (which are kept in a Prolog list, see csr_graphs.pl). The neighbors
+   of vertex v are adj[off[v]..off[v+1]), in increasing order. */
+
+typedef uint32_t csr_vertex_t;
+
+typedef struct csr_graph_ csr_graph_t;
+struct csr_graph_ {
+  intmach_t nv, ne;
+  intmach_t *off; /* (nv+1 entries) */
+  csr_vertex_t *adj; /* (ne entries) */
+  double *weight; /* (ne entries, or NULL if not weighted) */
+  bool_t int_weights; /* (all weights are integers) */
+  double min_weight;
+  intmach_t max_degree;
+  tagged_t *words; /* (vertex terms if all of them are atoms or small
+                      integers, which do not move on GC, or NULL) */
+};
+
+/* (arrays are never empty) */
+#define SIZE1(N) ((N) > 0 ? (N) : 1)
+
+#define IsWordTerm(X) (TaggedIsATM(X) || TaggedIsSmall(X))
+
+static csr_graph_t *csr_new(intmach_t nv, intmach_t ne, bool_t weighted) {
+  csr_graph_t *g = checkalloc_TYPE(csr_graph_t);
+  g->nv = nv;
+  g->ne = ne;
+  g->off = checkalloc_ARRAY(intmach_t, nv + 1);
+  g->adj = checkalloc_ARRAY(csr_vertex_t, SIZE1(ne));
+  g->weight = weighted ? checkalloc_ARRAY(double, SIZE1(ne)) : NULL;
+  g->int_weights = TRUE;
+  g->min_weight = 1;
+  g->max_degree = 0;
+  g->words = NULL;
+  return g;
+}
+
+static void csr_free(csr_graph_t *g) {
+  checkdealloc_ARRAY(intmach_t, g->nv + 1, g->off);
+  checkdealloc_ARRAY(csr_vertex_t, SIZE1(g->ne), g->adj);
+  if (g->weight != NULL) checkdealloc_ARRAY(double, SIZE1(g->ne), g->weight);
+  if (g->words != NULL) checkdealloc_ARRAY(tagged_t, SIZE1(g->nv), g->words);
+  checkdealloc_TYPE(csr_graph_t, g);
+}
+
+/* Set the fields computed from the adjacency arrays and the vertex
+   terms vt (sorted) */
+static void csr_complete(csr_graph_t *g, tagged_t *vt) {
+  intmach_t v, d;
+  g->max_degree = 0;
+  for (v = 0; v < g->nv; v++) {
+    d = g->off[v+1] - g->off[v];
+    if (d > g->max_degree) g->max_degree = d;
+  }
+  for (v = 0; v < g->nv; v++) {
+    if (!IsWordTerm(vt[v])) return;
+  }
+  g->words = checkalloc_ARRAY(tagged_t, SIZE1(g->nv));
+  memcpy(g->words, vt, g->nv * sizeof(tagged_t));
+}
+
+/* Like csr_complete, for the transpose gt of g */
+static void csr_complete_transpose(csr_graph_t *gt, csr_graph_t *g) {
+  intmach_t v, d;
+  gt->max_degree = 0;
+  for (v = 0; v < gt->nv; v++) {
+    d = gt->off[v+1] - gt->off[v];
+    if (d > gt->max_degree) gt->max_degree = d;
+  }
+  if (g->words != NULL) {
+    gt->words = checkalloc_ARRAY(tagged_t, SIZE1(g->nv));
+    memcpy(gt->words, g->words, g->nv * sizeof(tagged_t));
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Handles */
+
+/* Graphs are referred from Prolog by integer handles, which are
+   checked on each use (so that a stale or forged handle is detected
+   instead of crashing). A handle is the slot of the graph in the
+   table of graphs and a serial number that tells apart the graphs
+   which used the same slot. */
+
+#define CSR_SLOT_BITS 20
+#define CSR_MAX_SLOTS ((intmach_t)1 << CSR_SLOT_BITS)
+#define CSR_SERIAL_MASK ((uintmach_t)SmiValMax >> CSR_SLOT_BITS)
+
+typedef struct csr_slot_ csr_slot_t;
+struct csr_slot_ {
+  csr_graph_t *g; /* (NULL if the slot is free) */
+  uintmach_t serial;
+};
+
+static SLOCK csr_table_l;
+static csr_slot_t *csr_table = NULL;
+static intmach_t csr_table_size = 0;
+static intmach_t csr_table_used = 0; /* (slots ever used) */
+static intmach_t *csr_free_slots = NULL; /* (csr_table_size entries) */
+static intmach_t csr_free_count = 0;
+static uintmach_t csr_serial = 0;
+
+/* '$csr_init' */
+CBOOL__PROTO(prolog_csr_init) {
+  Init_slock(csr_table_l);
+  CBOOL__PROCEED;
+}
+
+/* Register g, returning its handle (or -1 if there are too many
+   graphs) */
+static intmach_t csr_register(csr_graph_t *g) {
+  intmach_t slot, size;
+
+  Wait_Acquire_slock(csr_table_l);
+  if (csr_free_count > 0) {
+    slot = csr_free_slots[--csr_free_count];
+  } else {
+    if (csr_table_used == csr_table_size) {
+      if (csr_table_size == CSR_MAX_SLOTS) {
+        Release_slock(csr_table_l);
+        return -1;
+      }
+      size = csr_table_size == 0 ? 64 : csr_table_size * 2;
+      if (csr_table == NULL) {
+        csr_table = checkalloc_ARRAY(csr_slot_t, size);
+        csr_free_slots = checkalloc_ARRAY(intmach_t, size);
+      } else {
+        csr_table = checkrealloc_ARRAY(csr_slot_t, csr_table_size, size, csr_table);
+        csr_free_slots = checkrealloc_ARRAY(intmach_t, csr_table_size, size, csr_free_slots);
+      }
+      csr_table_size = size;
+    }
+    slot = csr_table_used++;
+  }
+  csr_serial = (csr_serial + 1) & CSR_SERIAL_MASK;
+  if (csr_serial == 0) csr_serial = 1;
+  csr_table[slot].g = g;
+  csr_table[slot].serial = csr_serial;
+  Release_slock(csr_table_l);
+  return (intmach_t)((csr_serial << CSR_SLOT_BITS) | slot);
+}
+
+/* Graph of handle t, or NULL if t is not the handle of a live graph
+   (if remove is TRUE, the graph is also removed from the table) */
+static csr_graph_t *csr_lookup(tagged_t t, bool_t remove) {
+  intmach_t h, slot;
+  csr_graph_t *g = NULL;
+
+  DEREF(t, t);
+  if (!TaggedIsSmall(t)) return NULL;
+  h = GetSmall(t);
+  if (h <= 0) return NULL;
+  slot = h & (CSR_MAX_SLOTS - 1);
+  Wait_Acquire_slock(csr_table_l);
+  if (slot < csr_table_used &&
+      csr_table[slot].g != NULL &&
+      csr_table[slot].serial == ((uintmach_t)h >> CSR_SLOT_BITS)) {
+    g = csr_table[slot].g;
+    if (remove) {
+      csr_table[slot].g = NULL;
+      csr_free_slots[csr_free_count++] = slot;
+    }
+  }
+  Release_slock(csr_table_l);
+  return g;
+}
+
+/* Graph of handle T (fail if it is not valid; the error is raised
+   from csr_graphs.pl) */
+#define CSR_GRAPH(G, T) { \
+  (G) = csr_lookup((T), FALSE); \
+  if ((G) == NULL) CBOOL__FAIL; \
+}
+
+/* Register the new graph G and unify its handle with T */
+#define CSR_UNIFY_NEW(G, T) { \
+  intmach_t h_ = csr_register((G)); \
+  if (h_ < 0) { \
+    csr_free((G)); \
+    SERIOUS_FAULT("csr_graphs: too many graphs"); \
+  } \
+  CBOOL__UNIFY(MakeSmall(h_), (T)); \
+}
+
+/* Edge weight (1 in graphs without weights) */
+#define WEIGHT(g, e) ((g)->weight != NULL ? (g)->weight[e] : 1.0)
+
+/* --------------------------------------------------------------------------- */
+/* Vertex terms */
+
+static CFUN__PROTO(term_cmp, int, tagged_t x, tagged_t y) {
+  tagged_t r;
+  if (x == y) return 0;
+  if (TaggedIsSmall(x) && TaggedIsSmall(y)) {
+    return ((stagged_t)x < (stagged_t)y ? -1 : 1);
+  }
+  r = CFUN__EVAL(fu2_compare, x, y);
+  return (r == atom_lessthan ? -1 : r == atom_equal ? 0 : 1);
+}
+
+static intmach_t list_length(tagged_t t) {
+  intmach_t n = 0;
+  DEREF(t, t);
+  while (TaggedIsLST(t)) { DerefCdr(t, t); n++; }
+  return (t == atom_nil ? n : -1);
+}
+
+/* Store the (dereferenced) first n elements of list t in vt */
+static void load_terms(tagged_t t, tagged_t *vt, intmach_t n) {
+  intmach_t i;
+  DEREF(t, t);
+  for (i = 0; i < n; i++) {
+    DerefCar(vt[i], t);
+    DerefCdr(t, t);
+  }
+}
+
+/* Index of vertex x in vt (sorted), or -1 */
+static CFUN__PROTO(find_vertex, intmach_t, tagged_t *vt, intmach_t nv,
+                   tagged_t x) {
+  intmach_t lo = 0, hi = nv - 1, mid;
+  int c;
+  DEREF(x, x);
+  while (lo <= hi) {
+    mid = lo + (hi - lo) / 2;
+    c = CFUN__EVAL(term_cmp, vt[mid], x);
+    if (c == 0) return mid;
+    if (c < 0) lo = mid + 1; else hi = mid - 1;
+  }
+  return -1;
+}
+
+/* Sort (and remove duplicates of) the terms in vt, returning the new
+   length (merge sort) */
+static CFUN__PROTO(sort_terms, intmach_t, tagged_t *vt, intmach_t n) {
+  tagged_t *tmp, *a, *b, *swap;
+  intmach_t width, i, j, k, lo, mid, hi;
+
+  tmp = checkalloc_ARRAY(tagged_t, SIZE1(n));
+  a = vt;
+  b = tmp;
+  for (width = 1; width < n; width *= 2) {
+    for (lo = 0; lo < n; lo += 2*width) {
+      mid = (lo + width < n ? lo + width : n);
+      hi = (lo + 2*width < n ? lo + 2*width : n);
+      i = lo; j = mid; k = lo;
+      while (i < mid && j < hi) {
+        if (CFUN__EVAL(term_cmp, a[j], a[i]) < 0) b[k++] = a[j++];
+        else b[k++] = a[i++];
+      }
+      while (i < mid) b[k++] = a[i++];
+      while (j < hi) b[k++] = a[j++];
+    }
+    swap = a; a = b; b = swap;
+  }
+  if (a != vt) memcpy(vt, a, n * sizeof(tagged_t));
+  checkdealloc_ARRAY(tagged_t, SIZE1(n), tmp);
+  /* Remove duplicates */
+  for (i = 0, j = 0; i < n; i++) {
+    if (j == 0 || CFUN__EVAL(term_cmp, vt[j-1], vt[i]) != 0) vt[j++] = vt[i];
+  }
+  CFUN__PROCEED(j);
+}
+
+static CBOOL__PROTO(is_sorted, tagged_t *vt, intmach_t n) {
+  intmach_t i;
+  for (i = 1; i < n; i++) {
+    if (CFUN__EVAL(term_cmp, vt[i-1], vt[i]) >= 0) CBOOL__FAIL;
+  }
+  CBOOL__PROCEED;
+}
+
+static CFUN__PROTO(make_vertex_list, tagged_t, tagged_t *vt, intmach_t nv) {
+  tagged_t list = atom_nil;
+  intmach_t i;
+  for (i = nv; i-- > 0; ) {
+    MakeLST(list, vt[i], list);
+  }
+  CFUN__PROCEED(list);
+}
+
+/* Vertices which are atoms or small integers (the common case, see
+   IsWordTerm) are equal iff their tagged words are, so they are
+   looked up in a hash table instead of comparing terms */
+
+typedef struct ventry_ ventry_t;
+struct ventry_ {
+  tagged_t key; /* (0 for empty entries) */
+  intmach_t value;
+};
+
+typedef struct vtable_ vtable_t;
+struct vtable_ {
+  uintmach_t mask;
+  intmach_t count;
+  ventry_t *entry;
+};
+
+static void vtable_init(vtable_t *tab, intmach_t size) {
+  tab->mask = size - 1;
+  tab->count = 0;
+  tab->entry = checkalloc_ARRAY(ventry_t, size);
+  memset(tab->entry, 0, size * sizeof(ventry_t));
+}
+
+static void vtable_free(vtable_t *tab) {
+  checkdealloc_ARRAY(ventry_t, tab->mask + 1, tab->entry);
+}
+
+/* Entry for key x (Fibonacci hashing, linear probing) */
+static ventry_t *vtable_get(vtable_t *tab, tagged_t x) {
+  uintmach_t i = (uintmach_t)(((uint64_t)x * 0x9E3779B97F4A7C15ULL) >> 40);
+  ventry_t *p;
+  for (;;) {
+    p = &tab->entry[i & tab->mask];
+    if (p->key == x || p->key == 0) return p;
+    i++;
+  }
+}
+
+/* Insert key x, return FALSE if it was already there */
+static bool_t vtable_insert(vtable_t *tab, tagged_t x) {
+  vtable_t old;
+  ventry_t *p;
+  intmach_t i;
+  p = vtable_get(tab, x);
+  if (p->key != 0) return FALSE;
+  p->key = x;
+  if (++tab->count * 2 > (intmach_t)tab->mask) { /* (grow) */
+    old = *tab;
+    vtable_init(tab, 2 * (old.mask + 1));
+    tab->count = old.count;
+    for (i = 0; i <= (intmach_t)old.mask; i++) {
+      if (old.entry[i].key != 0) vtable_get(tab, old.entry[i].key)->key = old.entry[i].key;
+    }
+    vtable_free(&old);
+  }
+  return TRUE;
+}
+
+/* Index of vertex x (dereferenced) in vt (sorted), or -1 */
+static CFUN__PROTO(lookup_vertex, intmach_t, vtable_t *tab, tagged_t *vt,
+                   intmach_t nv, tagged_t x) {
+  ventry_t *p;
+  if (IsWordTerm(x)) {
+    p = vtable_get(tab, x);
+    CFUN__PROCEED(p->key == 0 ? -1 : p->value);
+  }
+  CFUN__PROCEED(CFUN__EVAL(find_vertex, vt, nv, x));
+}
+
+/* --------------------------------------------------------------------------- */
+/* Construction */
+
+static int cmp_vertex(const void *a, const void *b) {
+  csr_vertex_t x = *(const csr_vertex_t *)a;
+  csr_vertex_t y = *(const csr_vertex_t *)b;
+  return (x < y ? -1 : x > y ? 1 : 0);
+}
+
+/* '$csr_from_ugraph'(+UGraph, +Weighted, -H, -Vertices): build the
+   graph from a ugraph (lgraph with numeric labels if Weighted is 1).
+   Fails if UGraph is not a valid graph. */
+CBOOL__PROTO(prolog_csr_from_ugraph) {
+  csr_graph_t *g;
+  tagged_t t, p, ns, n, x;
+  tagged_t *vt;
+  intmach_t nv, ne, i, j, e, k, d;
+  bool_t weighted;
+
+  DEREF(X(1), X(1));
+  weighted = (X(1) == MakeSmall(1));
+  /* Count vertices and edges */
+  nv = 0;
+  ne = 0;
+  DEREF(t, X(0));
+  while (TaggedIsLST(t)) {
+    DerefCar(p, t);
+    if (!TaggedIsSTR(p) || TaggedToHeadfunctor(p) != functor_minus) CBOOL__FAIL;
+    DerefArg(ns, p, 2);
+    d = list_length(ns);
+    if (d < 0) CBOOL__FAIL;
+    ne += d;
+    nv++;
+    DerefCdr(t, t);
+  }
+  if (t != atom_nil) CBOOL__FAIL;
+  if (nv > (intmach_t)UINT32_MAX) CBOOL__FAIL;
+  /* (no GC happens below, so that the terms in vt stay valid) */
+  TEST_HEAP_OVERFLOW(G->heap_top, nv*LSTCELLS*sizeof(tagged_t)+CONTPAD, 4);
+
+  vt = checkalloc_ARRAY(tagged_t, SIZE1(nv));
+  DEREF(t, X(0));
+  for (i = 0; i < nv; i++) {
+    DerefCar(p, t);
+    DerefArg(vt[i], p, 1);
+    DerefCdr(t, t);
+  }
+  g = csr_new(nv, ne, weighted);
+  if (!CBOOL__SUCCEED(is_sorted, vt, nv)) goto fail;
+  DEREF(t, X(0));
+  e = 0;
+  for (i = 0; i < nv; i++) {
+    g->off[i] = e;
+    DerefCar(p, t);
+    DerefArg(ns, p, 2);
+    while (TaggedIsLST(ns)) {
+      DerefCar(n, ns);
+      if (weighted) {
+        if (!TaggedIsSTR(n) || TaggedToHeadfunctor(n) != functor_minus) goto fail;
+        DerefArg(x, n, 2);
+        if (!IsNumber(x)) goto fail;
+        if (!TaggedIsSmall(x)) g->int_weights = FALSE;
+        g->weight[e] = TaggedToFloat(x);
+        if (e == 0 || g->weight[e] < g->min_weight) g->min_weight = g->weight[e];
+        DerefArg(n, n, 1);
+      }
+      /* (neighbors are sorted, look first after the previous one) */
+      k = -1;
+      if (e > g->off[i]) {
+        j = g->adj[e-1] + 1;
+        if (j < nv && CFUN__EVAL(term_cmp, vt[j], n) == 0) k = j;
+      }
+      if (k < 0) k = CFUN__EVAL(find_vertex, vt, nv, n);
+      if (k < 0) goto fail;
+      g->adj[e++] = k;
+      DerefCdr(ns, ns);
+    }
+    DerefCdr(t, t);
+  }
+  g->off[nv] = e;
+  csr_complete(g, vt);
+  t = CFUN__EVAL(make_vertex_list, vt, nv);
+  checkdealloc_ARRAY(tagged_t, SIZE1(nv), vt);
+  CSR_UNIFY_NEW(g, X(2));
+  CBOOL__LASTUNIFY(t, X(3));
+ fail:
+  csr_free(g);
+  checkdealloc_ARRAY(tagged_t, SIZE1(nv), vt);
+  CBOOL__FAIL;
+}
+
+/* '$csr_from_edges'(+Vertices, +Edges, -H, -AllVertices): build the
+   graph from a list of vertices and a list of edges U-V */
+CBOOL__PROTO(prolog_csr_from_edges) {
+  csr_graph_t *g;
+  tagged_t t, p, u, v;
+  tagged_t *vt;
+  csr_vertex_t *src, *dst;
+  vtable_t tab;
+  intmach_t n0, ne, nt, nv, i, j, e, k;
+
+  n0 = list_length(X(0));
+  ne = list_length(X(1));
+  if (n0 < 0 || ne < 0) CBOOL__FAIL;
+  nt = n0 + 2*ne;
+  /* (no GC happens below, so that the terms in vt stay valid) */
+  TEST_HEAP_OVERFLOW(G->heap_top, nt*LSTCELLS*sizeof(tagged_t)+CONTPAD, 4);
+
+  /* Collect and sort all the vertices (removing first the repeated
+     ones which are in the table) */
+  vt = checkalloc_ARRAY(tagged_t, SIZE1(nt));
+  load_terms(X(0), vt, n0);
+  DEREF(t, X(1));
+  for (i = 0; i < ne; i++) {
+    DerefCar(p, t);
+    if (!TaggedIsSTR(p) || TaggedToHeadfunctor(p) != functor_minus) {
+      checkdealloc_ARRAY(tagged_t, SIZE1(nt), vt);
+      CBOOL__FAIL;
+    }
+    DerefArg(vt[n0 + 2*i], p, 1);
+    DerefArg(vt[n0 + 2*i + 1], p, 2);
+    DerefCdr(t, t);
+  }
+  vtable_init(&tab, 1024);
+  for (i = 0, j = 0; i < nt; i++) {
+    if (IsWordTerm(vt[i]) && !vtable_insert(&tab, vt[i])) continue;
+    vt[j++] = vt[i];
+  }
+  nv = CFUN__EVAL(sort_terms, vt, j);
+  if (nv > (intmach_t)UINT32_MAX) {
+    vtable_free(&tab);
+    checkdealloc_ARRAY(tagged_t, SIZE1(nt), vt);
+    CBOOL__FAIL;
+  }
+  for (i = 0; i < nv; i++) {
+    if (IsWordTerm(vt[i])) vtable_get(&tab, vt[i])->value = i;
+  }
+
+  /* Map the edges and group them by source (counting sort) */
+  src = checkalloc_ARRAY(csr_vertex_t, SIZE1(ne));
+  dst = checkalloc_ARRAY(csr_vertex_t, SIZE1(ne));
+  g = csr_new(nv, ne, FALSE);
+  memset(g->off, 0, (nv + 1) * sizeof(intmach_t));
+  DEREF(t, X(1));
+  for (i = 0; i < ne; i++) {
+    DerefCar(p, t);
+    DerefArg(u, p, 1);
+    DerefArg(v, p, 2);
+    src[i] = CFUN__EVAL(lookup_vertex, &tab, vt, nv, u);
+    dst[i] = CFUN__EVAL(lookup_vertex, &tab, vt, nv, v);
+    g->off[src[i] + 1]++;
+    DerefCdr(t, t);
+  }
+  vtable_free(&tab);
+  for (i = 0; i < nv; i++) g->off[i+1] += g->off[i];
+  for (i = 0; i < ne; i++) g->adj[g->off[src[i]]++] = dst[i];
+  for (i = nv; i > 0; i--) g->off[i] = g->off[i-1];
+  g->off[0] = 0;
+  checkdealloc_ARRAY(csr_vertex_t, SIZE1(ne), src);
+  checkdealloc_ARRAY(csr_vertex_t, SIZE1(ne), dst);
+
+  /* Sort the neighbors and remove repeated edges */
+  e = 0;
+  for (i = 0; i < nv; i++) {
+    intmach_t a = g->off[i], b = g->off[i+1];
+    qsort(g->adj + a, b - a, sizeof(csr_vertex_t), cmp_vertex);
+    g->off[i] = e;
+    for (j = a; j < b; j++) {
+      k = g->adj[j];
+      if (e == g->off[i] || g->adj[e-1] != k) g->adj[e++] = k;
+    }
+  }
+  g->off[nv] = e;
+  if (e < ne) {
+    g->adj = checkrealloc_ARRAY(csr_vertex_t, SIZE1(ne), SIZE1(e), g->adj);
+    g->ne = e;
+  }
+
+  csr_complete(g, vt);
+  t = CFUN__EVAL(make_vertex_list, vt, nv);
+  checkdealloc_ARRAY(tagged_t, SIZE1(nt), vt);
+  CSR_UNIFY_NEW(g, X(2));
+  CBOOL__LASTUNIFY(t, X(3));
+}
+
+/* '$csr_free'(+H) */
+CBOOL__PROTO(prolog_csr_free) {
+  csr_graph_t *g;
+
+  g = csr_lookup(X(0), TRUE);
+  if (g == NULL) CBOOL__FAIL;
+  csr_free(g);
+  CBOOL__PROCEED;
+}
+
+/* '$csr_check'(+H): H is the handle of a live graph */
+CBOOL__PROTO(prolog_csr_check) {
+  CBOOL__LASTTEST(csr_lookup(X(0), FALSE) != NULL);
+}
+
+/* '$csr_info'(+H, -NV, -NE, -MinWeight) */
+CBOOL__PROTO(prolog_csr_info) {
+  csr_graph_t *g;
+
+  CSR_GRAPH(g, X(0));
+  TEST_HEAP_OVERFLOW(G->heap_top, 12*sizeof(tagged_t)+CONTPAD, 4);
+  CBOOL__UNIFY(IntmachToTagged(g->nv), X(1));
+  CBOOL__UNIFY(IntmachToTagged(g->ne), X(2));
+  if (g->int_weights) {
+    CBOOL__LASTUNIFY(IntmachToTagged((intmach_t)g->min_weight), X(3));
+  } else {
+    CBOOL__LASTUNIFY(BoxFloat(g->min_weight), X(3));
+  }
+}
+
+/* '$csr_transpose'(+H, -HT) */
+CBOOL__PROTO(prolog_csr_transpose) {
+  csr_graph_t *g, *gt;
+  intmach_t v, e, k;
+
+  CSR_GRAPH(g, X(0));
+  gt = csr_new(g->nv, g->ne, g->weight != NULL);
+  gt->int_weights = g->int_weights;
+  gt->min_weight = g->min_weight;
+  memset(gt->off, 0, (g->nv + 1) * sizeof(intmach_t));
+  for (e = 0; e < g->ne; e++) gt->off[g->adj[e] + 1]++;
+  for (v = 0; v < g->nv; v++) gt->off[v+1] += gt->off[v];
+  /* (sources are visited in order, so neighbors stay sorted) */
+  for (v = 0; v < g->nv; v++) {
+    for (e = g->off[v]; e < g->off[v+1]; e++) {
+      k = gt->off[g->adj[e]]++;
+      gt->adj[k] = v;
+      if (gt->weight != NULL) gt->weight[k] = g->weight[e];
+    }
+  }
+  for (v = g->nv; v > 0; v--) gt->off[v] = gt->off[v-1];
+  gt->off[0] = 0;
+  csr_complete_transpose(gt, g);
+  CSR_UNIFY_NEW(gt, X(1));
+  CBOOL__PROCEED;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Results */
+
+/* Vertex terms of g for building results (from the vertex list vs,
+   unless they are kept with the graph). Call after TEST_HEAP_OVERFLOW
+   (which may move them). */
+static tagged_t *vertex_terms(csr_graph_t *g, tagged_t vs) {
+  tagged_t *vt;
+  intmach_t n;
+
+  if (g->words != NULL) return g->words;
+  vt = checkalloc_ARRAY(tagged_t, SIZE1(g->nv));
+  /* (a wrong vertex list gives wrong results, but it is never read
+     past its end) */
+  n = list_length(vs);
+  if (n < 0 || n > g->nv) n = 0;
+  load_terms(vs, vt, n);
+  for (; n < g->nv; n++) vt[n] = atom_nil;
+  return vt;
+}
+
+static void free_vertex_terms(csr_graph_t *g, tagged_t *vt) {
+  if (vt != g->words) checkdealloc_ARRAY(tagged_t, SIZE1(g->nv), vt);
+}
+
+/* List of the vertices in ix[0..n) */
+static CFUN__PROTO(make_index_list, tagged_t, tagged_t *vt, csr_vertex_t *ix,
+                   intmach_t n) {
+  tagged_t list = atom_nil;
+  intmach_t i;
+  for (i = n; i-- > 0; ) {
+    MakeLST(list, vt[ix[i]], list);
+  }
+  CFUN__PROCEED(list);
+}
+
+/* Pair K-V */
+static CFUN__PROTO(make_pair, tagged_t, tagged_t k, tagged_t v) {
+  tagged_t *h = G->heap_top;
+  HeapPush(h, functor_minus);
+  HeapPush(h, k);
+  HeapPush(h, v);
+  G->heap_top = h;
+  CFUN__PROCEED(Tagp(STR, h-3));
+}
+
+/* Map the vertex terms of list t (ignoring those which are not
+   vertices), return the number of vertices stored in ix */
+static CFUN__PROTO(map_vertices, intmach_t, csr_graph_t *g, tagged_t vs,
+                   tagged_t t, csr_vertex_t *ix) {
+  tagged_t *vt, x;
+  intmach_t n = 0, k;
+
+  vt = vertex_terms(g, vs);
+  DEREF(t, t);
+  while (TaggedIsLST(t)) {
+    DerefCar(x, t);
+    k = CFUN__EVAL(find_vertex, vt, g->nv, x);
+    if (k >= 0) ix[n++] = k;
+    DerefCdr(t, t);
+  }
+  free_vertex_terms(g, vt);
+  CFUN__PROCEED(n);
+}
+
+/* '$csr_to_ugraph'(+H, +Vertices, -UGraph) */
+CBOOL__PROTO(prolog_csr_to_ugraph) {
+  csr_graph_t *g;
+  tagged_t *vt, list, ns;
+  intmach_t v, e;
+
+  CSR_GRAPH(g, X(0));
+  TEST_HEAP_OVERFLOW(G->heap_top, (g->nv*(LSTCELLS+3)+g->ne*LSTCELLS)*sizeof(tagged_t)+CONTPAD, 3);
+  vt = vertex_terms(g, X(1));
+  list = atom_nil;
+  for (v = g->nv; v-- > 0; ) {
+    ns = atom_nil;
+    for (e = g->off[v+1]; e-- > g->off[v]; ) {
+      MakeLST(ns, vt[g->adj[e]], ns);
+    }
+    MakeLST(list, CFUN__EVAL(make_pair, vt[v], ns), list);
+  }
+  free_vertex_terms(g, vt);
+  CBOOL__LASTUNIFY(list, X(2));
+}
+
+/* '$csr_neighbors'(+H, +Vertices, +V, -Neighbors) */
+CBOOL__PROTO(prolog_csr_neighbors) {
+  csr_graph_t *g;
+  tagged_t *vt, list;
+  intmach_t v;
+
+  CSR_GRAPH(g, X(0));
+  /* (room for the neighbors of any vertex, so that the vertex terms
+     are loaded and searched once) */
+  TEST_HEAP_OVERFLOW(G->heap_top, g->max_degree*LSTCELLS*sizeof(tagged_t)+CONTPAD, 4);
+  vt = vertex_terms(g, X(1));
+  v = CFUN__EVAL(find_vertex, vt, g->nv, X(2));
+  if (v < 0) {
+    free_vertex_terms(g, vt);
+    CBOOL__FAIL;
+  }
+  list = CFUN__EVAL(make_index_list, vt, g->adj + g->off[v], g->off[v+1] - g->off[v]);
+  free_vertex_terms(g, vt);
+  CBOOL__LASTUNIFY(list, X(3));
+}
+
+/* --------------------------------------------------------------------------- */
+/* Strongly connected components (Tarjan) */
+
+typedef struct sccs_ sccs_t;
+struct sccs_ {
+  intmach_t n; /* number of components */
+  csr_vertex_t *comp; /* component of each vertex */
+  csr_vertex_t *members; /* vertices of each component, in pop order */
+  intmach_t *start; /* (n+1 entries) */
+};
+
+/* Components are numbered in the order they are found, which is a
+   reverse topological order of the condensed graph */
+static void tarjan(csr_graph_t *g, sccs_t *r) {
+  intmach_t nv = g->nv;
+  intmach_t *index, *low, *cs_e;
+  csr_vertex_t *stack, *cs_v;
+  char *on_stack;
+  intmach_t counter = 0, sp = 0, csp, m = 0, root, v, w, e;
+
+  index = checkalloc_ARRAY(intmach_t, SIZE1(nv));
+  low = checkalloc_ARRAY(intmach_t, SIZE1(nv));
+  cs_e = checkalloc_ARRAY(intmach_t, SIZE1(nv));
+  cs_v = checkalloc_ARRAY(csr_vertex_t, SIZE1(nv));
+  stack = checkalloc_ARRAY(csr_vertex_t, SIZE1(nv));
+  on_stack = checkalloc_ARRAY(char, SIZE1(nv));
+  r->comp = checkalloc_ARRAY(csr_vertex_t, SIZE1(nv));
+  r->members = checkalloc_ARRAY(csr_vertex_t, SIZE1(nv));
+  r->start = checkalloc_ARRAY(intmach_t, nv + 1);
+  r->n = 0;
+  r->start[0] = 0;
+  for (v = 0; v < nv; v++) { index[v] = -1; on_stack[v] = 0; }
+
+  for (root = 0; root < nv; root++) {
+    if (index[root] >= 0) continue;
+    /* (iterative depth-first search, with an explicit call stack) */
+    csp = 0;
+    cs_v[csp] = root; cs_e[csp] = g->off[root]; csp++;
+    index[root] = low[root] = counter++;
+    stack[sp++] = root; on_stack[root] = 1;
+    while (csp > 0) {
+      v = cs_v[csp-1];
+      e = cs_e[csp-1];
+      if (e < g->off[v+1]) {
+        cs_e[csp-1]++;
+        w = g->adj[e];
+        if (index[w] < 0) {
+          index[w] = low[w] = counter++;
+          stack[sp++] = w; on_stack[w] = 1;
+          cs_v[csp] = w; cs_e[csp] = g->off[w]; csp++;
+        } else if (on_stack[w] && index[w] < low[v]) {
+          low[v] = index[w];
+        }
+      } else {
+        csp--;
+        if (low[v] == index[v]) {
+          do {
+            w = stack[--sp];
+            on_stack[w] = 0;
+            r->comp[w] = r->n;
+            r->members[m++] = w;
+          } while (w != v);
+          r->n++;
+          r->start[r->n] = m;
+        }
+        if (csp > 0) {
+          w = cs_v[csp-1];
+          if (low[v] < low[w]) low[w] = low[v];
+        }
+      }
+    }
+  }
+
+  checkdealloc_ARRAY(intmach_t, SIZE1(nv), index);
+  checkdealloc_ARRAY(intmach_t, SIZE1(nv), low);
+  checkdealloc_ARRAY(intmach_t, SIZE1(nv), cs_e);
+  checkdealloc_ARRAY(csr_vertex_t, SIZE1(nv), cs_v);
+  checkdealloc_ARRAY(csr_vertex_t, SIZE1(nv), stack);
+  checkdealloc_ARRAY(char, SIZE1(nv), on_stack);
+}
+
+static void sccs_free(sccs_t *r, intmach_t nv) {
+  checkdealloc_ARRAY(csr_vertex_t, SIZE1(nv), r->comp);
+  checkdealloc_ARRAY(csr_vertex_t, SIZE1(nv), r->members);
+  checkdealloc_ARRAY(intmach_t, nv + 1, r->start);
+}
+
+/* '$csr_sccs'(+H, +Vertices, -SCCs) */
+CBOOL__PROTO(prolog_csr_sccs) {
+  csr_graph_t *g;
+  sccs_t r;
+  tagged_t *vt, list;
+  intmach_t c;
+
+  CSR_GRAPH(g, X(0));
+  tarjan(g, &r);
+  TEST_HEAP_OVERFLOW(G->heap_top, (g->nv+r.n)*LSTCELLS*sizeof(tagged_t)+CONTPAD, 3);
+  vt = vertex_terms(g, X(1));
+  list = atom_nil;
+  for (c = r.n; c-- > 0; ) {
+    MakeLST(list, CFUN__EVAL(make_index_list, vt, r.members + r.start[c], r.start[c+1] - r.start[c]), list);
+  }
+  free_vertex_terms(g, vt);
+  sccs_free(&r, g->nv);
+  CBOOL__LASTUNIFY(list, X(2));
+}
+
+/* --------------------------------------------------------------------------- */
+/* Topological sort (Kahn) */
+
+/* '$csr_top_sort'(+H, +Vertices, -Sorted): fails if there are cycles */
+CBOOL__PROTO(prolog_csr_top_sort) {
+  csr_graph_t *g;
+  intmach_t *indeg, head, tail, v, e;
+  csr_vertex_t *queue;
+  tagged_t *vt, list;
+
+  CSR_GRAPH(g, X(0));
+  indeg = checkalloc_ARRAY(intmach_t, SIZE1(g->nv));
+  queue = checkalloc_ARRAY(csr_vertex_t, SIZE1(g->nv));
+  for (v = 0; v < g->nv; v++) indeg[v] = 0;
+  for (e = 0; e < g->ne; e++) indeg[g->adj[e]]++;
+  tail = 0;
+  for (v = 0; v < g->nv; v++) {
+    if (indeg[v] == 0) queue[tail++] = v;
+  }
+  for (head = 0; head < tail; head++) {
+    v = queue[head];
+    for (e = g->off[v]; e < g->off[v+1]; e++) {
+      if (--indeg[g->adj[e]] == 0) queue[tail++] = g->adj[e];
+    }
+  }
+  checkdealloc_ARRAY(intmach_t, SIZE1(g->nv), indeg);
+  if (tail < g->nv) {
+    checkdealloc_ARRAY(csr_vertex_t, SIZE1(g->nv), queue);
+    CBOOL__FAIL;
+  }
+  TEST_HEAP_OVERFLOW(G->heap_top, g->nv*LSTCELLS*sizeof(tagged_t)+CONTPAD, 3);
+  vt = vertex_terms(g, X(1));
+  list = CFUN__EVAL(make_index_list, vt, queue, g->nv);
+  free_vertex_terms(g, vt);
+  checkdealloc_ARRAY(csr_vertex_t, SIZE1(g->nv), queue);
+  CBOOL__LASTUNIFY(list, X(2));
+}
+
+/* --------------------------------------------------------------------------- */
+/* Traversals */
+
+#define TRAV_BFS       0 /* vertices in breadth-first order */
+#define TRAV_DFS       1 /* vertices in depth-first (pre)order */
+#define TRAV_REACHABLE 2 /* vertices in standard order */
+
+/* '$csr_traverse'(+H, +Vertices, +Mode, +Sources, -Visited):
+   vertices reachable from Sources (including them) */
+CBOOL__PROTO(prolog_csr_traverse) {
+  csr_graph_t *g;
+  intmach_t nv, ns, n, i, head, csp, u, v, e;
+  int mode;
+  csr_vertex_t *src, *order, *cs_v;
+  intmach_t *cs_e;
+  char *seen;
+  tagged_t *vt, list;
+
+  CSR_GRAPH(g, X(0));
+  nv = g->nv;
+  DEREF(X(2), X(2));
+  mode = GetSmall(X(2));
+  ns = list_length(X(3));
+  if (ns < 0) CBOOL__FAIL;
+  src = checkalloc_ARRAY(csr_vertex_t, SIZE1(ns));
+  ns = CFUN__EVAL(map_vertices, g, X(1), X(3), src);
+
+  seen = checkalloc_ARRAY(char, SIZE1(nv));
+  memset(seen, 0, nv);
+  order = checkalloc_ARRAY(csr_vertex_t, SIZE1(nv));
+  n = 0;
+  if (mode == TRAV_DFS) {
+    cs_v = checkalloc_ARRAY(csr_vertex_t, SIZE1(nv));
+    cs_e = checkalloc_ARRAY(intmach_t, SIZE1(nv));
+    for (i = 0; i < ns; i++) {
+      if (seen[src[i]]) continue;
+      csp = 0;
+      seen[src[i]] = 1; order[n++] = src[i];
+      cs_v[csp] = src[i]; cs_e[csp] = g->off[src[i]]; csp++;
+      while (csp > 0) {
+        v = cs_v[csp-1];
+        e = cs_e[csp-1];
+        if (e == g->off[v+1]) { csp--; continue; }
+        cs_e[csp-1]++;
+        u = g->adj[e];
+        if (!seen[u]) {
+          seen[u] = 1; order[n++] = u;
+          cs_v[csp] = u; cs_e[csp] = g->off[u]; csp++;
+        }
+      }
+    }
+    checkdealloc_ARRAY(csr_vertex_t, SIZE1(nv), cs_v);
+    checkdealloc_ARRAY(intmach_t, SIZE1(nv), cs_e);
+  } else {
+    for (i = 0; i < ns; i++) {
+      if (!seen[src[i]]) { seen[src[i]] = 1; order[n++] = src[i]; }
+    }
+    for (head = 0; head < n; head++) {
+      v = order[head];
+      for (e = g->off[v]; e < g->off[v+1]; e++) {
+        u = g->adj[e];
+        if (!seen[u]) { seen[u] = 1; order[n++] = u; }
+      }
+    }
+    if (mode == TRAV_REACHABLE) {
+      for (v = 0, i = 0; v < nv; v++) {
+        if (seen[v]) order[i++] = v;
+      }
+    }
+  }
+  checkdealloc_ARRAY(csr_vertex_t, SIZE1(ns), src);
+  checkdealloc_ARRAY(char, SIZE1(nv), seen);
+
+  TEST_HEAP_OVERFLOW(G->heap_top, n*LSTCELLS*sizeof(tagged_t)+CONTPAD, 5);
+  vt = vertex_terms(g, X(1));
+  list = CFUN__EVAL(make_index_list, vt, order, n);
+  free_vertex_terms(g, vt);
+  checkdealloc_ARRAY(csr_vertex_t, SIZE1(nv), order);
+  CBOOL__LASTUNIFY(list, X(4));
+}
+
+/* --------------------------------------------------------------------------- */
+/* Transitive closure */
+
+typedef uint64_t word_t;
+#define WORD_BITS 64
+
+static intmach_t popcount(word_t x) {
+  intmach_t n = 0;
+  while (x != 0) { x &= x - 1; n++; }
+  return n;
+}
+
+/* '$csr_transitive_closure'(+H, +Vertices, -Closure): Closure is
+   the ugraph with an edge U-V for each path from U to V (with at
+   least one edge) */
+CBOOL__PROTO(prolog_csr_transitive_closure) {
+  csr_graph_t *g;
+  sccs_t r;
+  intmach_t nv, nw, c, i, j, k, v, e, d, total;
+  word_t *bits, *bc, *bd;
+  tagged_t *vt, list, ns;
+
+  CSR_GRAPH(g, X(0));
+  nv = g->nv;
+  tarjan(g, &r);
+  /* A bit set of reachable vertices for each component, computed in
+     the order the components are found (i.e., after all the
+     components reachable from them) */
+  nw = (nv + WORD_BITS - 1) / WORD_BITS;
+  bits = checkalloc_ARRAY(word_t, SIZE1(r.n*nw));
+  memset(bits, 0, r.n*nw*sizeof(word_t));
+  total = 0;
+  for (c = 0; c < r.n; c++) {
+    bc = bits + c*nw;
+    for (i = r.start[c]; i < r.start[c+1]; i++) {
+      v = r.members[i];
+      for (e = g->off[v]; e < g->off[v+1]; e++) {
+        j = g->adj[e];
+        bc[j / WORD_BITS] |= (word_t)1 << (j % WORD_BITS);
+        d = r.comp[j];
+        if (d != c) {
+          bd = bits + d*nw;
+          for (k = 0; k < nw; k++) bc[k] |= bd[k];
+        }
+      }
+    }
+    for (k = 0; k < nw; k++) {
+      total += popcount(bc[k]) * (r.start[c+1] - r.start[c]);
+    }
+  }
+
+  TEST_HEAP_OVERFLOW(G->heap_top, (nv*(LSTCELLS+3)+total*LSTCELLS)*sizeof(tagged_t)+CONTPAD, 3);
+  vt = vertex_terms(g, X(1));
+  list = atom_nil;
+  for (v = nv; v-- > 0; ) {
+    bc = bits + r.comp[v]*nw;
+    ns = atom_nil;
+    for (j = nv; j-- > 0; ) {
+      if (bc[j / WORD_BITS] & ((word_t)1 << (j % WORD_BITS))) {
+        MakeLST(ns, vt[j], ns);
+      }
+    }
+    MakeLST(list, CFUN__EVAL(make_pair, vt[v], ns), list);
+  }
+  free_vertex_terms(g, vt);
+  checkdealloc_ARRAY(word_t, SIZE1(r.n*nw), bits);
+  sccs_free(&r, nv);
+  CBOOL__LASTUNIFY(list, X(2));
+}
+
+/* --------------------------------------------------------------------------- */
+/* Shortest paths (Dijkstra) */
+
+typedef struct hitem_ hitem_t;
+struct hitem_ {
+  double d;
+  csr_vertex_t v;
+};
+
+/* (binary min-heap, with repeated vertices instead of decrease-key) */
+static void heap_push(hitem_t *h, intmach_t *n, double d, csr_vertex_t v) {
+  intmach_t i = (*n)++, p;
+  while (i > 0) {
+    p = (i - 1) / 2;
+    if (h[p].d <= d) break;
+    h[i] = h[p];
+    i = p;
+  }
+  h[i].d = d;
+  h[i].v = v;
+}
+
+static hitem_t heap_pop(hitem_t *h, intmach_t *n) {
+  hitem_t top = h[0], last = h[--(*n)];
+  intmach_t i = 0, k;
+  for (;;) {
+    k = 2*i + 1;
+    if (k >= *n) break;
+    if (k + 1 < *n && h[k+1].d < h[k].d) k++;
+    if (last.d <= h[k].d) break;
+    h[i] = h[k];
+    i = k;
+  }
+  h[i] = last;
+  return top;
+}
+
+/* '$csr_dijkstra'(+H, +Vertices, +Source, -Dists): Dists is the
+   list of V-D, where D is the length of the shortest path from Source
+   to V (for each V reachable from Source, in standard order). Fails
+   if Source is not a vertex. Weights must not be negative. */
+CBOOL__PROTO(prolog_csr_dijkstra) {
+  csr_graph_t *g;
+  intmach_t nv, n, u, v, e, hn;
+  double *dist, d;
+  hitem_t *heap, it;
+  tagged_t *vt, list, x;
+
+  CSR_GRAPH(g, X(0));
+  nv = g->nv;
+  vt = vertex_terms(g, X(1));
+  v = CFUN__EVAL(find_vertex, vt, nv, X(2));
+  free_vertex_terms(g, vt);
+  if (v < 0) CBOOL__FAIL;
+
+  dist = checkalloc_ARRAY(double, SIZE1(nv));
+  for (u = 0; u < nv; u++) dist[u] = INFINITY;
+  heap = checkalloc_ARRAY(hitem_t, g->ne + 1);
+  hn = 0;
+  dist[v] = 0;
+  heap_push(heap, &hn, 0, v);
+  n = 0;
+  while (hn > 0) {
+    it = heap_pop(heap, &hn);
+    if (it.d > dist[it.v]) continue; /* (already settled) */
+    n++;
+    for (e = g->off[it.v]; e < g->off[it.v+1]; e++) {
+      u = g->adj[e];
+      d = it.d + WEIGHT(g, e);
+      if (d < dist[u]) {
+        dist[u] = d;
+        heap_push(heap, &hn, d, u);
+      }
+    }
+  }
+  checkdealloc_ARRAY(hitem_t, g->ne + 1, heap);
+
+  TEST_HEAP_OVERFLOW(G->heap_top, n*(LSTCELLS+3+4)*sizeof(tagged_t)+CONTPAD, 4);
+  vt = vertex_terms(g, X(1));
+  list = atom_nil;
+  for (u = nv; u-- > 0; ) {
+    if (dist[u] == INFINITY) continue;
+    if (g->int_weights) {
+      x = IntmachToTagged((intmach_t)dist[u]);
+    } else {
+      x = BoxFloat(dist[u]);
+    }
+    MakeLST(list, CFUN__EVAL(make_pair, vt[u], x), list);
+  }
+  free_vertex_terms(g, vt);
+  checkdealloc_ARRAY(double, SIZE1(nv), dist);
+  CBOOL__LASTUNIFY(list, X(3));
+}
@@ -41,6 +41,8 @@
    A path is represented as a list of vertices.  No vertex can appear
    twice in a path.
 
+   See @lib{csr_graphs} for a compact representation of large graphs,
+   with native implementations of common graph algorithms.
 ").
 
 :- use_module(library(sets), [
@@ -0,0 +1,87 @@
+:- module(_, [], [assertions, regtypes]).
+
+:- doc(title, "Heap snapshots").
+
+:- doc(author, "The Ciao Development Team").
+
+:- doc(stability, devel).
+
+:- doc(module, "@cindex{heap snapshot} @cindex{retained size}
+
+   This module dumps the graph of heap terms of the current thread
+   to a file, and analyzes such files to find which terms (and which
+   predicates) retain most memory.
+
+   A snapshot contains the heap objects (structures, list cells,
+   attributed variables, and boxed numbers) reachable from the roots
+   of the execution: environment frames (of the active continuation
+   and of the choicepoints), arguments saved in choicepoints, trail
+   entries (e.g., for @pred{setarg/3}), and global variables. Roots
+   in frames and choicepoints are labeled with the predicate that
+   owns them. Note that terms stored in the database (including
+   solutions collected by @pred{findall/3}) are not on the heap (see
+   @pred{memory_report/1} for their size).
+
+   The analysis computes the dominator tree of the heap graph, and
+   the @em{retained size} of each object (the bytes that would be
+   freed if it became unreachable). The results are summarized per
+   functor and per root predicate:
+
+@begin{verbatim}
+?- heap_snapshot('heap.snap').
+...
+?- heap_snapshot_analyze('heap.snap', 10, Total, ByFunctor, ByRoot).
+@end{verbatim}
+
+   The @tt{heapsnap} command prints the same summary for a snapshot
+   file.
+").
+
+:- use_module(engine(internals), [
+    '$heap_snapshot'/1,
+    '$heap_snapshot_analyze'/5
+]).
+
+% ---------------------------------------------------------------------------
+
+:- export(heap_snapshot/1).
+:- pred heap_snapshot(File) : atm(File)
+   # "Write a snapshot of the heap of the current thread to
+     @var{File}.".
+
+heap_snapshot(File) :-
+    ( '$heap_snapshot'(File) -> true
+    ; throw(error(permission_error(open, source_sink, File), heap_snapshot/1))
+    ).
+
+:- export(heap_snapshot_analyze/5).
+:- pred heap_snapshot_analyze(File, N, Total, ByFunctor, ByRoot)
+   : (atm(File), int(N))
+   => (int(Total), snapshot_summary(ByFunctor), snapshot_summary(ByRoot))
+   # "Analyze the snapshot in @var{File}. @var{Total} is the size in
+     bytes of the reachable heap. @var{ByFunctor} and @var{ByRoot}
+     are the @var{N} entries (all if @var{N} is 0) with the largest
+     retained sizes, for each functor and for each root
+     (@tt{Kind Pred}) respectively.
+
+     The retained size of a functor counts the objects that are not
+     immediately dominated by an object with the same functor (so
+     that, e.g., a list is counted once, from its first cell). The
+     retained size of a root counts the objects that are only
+     reachable from roots with that label.".
+
+heap_snapshot_analyze(File, N, Total, ByFunctor, ByRoot) :-
+    ( '$heap_snapshot_analyze'(File, N, Total, ByFunctor, ByRoot) -> true
+    ; throw(error(domain_error(heap_snapshot, File), heap_snapshot_analyze/5))
+    ).
+
+:- export(snapshot_summary/1).
+:- regtype snapshot_summary(S) # "@var{S} is a list of
+   @tt{Label-[Count,Shallow,Retained]} elements, where @var{Count} is
+   the number of objects (or roots), @var{Shallow} their size in
+   bytes, and @var{Retained} their retained size in bytes.".
+
+snapshot_summary([]).
+snapshot_summary([Label-[Count, Shallow, Retained]|S]) :-
+    atm(Label), int(Count), int(Shallow), int(Retained),
+    snapshot_summary(S).
@@ -64,8 +64,13 @@ cgi_read_post -->
     [content_length(Len)],
     %
     { current_input(CI) },
-    { read_bytes(CI, Len, Cs) },
-    [content(Cs)],
+    ( { Type = multipart, Subtype = 'form-data',
+        current_prolog_flag(stream_form_uploads, on) } ->
+        % (read on demand, see http_parse_form/2)
+        [content_stream(CI, [])]
+    ; { read_bytes(CI, Len, Cs) },
+      [content(Cs)]
+    ),
     !.
 cgi_read_post --> [].
 
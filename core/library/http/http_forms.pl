@@ -65,10 +65,16 @@ value_assignment(A=V) :-
     @includedef{define_flag/3}
     (See @ref{Runtime system control and flags}).
 
-    If flag is @tt{on}, values returned by @pred{http_parse_form/2}
-    are always atoms, unchanged from its original value.").
+    If flag @tt{raw_form_values} is @tt{on}, values returned by
+    @pred{http_parse_form/2} are always atoms, unchanged from its
+    original value.
+
+    If flag @tt{stream_form_uploads} is @tt{on}, the HTTP server and
+    @lib{cgi} do not read the content of @tt{multipart/form-data}
+    requests (see @pred{http_parse_form/2}).").
 
 define_flag(raw_form_values, [on,off], off).
+define_flag(stream_form_uploads, [on,off], off).
 
 :- use_module(engine(runtime_control), [current_prolog_flag/2]).
 
@@ -302,7 +308,16 @@ lines_to_value_cooked(Ls, L, [L|Ls]).   % else, return the list of lines
 
 :- export(http_parse_form/2).
 :- pred http_parse_form(Request, Dic) # "Get form data @var{Dic} from
-   HTTP request @var{Request}".
+   HTTP request @var{Request}. Uploaded files are returned as
+   @tt{file(FileName, Bytes)}.
+
+   If the content of a @tt{multipart/form-data} request has not been
+   read yet (@tt{content_stream/2}, when the flag
+   @tt{stream_form_uploads} is @tt{on}), it is read with
+   @pred{read_multipart_form_data/4} (it can only be done once, with
+   its default size limits) and uploaded files are returned as
+   @tt{file(FileName, tmp_file(Path))} instead. The caller must
+   delete those files.".
 
 http_parse_form(Request, Dic) :-
     ( member(method(Method), Request) -> true ; fail ),
@@ -330,7 +345,15 @@ http_parse_form_of_type(application, 'x-www-form-urlencoded', Request, _, Dic) :
     ( member(content(Cs), Request) -> true ; fail ),
     urlencoded_to_dic(Dic, Cs),
     !.
-% TODO: implement multipart in POST --- try not read the contents!
+http_parse_form_of_type(multipart, 'form-data', Request, Params, Dic) :-
+    ( member(content_stream(S, Pending), Request) -> true ; fail ),
+    member((boundary=B), Params),
+    ( member(content_length(Len), Request) ->
+        Opts = [length(Len), pending(Pending)]
+    ; Opts = [pending(Pending)]
+    ),
+    read_multipart_form_data(S, B, Opts, Dic),
+    !.
 http_parse_form_of_type(multipart, 'form-data', Request, Params, Dic) :-
     ( member(content(Cs), Request) -> true ; fail ),
     member((boundary=B), Params),
@@ -92,6 +92,13 @@
 %  content (bytelist/1).  If @tt{method(head)} of the HTTP
 %  request is used, an empty list is get here.
 %
+%  @item @bf{content_stream(}@em{Stream,Pending}@bf{):} Used instead
+%  of @tt{content/1} in @tt{multipart/form-data} requests when the
+%  flag @tt{stream_form_uploads} is @tt{on}. The content is read on
+%  demand (see @pred{http_parse_form/2}).
+%  @em{Stream} is the stream where the content can be read and
+%  @em{Pending} are its first bytes, already read from @em{Stream}.
+%
 %  @end{itemize}
 %
 
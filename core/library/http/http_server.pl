@@ -11,7 +11,8 @@
 %  It can be used to handle individual HTTP requests
 %  (@pred{http_serve_fetch/2}) or for implementing a simple HTTP
 %  server (see @pred{http_bind/1}, @pred{http_loop/1},
-%  @pred{http_shutdown/1}).
+%  @pred{http_shutdown/1}). The server can handle requests
+%  concurrently with a pool of workers (see @pred{http_loop/2}).
 %
 %  Clients of this module must use the @lib{http_server_hooks} package
 %  and implement the multifile @pred{httpserv.handle/3} (see
@@ -90,6 +91,12 @@ flatten([[X|Xs]|Ys],Zs):-
 
 % Receive content (only for POST requests)
 % (Note: Tail are pending read characters from parsing the header)
+http_read_content(Stream, Request, Request1, Tail) :-
+    member(content_type(multipart,'form-data',_),Request),
+    current_prolog_flag(stream_form_uploads, on),
+    !,
+    % (read on demand, see http_parse_form/2)
+    Request1 = [content_stream(Stream,Tail)|Request].
 http_read_content(Stream, Request, Request1, Tail) :-
     member(content_length(Length),Request),
     http_read_content_n(Stream,Length,Tail,Content),
@@ -303,10 +310,38 @@ not_found_html(
    with @pred{http_loop/1})".
 
 http_bind(Port) :-
+    http_bind(Port, []).
+
+:- export(http_bind/2).
+:- pred http_bind(Port, Opts) # "Like @pred{http_bind/1}, with the
+   following options:
+   @begin{itemize}
+   @item @tt{backlog(N)}: maximum number of pending connections (128
+     by default).
+   @item @tt{acceptors(N)}: bind @var{N} sockets to the same port
+     (with the @tt{reuseport} option of @pred{bind_socket/4}), each
+     of them served by its own acceptor in @pred{http_loop/2}. If
+     @var{Port} is free, it is unified with the port assigned by the
+     O.S. to the first socket.
+   @end{itemize}".
+
+http_bind(Port, Opts) :-
     retractall_fact(shutdown(_)),
     retractall_fact(curr_socket(_)),
-    bind_socket(Port, 5, Socket),
-    assertz_fact(curr_socket(Socket)).
+    ( member(backlog(Backlog), Opts) -> true ; Backlog = 128 ),
+    ( member(acceptors(N), Opts) -> true ; N = 1 ),
+    ( N > 1 ->
+        bind_sockets(N, Port, Backlog)
+    ; bind_socket(Port, Backlog, Socket),
+      assertz_fact(curr_socket(Socket))
+    ).
+
+bind_sockets(0, _, _) :- !.
+bind_sockets(N, Port, Backlog) :-
+    bind_socket(Port, Backlog, [reuseport], Socket),
+    assertz_fact(curr_socket(Socket)),
+    N1 is N - 1,
+    bind_sockets(N1, Port, Backlog).
 
 :- export(http_loop/1).
 :- pred http_loop(ExitCode)
@@ -331,7 +366,7 @@ serve_socket_loop(Socket) :-
       serve_socket_loop(Socket)
     ).
 
-:- data shutdown/1.
+:- concurrent shutdown/1.
 
 :- export(http_shutdown/1).
 :- pred http_shutdown(ExitCode) # "@var{ExitCode} mark that we are not
@@ -343,11 +378,134 @@ http_shutdown(ExitCode) :-
 socket_serve(Stream, yes) :-
     % TODO: Are Stream objects here leaking? (see C code)
     http_serve_fetch(Stream,http_serve(Stream)), % Note: http_serve_fetch/1 closes Stream
-    ( current_fact(shutdown(Code)) ->
+    ( current_fact_nb(shutdown(Code)) ->
         throw(err_shutdown(Code)) % TODO: better way?
     ; true
     ).
 
+% ---------------------------------------------------------------------------
+% Multi-worker server
+
+:- use_module(library(concurrency), [eng_call/4, eng_wait/1, eng_release/1]).
+:- use_module(library(aggregates), [findall/3]).
+
+:- export(http_loop/2).
+:- pred http_loop(ExitCode, Opts)
+   # "Like @pred{http_loop/1}, but requests are handled concurrently
+      by a pool of workers, each of them an engine with its own
+      thread (see @lib{concurrency}). An acceptor for each bound
+      socket (see @pred{http_bind/2}) accepts connections and puts
+      them in a bounded queue, from which the workers take them (one
+      request per connection). The following options are accepted:
+      @begin{itemize}
+      @item @tt{workers(N)}: number of workers (4 by default).
+      @item @tt{queue(N)}: maximum number of accepted connections
+        waiting for a worker (64 by default). Acceptors wait when the
+        queue is full, so that new connections stay in the socket
+        backlog.
+      @item @tt{timeout(Ms)}: maximum time in milliseconds for each
+        receive or send operation of a request (@tt{off} by default).
+        Slow clients do not hold a worker for longer than that.
+      @end{itemize}
+
+      After @pred{http_shutdown/1} the acceptors stop accepting new
+      connections, and the predicate exits when the workers have
+      served all the queued connections.".
+
+http_loop(ExitCode, Opts) :-
+    ( member(workers(NWorkers), Opts) -> true ; NWorkers = 4 ),
+    ( member(queue(QueueSize), Opts) -> true ; QueueSize = 64 ),
+    ( member(timeout(Timeout), Opts) -> true ; Timeout = off ),
+    retractall_fact(conn_queue(_)),
+    retractall_fact(free_slot),
+    add_free_slots(QueueSize),
+    start_workers(NWorkers, Timeout, Workers),
+    findall(Socket, current_fact(curr_socket(Socket)), [Socket0|Sockets]),
+    start_acceptors(Sockets, Acceptors),
+    acceptor(Socket0),
+    wait_engines(Acceptors),
+    % (workers stop after serving the queued connections)
+    stop_workers(NWorkers),
+    wait_engines(Workers),
+    current_fact_nb(shutdown(ExitCode)).
+
+% Bounded queue of accepted connections (conn_queue/1 facts, each of
+% them taking a free_slot/0 fact)
+:- concurrent conn_queue/1.
+:- concurrent free_slot/0.
+
+add_free_slots(0) :- !.
+add_free_slots(N) :-
+    assertz_fact(free_slot),
+    N1 is N - 1,
+    add_free_slots(N1).
+
+enqueue_conn(Item) :-
+    retract_fact(free_slot), !, % (waits if the queue is full)
+    assertz_fact(conn_queue(Item)).
+
+dequeue_conn(Item) :-
+    retract_fact(conn_queue(Item)), !, % (waits if the queue is empty)
+    assertz_fact(free_slot).
+
+start_acceptors([], []).
+start_acceptors([Socket|Sockets], [Id|Ids]) :-
+    eng_call(acceptor(Socket), create, create, Id),
+    start_acceptors(Sockets, Ids).
+
+% (period in milliseconds to check for shutdown while waiting for
+% connections)
+acceptor_period(200).
+
+acceptor(Socket) :-
+    acceptor_period(Period),
+    repeat,
+      ( current_fact_nb(shutdown(_)) ->
+          !
+      ; catch(select_socket(Socket, Stream, Period, [], _), E,
+              (log(error, E), fail)),
+        nonvar(Stream),
+        enqueue_conn(conn(Stream)),
+        fail
+      ).
+
+start_workers(0, _, []) :- !.
+start_workers(N, Timeout, [Id|Ids]) :-
+    eng_call(worker(Timeout), create, create, Id),
+    N1 is N - 1,
+    start_workers(N1, Timeout, Ids).
+
+stop_workers(0) :- !.
+stop_workers(N) :-
+    enqueue_conn(stop),
+    N1 is N - 1,
+    stop_workers(N1).
+
+worker(Timeout) :-
+    repeat,
+      dequeue_conn(Item),
+      ( Item = stop ->
+          !
+      ; Item = conn(Stream),
+        worker_serve(Stream, Timeout),
+        fail
+      ).
+
+worker_serve(Stream, Timeout) :-
+    catch(worker_serve_(Stream, Timeout), E, log(error, E)),
+    % (http_serve_fetch/2 only closes Stream after a response)
+    catch(close(Stream), _, true).
+
+worker_serve_(Stream, Timeout) :-
+    ( Timeout = off -> true ; socket_timeout(Stream, Timeout) ),
+    http_serve_fetch(Stream, http_serve(Stream)).
+
+wait_engines([]).
+wait_engines([Id|Ids]) :-
+    eng_wait(Id),
+    eng_release(Id),
+    wait_engines(Ids).
+
 http_serve(_Stream, Request, Response) :-
     log(note, received_message(Request)),
     ( handle(Request,Response0) ->
@@ -394,7 +552,7 @@ locate_file(File, LocalFile) :-
     file_exists(LocalFile).
 
 :- use_module(library(system), [file_properties/6]).
-:- use_module(engine(runtime_control), [set_prolog_flag/2, prolog_flag/3]).
+:- use_module(engine(runtime_control), [set_prolog_flag/2, prolog_flag/3, current_prolog_flag/2]).
 
 % TODO: duplicated
 is_dir(Path) :-
@@ -1,4 +1,4 @@
-:- module(multipart_form_data, [], [assertions, regtypes, isomodes, dcg, hiord, doccomments]).
+:- module(multipart_form_data, [], [assertions, regtypes, isomodes, dcg, hiord, doccomments, foreign_interface]).
 
 %! \title  Multipart Form data
 %  \author The Ciao Development Team
@@ -6,8 +6,15 @@
 %  \module
 %
 %  Parsing of multipart/form-data media type (RFC7578).
+%
+%  Contents can be parsed from a string in memory
+%  (@pred{parse_multipart_form_data/3}) or read directly from a stream
+%  (@pred{read_multipart_form_data/4}). The latter searches the
+%  boundaries in blocks of bytes read from the stream and stores file
+%  parts in temporary files (or other sinks), so that large uploads
+%  are processed in bounded memory.
 
-:- use_module(library(lists), [member/2, append/3]).
+:- use_module(library(lists), [member/2, append/3, reverse/2]).
 :- use_module(library(http/http_forms), [lines_to_value/2]).
 :- use_module(library(http/http_grammar)).
 
@@ -119,3 +126,168 @@ parse_line_raw(Cs, Tail) -->
         )
     ; { Cs = Tail }
     ).
+
+% ---------------------------------------------------------------------------
+
+:- use_module(engine(stream_basic), [open/3, close/1, stream/1]).
+:- use_module(library(system), [mktemp_in_tmp/2, delete_file/1]).
+:- use_module(library(port_reify), [once_port_reify/2, port_call/1]).
+
+:- export(multipart_form_data_option/1).
+:- regtype multipart_form_data_option/1 # "Options for
+   @pred{read_multipart_form_data/4}".
+:- doc(multipart_form_data_option/1, "
+   @begin{description}
+   @item{@tt{length(Bytes)}} length of the contents (e.g., from the
+     @tt{Content-Length} header). Otherwise the contents are read up
+     to the end of the stream.
+   @item{@tt{pending(Bytes)}} first bytes of the contents, already
+     read from the stream (included in @tt{length/1}).
+   @item{@tt{max_field_size(Bytes)}} maximum size of the value of a
+     field which is not a file (1MB by default).
+   @item{@tt{max_file_size(Bytes)}} maximum size of a file (100MB by
+     default).
+   @end{description}
+").
+multipart_form_data_option(length(Bytes)) :- int(Bytes).
+multipart_form_data_option(pending(Bytes)) :- string(Bytes).
+multipart_form_data_option(max_field_size(Bytes)) :- int(Bytes).
+multipart_form_data_option(max_file_size(Bytes)) :- int(Bytes).
+
+:- export(read_multipart_form_data/4).
+:- pred read_multipart_form_data(+S, +B, +Opts, -Dic)
+   : (stream(S), string(B), list(multipart_form_data_option, Opts))
+   # "Like @pred{parse_multipart_form_data/3}, but reading the
+      contents from stream @var{S}. The contents of a file part are
+      stored in a new temporary file @var{Path} and its value is
+      @tt{file(FileName, tmp_file(Path))} (the caller must delete
+      those files).".
+
+read_multipart_form_data(S, B, Opts, Dic) :-
+    read_multipart_form_data(S, B, Opts, tmp_file_sink, Dic).
+
+tmp_file_sink(_Name, _FileName, Out, tmp_file(Path)) :-
+    mktemp_in_tmp('ciao_upload_XXXXXX', Path),
+    open(Path, write, Out).
+
+:- export(read_multipart_form_data/5).
+:- meta_predicate read_multipart_form_data(?, ?, ?, pred(4), ?).
+:- pred read_multipart_form_data(+S, +B, +Opts, +Sink, -Dic)
+   : (stream(S), string(B), list(multipart_form_data_option, Opts))
+   # "Like @pred{read_multipart_form_data/4}, but the contents of each
+      file part are written to the stream @var{Out} obtained from
+      @tt{Sink(Name, FileName, Out, Value)}, which is closed after
+      that. The value of the part is @tt{file(FileName, Value)}.".
+
+read_multipart_form_data(S, B, Opts, Sink, Dic) :-
+    ( member(length(Len), Opts) -> true ; Len = -1 ),
+    ( member(pending(Pending), Opts) -> true ; Pending = [] ),
+    ( member(max_field_size(MaxField), Opts) -> true ; MaxField = 1048576 ),
+    ( member(max_file_size(MaxFile), Opts) -> true ; MaxFile = 104857600 ),
+    Boundary = "--"||B,
+    ( '$multipart_open'(Pending, Len, B, R) -> true
+    ; throw(error(domain_error(multipart_boundary, Boundary), read_multipart_form_data/5))
+    ),
+    Ctx = ctx(R, S, MaxField, MaxFile, Sink),
+    once_port_reify(read_parts(Ctx, [], Dic), Port),
+    '$multipart_close'(R),
+    port_call(Port).
+
+% (files of the parts read so far are removed on errors or failure)
+read_parts(Ctx, Acc, Dic) :-
+    once_port_reify(read_part(Ctx, NV), Port),
+    ( Port = success -> true
+    ; remove_tmp_files(Acc),
+      port_call(Port)
+    ),
+    ( NV = end_of_file ->
+        reverse(Acc, Dic)
+    ; read_parts(Ctx, [NV|Acc], Dic)
+    ).
+
+read_part(Ctx, NV) :-
+    Ctx = ctx(R, S, _, _, _),
+    ( '$multipart_next'(R, S, HeadLines) -> true
+    ; throw_malformed
+    ),
+    ( HeadLines = end_of_file ->
+        NV = end_of_file
+    ; extract_name_type(HeadLines, Name, Type) ->
+        NV = (Name=Value),
+        read_value(Type, Name, Ctx, Value)
+    ; throw_malformed
+    ).
+
+read_value(data, _Name, Ctx, Value) :-
+    Ctx = ctx(R, S, MaxField, _, _),
+    ( '$multipart_read'(R, S, [], MaxField, Size, Bytes) -> true
+    ; throw_malformed
+    ),
+    ( MaxField >= 0, Size > MaxField ->
+        throw_too_large(max_field_size)
+    ; true
+    ),
+    crlf_lines(Bytes, Lines),
+    lines_to_value(Lines, Value).
+read_value(file(F), Name, Ctx, file(F, Value)) :-
+    Ctx = ctx(R, S, _, MaxFile, Sink),
+    Sink(Name, F, Out, Value),
+    once_port_reify(read_file(R, S, Out, MaxFile), Port),
+    close(Out),
+    ( Port = success -> true
+    ; remove_tmp_file(Value),
+      port_call(Port)
+    ).
+
+read_file(R, S, Out, MaxFile) :-
+    ( '$multipart_read'(R, S, Out, MaxFile, Size, _) -> true
+    ; throw_malformed
+    ),
+    ( MaxFile >= 0, Size > MaxFile ->
+        throw_too_large(max_file_size)
+    ; true
+    ).
+
+throw_malformed :-
+    throw(error(syntax_error(multipart_form_data), read_multipart_form_data/5)).
+
+throw_too_large(Limit) :-
+    throw(error(resource_error(Limit), read_multipart_form_data/5)).
+
+remove_tmp_files([]).
+remove_tmp_files([_=V|NVs]) :-
+    ( V = file(_, Value) -> remove_tmp_file(Value) ; true ),
+    remove_tmp_files(NVs).
+
+remove_tmp_file(Value) :-
+    ( Value = tmp_file(Path) ->
+        catch(delete_file(Path), _, true)
+    ; true
+    ).
+
+% Split at CRLF (as parse_line//2)
+crlf_lines(Cs, [L|Ls]) :-
+    crlf_line(Cs, L, Rest),
+    ( Rest = end -> Ls = [] ; crlf_lines(Rest, Ls) ).
+
+crlf_line([], [], end).
+crlf_line([C|Cs], L, Rest) :-
+    ( C = 0'\r, Cs = [0'\n|Cs1] ->
+        L = [], Rest = Cs1
+    ; L = [C|L1],
+      crlf_line(Cs, L1, Rest)
+    ).
+
+% ---------------------------------------------------------------------------
+
+:- trust pred '$multipart_open'(+Pending, +Length, +Boundary, -Reader)
+   :: string * int * string * int + foreign_low(prolog_multipart_open).
+:- trust pred '$multipart_next'(+Reader, +Stream, -Headers)
+   :: int * stream * term + foreign_low(prolog_multipart_next).
+:- trust pred '$multipart_read'(+Reader, +Stream, +Out, +Max, -Size, -Bytes)
+   :: int * stream * term * int * int * string
+   + foreign_low(prolog_multipart_read).
+:- trust pred '$multipart_close'(+Reader)
+   :: int + foreign_low(prolog_multipart_close).
+
+:- use_foreign_source(multipart_form_data_c).
@@ -0,0 +1,208 @@
+:- module(_, [], [assertions, datafacts]).
+
+:- doc(title, "Tests for multipart_form_data.pl").
+
+:- use_module(library(http/multipart_form_data)).
+:- use_module(library(lists), [append/3, length/2]).
+:- use_module(library(between), [between/3]).
+:- use_module(library(port_reify), [once_port_reify/2, port_call/1]).
+:- use_module(library(system), [mktemp_in_tmp/2, delete_file/1, file_exists/1]).
+:- use_module(library(stream_utils), [file_to_bytes/2, bytes_to_file/2]).
+:- use_module(engine(stream_basic), [open/3, close/1]).
+
+% ---------------------------------------------------------------------------
+
+:- export(test_parts/0).
+:- test test_parts # "Fields and files are read as with the in-memory
+   parser, and file contents are exact".
+test_parts :-
+    append("line 1\r\nline 2\n\r\n", [0, 255], Data),
+    Parts = [field("a", "hello"), file("f", "f.bin", Data), field("b", "x y")],
+    body(Parts, Body),
+    read_body(Body, [], Dic),
+    Dic = [a=A, f=file('f.bin', Bytes), b=B],
+    Bytes == Data,
+    boundary(Bd),
+    parse_multipart_form_data(Body, Bd, [a=A0, _, b=B0]),
+    A == A0, B == B0.
+
+:- export(test_block_boundary/0).
+:- test test_block_boundary # "Parts ending around the 64KB block
+   boundary (so that the delimiter is split across blocks)".
+test_block_boundary :-
+    body([], Empty), length(Empty, Overhead0),
+    body([file("f", "f", [])], Body0), length(Body0, Overhead1),
+    Prefix is Overhead1 - Overhead0 - 2, % (bytes before the data)
+    % (the first block has a leading CRLF and 65534 bytes of the
+    % stream, so that the data ends at the end of the block for Base)
+    Base is 65534 - Prefix,
+    \+ ( between(-30, 30, K),
+         Size is Base + K,
+         \+ block_case(Size) ),
+    % (several blocks)
+    block_case(200000).
+
+block_case(Size) :-
+    filler(Size, Data),
+    body([file("f", "f", Data), field("g", "end")], Body),
+    read_body(Body, [], Dic),
+    Dic = [f=file(f, Data1), g=end],
+    Data1 == Data.
+
+% Bytes that look like the end of a line
+filler(0, []) :- !.
+filler(N, [C|Cs]) :-
+    ( N mod 7 =:= 0 -> C = 0'\r ; N mod 7 =:= 1 -> C = 0'\n ; C = 0'- ),
+    N1 is N - 1,
+    filler(N1, Cs).
+
+:- export(test_near_miss/0).
+:- test test_near_miss # "Near-miss delimiters are part of the data".
+test_near_miss :-
+    boundary(Bd),
+    append(BdPrefix, [_], Bd), % (all but the last byte)
+    NearMisses = [
+        "\r\n--"||BdPrefix,
+        "\r\n-"||Bd,
+        "\n--"||Bd,
+        "\r--"||Bd,
+        "--"||Bd,
+        "\r\n--"||BdX,
+        "\r\n\r\n--"||BdPrefix
+    ],
+    append(BdPrefix, "X", BdX),
+    \+ ( member_(NM, NearMisses),
+         \+ near_miss_case(NM) ).
+
+near_miss_case(NM) :-
+    append("a", NM, Data0), append(Data0, "b", Data),
+    body([file("f", "f", Data), field("g", Data)], Body),
+    read_body(Body, [], Dic),
+    Dic = [f=file(f, Data1), g=_],
+    Data1 == Data,
+    % (the end of contents is also a near miss)
+    body([file("f", "f", NM)], Body2),
+    read_body(Body2, [], [f=file(f, NM1)]),
+    NM1 == NM.
+
+member_(X, [X|_]).
+member_(X, [_|Xs]) :- member_(X, Xs).
+
+:- export(test_truncated/0).
+:- test test_truncated # "Truncated contents raise a syntax error and
+   remove the files read so far".
+test_truncated :-
+    filler(1000, Data),
+    body([file("f", "f", Data), field("a", "v"), file("h", "h", Data)], Body),
+    length(Body, Len),
+    \+ ( between(1, 40, I),
+         Cut is (Len * I) // 41,
+         \+ truncated_case(Body, Cut, []) ),
+    % (the stream ends before the given content length)
+    Cut is Len - 20,
+    truncated_case(Body, Cut, [length(Len)]).
+
+truncated_case(Body, Cut, Opts) :-
+    length(Prefix, Cut),
+    append(Prefix, _, Body), !,
+    read_error(Prefix, Opts, E),
+    E = error(syntax_error(multipart_form_data), _),
+    no_tmp_files.
+
+:- export(test_limits/0).
+:- test test_limits # "max_field_size and max_file_size are enforced".
+test_limits :-
+    filler(100, Data),
+    body([field("a", Data)], Body1),
+    read_body(Body1, [max_field_size(100)], [a=_]),
+    read_error(Body1, [max_field_size(99)], E1),
+    E1 = error(resource_error(max_field_size), _),
+    body([file("f", "f", Data), file("g", "g", Data), field("x", "y")], Body2),
+    read_body(Body2, [max_file_size(100)], [f=_, g=_, x=y]),
+    read_error(Body2, [max_file_size(99)], E2),
+    E2 = error(resource_error(max_file_size), _),
+    no_tmp_files,
+    % (files are not limited by max_field_size)
+    read_body(Body2, [max_field_size(10)], [f=_, g=_, x=y]).
+
+:- export(test_sink_failure/0).
+:- test test_sink_failure # "If a sink fails the reader fails and the
+   files read so far are removed".
+test_sink_failure :-
+    body([file("f", "f", "x"), file("g", "g", "y")], Body),
+    \+ read_body_sink(Body, [], failing_sink, _),
+    no_tmp_files.
+
+% ---------------------------------------------------------------------------
+
+boundary("XyZ-123").
+
+% Contents for a list of parts
+body(Parts, Body) :-
+    boundary(Bd),
+    parts(Parts, Bd, Body).
+
+parts([], Bd, Body) :-
+    append("--"||Bd, "--\r\n", Body).
+parts([Part|Parts], Bd, Body) :-
+    part_header(Part, Header, Value),
+    append("--"||Bd, "\r\n"||Body1, Body),
+    append(Header, "\r\n"||Body2, Body1),
+    append(Value, "\r\n"||Body3, Body2),
+    parts(Parts, Bd, Body3).
+
+part_header(field(Name, Value), Header, Value) :-
+    append("Content-Disposition: form-data; name=\""||Name, "\"\r\n", Header).
+part_header(file(Name, FileName, Value), Header, Value) :-
+    append("Content-Disposition: form-data; name=\""||Name, "\"; filename=\""||Rest, Header),
+    append(FileName, "\"\r\nContent-Type: application/octet-stream\r\n", Rest).
+
+% Read Body from a file with the tmp_file sink (the contents of files
+% are returned as bytes)
+read_body(Body, Opts, Dic) :-
+    read_body_sink(Body, Opts, recording_sink, Dic0),
+    file_values(Dic0, Dic),
+    no_tmp_files.
+
+:- meta_predicate read_body_sink(?, ?, pred(4), ?).
+read_body_sink(Body, Opts, Sink, Dic) :-
+    mktemp_in_tmp('ciao_mptest_XXXXXX', Path),
+    bytes_to_file(Body, Path),
+    open(Path, read, S),
+    boundary(Bd),
+    once_port_reify(read_multipart_form_data(S, Bd, Opts, Sink, Dic), Port),
+    close(S),
+    delete_file(Path),
+    port_call(Port).
+
+read_error(Body, Opts, E) :-
+    catch((read_body_sink(Body, Opts, recording_sink, _), fail), E, true).
+
+file_values([], []).
+file_values([N=V|NVs], [N=V1|NVs1]) :-
+    ( V = file(F, tmp_file(Path)) ->
+        file_to_bytes(Path, Bytes),
+        delete_file(Path),
+        retract_fact(tmp_file(Path)),
+        V1 = file(F, Bytes)
+    ; V1 = V
+    ),
+    file_values(NVs, NVs1).
+
+% Temporary files (like the default sink), recorded to check that they
+% are removed
+:- data tmp_file/1.
+
+recording_sink(_Name, _FileName, Out, tmp_file(Path)) :-
+    mktemp_in_tmp('ciao_upload_XXXXXX', Path),
+    assertz_fact(tmp_file(Path)),
+    open(Path, write, Out).
+
+failing_sink(Name, FileName, Out, Value) :-
+    Name = f,
+    recording_sink(Name, FileName, Out, Value).
+
+% No recorded file exists (and forget them)
+no_tmp_files :-
+    \+ ( current_fact(tmp_file(Path)), file_exists(Path) ),
+    retractall_fact(tmp_file(_)).
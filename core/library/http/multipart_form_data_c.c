@@ -0,0 +1,375 @@
+/*
+ *  multipart_form_data_c.c
+ *
+ *  Streaming reader for multipart/form-data contents (see
+ *  multipart_form_data.pl).
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#include <string.h>
+
+#include <ciao/eng.h>
+#include <ciao/eng_gc.h>
+#include <ciao/eng_registry.h>
+#include <ciao/stream_basic.h>
+#include <ciao/io_basic.h>
+
+/* The contents are read in blocks into a buffer, where the delimiter
+   "\r\n--Boundary" is searched (Boyer-Moore-Horspool). Part data is
+   written to an output stream or collected in memory, so that the
+   memory used is bounded by the buffer size and the limits given by
+   the caller. */
+
+#define MP_MAX_BOUNDARY 200 /* (RFC 2046 allows 70) */
+#define MP_MAX_DELIM (MP_MAX_BOUNDARY + 4)
+#define MP_MAX_HEADER 16384 /* (size of the headers of a part) */
+
+typedef struct multipart_ multipart_t;
+struct multipart_ {
+  unsigned char *buf;
+  intmach_t size; /* size of buf */
+  intmach_t pos, end; /* pending data is buf[pos..end) */
+  intmach_t left; /* bytes not read yet from the stream (-1 if unknown) */
+  bool_t eof; /* no more data in the stream */
+  bool_t in_part; /* the next delimiter is not found yet */
+  bool_t done; /* the close delimiter has been read */
+  intmach_t dlen;
+  unsigned char delim[MP_MAX_DELIM]; /* "\r\n--" followed by the boundary */
+  intmach_t skip[256]; /* (shifts for the search) */
+};
+
+#define TaggedToMultipart(X) TermToPointer(multipart_t, X)
+
+/* Read more data into the buffer, moving the pending data to the
+   beginning. Return FALSE at the end of the stream. */
+static CFUN__PROTO(mp_fill, bool_t, multipart_t *mp, stream_node_t *s) {
+  intmach_t n, r;
+
+  if (mp->pos > 0) {
+    memmove(mp->buf, mp->buf + mp->pos, mp->end - mp->pos);
+    mp->end -= mp->pos;
+    mp->pos = 0;
+  }
+  if (mp->eof) return FALSE;
+  n = mp->size - mp->end;
+  if (mp->left >= 0 && mp->left < n) n = mp->left;
+  if (n == 0) {
+    if (mp->left == 0) mp->eof = TRUE;
+    return !mp->eof;
+  }
+  /* (partial reads, so that data from sockets is processed as it comes) */
+  r = CFUN__EVAL(readbytes, s, mp->buf + mp->end, n, TRUE);
+  if (r == BYTES_IO_ERROR) {
+    perror("read() in multipart_form_data");
+    UNLOCATED_EXCEPTION(ERR_resource_error(r_undefined));
+  }
+  if (r <= 0) {
+    mp->eof = TRUE;
+    return FALSE;
+  }
+  mp->end += r;
+  if (mp->left >= 0) mp->left -= r;
+  return TRUE;
+}
+
+/* Index of the first delimiter in the pending data, or -1 */
+static intmach_t mp_find(multipart_t *mp) {
+  intmach_t m = mp->dlen;
+  intmach_t i, j;
+  unsigned char *b = mp->buf;
+  unsigned char *d = mp->delim;
+
+  for (i = mp->pos; i + m <= mp->end; i += mp->skip[b[i + m - 1]]) {
+    for (j = m - 1; j >= 0 && b[i + j] == d[j]; j--) {}
+    if (j < 0) return i;
+  }
+  return -1;
+}
+
+/* Byte vector (for data read into memory) */
+typedef struct bytes_ bytes_t;
+struct bytes_ {
+  unsigned char *p;
+  intmach_t len, size;
+};
+
+static void bytes_add(bytes_t *v, unsigned char *p, intmach_t n) {
+  if (v->len + n > v->size) {
+    intmach_t size = v->size * 2;
+    if (size < v->len + n) size = v->len + n;
+    v->p = checkrealloc_ARRAY(unsigned char, v->size, size, v->p);
+    v->size = size;
+  }
+  memcpy(v->p + v->len, p, n);
+  v->len += n;
+}
+
+#define MP_OK        0
+#define MP_TRUNCATED 1 /* end of the stream before the delimiter */
+#define MP_TOO_LARGE 2 /* more than max bytes */
+
+/* Read the data up to the next delimiter (which is consumed), writing
+   it to out, adding it to v (if not NULL), or discarding it. Stop if
+   there are more than max bytes (if max >= 0). The total size is
+   stored in *size. */
+static CFUN__PROTO(mp_part, int, multipart_t *mp, stream_node_t *in,
+                   stream_node_t *out, bytes_t *v, intmach_t max,
+                   intmach_t *size) {
+  intmach_t k, n, total = 0;
+  int status;
+
+  for (;;) {
+    k = mp_find(mp);
+    if (k >= 0) {
+      n = k - mp->pos;
+      status = MP_OK;
+    } else {
+      /* (keep the bytes that may start a delimiter) */
+      n = mp->end - mp->pos - (mp->dlen - 1);
+      if (n < 0) n = 0;
+      status = MP_TRUNCATED;
+    }
+    if (max >= 0 && total + n > max) {
+      n = max + 1 - total;
+      status = MP_TOO_LARGE;
+    }
+    if (n > 0) {
+      if (out != NULL) {
+        CVOID__CALL(print_bytes, out, (char *)mp->buf + mp->pos, n);
+      } else if (v != NULL) {
+        bytes_add(v, mp->buf + mp->pos, n);
+      }
+      total += n;
+      mp->pos += n;
+    }
+    if (status == MP_OK) {
+      mp->pos += mp->dlen;
+      mp->in_part = FALSE;
+      break;
+    }
+    if (status == MP_TOO_LARGE) break;
+    if (!CFUN__EVAL(mp_fill, mp, in)) break;
+  }
+  *size = total;
+  return status;
+}
+
+/* Next byte (-1 at the end of the stream) */
+static CFUN__PROTO(mp_byte, int, multipart_t *mp, stream_node_t *s) {
+  if (mp->pos == mp->end && !CFUN__EVAL(mp_fill, mp, s)) return -1;
+  return mp->buf[mp->pos++];
+}
+
+/* --------------------------------------------------------------------------- */
+
+/* '$multipart_open'(+Pending, +Length, +Boundary, -Reader): Reader for
+   contents with Boundary, of Length bytes (-1 if unknown) where the
+   first bytes (Pending) have already been read from the stream */
+CBOOL__PROTO(prolog_multipart_open) {
+  multipart_t *mp;
+  tagged_t t, c;
+  intmach_t n, i, m;
+
+  DEREF(X(1), X(1));
+  if (!TaggedIsSmall(X(1))) CBOOL__FAIL;
+  /* Delimiter */
+  mp = checkalloc_TYPE(multipart_t);
+  memcpy(mp->delim, "\r\n--", 4);
+  m = 4;
+  DEREF(t, X(2));
+  while (TaggedIsLST(t)) {
+    DerefCar(c, t);
+    if (!TaggedIsSmall(c) || GetSmall(c) < 0 || GetSmall(c) > 255 ||
+        m == MP_MAX_DELIM) goto fail;
+    mp->delim[m++] = GetSmall(c);
+    DerefCdr(t, t);
+  }
+  if (t != atom_nil || m == 4) goto fail;
+  mp->dlen = m;
+  for (i = 0; i < 256; i++) mp->skip[i] = m;
+  for (i = 0; i < m - 1; i++) mp->skip[mp->delim[i]] = m - 1 - i;
+  /* Buffer (with a leading "\r\n", so that the first delimiter can
+     also be found in the same way) */
+  n = 0;
+  DEREF(t, X(0));
+  while (TaggedIsLST(t)) { DerefCdr(t, t); n++; }
+  if (t != atom_nil) goto fail;
+  mp->size = BULKIO_BUFSIZE;
+  if (mp->size < n + 2) mp->size = n + 2;
+  mp->buf = checkalloc_ARRAY(unsigned char, mp->size);
+  mp->buf[0] = '\r';
+  mp->buf[1] = '\n';
+  mp->pos = 0;
+  mp->end = 2;
+  DEREF(t, X(0));
+  while (TaggedIsLST(t)) {
+    DerefCar(c, t);
+    if (!TaggedIsSmall(c) || GetSmall(c) < 0 || GetSmall(c) > 255) {
+      checkdealloc_ARRAY(unsigned char, mp->size, mp->buf);
+      goto fail;
+    }
+    mp->buf[mp->end++] = GetSmall(c);
+    DerefCdr(t, t);
+  }
+  mp->left = GetSmall(X(1));
+  if (mp->left >= 0) {
+    mp->left -= n;
+    if (mp->left < 0) mp->left = 0;
+  }
+  mp->eof = FALSE;
+  mp->in_part = TRUE; /* (the preamble) */
+  mp->done = FALSE;
+  CBOOL__LASTUNIFY(PointerToTerm(mp), X(3));
+ fail:
+  checkdealloc_TYPE(multipart_t, mp);
+  CBOOL__FAIL;
+}
+
+/* '$multipart_close'(+Reader) */
+CBOOL__PROTO(prolog_multipart_close) {
+  multipart_t *mp;
+
+  DEREF(X(0), X(0));
+  mp = TaggedToMultipart(X(0));
+  checkdealloc_ARRAY(unsigned char, mp->size, mp->buf);
+  checkdealloc_TYPE(multipart_t, mp);
+  CBOOL__PROCEED;
+}
+
+/* '$multipart_next'(+Reader, +Stream, -Headers): skip to the next part
+   and read its header lines (without line terminators). Headers is
+   end_of_file after the close delimiter. Fails if the contents are
+   malformed or truncated. */
+CBOOL__PROTO(prolog_multipart_next) {
+  ERR__FUNCTOR("multipart_form_data:$multipart_next", 3);
+  multipart_t *mp;
+  stream_node_t *s;
+  int errcode, c, c2;
+  intmach_t size, len, nlines, start, i, k;
+  unsigned char *h;
+  intmach_t *ends;
+  tagged_t list, line;
+
+  DEREF(X(0), X(0));
+  mp = TaggedToMultipart(X(0));
+  s = stream_to_ptr_check(X(1), 'r', &errcode);
+  if (!s) BUILTIN_ERROR(errcode, X(1), 2);
+
+  if (mp->done) CBOOL__LASTUNIFY(GET_ATOM("end_of_file"), X(2));
+  if (mp->in_part) {
+    if (CFUN__EVAL(mp_part, mp, s, NULL, NULL, -1, &size) != MP_OK) {
+      CBOOL__FAIL;
+    }
+  }
+  /* Close delimiter, or transport padding up to the end of line */
+  c = CFUN__EVAL(mp_byte, mp, s);
+  if (c == '-') {
+    c2 = CFUN__EVAL(mp_byte, mp, s);
+    if (c2 == '-') {
+      mp->done = TRUE;
+      CBOOL__LASTUNIFY(GET_ATOM("end_of_file"), X(2));
+    }
+    CBOOL__FAIL;
+  }
+  for (i = 0; c != '\n'; i++) {
+    if (c < 0 || i == MP_MAX_HEADER) CBOOL__FAIL;
+    c = CFUN__EVAL(mp_byte, mp, s);
+  }
+  mp->in_part = TRUE;
+
+  /* Header lines, up to an empty line */
+  h = checkalloc_ARRAY(unsigned char, MP_MAX_HEADER);
+  ends = checkalloc_ARRAY(intmach_t, MP_MAX_HEADER);
+  len = 0;
+  nlines = 0;
+  start = 0;
+  for (;;) {
+    c = CFUN__EVAL(mp_byte, mp, s);
+    if (c < 0 || len == MP_MAX_HEADER) goto fail;
+    if (c == '\n') {
+      k = len;
+      if (k > start && h[k-1] == '\r') k--;
+      if (k == start) break; /* (empty line) */
+      ends[nlines++] = k;
+      start = len = k;
+    } else {
+      h[len++] = c;
+    }
+  }
+
+  TEST_HEAP_OVERFLOW(G->heap_top, (len+nlines)*LSTCELLS*sizeof(tagged_t)+CONTPAD, 3);
+  list = atom_nil;
+  for (k = nlines; k-- > 0; ) {
+    start = (k == 0 ? 0 : ends[k-1]);
+    line = atom_nil;
+    for (i = ends[k]; i-- > start; ) {
+      MakeLST(line, MakeSmall(h[i]), line);
+    }
+    MakeLST(list, line, list);
+  }
+  checkdealloc_ARRAY(intmach_t, MP_MAX_HEADER, ends);
+  checkdealloc_ARRAY(unsigned char, MP_MAX_HEADER, h);
+  CBOOL__LASTUNIFY(list, X(2));
+ fail:
+  checkdealloc_ARRAY(intmach_t, MP_MAX_HEADER, ends);
+  checkdealloc_ARRAY(unsigned char, MP_MAX_HEADER, h);
+  CBOOL__FAIL;
+}
+
+/* '$multipart_read'(+Reader, +Stream, +Out, +Max, -Size, -Bytes): read
+   the data of the current part (of Size bytes), writing it to the
+   stream Out, or into Bytes if Out is []. If there are more than Max
+   bytes (Max >= 0) it stops with Size = Max+1. Fails if the contents
+   are truncated. */
+CBOOL__PROTO(prolog_multipart_read) {
+  ERR__FUNCTOR("multipart_form_data:$multipart_read", 6);
+  multipart_t *mp;
+  stream_node_t *s, *out;
+  int errcode, status;
+  intmach_t max, size, i;
+  bytes_t v;
+  tagged_t list;
+
+  DEREF(X(0), X(0));
+  mp = TaggedToMultipart(X(0));
+  s = stream_to_ptr_check(X(1), 'r', &errcode);
+  if (!s) BUILTIN_ERROR(errcode, X(1), 2);
+  DEREF(X(2), X(2));
+  if (X(2) == atom_nil) {
+    out = NULL;
+  } else {
+    out = stream_to_ptr_check(X(2), 'w', &errcode);
+    if (!out) BUILTIN_ERROR(errcode, X(2), 3);
+  }
+  DEREF(X(3), X(3));
+  if (!TaggedIsSmall(X(3))) BUILTIN_ERROR(ERR_type_error(integer), X(3), 4);
+  max = GetSmall(X(3));
+  if (!mp->in_part) CBOOL__FAIL;
+
+  if (out != NULL) {
+    status = CFUN__EVAL(mp_part, mp, s, out, NULL, max, &size);
+    if (status == MP_TRUNCATED) CBOOL__FAIL;
+    TEST_HEAP_OVERFLOW(G->heap_top, 4*sizeof(tagged_t)+CONTPAD, 6);
+    CBOOL__UNIFY(IntmachToTagged(size), X(4));
+    CBOOL__LASTUNIFY(atom_nil, X(5));
+  }
+
+  v.size = 1024;
+  v.len = 0;
+  v.p = checkalloc_ARRAY(unsigned char, v.size);
+  status = CFUN__EVAL(mp_part, mp, s, NULL, &v, max, &size);
+  if (status == MP_TRUNCATED) {
+    checkdealloc_ARRAY(unsigned char, v.size, v.p);
+    CBOOL__FAIL;
+  }
+  if (status == MP_TOO_LARGE) v.len = 0;
+  TEST_HEAP_OVERFLOW(G->heap_top, (v.len*LSTCELLS+4)*sizeof(tagged_t)+CONTPAD, 6);
+  list = atom_nil;
+  for (i = v.len; i-- > 0; ) {
+    MakeLST(list, MakeSmall(v.p[i]), list);
+  }
+  checkdealloc_ARRAY(unsigned char, v.size, v.p);
+  CBOOL__UNIFY(IntmachToTagged(size), X(4));
+  CBOOL__LASTUNIFY(list, X(5));
+}
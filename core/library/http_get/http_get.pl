@@ -1,4 +1,5 @@
-:- module(http_get, [http_get/2], [assertions]).
+:- module(http_get, [http_get/2, http_get/3, http_close_connections/0],
+    [assertions, isomodes, datafacts]).
 
 :- doc(title, "Simple HTTP Download").
 
@@ -9,37 +10,89 @@
    downloading files from the Web. It supports HTTP, HTTPS, and FTP
    protocols.
 
-   As backend the module uses the command line tool @tt{curl} or
-   @tt{wget}, depending on the one currently available on the system.
-   Proxy are supported through the environment variables,
+   HTTP URLs are fetched with a native HTTP/1.1 client built on
+   @lib{sockets}, which is loaded on first use. Connections are kept alive and reused for later
+   requests to the same host (at most @tt{8} idle connections per
+   host are kept), response bodies (either with a content length or
+   chunked) are written to the output channel as they arrive, and
+   redirections are followed. Requests can be made concurrently from
+   several threads (see @lib{concurrency}).
+
+   For other protocols (and for output channels not supported by the
+   native client) the module uses as backend the command line tool
+   @tt{curl} or @tt{wget}, depending on the one currently available on
+   the system. Proxy are supported through the environment variables,
    @tt{http_proxy}, @tt{https_proxy}, @tt{ftp_proxy}, and
    @tt{no_proxy}. Refer to the manual page of @tt{curl} or @tt{wget}
    for more information about how setting those variables.").
 
 :- doc(bug, "Optionally, link against libcurl so that the dependency
    with external command is not needed").
+:- doc(bug, "The native client does not support HTTPS nor proxies
+   (HTTPS URLs use the external command).").
+:- doc(bug, "The timeout does not apply to establishing the
+   connection.").
 
 :- use_module(library(process)).
 :- use_module(library(process/process_channel)).
+:- use_module(library(http/url), [url_info/2]).
 
 :- pred http_get(URL, OutputChanel) : (atom(URL), process_channel(Output))  #
      "downloads form the internet the file at the address @var{URL} and
       output it in the channel @var{Output}.".
 
 http_get(URL, Output):-
+    http_get(URL, Output, []).
+
+:- pred http_get(URL, Output, Opts) : (atom(URL), process_channel(Output))
+   # "Like @pred{http_get/2}, with the following options (only for
+      the native client):
+      @begin{itemize}
+      @item @tt{timeout(Ms)}: maximum time in milliseconds waiting
+        for each part of the response (no timeout by default).
+      @item @tt{max_redirects(N)}: maximum number of redirections
+        followed (@tt{10} by default).
+      @item @tt{status(Code)}: unify @var{Code} with the status code
+        of the (last) response.
+      @item @tt{headers(Headers)}: unify @var{Headers} with the header
+        fields of the (last) response, as a list of
+        @tt{Name-Value}, where @var{Name} is an atom in lowercase and
+        @var{Value} a string.
+      @end{itemize}".
+
+http_get(URL, Output, Opts) :-
+    url_info(URL, http(Host, Port, URIStr)),
+    native_channel(Output),
+    native_client,
+    !,
+    http_native_get(http(Host, Port, URIStr), Output, Opts, Result),
+    ( Result = command(URL2) -> command_get(URL2, Output) ; true ).
+http_get(URL, Output, _Opts):-
+    command_get(URL, Output).
+
+% ---------------------------------------------------------------------------
+% External commands
+
+command_get(URL, Output):-
     detect_command(curl), !, curl(URL, Output).
-http_get(URL, Output):-
+command_get(URL, Output):-
     detect_command(wget), !, wget(URL, Output).
-http_get(_, _) :- 
+command_get(_, _) :-
     throw(error(http_get/2, neither_wget_nor_curl_found)).
 
-% Silently fail if the command cannot be found in the path or does not
-% answer successfully to '--version' option.
+:- data detected/2. % (cached, Cmd is found or not)
+
 detect_command(Cmd):-
-    catch(detect_command_(Cmd), _E, fail).
+    ( current_fact(detected(Cmd, Found)) -> true
+    ; ( detect_command_(Cmd) -> Found = yes ; Found = no ),
+      assertz_fact(detected(Cmd, Found))
+    ),
+    Found = yes.
 
+% Silently fail if the command cannot be found in the path or does not
+% answer successfully to '--version' option.
 detect_command_(Cmd):-
-    process_call(path(Cmd), ['--version'], [stdout(null), stderr(null), status(0)]).
+    catch(process_call(path(Cmd), ['--version'], [stdout(null), stderr(null), status(0)]), _E, fail).
 
 curl(URL, Output):-
     % '-L' is needed to follow HTTP redirects
@@ -47,3 +100,37 @@ curl(URL, Output):-
 
 wget(URL, Output):-
     process_call(path(wget), ['-q', URL, '-O', '-'], [stdout(Output)]).
+
+% ---------------------------------------------------------------------------
+% Native client (see http_get_native.pl)
+
+% (channels supported by the native client)
+native_channel(default).
+native_channel(null).
+native_channel(stream(_)).
+native_channel(file(_)).
+native_channel(file_append(_)).
+native_channel(string(_)).
+native_channel(line(_)).
+native_channel(atmlist(_)).
+
+% (hooks defined by the native client)
+:- multifile http_native_get/4.
+:- multifile http_native_close/0.
+
+:- use_module(engine(runtime_control), [current_module/1]).
+:- use_module(library(http_get/http_get_holder), [do_use_module/1]).
+
+% The native client is loaded on first use (it fails if it cannot be
+% loaded, e.g., when foreign code is not available)
+native_client :-
+    current_module(http_get_native), !.
+native_client :-
+    catch(http_get_holder:do_use_module(library(http_get/http_get_native)), _, fail),
+    current_module(http_get_native).
+
+:- pred http_close_connections # "Close all the idle connections kept
+   alive by the native HTTP client.".
+
+http_close_connections :-
+    ( current_module(http_get_native) -> http_native_close ; true ).
@@ -0,0 +1,2 @@
+:- module(_, [], [dynmod_holder]).
+% (Holder for the native HTTP client, loaded on demand by http_get.pl)
@@ -0,0 +1,407 @@
+:- module(_, [], [assertions, isomodes, datafacts]).
+
+:- doc(title, "Native HTTP/1.1 client").
+
+:- doc(author, "The Ciao Development Team").
+
+:- doc(module, "This module implements the native HTTP/1.1 client
+   used by @lib{http_get} for @tt{http://} URLs. It is loaded by
+   @lib{http_get} when it is first needed, so that programs using
+   @lib{http_get} (like the builder) do not depend statically on the
+   foreign code of @lib{sockets}.").
+
+:- use_module(library(lists), [member/2, append/3, length/2]).
+:- use_module(library(aggregates), [findall/3]).
+:- use_module(engine(stream_basic)).
+:- use_module(library(stream_utils), [write_bytes/2, read_bytes/3]).
+:- use_module(library(sockets)).
+:- use_module(library(http/url), [url_info_relative/3]).
+:- use_module(library(process/process_channel), [bytes_to_channel/2]).
+
+% ---------------------------------------------------------------------------
+% Requests
+
+% (hook for http_get/3)
+:- multifile http_native_get/4.
+http_native_get(URLTerm, Output, Opts, Result) :-
+    ( member_opt(max_redirects(MaxRedirects), Opts) -> true ; MaxRedirects = 10 ),
+    http_get_(URLTerm, Output, Opts, MaxRedirects, Result).
+
+member_opt(X, [Y|Ys]) :- ( X = Y -> true ; member_opt(X, Ys) ).
+
+% Result is command(URL) if the response is a redirection to a URL
+% that is not handled by the native client, or done otherwise.
+http_get_(URLTerm, Output, Opts, Redirects, Result) :-
+    ( member_opt(timeout(Timeout), Opts) -> true ; Timeout = off ),
+    http_request(URLTerm, Timeout, Output, Redirects, Code, Headers, Next),
+    ( Next = redirect(Location) ->
+        ( url_info_relative(Location, URLTerm, URLTerm2) ->
+            Redirects1 is Redirects - 1,
+            http_get_(URLTerm2, Output, Opts, Redirects1, Result)
+        ; % (not an HTTP URL)
+          atom_codes(URL2, Location),
+          Result = command(URL2)
+        )
+    ; ( member_opt(status(Code0), Opts) -> Code0 = Code ; true ),
+      ( member_opt(headers(Headers0), Opts) -> Headers0 = Headers ; true ),
+      Result = done
+    ).
+
+% Send a GET request and receive the response. Next is redirect(URL)
+% if the response is a redirection that must be followed (and its
+% body is discarded), or done otherwise.
+http_request(http(Host, Port, URIStr), Timeout, Output, Redirects, Code, Headers, Next) :-
+    request_bytes(Host, Port, URIStr, Request),
+    get_conn(Host, Port, Stream, Reused),
+    catch(transaction(Stream, Timeout, Request, Output, Redirects, Code, Headers, Next, Reusable),
+          E, true),
+    ( var(E) ->
+        ( Reusable = yes -> release_conn(Host, Port, Stream)
+        ; close_conn(Stream)
+        )
+    ; close_conn(Stream),
+      ( E = conn_closed, Reused = yes ->
+          % (a kept alive connection was closed by the server, retry)
+          http_request(http(Host, Port, URIStr), Timeout, Output, Redirects, Code, Headers, Next)
+      ; E = conn_closed ->
+          throw(error(system_error(connection_closed(Host, Port)), http_get/3))
+      ; throw(E)
+      )
+    ).
+
+request_bytes(Host, Port, URIStr, Request) :-
+    atom_codes(Host, HostStr),
+    ( Port = 80 -> HostPort = HostStr
+    ; number_codes(Port, PortStr),
+      append(HostStr, [0':|PortStr], HostPort)
+    ),
+    append("GET ", URIStr, R0),
+    append(R0, " HTTP/1.1\r\nHost: "||HostPort, R1),
+    append(R1, "\r\nUser-Agent: Ciao\r\nAccept-Encoding: identity\r\n\r\n", Request).
+
+transaction(Stream, Timeout, Request, Output, Redirects, Code, Headers, Next, Reusable) :-
+    socket_timeout(Stream, Timeout),
+    ( socket_sendall(Stream, Request) -> true ; throw(conn_closed) ),
+    recv_head(Stream, Head, Buf),
+    parse_head(Head, Version, Code, Headers),
+    framing(Code, Headers, Framing),
+    ( redirect_code(Code), Redirects > 0,
+      member(location-Location, Headers) ->
+        Next = redirect(Location),
+        copy_body(Framing, Stream, Buf, Rest, null, null)
+    ; Next = done,
+      output_body(Output, Framing, Stream, Buf, Rest)
+    ),
+    ( Rest = [], Framing \= close, keep_alive(Version, Headers) ->
+        Reusable = yes
+    ; Reusable = no
+    ).
+
+redirect_code(301).
+redirect_code(302).
+redirect_code(303).
+redirect_code(307).
+redirect_code(308).
+
+keep_alive(Version, Headers) :-
+    ( member(connection-Value, Headers) ->
+        lowercase(Value, Value1),
+        ( Value1 = "close" -> fail
+        ; Value1 = "keep-alive" -> true
+        ; Version = '1.1'
+        )
+    ; Version = '1.1'
+    ).
+
+% How the body is delimited (RFC 7230, section 3.3.3)
+framing(Code, _, none) :- ( Code < 200 ; Code = 204 ; Code = 304 ), !.
+framing(_, Headers, chunked) :-
+    member('transfer-encoding'-Value, Headers),
+    lowercase(Value, Value1),
+    append(_, "chunked", Value1), !.
+framing(_, Headers, length(N)) :-
+    member('content-length'-Value, Headers),
+    catch(number_codes(N, Value), _, fail), integer(N), N >= 0, !.
+framing(_, _, close).
+
+% ---------------------------------------------------------------------------
+% Output channels (bodies are written to streams as they arrive)
+
+output_body(default, Framing, Stream, Buf, Rest) :- !,
+    copy_body(Framing, Stream, Buf, Rest, stream(user_output), _).
+output_body(null, Framing, Stream, Buf, Rest) :- !,
+    copy_body(Framing, Stream, Buf, Rest, null, _).
+output_body(stream(S), Framing, Stream, Buf, Rest) :- !,
+    copy_body(Framing, Stream, Buf, Rest, stream(S), _).
+output_body(file(File), Framing, Stream, Buf, Rest) :- !,
+    output_body_file(File, write, Framing, Stream, Buf, Rest).
+output_body(file_append(File), Framing, Stream, Buf, Rest) :- !,
+    output_body_file(File, append, Framing, Stream, Buf, Rest).
+output_body(Channel, Framing, Stream, Buf, Rest) :-
+    copy_body(Framing, Stream, Buf, Rest, mem(Bytes), mem([])),
+    bytes_to_channel(Bytes, Channel).
+
+output_body_file(File, Mode, Framing, Stream, Buf, Rest) :-
+    open(File, Mode, S),
+    catch(copy_body(Framing, Stream, Buf, Rest, stream(S), _), E,
+          (close(S), throw(E))),
+    close(S).
+
+% ---------------------------------------------------------------------------
+% Receive the response
+
+recv_bytes(Stream, Bytes) :-
+    socket_recv(Stream, Bytes, N),
+    N > 0, !.
+recv_bytes(_, _) :-
+    throw(conn_closed).
+
+% Head are the bytes before the first empty line, Buf the bytes after
+% it. Each received byte is scanned once (Pend are the bytes of a
+% possible end of the head that are not in Head yet).
+recv_head(Stream, Head, Buf) :-
+    recv_bytes(Stream, Bytes),
+    scan_head(Bytes, [], Stream, Head, Buf).
+
+scan_head([], Pend, Stream, Head, Buf) :-
+    catch(recv_bytes(Stream, Bytes), conn_closed, premature_end),
+    scan_head(Bytes, Pend, Stream, Head, Buf).
+scan_head([C|Cs], Pend, Stream, Head, Buf) :-
+    ( head_end(Pend, C, Pend1) ->
+        ( Pend1 = done -> Head = [], Buf = Cs
+        ; scan_head(Cs, Pend1, Stream, Head, Buf)
+        )
+    ; Pend = [] ->
+        Head = [C|Head1],
+        scan_head(Cs, [], Stream, Head1, Buf)
+    ; append(Pend, Head1, Head),
+      scan_head([C|Cs], [], Stream, Head1, Buf)
+    ).
+
+head_end([], 13, [13]).
+head_end([], 10, [10]).
+head_end([13], 10, [13,10]).
+head_end([13,10], 13, [13,10,13]).
+head_end([13,10], 10, done).
+head_end([13,10,13], 10, done).
+head_end([10], 10, done).
+
+premature_end :-
+    throw(error(system_error(premature_end_of_response), http_get/3)).
+
+copy_body(none, _Stream, Buf, Buf, Sink, Sink).
+copy_body(length(N), Stream, Buf, Rest, Sink0, Sink) :-
+    copy_length(N, Stream, Buf, Rest, Sink0, Sink).
+copy_body(chunked, Stream, Buf, Rest, Sink0, Sink) :-
+    copy_chunked(Stream, Buf, Rest, Sink0, Sink).
+copy_body(close, Stream, Buf, [], Sink0, Sink) :-
+    copy_all(Stream, Buf, Sink0, Sink).
+
+% Copy N bytes, first from Buf and then from the stream (Rest are the
+% bytes left in Buf)
+copy_length(0, _Stream, Buf, Buf, Sink, Sink) :- !.
+copy_length(N, Stream, [], [], Sink0, Sink) :- !,
+    copy_stream_length(N, Stream, Sink0, Sink).
+copy_length(N, Stream, Buf, Rest, Sink0, Sink) :-
+    take(Sink0, N, Buf, Buf1, N1, Sink1),
+    copy_length(N1, Stream, Buf1, Rest, Sink1, Sink).
+
+% (bytes read from the stream at once)
+block_size(65536).
+
+copy_stream_length(0, _Stream, Sink, Sink) :- !.
+copy_stream_length(N, Stream, Sink0, Sink) :-
+    block_size(B),
+    ( N < B -> K = N ; K = B ),
+    read_bytes(Stream, K, Bytes),
+    length(Bytes, K1),
+    ( K1 < K -> premature_end ; true ),
+    put_bytes(Sink0, Bytes, Sink1),
+    N1 is N - K,
+    copy_stream_length(N1, Stream, Sink1, Sink).
+
+% Take at most N bytes from Buf into the sink (N1 bytes are missing).
+take(Sink0, N, Buf, Buf1, N1, Sink) :-
+    length(Buf, K),
+    ( K =< N ->
+        put_bytes(Sink0, Buf, Sink), Buf1 = [], N1 is N - K
+    ; split_at(N, Buf, Bytes, Buf1),
+      put_bytes(Sink0, Bytes, Sink), N1 = 0
+    ).
+
+split_at(0, Buf, [], Buf) :- !.
+split_at(N, [X|Buf], [X|Xs], Buf1) :-
+    N0 is N - 1,
+    split_at(N0, Buf, Xs, Buf1).
+
+% Sinks are null, stream(S), or mem(Tail) (where Tail is the open tail
+% of a list of bytes).
+put_bytes(null, _, null).
+put_bytes(stream(S), Bytes, stream(S)) :-
+    write_bytes(S, Bytes).
+put_bytes(mem(Tail), Bytes, mem(Tail1)) :-
+    append(Bytes, Tail1, Tail).
+
+copy_chunked(Stream, Buf0, Rest, Sink0, Sink) :-
+    recv_line(Stream, Buf0, Line, Buf1),
+    ( chunk_size(Line, N) -> true
+    ; throw(error(system_error(bad_chunk_size), http_get/3))
+    ),
+    ( N = 0 ->
+        skip_trailers(Stream, Buf1, Rest),
+        Sink = Sink0
+    ; copy_length(N, Stream, Buf1, Buf2, Sink0, Sink1),
+      recv_line(Stream, Buf2, _, Buf3),
+      copy_chunked(Stream, Buf3, Rest, Sink1, Sink)
+    ).
+
+skip_trailers(Stream, Buf0, Rest) :-
+    recv_line(Stream, Buf0, Line, Buf1),
+    ( Line = [] -> Rest = Buf1
+    ; skip_trailers(Stream, Buf1, Rest)
+    ).
+
+% Line is the next line, first from Buf and then from the stream (byte
+% by byte, since lines of chunked bodies are short)
+recv_line(_Stream, Buf0, Line, Buf) :-
+    split_line(Buf0, Line0, Buf1), !,
+    Line = Line0, Buf = Buf1.
+recv_line(Stream, Buf0, Line, []) :-
+    stream_line(Stream, Bytes),
+    append(Buf0, Bytes, Line0),
+    ( append(Line1, [13], Line0) -> Line = Line1 ; Line = Line0 ).
+
+split_line([13,10|Buf], [], Buf) :- !.
+split_line([10|Buf], [], Buf) :- !.
+split_line([C|Cs], [C|Line], Buf) :- split_line(Cs, Line, Buf).
+
+% (bytes before the next new line character)
+stream_line(Stream, Bytes) :-
+    read_bytes(Stream, 1, Bs),
+    ( Bs = [10] -> Bytes = []
+    ; Bs = [C] -> Bytes = [C|Bytes1], stream_line(Stream, Bytes1)
+    ; premature_end
+    ).
+
+% (hexadecimal, ignoring chunk extensions)
+chunk_size([C|Cs], N) :-
+    hex_digit(C, D),
+    chunk_size_(Cs, D, N).
+
+chunk_size_([C|Cs], N0, N) :-
+    hex_digit(C, D), !,
+    N1 is N0 * 16 + D,
+    chunk_size_(Cs, N1, N).
+chunk_size_(_, N, N).
+
+hex_digit(C, D) :- C >= 0'0, C =< 0'9, !, D is C - 0'0.
+hex_digit(C, D) :- C >= 0'a, C =< 0'f, !, D is C - 0'a + 10.
+hex_digit(C, D) :- C >= 0'A, C =< 0'F, D is C - 0'A + 10.
+
+copy_all(Stream, Buf, Sink0, Sink) :-
+    put_bytes(Sink0, Buf, Sink1),
+    copy_stream_all(Stream, Sink1, Sink).
+
+copy_stream_all(Stream, Sink0, Sink) :-
+    block_size(B),
+    read_bytes(Stream, B, Bytes),
+    put_bytes(Sink0, Bytes, Sink1),
+    length(Bytes, K),
+    ( K < B -> Sink = Sink1 % (end of stream)
+    ; copy_stream_all(Stream, Sink1, Sink)
+    ).
+
+% ---------------------------------------------------------------------------
+% Parse the status line and header fields
+
+parse_head(Head, Version, Code, Headers) :-
+    split_lines(Head, [StatusLine|Lines]),
+    ( status_line(StatusLine, Version, Code) -> true
+    ; throw(error(system_error(bad_status_line), http_get/3))
+    ),
+    header_fields(Lines, Headers).
+
+split_lines([], []) :- !.
+split_lines(Bytes, [Line|Lines]) :-
+    ( split_line(Bytes, Line0, Bytes1) -> Line = Line0
+    ; Line = Bytes, Bytes1 = []
+    ),
+    split_lines(Bytes1, Lines).
+
+status_line("HTTP/"||Cs, Version, Code) :-
+    append(VersionStr, [0'\s|Cs1], Cs), !,
+    atom_codes(Version, VersionStr),
+    Cs1 = [D1,D2,D3|_],
+    number_codes(Code, [D1,D2,D3]).
+
+header_fields([], []).
+header_fields([Line|Lines], Headers) :-
+    ( append(NameStr, [0':|Value0], Line) ->
+        lowercase(NameStr, NameStr1),
+        atom_codes(Name, NameStr1),
+        trim_spaces(Value0, Value),
+        Headers = [Name-Value|Headers0]
+    ; Headers = Headers0 % (ignore malformed fields)
+    ),
+    header_fields(Lines, Headers0).
+
+trim_spaces([C|Cs], Ys) :- space(C), !, trim_spaces(Cs, Ys).
+trim_spaces(Cs, Ys) :- trim_tr_spaces(Cs, Ys).
+
+trim_tr_spaces([], []).
+trim_tr_spaces([C|Cs], Ys) :-
+    trim_tr_spaces(Cs, Ys0),
+    ( Ys0 = [], space(C) -> Ys = [] ; Ys = [C|Ys0] ).
+
+space(0'\s).
+space(0'\t).
+
+lowercase([], []).
+lowercase([C|Cs], [D|Ds]) :-
+    ( C >= 0'A, C =< 0'Z -> D is C + 0'a - 0'A ; D = C ),
+    lowercase(Cs, Ds).
+
+% ---------------------------------------------------------------------------
+% Connection pool (shared by all threads)
+
+:- concurrent idle_conn/3. % idle_conn(Host, Port, Stream)
+
+max_idle_per_host(8).
+
+get_conn(Host, Port, Stream, Reused) :-
+    ( retract_fact_nb(idle_conn(Host, Port, Stream0)) ->
+        ( conn_alive(Stream0) ->
+            Stream = Stream0, Reused = yes
+        ; close_conn(Stream0),
+          get_conn(Host, Port, Stream, Reused)
+        )
+    ; connect_to_socket(Host, Port, Stream),
+      Reused = no
+    ).
+
+% An idle connection is usable if there is nothing to read (otherwise
+% it has been closed by the server)
+conn_alive(Stream) :-
+    catch(select_socket(_, _, 0, [Stream], Ready), _, fail),
+    Ready = [].
+
+release_conn(Host, Port, Stream) :-
+    findall(S, current_fact_nb(idle_conn(Host, Port, S)), Ss),
+    length(Ss, N),
+    max_idle_per_host(Max),
+    ( N < Max ->
+        assertz_fact(idle_conn(Host, Port, Stream))
+    ; close_conn(Stream)
+    ).
+
+close_conn(Stream) :-
+    catch(close(Stream), _, true).
+
+% (hook for http_close_connections/0)
+:- multifile http_native_close/0.
+http_native_close :-
+    ( retract_fact_nb(idle_conn(_, _, Stream)) ->
+        close_conn(Stream),
+        http_native_close
+    ; true
+    ).
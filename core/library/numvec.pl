@@ -0,0 +1,121 @@
+:- module(_, [], [assertions, regtypes, isomodes]).
+
+:- doc(title, "Packed numeric vectors").
+
+:- doc(author, "The Ciao Development Team").
+
+:- doc(stability, devel).
+
+:- doc(module, "@cindex{numeric vector} @cindex{unboxed array}
+
+   This module implements homogeneous vectors of numbers stored
+   unboxed in a single heap object (a blob), with constant time access
+   to elements. Compared to lists of numbers they need much less
+   memory (e.g., 8 bytes per @tt{float64} element instead of 40) and
+   they can be passed to foreign code without conversion: the C
+   function receives a pointer to the vector data, which it can read
+   or fill in place (see the @tt{c_int8_vec}, ..., @tt{c_double_vec}
+   types in @lib{foreign_interface_properties}).
+
+@begin{verbatim}
+?- list_to_numvec(float64, [1.0, 2.5, 3.0], V),
+   numvec_get(V, 1, X), numvec_length(V, N).
+
+X = 2.5,
+N = 3,
+V = ... ?
+@end{verbatim}
+
+   Vectors are ordinary (ground) terms: they can be unified, compared,
+   copied, and asserted. The supported element types are
+   @tt{int8}, @tt{int16}, @tt{int32}, @tt{int64}, and @tt{float64}.
+
+   Note that vectors filled in place by foreign code are destructively
+   updated (the changes are not undone on backtracking), so this
+   should only be done on vectors that are not shared (e.g., just
+   created with @pred{numvec_new/3}).
+").
+
+:- use_module(engine(internals), [
+    '$numvec_new'/3,
+    '$list_to_numvec'/3,
+    '$numvec_to_list'/2,
+    '$numvec_get'/3
+]).
+
+% ---------------------------------------------------------------------------
+
+:- export(numvec/1).
+:- regtype numvec(V) # "@var{V} is a packed numeric vector.".
+
+numvec('$numvec'(Type, N, Data)) :-
+    numvec_elem_type(Type), int(N), int(Data).
+
+:- export(numvec_elem_type/1).
+:- regtype numvec_elem_type(T) # "@var{T} is the type of the elements
+   of a vector.".
+
+numvec_elem_type(int8).
+numvec_elem_type(int16).
+numvec_elem_type(int32).
+numvec_elem_type(int64).
+numvec_elem_type(float64).
+
+% ---------------------------------------------------------------------------
+
+:- export(numvec_new/3).
+:- pred numvec_new(+Type, +N, -V) :: numvec_elem_type * int * numvec
+   # "@var{V} is a vector of @var{N} elements of type @var{Type}, all
+     of them zero.".
+
+numvec_new(Type, N, V) :-
+    check_type(Type, numvec_new/3),
+    ( integer(N), N >= 0 -> true
+    ; throw(error(type_error(integer, N), numvec_new/3))
+    ),
+    '$numvec_new'(Type, N, V).
+
+:- export(list_to_numvec/3).
+:- pred list_to_numvec(+Type, +List, -V) :: numvec_elem_type * list(num) * numvec
+   # "@var{V} is a vector of type @var{Type} with the elements of
+     @var{List}. Integers out of the range of @var{Type} raise a
+     representation error.".
+
+list_to_numvec(Type, List, V) :-
+    check_type(Type, list_to_numvec/3),
+    '$list_to_numvec'(Type, List, V).
+
+:- export(numvec_to_list/2).
+:- pred numvec_to_list(+V, -List) :: numvec * list(num)
+   # "@var{List} is the list of elements of @var{V}.".
+
+numvec_to_list(V, List) :-
+    ( '$numvec_to_list'(V, List0) -> List = List0
+    ; throw(error(type_error(numvec, V), numvec_to_list/2))
+    ).
+
+:- export(numvec_get/3).
+:- pred numvec_get(+V, +I, -X) :: numvec * int * num
+   # "@var{X} is the element of @var{V} at (zero-based) index @var{I}.
+     Fails if @var{I} is out of range.".
+
+numvec_get(V, I, X) :-
+    '$numvec_get'(V, I, X).
+
+:- export(numvec_length/2).
+:- pred numvec_length(+V, -N) :: numvec * int
+   # "@var{N} is the number of elements of @var{V}.".
+
+numvec_length('$numvec'(_, N, _), N).
+
+:- export(numvec_type/2).
+:- pred numvec_type(+V, -Type) :: numvec * numvec_elem_type
+   # "@var{Type} is the type of the elements of @var{V}.".
+
+numvec_type('$numvec'(Type, _, _), Type).
+
+check_type(Type, _) :- atom(Type), numvec_elem_type(Type), !.
+check_type(Type, PI) :- var(Type), !,
+    throw(error(instantiation_error, PI)).
+check_type(Type, PI) :-
+    throw(error(domain_error(numvec_elem_type, Type), PI)).
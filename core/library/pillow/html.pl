@@ -1,7 +1,8 @@
 :- module(html, [
     canonic_html_term/1, canonic_xml_term/1, html_term/1,
-    output_html/1, html2terms/2, xml2terms/2, html_template/3
-    ], [assertions,isomodes,dcg]).
+    output_html/1, output_html/2, html2terms/2, xml2terms/2,
+    html2terms/3, xml2terms/3, html_parse_option/1, html_template/3
+    ], [assertions,isomodes,dcg,foreign_interface]).
 
 :- doc(title, "HTML/XML parser and generator").
 
@@ -11,7 +12,13 @@
 :- doc(author, "The Ciao Development Team").
 
 :- doc(module, "This module implements predicates for
-   @concept{HTML}/@concept{XML} generation and parsing.").
+   @concept{HTML}/@concept{XML} generation and parsing.
+
+   Parsing is done by a native tokenizer (which falls back to the
+   grammar in this module for templates and for inputs that are not
+   lists of character codes). Generation writes directly to the
+   output stream in @pred{output_html/1} and @pred{output_html/2},
+   without building the whole string first.").
 
 :- doc(appendix, "The code uses input from from L. Naish's forms and
    Francisco Bueno's previous Chat interface.  Other people who have
@@ -20,7 +27,8 @@
 
 :- include(library(pillow/ops)).
 % 
-:- use_module(library(stream_utils), [write_string/1]).
+:- use_module(engine(stream_basic), [current_output/1, stream/1]).
+:- use_module(library(stream_utils), [write_string/2]).
 :- use_module(library(strings), [whitespace/2, whitespace0/2, string/3]).
 :- use_module(library(lists), [reverse/2, list_lookup/4]).
 
@@ -304,10 +312,18 @@ html_expansion(it(X),i(X)).
 
 :- pred output_html(+html_term).
 
-% Translate html format and send to current output
 output_html(F) :-
-    html_str(F,T,[]),
-    write_string(T).
+    current_output(S),
+    output_html(S, F).
+
+:- doc(output_html(Stream, HTMLTerm), "Outputs @var{HTMLTerm},
+   interpreted as an @pred{html_term/1}, to @var{Stream}. The code is
+   written as it is generated.").
+
+:- pred output_html(+stream, +html_term).
+
+output_html(S, F) :-
+    html_str(F, '$html_stream'(S), _).
 
 % HTML <-> Terms translation
 
@@ -322,10 +338,22 @@ output_html(F) :-
 
 % TODO: rename by html_term_string/2 and switch arg order?
 html2terms(Chars, Terms) :-
+    html2terms(Chars, Terms, []).
+
+:- doc(html2terms(String,Terms,Opts), "Like @pred{html2terms/2}, with
+   options @var{Opts} for parsing (see @pred{html_parse_option/1}).").
+
+:- pred html2terms(-string,+html_term,+list(html_parse_option)).
+:- pred html2terms(+string,?canonic_html_term,+list(html_parse_option)).
+
+html2terms(Chars, Terms, _Opts) :-
     var(Chars), !,
     html_str(Terms, Chars, []).
-html2terms(Chars, Terms) :-
-    parse_html([], Terms, [], Chars, []).
+html2terms(Chars, Terms, Opts) :-
+    parse_flags(Opts, 0, Flags),
+    ( html_parse_codes(Flags, Chars, Terms0) -> Terms = Terms0
+    ; parse_html([], Terms, [], Chars, [])
+    ).
 
 % XML <-> Terms translation
 
@@ -339,136 +367,196 @@ html2terms(Chars, Terms) :-
     # "Translates XML code into a structured XML-term.".
 
 xml2terms(Chars, Terms) :-
+    xml2terms(Chars, Terms, []).
+
+:- doc(xml2terms(String,Terms,Opts), "Like @pred{xml2terms/2}, with
+   options @var{Opts} for parsing (see @pred{html_parse_option/1};
+   @tt{recover} is ignored).").
+
+:- pred xml2terms(-string,+html_term,+list(html_parse_option)).
+:- pred xml2terms(+string,?canonic_xml_term,+list(html_parse_option)).
+
+xml2terms(Chars, Terms, _Opts) :-
     var(Chars), !,
     html_str(Terms, Chars, []). % Uses the same as HTML
-xml2terms(Chars, Terms) :-
-    parse_xml([], Terms, [], Chars, []).
+xml2terms(Chars, Terms, Opts) :-
+    parse_flags(Opts, 1, Flags0),
+    Flags is Flags0 /\ \4,
+    ( html_parse_codes(Flags, Chars, Terms0) -> Terms = Terms0
+    ; parse_xml([], Terms, [], Chars, [])
+    ).
+
+:- prop html_parse_option(Opt) + regtype
+   # "@var{Opt} is an option for parsing HTML or XML code.".
+:- doc(html_parse_option/1, "
+   @begin{description}
+   @item{@tt{decode_entities}} decode character references
+     (@tt{&amp;amp;}, @tt{&amp;#233;}, etc.) in text and attribute
+     values. Characters are encoded as UTF-8. Only the predefined
+     entities are recognized in XML. References that are not
+     recognized are kept.
+   @item{@tt{recover}} recover from malformed HTML as browsers do:
+     the contents of @tt{script} and @tt{style} are text, void
+     elements (such as @tt{br} or @tt{img}) are never environments,
+     some end tags are implied (e.g., a @tt{li} element is closed by
+     the next @tt{li}, and a @tt{p} element by the next block),
+     unclosed elements are closed by the end tag of an enclosing
+     element or by the end of the input, and other end tags are
+     ignored.
+   @end{description}
+").
+
+html_parse_option(decode_entities).
+html_parse_option(recover).
+
+% Flags for html_parse_codes/3 (see html_c.c)
+parse_flags([], F, F).
+parse_flags([Opt|Opts], F0, F) :-
+    parse_flag(Opt, F1),
+    F2 is F0 \/ F1,
+    parse_flags(Opts, F2, F).
+
+parse_flag(decode_entities, 2) :- !.
+parse_flag(recover, 4) :- !.
+parse_flag(Opt, _) :-
+    throw(error(domain_error(html_parse_option, Opt), html2terms/3)).
+
+:- trust pred html_parse_codes(+Flags, +Chars, -Terms)
+   :: int * string * list + foreign_low(prolog_html_parse_codes).
+:- trust pred html_put_codes(+Stream, +Mode, +Codes, -Rest)
+   :: stream * int * string * term + foreign_low(prolog_html_put_codes).
+
+:- use_foreign_source(html_c).
 
 % ---------------------------------------------------------------------------
 %% Terms -> HTML/XML translation %%
 
+% The output of html_str//1 is either a list of character codes (as
+% usual in DCGs) or '$html_stream'(S), in which case the code is
+% written directly to stream S (see emit//1).
+
 html_str(X) --> {var(X)}, !,
-    "<b>**Warning: free variable**</b>".
+    emit("<b>**Warning: free variable**</b>").
 html_str(T) --> {html_expansion(T,NT)}, !,
     html_str(NT).
-html_str(start) --> !, "<html>".
-html_str(end)   --> !, "</html>".
-html_str(--)  --> !, newline, "<hr>", newline.
-html_str(\\) --> !, "<br>", newline.
-html_str($)  --> !, newline, "<p>".
+html_str(start) --> !, emit("<html>").
+html_str(end)   --> !, emit("</html>").
+html_str(--)  --> !, newline, emit("<hr>"), newline.
+html_str(\\) --> !, emit("<br>"), newline.
+html_str($)  --> !, newline, emit("<p>").
 html_str(comment(C)) --> !,
-    "<!-- ",atomic_or_string(C)," -->",
+    emit("<!-- "),atomic_or_string(C),emit(" -->"),
     newline.
 html_str(declare(C)) --> !,
-    "<!",atomic_or_string(C),">",
+    emit("<!"),atomic_or_string(C),emit(">"),
     newline.
 % XML declaration
 html_str(xmldecl(Atts)) --> !,
-    "<?xml",
+    emit("<?xml"),
     html_atts(Atts),
-    "?>".
+    emit("?>").
 html_str(image(Addr)) --> !,
-    "<img",
+    emit("<img"),
     html_atts([src=Addr]),
-    ">".
+    emit(">").
 html_str(image(Addr,Atts)) --> !,
-    "<img",
+    emit("<img"),
     html_atts([src=Addr|Atts]),
-    ">".
+    emit(">").
 html_str(ref(Addr,Text)) --> !,
-    "<a",
+    emit("<a"),
     html_atts([href=Addr]),
-    ">",
+    emit(">"),
     html_str(Text),
-    "</a>".
+    emit("</a>").
 html_str(label(Label,Text)) --> !,
-    "<a",
+    emit("<a"),
     html_atts([name=Label]),
-    ">",
+    emit(">"),
     html_str(Text),
-    "</a>".
+    emit("</a>").
 html_str(heading(L,X)) -->
     {number_codes(L,[N])}, !,
     html_env([0'h,N],X),
     newline.
 html_str(itemize(L)) --> !,
-    "<ul>",
+    emit("<ul>"),
     newline,
     html_items(L),
-    "</ul>".
+    emit("</ul>").
 html_str(enumerate(L)) --> !,
-    "<ol>",
+    emit("<ol>"),
     newline,
     html_items(L),
-    "</ol>".
+    emit("</ol>").
 html_str(description(L)) --> !,
-    "<dl>",
+    emit("<dl>"),
     newline,
     html_descriptions(L),
-    "</dl>".
+    emit("</dl>").
 html_str(preformatted(X)) --> !,
-    "<pre>",
+    emit("<pre>"),
     newline,
     preformatted_lines(X),
-    "</pre>".
+    emit("</pre>").
 html_str(entity(Name)) --> !,
-    "&",atomic_or_string(Name),";".
+    emit("&"),atomic_or_string(Name),emit(";").
 % Forms
 html_str(start_form) --> !,
-    "<form",
+    emit("<form"),
     html_atts([method="POST"]),
-    ">",
+    emit(">"),
     newline.
 html_str(start_form(Addr)) --> !, 
-    "<form",
+    emit("<form"),
     html_atts([method="POST", action=Addr]),
-    ">",
+    emit(">"),
     newline.
 html_str(start_form(Addr,Atts)) --> !, 
-    "<form",
+    emit("<form"),
     html_atts([action=Addr|Atts]),
-    ">",
+    emit(">"),
     newline.
 html_str(end_form) --> !,
-    "</form>", newline.
+    emit("</form>"), newline.
 html_str(checkbox(Name,on)) --> !,
-    "<input",
+    emit("<input"),
     html_atts([name=Name,type=checkbox,checked]),
-    ">".
+    emit(">").
 html_str(checkbox(Name,_)) --> !,
-    "<input",
+    emit("<input"),
     html_atts([name=Name,type=checkbox]),
-    ">".
+    emit(">").
 html_str(radio(Name,Value,Value)) --> !,
-    "<input",
+    emit("<input"),
     html_atts([name=Name,type=radio,value=Value,checked]),
-    ">".
+    emit(">").
 html_str(radio(Name,Value,_)) --> !,
-    "<input",
+    emit("<input"),
     html_atts([name=Name,type=radio,value=Value]),
-    ">".
+    emit(">").
 html_str(input(Type,Atts)) --> !,
-    "<input",
+    emit("<input"),
     html_atts([type=Type|Atts]),
-    ">".
+    emit(">").
 html_str(textinput(Name,Atts,Text)) --> !,
-    "<textarea",
+    emit("<textarea"),
     html_atts([name=Name|Atts]),
-    ">",
+    emit(">"),
     textarea_data(Text),
-    "</textarea>".
+    emit("</textarea>").
 html_str(menu(Name,Atts,Items)) --> !,
-    "<select",
+    emit("<select"),
     html_atts([name=Name|Atts]),
-    ">", newline,
+    emit(">"), newline,
     html_options(Items),
-    "</select>".
+    emit("</select>").
 html_str(option(Name,Val,Options)) --> !,
-    "<select",
+    emit("<select"),
     html_atts([name=Name]),
-    ">", newline,
+    emit(">"), newline,
     html_one_option(Options, Val),
-    "</select>".
+    emit("</select>").
 html_str(prolog_term(T)) --> !,
     prolog_term(T).
 % Constructs
@@ -476,53 +564,80 @@ html_str(verbatim(Text)) --> !,
     html_quoted(Text).
 html_str(nl) --> !, newline. % Just to improve HTML source readability
 html_str([]) --> !.
+html_str([C|Cs]) --> {integer(C), C >= 0, C =< 255}, !,
+    html_text([C|Cs], Rest),
+    html_str(Rest).
 html_str([E|Es]) --> !,
     html_str(E),
     html_str(Es).
 html_str(begin(T)) --> {atom(T), atom_codes(T,TS)}, !,
-    "<",string(TS),">".
+    emit("<"),emit(TS),emit(">").
 html_str(begin(T,Atts)) --> {atom(T), atom_codes(T,TS)}, !,
-    "<",string(TS),
+    emit("<"),emit(TS),
     html_atts(Atts),
-    ">".
+    emit(">").
 html_str(end(T)) --> {atom(T), atom_codes(T,TS)}, !,
-    "</",string(TS),">".
+    emit("</"),emit(TS),emit(">").
 html_str(env(Name,Atts,Text)) --> {atom(Name), atom_codes(Name,NS)}, !,
     html_env_atts(NS,Atts,Text).
 html_str(T$Atts) --> {atom(T), atom_codes(T,TS)}, !,
-    "<",string(TS),
+    emit("<"),emit(TS),
     html_atts(Atts),
-    ">".
+    emit(">").
 % XML empty element
 html_str(elem(N,Atts)) --> {atom(N), atom_codes(N,NS)}, !,
-    "<",string(NS),
+    emit("<"),emit(NS),
     html_atts(Atts),
-    "/>".
+    emit("/>").
 html_str(F) --> {F =.. [Env,X], atom_codes(Env, ES)}, !,
     html_env(ES,X).
 html_str(F) --> {F =.. [Env,Atts,X], atom_codes(Env, ES)}, !,
     html_env_atts(ES,Atts,X).
-html_str(C) --> {integer(C), C >= 0, C =< 255}, !, [C].
+html_str(C) --> {integer(C), C >= 0, C =< 255}, !, emit([C]).
 html_str(T) -->
     prolog_term(T).
 
-newline --> [10].
+% Output of codes, to a list or to a stream
+
+emit(Cs) --> stream_put(0, Cs, Rest), !, emit_rest(Rest).
+emit(Cs) --> string(Cs).
+
+% (elements that are not character codes)
+emit_rest([], S, S) :- !.
+emit_rest(Cs, S, S) :- S = '$html_stream'(St), write_string(St, Cs).
+
+% Write the longest prefix of Cs made of character codes to the
+% output stream, escaped as indicated by Mode (see html_c.c)
+stream_put(Mode, Cs, Rest, S0, S) :-
+    nonvar(S0), S0 = '$html_stream'(St),
+    S = S0,
+    html_put_codes(St, Mode, Cs, Rest).
+
+% (text run of a string)
+html_text(Cs, Rest) --> stream_put(0, Cs, Rest), !.
+html_text([C|Cs], Rest) --> {integer(C), C >= 0, C =< 255}, !,
+    [C],
+    html_text(Cs, Rest).
+html_text(Rest, Rest) --> [].
+
+newline --> emit("\n").
 
 html_atts([]) --> [].
 html_atts([A|As]) -->
-    " ",
+    emit(" "),
     html_att(A),
     html_atts(As).
 
 html_att(A=V) --> {atom_codes(A,AS)}, !,
-    string(AS),"=""",html_quoted_quote(V),"""".
+    emit(AS),emit("="""),html_quoted_quote(V),emit("""").
 html_att(A) -->  {atom_codes(A,AS)},
-    string(AS).
+    emit(AS).
 
 html_quoted_quote(T) -->
     { atomic(T), \+ T = "" -> name(T,TS) ; TS = T },
     html_quoted_quote_chars(TS).
 
+html_quoted_quote_chars(Cs) --> stream_put(2, Cs, Rest), !, emit_rest(Rest).
 html_quoted_quote_chars([]) --> [].
 html_quoted_quote_chars([C|T]) -->
     html_quoted_quote_char(C),
@@ -532,22 +647,22 @@ html_quoted_quote_char(0'") --> !, "&quot;".
 html_quoted_quote_char(C)   --> [C].
 
 html_env(E,I) -->
-    "<",string(E),">",
+    emit("<"),emit(E),emit(">"),
     html_str(I),
-    "</",string(E),">".
+    emit("</"),emit(E),emit(">").
 
 html_env_atts(E,Atts,I) -->
-    "<",string(E),
+    emit("<"),emit(E),
     html_atts(Atts),
-    ">",
+    emit(">"),
     html_str(I),
-    "</",string(E),">".
+    emit("</"),emit(E),emit(">").
 
 html_items([]) --> [].
 html_items([It|Its]) -->
-    "<li>",
+    emit("<li>"),
     html_str(It),
-    "</li>",
+    emit("</li>"),
     newline,
     html_items(Its).
 
@@ -557,15 +672,15 @@ html_descriptions([D|Ds]) -->
     html_descriptions(Ds).
 
 html_description((T,D)) --> !,
-    "<dt>",
+    emit("<dt>"),
     html_str(T),
-    "</dt>",
+    emit("</dt>"),
     newline,
     html_description(D).
 html_description(D) -->
-    "<dd>",
+    emit("<dd>"),
     html_str(D),
-    "</dd>",
+    emit("</dd>"),
     newline.
 
 preformatted_lines([]) --> [].
@@ -581,25 +696,26 @@ html_options([Op|Ops]) -->
     html_options(Ops).
 
 html_option($Op) --> !,
-    "<option selected>",html_quoted(Op),"</option>".
+    emit("<option selected>"),html_quoted(Op),emit("</option>").
 html_option(Op) -->
-    "<option>",html_quoted(Op),"</option>".
+    emit("<option>"),html_quoted(Op),emit("</option>").
 
 html_one_option([], _) --> [].
 html_one_option([Op|Ops], Sel) -->
-    "<option",
+    emit("<option"),
     html_one_option_sel(Op, Sel),
-    ">",html_quoted(Op),"</option>",
+    emit(">"),html_quoted(Op),emit("</option>"),
     newline,
     html_one_option(Ops, Sel).
 
-html_one_option_sel(Op, Op) --> !, " selected".
+html_one_option_sel(Op, Op) --> !, emit(" selected").
 html_one_option_sel(_, _) --> "".
 
 html_quoted(T) -->
     {atomic(T) -> name(T,TS) ; TS = T},
     html_quoted_chars(TS).
 
+html_quoted_chars(Cs) --> stream_put(1, Cs, Rest), !, emit_rest(Rest).
 html_quoted_chars([]) --> [].
 html_quoted_chars([C|T]) -->
     html_quoted_char(C),
@@ -613,16 +729,16 @@ html_quoted_char(0'\n)--> !, "<br>".
 html_quoted_char(C)   --> [C].
 
 prolog_term(V) -->
-    {var(V)}, !, "_".
+    {var(V)}, !, emit("_").
 prolog_term(T) -->
     {functor(T,F,A), atom_codes(F,FS)},
-    string(FS), prolog_term_maybe_args(A,T).
+    emit(FS), prolog_term_maybe_args(A,T).
 
 prolog_term_maybe_args(0,_) --> !, "".
 prolog_term_maybe_args(A,T) -->
-    "(",
+    emit("("),
     prolog_term_args(1,A,T),
-    ")".
+    emit(")").
 
 prolog_term_args(N, N, T) --> !,
     {arg(N,T,A)},
@@ -630,18 +746,28 @@ prolog_term_args(N, N, T) --> !,
 prolog_term_args(N, M, T) -->
     {arg(N,T,A)},
     prolog_term(A),
-    ",",
+    emit(","),
     {N1 is N+1},
     prolog_term_args(N1,M,T).
 
 textarea_data('$empty') --> [], !.
 textarea_data(X) -->
     {atomic(X), name(X,S)}, !,
-    string(S).
+    emit(S).
 textarea_data(L) -->
-    html_lines(L), !.
+    {html_lines(L)}, !,
+    emit_lines(L).
 textarea_data(S) -->
-    string(S).
+    emit(S).
+
+% (a list of lines)
+html_lines([]).
+html_lines([L|Ls]) :- list(L), html_lines(Ls).
+
+emit_lines([]) --> [].
+emit_lines([L|Ls]) -->
+    emit(L), emit([13,10]),
+    emit_lines(Ls).
 
 % ---------------------------------------------------------------------------
 
@@ -968,9 +1094,9 @@ xml_tag_char(0'-) --> "-".
 
 atomic_or_string(X) -->
     { atomic(X), name(X,S) }, !,
-    string(S).
+    emit(S).
 atomic_or_string(S) -->
-    string(S).
+    emit(S).
 
 loupalpha(C) --> loalpha(C), !.
 loupalpha(C) --> upalpha(CU), { C is CU+0'a-0'A }.
@@ -980,17 +1106,3 @@ loalpha(C) --> [C], {C >= 0'a, C =< 0'z}.
 upalpha(C) --> [C], {C >= 0'A, C =< 0'Z}.
 
 digit(C) --> [C], {C >= 0'0, C =< 0'9}.
-
-html_crlf --> [13,10], !.
-html_crlf --> [10].
-
-html_line([]) -->
-    html_crlf, !.
-html_line([X|T]) -->
-    [X],
-    html_line(T).
-
-html_lines([L|Ls]) -->
-    html_line(L), !,
-    html_lines(Ls).
-html_lines([]) --> "".
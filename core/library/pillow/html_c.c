@@ -0,0 +1,1000 @@
+/*
+ *  html_c.c
+ *
+ *  Native HTML/XML tokenizer and serializer (see html.pl).
+ *
+ *  See Copyright Notice in ciaoengine.pl
+ */
+
+#include <string.h>
+
+#include <ciao/eng.h>
+#include <ciao/eng_gc.h>
+#include <ciao/eng_registry.h>
+#include <ciao/stream_basic.h>
+#include <ciao/io_basic.h>
+
+/* Parser flags (see parse_flags/3 in html.pl) */
+#define HTML_XML     1 /* XML syntax (otherwise HTML) */
+#define HTML_DECODE  2 /* decode character references */
+#define HTML_RECOVER 4 /* tolerant HTML recovery */
+
+#define NONE ((size_t)-1)
+
+/* --------------------------------------------------------------------------- */
+/* Parse tree */
+
+/* The parser mimics the DCG in html.pl: a stack of items, where open
+   tags are closed (as environments) by their end tags. Strings are
+   stored in a pool of codes and names in a pool of chars. The terms
+   are built at the end in a single pass over the heap. */
+
+typedef enum {
+  N_TEXT,    /* text (string) */
+  N_COMMENT, /* comment(string) */
+  N_DECLARE, /* declare(string) */
+  N_TAG,     /* Tag$Atts (open tag) */
+  N_ENV,     /* env(Tag,Atts,Items) */
+  N_ELEM,    /* elem(Tag,Atts) */
+  N_XMLDECL  /* xmldecl(Atts) */
+} node_kind_t;
+
+typedef struct node_ node_t;
+struct node_ {
+  node_kind_t kind;
+  bool_t final; /* (added to the building order) */
+  size_t name; /* tag name (in names) */
+  size_t str, len; /* string (in codes) */
+  size_t atts, natts; /* attributes (in atts) */
+  size_t kids, nkids; /* items of N_ENV (in kids) */
+  tagged_t term;
+};
+
+typedef struct att_ att_t;
+struct att_ {
+  size_t name; /* (in names) */
+  bool_t has_value;
+  size_t str, len; /* value (in codes) */
+};
+
+/* Attribute token (offsets in the input) */
+typedef struct tok_att_ tok_att_t;
+struct tok_att_ {
+  size_t name, name_len;
+  bool_t has_value;
+  size_t val, val_len;
+  int quote; /* quote char of the value (or 0) */
+};
+
+typedef enum {
+  U_END, U_COMMENT, U_DECLARE, U_TAG, U_ELEM, U_XMLDECL
+} unit_kind_t;
+
+/* Markup unit (offsets in the input) */
+typedef struct unit_ unit_t;
+struct unit_ {
+  unit_kind_t kind;
+  size_t a, len; /* tag name or string */
+  size_t natts; /* (in tok_atts) */
+};
+
+typedef struct hp_ hp_t;
+struct hp_ {
+  int flags;
+  int *s; /* input codes */
+  size_t n;
+  size_t raw; /* open script/style node (with HTML_RECOVER) or NONE */
+  tagged_t f_eq, f_comment, f_declare, f_dollar, f_elem, f_xmldecl, f_env;
+#define HP_ARRAY(Type, Arr) Type *Arr; size_t Arr##_n; size_t Arr##_size
+  HP_ARRAY(node_t, nodes);
+  HP_ARRAY(size_t, stack); /* parse stack */
+  HP_ARRAY(size_t, kids);
+  HP_ARRAY(size_t, order); /* nodes in building order */
+  HP_ARRAY(att_t, atts);
+  HP_ARRAY(tok_att_t, tok_atts);
+  HP_ARRAY(int, codes);
+  HP_ARRAY(char, names);
+#undef HP_ARRAY
+};
+
+#define HP_INIT(P, Type, Arr, Size) ({ \
+  (P)->Arr##_size = (Size); \
+  (P)->Arr##_n = 0; \
+  (P)->Arr = checkalloc_ARRAY(Type, (P)->Arr##_size); \
+})
+
+#define HP_FREE(P, Type, Arr) \
+  checkdealloc_ARRAY(Type, (P)->Arr##_size, (P)->Arr)
+
+/* Make room for N more elements */
+#define HP_RESERVE(P, Type, Arr, N) ({ \
+  if ((P)->Arr##_n + (N) > (P)->Arr##_size) { \
+    size_t size_ = (P)->Arr##_size; \
+    while ((P)->Arr##_n + (N) > size_) size_ *= 2; \
+    (P)->Arr = checkrealloc_ARRAY(Type, (P)->Arr##_size, size_, (P)->Arr); \
+    (P)->Arr##_size = size_; \
+  } \
+})
+
+static void hp_init(hp_t *p) {
+  HP_INIT(p, node_t, nodes, 256);
+  HP_INIT(p, size_t, stack, 64);
+  HP_INIT(p, size_t, kids, 256);
+  HP_INIT(p, size_t, order, 256);
+  HP_INIT(p, att_t, atts, 64);
+  HP_INIT(p, tok_att_t, tok_atts, 16);
+  HP_INIT(p, int, codes, 4096);
+  HP_INIT(p, char, names, 1024);
+  p->raw = NONE;
+  p->f_eq = deffunctor("=", 2);
+  p->f_comment = deffunctor("comment", 1);
+  p->f_declare = deffunctor("declare", 1);
+  p->f_dollar = deffunctor("$", 2);
+  p->f_elem = deffunctor("elem", 2);
+  p->f_xmldecl = deffunctor("xmldecl", 1);
+  p->f_env = deffunctor("env", 3);
+}
+
+static void hp_free(hp_t *p) {
+  HP_FREE(p, node_t, nodes);
+  HP_FREE(p, size_t, stack);
+  HP_FREE(p, size_t, kids);
+  HP_FREE(p, size_t, order);
+  HP_FREE(p, att_t, atts);
+  HP_FREE(p, tok_att_t, tok_atts);
+  HP_FREE(p, int, codes);
+  HP_FREE(p, char, names);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Character classes (as in html.pl) */
+
+static inline bool_t is_ws(int c) {
+  return c == 10 || c == 13 || c == 32 || c == 9;
+}
+
+static inline bool_t is_alpha(int c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static inline bool_t is_digit(int c) {
+  return c >= '0' && c <= '9';
+}
+
+static inline int to_lower(int c) {
+  return (c >= 'A' && c <= 'Z') ? c + 'a' - 'A' : c;
+}
+
+static inline size_t skip_ws(hp_t *p, size_t i) {
+  while (i < p->n && is_ws(p->s[i])) i++;
+  return i;
+}
+
+/* Tag name at i (html_tag//1 or xml_tag//1). Returns its end or NONE */
+static size_t tag_name(hp_t *p, size_t i) {
+  int c;
+  if (i >= p->n) return NONE;
+  c = p->s[i];
+  if (p->flags & HTML_XML) {
+    if (!(is_alpha(c) || c == '_' || c == ':')) return NONE;
+    for (i++; i < p->n; i++) {
+      c = p->s[i];
+      if (!(is_alpha(c) || is_digit(c) ||
+            c == '_' || c == ':' || c == '.' || c == '-')) break;
+    }
+  } else {
+    if (!is_alpha(c)) return NONE;
+    for (i++; i < p->n; i++) {
+      c = p->s[i];
+      if (!(is_alpha(c) || is_digit(c) || c == '.' || c == '-')) break;
+    }
+  }
+  return i;
+}
+
+/* Is s[i..] the (ASCII) string lit? */
+static inline bool_t looking_at(hp_t *p, size_t i, const char *lit) {
+  for (; *lit != 0; lit++, i++) {
+    if (i >= p->n || p->s[i] != *lit) return FALSE;
+  }
+  return TRUE;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Markup units */
+
+static tok_att_t *tok_att(hp_t *p, size_t k) {
+  HP_RESERVE(p, tok_att_t, tok_atts, k + 1 - p->tok_atts_n);
+  if (p->tok_atts_n < k + 1) p->tok_atts_n = k + 1;
+  return &p->tok_atts[k];
+}
+
+/* Quoted value at i (opening quote). Returns its end or NONE */
+static size_t quoted_value(hp_t *p, size_t i, tok_att_t *a) {
+  int q = p->s[i];
+  size_t j;
+  for (j = i + 1; j < p->n; j++) {
+    if (p->s[j] == q) {
+      a->has_value = TRUE;
+      a->val = i + 1;
+      a->val_len = j - (i + 1);
+      a->quote = q;
+      return j + 1;
+    }
+  }
+  return NONE;
+}
+
+/* HTML attributes and end of tag (html_tag_atts//2, whitespace0, ">").
+   Returns the end of the tag or NONE */
+static size_t html_atts(hp_t *p, size_t i, size_t *natts) {
+  size_t j, k, q, r, w, v, e;
+  tok_att_t *a;
+  int c;
+
+  *natts = 0;
+  for (;;) {
+    j = skip_ws(p, i);
+    if (j < p->n && p->s[j] == '>') return j + 1;
+    if (j == i || j >= p->n) return NONE;
+    if (p->s[j] == '_') return NONE; /* (template variable) */
+    k = tag_name(p, j);
+    if (k == NONE) return NONE;
+    a = tok_att(p, *natts);
+    a->name = j;
+    a->name_len = k - j;
+    a->has_value = FALSE;
+    a->quote = 0;
+    i = k;
+    /* html_opt_value//3 */
+    q = skip_ws(p, k);
+    if (q < p->n && p->s[q] == '=') {
+      r = q + 1;
+      w = skip_ws(p, r) - r;
+      v = r + w;
+      e = NONE;
+      if (v < p->n) {
+        c = p->s[v];
+        if (c == '"' || c == '\'') {
+          e = quoted_value(p, v, a);
+        } else if (c != '_') { /* (lax value) */
+          for (e = v; e < p->n && p->s[e] != '>' && p->s[e] > 32; e++);
+          a->has_value = TRUE;
+          a->val = v;
+          a->val_len = e - v;
+        }
+      } else { /* (empty lax value) */
+        e = v;
+        a->has_value = TRUE;
+        a->val = v;
+        a->val_len = 0;
+      }
+      if (e == NONE && w > 0) { /* (empty value, before the last blank) */
+        e = v - 1;
+        a->has_value = TRUE;
+        a->val = e;
+        a->val_len = 0;
+      }
+      if (e != NONE) i = e;
+    }
+    (*natts)++;
+  }
+}
+
+/* End of an XML tag (after the attributes) */
+typedef enum { X_DECL, X_TAG } xml_end_t;
+
+/* XML attributes and end of tag (xml_tag_atts//2, whitespace0,
+   end). This backtracks like the DCG, where xml_bad_value//1 takes
+   the shortest value for which the rest of the tag can be
+   parsed. Returns the end of the tag or NONE */
+static size_t xml_atts(hp_t *p, size_t i, xml_end_t end, size_t k0,
+                       size_t *natts, bool_t *elem) {
+  size_t j, k, u, r, w, kk, v, e, res;
+  tok_att_t *a;
+  int c;
+
+  /* (no more attributes) */
+  j = skip_ws(p, i);
+  if (end == X_DECL) {
+    if (looking_at(p, j, "?>")) { *natts = k0; return j + 2; }
+  } else if (j < p->n && p->s[j] == '/') {
+    if (looking_at(p, j + 1, ">")) { *natts = k0; *elem = TRUE; return j + 2; }
+  } else if (j < p->n && p->s[j] == '>') {
+    *natts = k0; *elem = FALSE; return j + 1;
+  }
+  /* (one more attribute) */
+  if (j == i) return NONE;
+  k = tag_name(p, j);
+  if (k == NONE) return NONE;
+  u = skip_ws(p, k);
+  if (u >= p->n || p->s[u] != '=') return NONE;
+  r = u + 1;
+  w = skip_ws(p, r) - r;
+  for (kk = w + 1; kk-- > 0; ) {
+    v = r + kk;
+    a = tok_att(p, k0);
+    a->name = j;
+    a->name_len = k - j;
+    c = v < p->n ? p->s[v] : -1;
+    if (c == '_') continue; /* (template variable) */
+    if (c == '"' || c == '\'') {
+      e = quoted_value(p, v, a);
+      if (e == NONE) continue;
+      res = xml_atts(p, e, end, k0 + 1, natts, elem);
+      if (res != NONE) return res;
+      continue;
+    }
+    for (e = v; e <= p->n; e++) { /* (xml_bad_value//1) */
+      res = xml_atts(p, e, end, k0 + 1, natts, elem);
+      if (res != NONE) {
+        a = tok_att(p, k0); /* (may have moved) */
+        a->has_value = TRUE;
+        a->val = v;
+        a->val_len = e - v;
+        a->quote = 0;
+        return res;
+      }
+    }
+  }
+  return NONE;
+}
+
+/* Markup unit after '<' at i (html_unit//3 or xml_unit//3). Returns
+   its end or NONE */
+static size_t markup_unit(hp_t *p, size_t i, unit_t *u) {
+  size_t j, k;
+  bool_t elem;
+
+  if (i >= p->n) return NONE;
+  if (p->s[i] == '/') { /* end tag */
+    k = tag_name(p, i + 1);
+    if (k == NONE) return NONE;
+    j = skip_ws(p, k);
+    if (j >= p->n || p->s[j] != '>') return NONE;
+    u->kind = U_END;
+    u->a = i + 1;
+    u->len = k - (i + 1);
+    return j + 1;
+  }
+  if (looking_at(p, i, "!--")) { /* comment */
+    for (j = i + 3; j + 2 < p->n; j++) {
+      if (looking_at(p, j, "-->")) {
+        u->kind = U_COMMENT;
+        u->a = i + 3;
+        u->len = j - (i + 3);
+        return j + 3;
+      }
+    }
+  }
+  if (p->s[i] == '!') { /* declaration */
+    for (j = i + 1; j < p->n; j++) {
+      if (p->s[j] == '>') {
+        u->kind = U_DECLARE;
+        u->a = i + 1;
+        u->len = j - (i + 1);
+        return j + 1;
+      }
+    }
+    return NONE;
+  }
+  if (!(p->flags & HTML_XML)) {
+    k = tag_name(p, i);
+    if (k == NONE) return NONE;
+    j = html_atts(p, k, &u->natts);
+    if (j == NONE) return NONE;
+    u->kind = U_TAG;
+    u->a = i;
+    u->len = k - i;
+    return j;
+  }
+  if (looking_at(p, i, "?xml")) {
+    j = xml_atts(p, i + 4, X_DECL, 0, &u->natts, &elem);
+    if (j == NONE) return NONE;
+    u->kind = U_XMLDECL;
+    return j;
+  }
+  k = tag_name(p, i);
+  if (k == NONE) return NONE;
+  j = xml_atts(p, k, X_TAG, 0, &u->natts, &elem);
+  if (j == NONE) return NONE;
+  u->kind = elem ? U_ELEM : U_TAG;
+  u->a = i;
+  u->len = k - i;
+  return j;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Strings and names */
+
+typedef struct entity_ entity_t;
+struct entity_ {
+  const char *name;
+  int code;
+};
+
+/* (the first ones are the XML predefined entities) */
+#define XML_ENTITIES 5
+static const entity_t entities[] = {
+  {"amp", '&'}, {"lt", '<'}, {"gt", '>'}, {"quot", '"'}, {"apos", '\''},
+  {"nbsp", 160}, {"iexcl", 161}, {"cent", 162}, {"pound", 163},
+  {"yen", 165}, {"sect", 167}, {"copy", 169}, {"laquo", 171},
+  {"reg", 174}, {"deg", 176}, {"plusmn", 177}, {"micro", 181},
+  {"para", 182}, {"middot", 183}, {"raquo", 187}, {"iquest", 191},
+  {"times", 215}, {"divide", 247}, {"ndash", 0x2013}, {"mdash", 0x2014},
+  {"lsquo", 0x2018}, {"rsquo", 0x2019}, {"ldquo", 0x201c},
+  {"rdquo", 0x201d}, {"bull", 0x2022}, {"hellip", 0x2026},
+  {"euro", 0x20ac}, {"trade", 0x2122}, {"larr", 0x2190},
+  {"rarr", 0x2192}, {NULL, 0}
+};
+
+static void put_code(hp_t *p, int c) {
+  HP_RESERVE(p, int, codes, 1);
+  p->codes[p->codes_n++] = c;
+}
+
+/* Put c as UTF-8 (codes are bytes) */
+static void put_utf8(hp_t *p, int c) {
+  if (c < 0x80) {
+    put_code(p, c);
+  } else if (c < 0x800) {
+    put_code(p, 0xc0 | (c >> 6));
+    put_code(p, 0x80 | (c & 0x3f));
+  } else if (c < 0x10000) {
+    put_code(p, 0xe0 | (c >> 12));
+    put_code(p, 0x80 | ((c >> 6) & 0x3f));
+    put_code(p, 0x80 | (c & 0x3f));
+  } else {
+    put_code(p, 0xf0 | (c >> 18));
+    put_code(p, 0x80 | ((c >> 12) & 0x3f));
+    put_code(p, 0x80 | ((c >> 6) & 0x3f));
+    put_code(p, 0x80 | (c & 0x3f));
+  }
+}
+
+/* Decode the character reference at s[i] = '&' (before end). Returns
+   its end or NONE */
+static size_t put_entity(hp_t *p, size_t i, size_t end) {
+  size_t j, k;
+  int c, base, d;
+  char name[16];
+  const entity_t *e;
+
+  j = i + 1;
+  if (j < end && p->s[j] == '#') { /* numeric */
+    j++;
+    base = 10;
+    if (j < end && (p->s[j] == 'x' || p->s[j] == 'X')) { base = 16; j++; }
+    c = 0;
+    for (k = j; k < end && k - j < 8; k++) {
+      d = p->s[k];
+      if (is_digit(d)) d -= '0';
+      else if (base == 16 && d >= 'a' && d <= 'f') d -= 'a' - 10;
+      else if (base == 16 && d >= 'A' && d <= 'F') d -= 'A' - 10;
+      else break;
+      c = c * base + d;
+    }
+    if (k == j || k >= end || p->s[k] != ';') return NONE;
+    if (c == 0 || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff)) return NONE;
+    put_utf8(p, c);
+    return k + 1;
+  }
+  for (k = j; k < end && k - j < sizeof(name) - 1 &&
+         (is_alpha(p->s[k]) || is_digit(p->s[k])); k++) {
+    name[k - j] = (char)p->s[k];
+  }
+  if (k == j || k >= end || p->s[k] != ';') return NONE;
+  name[k - j] = 0;
+  for (e = entities; e->name != NULL; e++) {
+    if ((p->flags & HTML_XML) && e - entities >= XML_ENTITIES) break;
+    if (strcmp(e->name, name) == 0) {
+      put_utf8(p, e->code);
+      return k + 1;
+    }
+  }
+  return NONE;
+}
+
+/* Copy s[i..i+len) to the pool of codes. With HTML_DECODE character
+   references are decoded, otherwise '"' is written as "&quot;" in
+   values quoted with "'" (as xml_quoted_string//2). Returns the offset
+   in the pool */
+static size_t put_string(hp_t *p, size_t i, size_t len, int quote,
+                         bool_t decode) {
+  size_t str = p->codes_n, end = i + len, j;
+  int c;
+
+  HP_RESERVE(p, int, codes, len);
+  while (i < end) {
+    c = p->s[i];
+    if (decode && c == '&') {
+      j = put_entity(p, i, end);
+      if (j != NONE) { i = j; continue; }
+    } else if (!decode && c == '"' && quote == '\'' && (p->flags & HTML_XML)) {
+      put_code(p, '&'); put_code(p, 'q'); put_code(p, 'u');
+      put_code(p, 'o'); put_code(p, 't'); put_code(p, ';');
+      i++;
+      continue;
+    }
+    put_code(p, c);
+    i++;
+  }
+  return str;
+}
+
+/* Copy the name at s[i..i+len) to the pool of names (lowercase for
+   HTML), after prefix. Returns the offset in the pool */
+static size_t put_name(hp_t *p, const char *prefix, size_t i, size_t len) {
+  size_t name = p->names_n, plen = strlen(prefix), k;
+
+  HP_RESERVE(p, char, names, plen + len + 1);
+  memcpy(p->names + p->names_n, prefix, plen);
+  p->names_n += plen;
+  for (k = 0; k < len; k++) {
+    int c = p->s[i + k];
+    p->names[p->names_n++] = (char)((p->flags & HTML_XML) ? c : to_lower(c));
+  }
+  p->names[p->names_n++] = 0;
+  return name;
+}
+
+#define NAME(P, N) ((P)->names + (N)->name)
+
+/* Is the name at s[i..i+len) equal to str? */
+static bool_t name_eq(hp_t *p, size_t i, size_t len, const char *str) {
+  size_t k;
+  for (k = 0; k < len; k++, str++) {
+    int c = p->s[i + k];
+    if (*str == 0) return FALSE;
+    if (((p->flags & HTML_XML) ? c : to_lower(c)) != *str) return FALSE;
+  }
+  return *str == 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Parse stack */
+
+static size_t new_node(hp_t *p, node_kind_t kind) {
+  node_t *x;
+  HP_RESERVE(p, node_t, nodes, 1);
+  x = &p->nodes[p->nodes_n];
+  memset(x, 0, sizeof(node_t));
+  x->kind = kind;
+  x->final = FALSE;
+  return p->nodes_n++;
+}
+
+static void push(hp_t *p, size_t x) {
+  HP_RESERVE(p, size_t, stack, 1);
+  p->stack[p->stack_n++] = x;
+}
+
+static void finalize(hp_t *p, size_t x) {
+  if (p->nodes[x].final) return;
+  p->nodes[x].final = TRUE;
+  HP_RESERVE(p, size_t, order, 1);
+  p->order[p->order_n++] = x;
+}
+
+static void push_text(hp_t *p, size_t i, size_t j) {
+  size_t x = new_node(p, N_TEXT);
+  p->nodes[x].str = put_string(p, i, j - i, 0,
+                               (p->flags & HTML_DECODE) && p->raw == NONE);
+  p->nodes[x].len = p->codes_n - p->nodes[x].str;
+  push(p, x);
+}
+
+/* Commit the attributes of a unit to node x */
+static void put_atts(hp_t *p, size_t x, unit_t *u) {
+  size_t k;
+  att_t *a;
+  tok_att_t *t;
+
+  HP_RESERVE(p, att_t, atts, u->natts);
+  p->nodes[x].atts = p->atts_n;
+  p->nodes[x].natts = u->natts;
+  for (k = 0; k < u->natts; k++) {
+    t = &p->tok_atts[k];
+    a = &p->atts[p->atts_n++];
+    a->name = put_name(p, "", t->name, t->name_len);
+    a->has_value = t->has_value;
+    if (t->has_value) {
+      a->str = put_string(p, t->val, t->val_len, t->quote, p->flags & HTML_DECODE);
+      a->len = p->codes_n - a->str;
+    }
+  }
+}
+
+static const char *void_elements[] = {
+  "area", "base", "br", "col", "embed", "hr", "img", "input", "link",
+  "meta", "param", "source", "track", "wbr", NULL
+};
+
+static bool_t in_list(const char *name, const char **list) {
+  for (; *list != NULL; list++) {
+    if (strcmp(name, *list) == 0) return TRUE;
+  }
+  return FALSE;
+}
+
+/* Is x a tag that can be closed? (all of them, or non-void elements
+   with HTML_RECOVER) */
+static bool_t is_open(hp_t *p, size_t x) {
+  node_t *n = &p->nodes[x];
+  if (n->kind != N_TAG) return FALSE;
+  if (!(p->flags & HTML_RECOVER)) return TRUE;
+  return !in_list(NAME(p, n), void_elements);
+}
+
+/* Close the tag at stack position k as an environment with the items
+   above it */
+static void close_env(hp_t *p, size_t k) {
+  size_t x = p->stack[k], m;
+  node_t *n;
+
+  HP_RESERVE(p, size_t, kids, p->stack_n - (k + 1));
+  n = &p->nodes[x];
+  n->kind = N_ENV;
+  n->kids = p->kids_n;
+  n->nkids = p->stack_n - (k + 1);
+  for (m = k + 1; m < p->stack_n; m++) {
+    finalize(p, p->stack[m]);
+    p->kids[p->kids_n++] = p->stack[m];
+  }
+  p->stack_n = k + 1;
+  finalize(p, x);
+}
+
+/* Close (with HTML_RECOVER) the open tags above stack position k */
+static void close_inner(hp_t *p, size_t k) {
+  size_t m;
+  for (m = p->stack_n; m-- > k + 1; ) {
+    if (is_open(p, p->stack[m])) close_env(p, m);
+  }
+}
+
+/* Innermost open tag (with HTML_RECOVER) */
+static size_t innermost_open(hp_t *p) {
+  size_t m;
+  for (m = p->stack_n; m-- > 0; ) {
+    if (is_open(p, p->stack[m])) return m;
+  }
+  return NONE;
+}
+
+/* Tags whose start closes an open tag (implied end tags) */
+typedef struct implied_ implied_t;
+struct implied_ {
+  const char *tag;
+  const char *closes[8];
+};
+
+static const implied_t implied_ends[] = {
+  {"li", {"li", NULL}},
+  {"dt", {"dt", "dd", NULL}},
+  {"dd", {"dt", "dd", NULL}},
+  {"tr", {"td", "th", "tr", NULL}},
+  {"td", {"td", "th", NULL}},
+  {"th", {"td", "th", NULL}},
+  {"option", {"option", NULL}},
+  {NULL, {NULL}}
+};
+
+/* (tags that close an open p) */
+static const char *p_closers[] = {
+  "p", "li", "dt", "dd", "div", "ul", "ol", "dl", "table", "pre",
+  "blockquote", "form", "hr", "h1", "h2", "h3", "h4", "h5", "h6",
+  "section", "article", "header", "footer", "nav", NULL
+};
+
+static bool_t closes(const char *tag, const char *open) {
+  const implied_t *i;
+  if (strcmp(open, "p") == 0 && in_list(tag, p_closers)) return TRUE;
+  for (i = implied_ends; i->tag != NULL; i++) {
+    if (strcmp(i->tag, tag) == 0) return in_list(open, (const char **)i->closes);
+  }
+  return FALSE;
+}
+
+static bool_t is_raw_text(const char *tag) {
+  return strcmp(tag, "script") == 0 || strcmp(tag, "style") == 0;
+}
+
+static void apply_unit(hp_t *p, unit_t *u) {
+  size_t x, k;
+
+  switch (u->kind) {
+  case U_COMMENT:
+  case U_DECLARE:
+    x = new_node(p, u->kind == U_COMMENT ? N_COMMENT : N_DECLARE);
+    p->nodes[x].str = put_string(p, u->a, u->len, 0, FALSE);
+    p->nodes[x].len = u->len;
+    push(p, x);
+    break;
+  case U_XMLDECL:
+    x = new_node(p, N_XMLDECL);
+    put_atts(p, x, u);
+    push(p, x);
+    break;
+  case U_ELEM:
+    x = new_node(p, N_ELEM);
+    p->nodes[x].name = put_name(p, "", u->a, u->len);
+    put_atts(p, x, u);
+    push(p, x);
+    break;
+  case U_TAG:
+    x = new_node(p, N_TAG);
+    p->nodes[x].name = put_name(p, "", u->a, u->len);
+    put_atts(p, x, u);
+    if (p->flags & HTML_RECOVER) {
+      while ((k = innermost_open(p)) != NONE &&
+             closes(NAME(p, &p->nodes[x]), NAME(p, &p->nodes[p->stack[k]]))) {
+        close_inner(p, k);
+        close_env(p, k);
+      }
+      if (is_raw_text(NAME(p, &p->nodes[x]))) p->raw = x;
+    }
+    push(p, x);
+    break;
+  case U_END:
+    /* (poptokenstack/4) */
+    for (k = p->stack_n; k-- > 0; ) {
+      x = p->stack[k];
+      if (is_open(p, x) && name_eq(p, u->a, u->len, NAME(p, &p->nodes[x]))) {
+        if (p->flags & HTML_RECOVER) close_inner(p, k);
+        close_env(p, k);
+        p->raw = NONE;
+        return;
+      }
+    }
+    if (p->flags & HTML_RECOVER) return; /* (ignore) */
+    x = new_node(p, N_TAG);
+    p->nodes[x].name = put_name(p, "/", u->a, u->len);
+    push(p, x);
+    break;
+  }
+}
+
+static void parse(hp_t *p) {
+  size_t i = 0, j, text = NONE, m;
+  unit_t u;
+
+  while (i < p->n) {
+    if (p->s[i] == '<') {
+      j = markup_unit(p, i + 1, &u);
+      if (j != NONE && p->raw != NONE &&
+          !(u.kind == U_END && name_eq(p, u.a, u.len, NAME(p, &p->nodes[p->raw])))) {
+        j = NONE; /* (only the end tag of script/style) */
+      }
+      if (j != NONE) {
+        if (text != NONE) { push_text(p, text, i); text = NONE; }
+        apply_unit(p, &u);
+        i = j;
+        continue;
+      }
+    }
+    if (text == NONE) text = i;
+    i++;
+  }
+  if (text != NONE) push_text(p, text, i);
+  if (p->flags & HTML_RECOVER) {
+    for (m = p->stack_n; m-- > 0; ) {
+      if (is_open(p, p->stack[m])) close_env(p, m);
+    }
+  }
+  for (m = 0; m < p->stack_n; m++) finalize(p, p->stack[m]);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Building the terms */
+
+static size_t atts_cells(hp_t *p, node_t *n) {
+  size_t k, cells = 0;
+  for (k = 0; k < n->natts; k++) {
+    att_t *a = &p->atts[n->atts + k];
+    cells += LSTCELLS;
+    if (a->has_value) cells += 3 + a->len * LSTCELLS;
+  }
+  return cells;
+}
+
+static size_t node_cells(hp_t *p, node_t *n) {
+  switch (n->kind) {
+  case N_TEXT: return n->len * LSTCELLS;
+  case N_COMMENT: case N_DECLARE: return 2 + n->len * LSTCELLS;
+  case N_TAG: case N_ELEM: return 3 + atts_cells(p, n);
+  case N_XMLDECL: return 2 + atts_cells(p, n);
+  case N_ENV: return 4 + atts_cells(p, n) + n->nkids * LSTCELLS;
+  }
+  return 0;
+}
+
+static CFUN__PROTO(make_string, tagged_t, hp_t *p, size_t str, size_t len) {
+  tagged_t list = atom_nil;
+  size_t k;
+  for (k = len; k-- > 0; ) {
+    MakeLST(list, MakeSmall(p->codes[str + k]), list);
+  }
+  CFUN__PROCEED(list);
+}
+
+static CFUN__PROTO(make_atts, tagged_t, hp_t *p, node_t *n) {
+  tagged_t list = atom_nil, x;
+  tagged_t *h;
+  size_t k;
+
+  for (k = n->natts; k-- > 0; ) {
+    att_t *a = &p->atts[n->atts + k];
+    x = GET_ATOM(p->names + a->name);
+    if (a->has_value) {
+      tagged_t v = CFUN__EVAL(make_string, p, a->str, a->len);
+      h = G->heap_top;
+      HeapPush(h, p->f_eq);
+      HeapPush(h, x);
+      HeapPush(h, v);
+      G->heap_top = h;
+      x = Tagp(STR, h-3);
+    }
+    MakeLST(list, x, list);
+  }
+  CFUN__PROCEED(list);
+}
+
+static CFUN__PROTO(make_node, tagged_t, hp_t *p, node_t *n) {
+  tagged_t x, atts, *h;
+  size_t k;
+
+  switch (n->kind) {
+  case N_TEXT:
+    CFUN__PROCEED(CFUN__EVAL(make_string, p, n->str, n->len));
+  case N_COMMENT:
+  case N_DECLARE:
+    x = CFUN__EVAL(make_string, p, n->str, n->len);
+    h = G->heap_top;
+    HeapPush(h, n->kind == N_COMMENT ? p->f_comment : p->f_declare);
+    HeapPush(h, x);
+    G->heap_top = h;
+    CFUN__PROCEED(Tagp(STR, h-2));
+  case N_TAG:
+  case N_ELEM:
+    atts = CFUN__EVAL(make_atts, p, n);
+    h = G->heap_top;
+    HeapPush(h, n->kind == N_TAG ? p->f_dollar : p->f_elem);
+    HeapPush(h, GET_ATOM(NAME(p, n)));
+    HeapPush(h, atts);
+    G->heap_top = h;
+    CFUN__PROCEED(Tagp(STR, h-3));
+  case N_XMLDECL:
+    atts = CFUN__EVAL(make_atts, p, n);
+    h = G->heap_top;
+    HeapPush(h, p->f_xmldecl);
+    HeapPush(h, atts);
+    G->heap_top = h;
+    CFUN__PROCEED(Tagp(STR, h-2));
+  case N_ENV:
+    atts = CFUN__EVAL(make_atts, p, n);
+    x = atom_nil;
+    for (k = n->nkids; k-- > 0; ) {
+      MakeLST(x, p->nodes[p->kids[n->kids + k]].term, x);
+    }
+    h = G->heap_top;
+    HeapPush(h, p->f_env);
+    HeapPush(h, GET_ATOM(NAME(p, n)));
+    HeapPush(h, atts);
+    HeapPush(h, x);
+    G->heap_top = h;
+    CFUN__PROCEED(Tagp(STR, h-4));
+  }
+  CFUN__PROCEED(atom_nil);
+}
+
+/* html_parse_codes(+Flags, +Codes, -Terms): parse the HTML (or XML)
+   code in Codes. Fails if Codes is not a list of character codes. */
+CBOOL__PROTO(prolog_html_parse_codes) {
+  hp_t p;
+  tagged_t t, c, list;
+  size_t k, n, cells;
+
+  DEREF(X(0), X(0));
+  if (!TaggedIsSmall(X(0))) CBOOL__FAIL;
+  p.flags = GetSmall(X(0));
+  /* Copy the input */
+  n = 0;
+  DEREF(t, X(1));
+  while (TaggedIsLST(t)) { DerefCdr(t, t); n++; }
+  if (t != atom_nil) CBOOL__FAIL;
+  p.n = n;
+  p.s = checkalloc_ARRAY(int, n + 1);
+  DEREF(t, X(1));
+  for (k = 0; k < n; k++) {
+    DerefCar(c, t);
+    if (!TaggedIsSmall(c) || GetSmall(c) < 0) {
+      checkdealloc_ARRAY(int, n + 1, p.s);
+      CBOOL__FAIL;
+    }
+    p.s[k] = GetSmall(c);
+    DerefCdr(t, t);
+  }
+  hp_init(&p);
+  parse(&p);
+  /* Build the terms */
+  cells = p.stack_n * LSTCELLS;
+  for (k = 0; k < p.order_n; k++) {
+    cells += node_cells(&p, &p.nodes[p.order[k]]);
+  }
+  TEST_HEAP_OVERFLOW(G->heap_top, cells*sizeof(tagged_t)+CONTPAD, 3);
+  for (k = 0; k < p.order_n; k++) {
+    node_t *x = &p.nodes[p.order[k]];
+    x->term = CFUN__EVAL(make_node, &p, x);
+  }
+  list = atom_nil;
+  for (k = p.stack_n; k-- > 0; ) {
+    MakeLST(list, p.nodes[p.stack[k]].term, list);
+  }
+  hp_free(&p);
+  checkdealloc_ARRAY(int, n + 1, p.s);
+  CBOOL__LASTUNIFY(list, X(2));
+}
+
+/* --------------------------------------------------------------------------- */
+/* Serializer */
+
+/* Escaping modes (see html_put_codes/4 in html.pl) */
+#define ESC_RAW     0 /* no escaping */
+#define ESC_TEXT    1 /* as html_quoted_char//1 */
+#define ESC_ATTR    2 /* as html_quoted_quote_char//1 */
+
+#define OUT_BUFSIZE 4096
+
+/* html_put_codes(+Stream, +Mode, +Codes, -Rest): write the longest
+   prefix of Codes made of character codes (0..255) to Stream,
+   escaped according to Mode, and unify Rest with the rest of the
+   list. */
+CBOOL__PROTO(prolog_html_put_codes) {
+  ERR__FUNCTOR("html:html_put_codes", 4);
+  stream_node_t *s;
+  int errcode, mode;
+  intmach_t c;
+  const char *esc;
+  char buf[OUT_BUFSIZE];
+  size_t len = 0;
+  tagged_t t, x;
+
+  s = stream_to_ptr_check(X(0), 'w', &errcode);
+  if (!s) BUILTIN_ERROR(errcode, X(0), 1);
+  DEREF(X(1), X(1));
+  if (!TaggedIsSmall(X(1))) BUILTIN_ERROR(ERR_type_error(integer), X(1), 2);
+  mode = GetSmall(X(1));
+
+  DEREF(t, X(2));
+  while (TaggedIsLST(t)) {
+    DerefCar(x, t);
+    if (!TaggedIsSmall(x)) break;
+    c = GetSmall(x);
+    if (c < 0 || c > 255) break;
+    esc = NULL;
+    if (mode == ESC_TEXT) {
+      switch (c) {
+      case '>': esc = "&gt;"; break;
+      case '<': esc = "&lt;"; break;
+      case '&': esc = "&amp;"; break;
+      case '"': esc = "&quot;"; break;
+      case '\n': esc = "<br>"; break;
+      }
+    } else if (mode == ESC_ATTR && c == '"') {
+      esc = "&quot;";
+    }
+    if (len + 8 > OUT_BUFSIZE) {
+      CVOID__CALL(print_bytes, s, buf, len);
+      len = 0;
+    }
+    if (esc != NULL) {
+      while (*esc != 0) buf[len++] = *esc++;
+    } else {
+      buf[len++] = (char)c;
+    }
+    DerefCdr(t, t);
+  }
+  if (len > 0) CVOID__CALL(print_bytes, s, buf, len);
+  CBOOL__LASTUNIFY(t, X(3));
+}
@@ -138,13 +138,37 @@ $ cd core/examples/general
 $ CIAODBG=profile CIAORTOPTS=\"--profile-calls --profile-roughtime\" ciaopp -A guardians.pl
 @end{verbatim}
 
+  @section{Call statistics in the default engine}
+
+  A lighter form of call counting is available in every engine
+  (without recompiling it). When enabled, each thread counts calls
+  per predicate in a private table (optionally sampling one of every
+  @var{N} calls and measuring rough wall time) and the tables of all
+  threads are merged when read:
+
+@begin{verbatim}
+?- callstats_start([calls,roughtime,period(16)]).
+?- ... run your workload ...
+?- callstats_stop, print_callstats(10).
+@end{verbatim}
+
+  When disabled, the cost is a single predicted branch per call. The
+  same statistics can be enabled for a whole executable with the
+  @tt{--callstats}, @tt{--callstats-time}, and
+  @tt{--callstats-period=N} engine options (e.g., through
+  @tt{CIAORTOPTS}).
+
 ").
 
 :- use_module(engine(internals), [
     '$profile_flags_set'/1,
     '$profile_flags_get'/1,
     '$profile_dump'/0,
-    '$profile_reset'/0
+    '$profile_reset'/0,
+    '$callstats_set'/2,
+    '$callstats_get'/2,
+    '$callstats_reset'/0,
+    '$callstats_top'/2
 ]).
 :- use_module(library(port_reify), [once_port_reify/2, port_call/1]).
 
@@ -220,3 +244,95 @@ print_profile :-
     % TODO: hardwired
     file_to_string('/tmp/ciao__profile.txt', Str),
     write_string(Str).
+
+% ---------------------------------------------------------------------------
+%! # Call statistics (default engine)
+
+:- export(callstats_opt/1).
+:- doc(callstats_opt/1,"@var{X} is a call statistics option:
+@begin{itemize}
+@item @tt{calls}: count number of calls per predicate
+@item @tt{roughtime}: rough approximation of (wall) execution time
+  (since a sampled call until the next sampled call in the same thread)
+@item @tt{period(N)}: record only one of every @var{N} calls (each
+  sample counts as @var{N} calls)
+@end{itemize}
+").
+:- regtype callstats_opt(X)
+   # "@var{X} is a call statistics option.".
+
+callstats_opt(calls).
+callstats_opt(roughtime).
+callstats_opt(period(N)) :- int(N).
+
+% (see eng_profile.h)
+get_callstats_opt(calls, 1).
+get_callstats_opt(roughtime, 3).
+
+get_callstats_opts([], F, F, P, P).
+get_callstats_opts([Opt|Opts], F0, F, P0, P) :-
+    ( var(Opt) -> throw(error(instantiation_error, callstats_start/1))
+    ; Opt = period(P1), integer(P1), P1 >= 1 -> F1 = F0
+    ; get_callstats_opt(Opt, OptF) -> F1 is F0 \/ OptF, P1 = P0
+    ; throw(error(domain_error(callstats_opt, Opt), callstats_start/1))
+    ),
+    get_callstats_opts(Opts, F1, F, P1, P).
+
+:- export(callstats_start/1).
+:- pred callstats_start(Opts) : list(callstats_opt, Opts)
+   # "Enable call statistics (in all threads) with options
+     @var{Opts}. Previous counters are kept (see
+     @pred{callstats_reset/0}).".
+
+callstats_start(Opts) :-
+    get_callstats_opts(Opts, 0, Flags, 1, Period),
+    '$callstats_set'(Flags, Period).
+
+:- export(callstats_start/0).
+:- pred callstats_start # "Like @pred{callstats_start/1} with
+   default options (@tt{calls})".
+
+callstats_start :- callstats_start([calls]).
+
+:- export(callstats_stop/0).
+:- pred callstats_stop # "Disable call statistics (counters are
+   kept).".
+
+callstats_stop :-
+    '$callstats_get'(_, Period),
+    '$callstats_set'(0, Period).
+
+:- export(callstats_reset/0).
+:- pred callstats_reset # "Reset the call statistics counters of all
+   threads.".
+
+callstats_reset :- '$callstats_reset'.
+
+:- export(callstats_top/2).
+:- pred callstats_top(N, Stats) : int(N) => list(Stats)
+   # "@var{Stats} is a list of @tt{F/A-Calls-Time} (@tt{Time} in
+     microseconds, @tt{0} unless @tt{roughtime} was enabled) for the
+     @var{N} most called predicates (all of them if @var{N} is
+     @tt{0}), in decreasing order of calls. Counters from all threads
+     are merged.".
+
+callstats_top(N, Stats) :- '$callstats_top'(N, Stats).
+
+:- use_module(library(format), [format/2]).
+:- use_module(library(lists), [member/2]).
+
+:- export(print_callstats/1).
+:- pred print_callstats(N) : int(N)
+   # "Print the @var{N} most called predicates (see
+     @pred{callstats_top/2}).".
+
+print_callstats(N) :-
+    callstats_top(N, Stats),
+    format("~w~t~12|~w~t~28|~w~n", ['Calls', 'Time (ms)', 'Spec']),
+    format("~w~t~12|~w~t~28|~w~n", ['=====', '=========', '====']),
+    ( member(F/A-Calls-Time, Stats),
+        Ms is Time / 1000.0,
+        format("~d~t~12|~3f~t~28|~w/~d~n", [Calls, Ms, F, A]),
+        fail
+    ; true
+    ).
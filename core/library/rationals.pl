@@ -0,0 +1,45 @@
+:- module(rationals, [rational/1, rational/3], [assertions]).
+
+:- doc(title, "Rational numbers").
+
+:- doc(module, "This module provides type testing and decomposition of
+   the @concept{rational numbers} computed by the @tt{rdiv/2},
+   @tt{rational/1}, and @tt{rationalize/1} evaluable functors (see
+   @pred{arithexpression/1}). For example:
+
+@begin{verbatim}
+?- X is 1 rdiv 3 + 1 rdiv 6, rational(X, N, D).
+
+X = rat(1,2),
+N = 1,
+D = 2 ?
+@end{verbatim}
+
+   Rationals are @tt{rat(N,D)} terms in canonical form (@tt{D > 1} and
+   @var{N} and @var{D} coprime), so that integers are also rationals
+   (with denominator 1). Note that rationals are compared and
+   unified as terms (e.g., @tt{X is 1 rdiv 2, X == rat(1,2)}
+   succeeds), while arithmetic comparison must be used to compare
+   them with other numbers (e.g., @tt{1 rdiv 2 =:= 0.5}).").
+
+:- prop rational(X)
+   # "@var{X} is a rational number (an integer or a rational in
+   canonical form).".
+
+rational(X) :- integer(X), !.
+rational(X) :-
+    X = rat(N, D),
+    integer(N), integer(D),
+    D > 1,
+    gcd(N, D) =:= 1.
+
+:- pred rational(X, N, D) # "@var{X} is the rational number
+   @var{N}/@var{D}, where @var{N} and @var{D} are the numerator and
+   (positive) denominator of @var{X} in canonical form.".
+
+rational(X, N, D) :- integer(X), !,
+    N = X,
+    D = 1.
+rational(X, N, D) :-
+    rational(X),
+    X = rat(N, D).
@@ -0,0 +1,78 @@
+:- module(_, [], [assertions]).
+
+:- doc(title, "Tests for rationals.pl").
+
+:- use_module(library(rationals)).
+:- use_module(library(between), [between/3]).
+
+% ---------------------------------------------------------------------------
+
+:- export(test_canonical/0).
+:- test test_canonical # "rdiv/2 gives rationals in canonical form".
+test_canonical :-
+    X1 is 1 rdiv 3 + 1 rdiv 6, X1 == rat(1,2),
+    X2 is 2 rdiv 4, X2 == rat(1,2),
+    X3 is 4 rdiv 2, X3 == 2,
+    X4 is 1 rdiv -2, X4 == rat(-1,2),
+    X5 is rat(2,6), X5 == rat(1,3), % (not canonical, evaluated)
+    X6 is 1 rdiv 3 * 3, X6 == 1,
+    X7 is -(1 rdiv 3) - 1 rdiv 6, X7 == rat(-1,2),
+    rational(X1, N, D), N == 1, D == 2,
+    rational(3, N3, D3), N3 == 3, D3 == 1,
+    \+ rational(rat(2,4)),
+    \+ rational(0.5).
+
+:- export(test_compare/0).
+:- test test_compare # "Arithmetic comparison of rationals".
+test_compare :-
+    1 rdiv 3 < 1 rdiv 2,
+    1 rdiv 3 =:= rat(2,6),
+    1 rdiv 3 =\= 0.3333,
+    -1 rdiv 2 < 0,
+    7 rdiv 2 > 3,
+    1 rdiv 2 =:= 0.5.
+
+:- export(test_rounding/0).
+:- test test_rounding # "Rounding of rationals to integers".
+test_rounding :-
+    X = rat(-3,2),
+    F is floor(X), F == -2,
+    C is ceiling(X), C == -1,
+    T is truncate(X), T == -1,
+    R is round(X), R == -2,
+    A is abs(X), A == rat(3,2),
+    S is sign(X), S == -1.
+
+:- export(test_integer_functors/0).
+:- test test_integer_functors # "Integer functors raise a type error on
+   rationals".
+test_integer_functors :-
+    catch((_ is (1 rdiv 2) mod 2, R = ok), error(E, _), R = E),
+    R = type_error(_, _).
+
+:- export(test_float/0).
+:- test test_float # "Conversion between floats and rationals".
+test_float :-
+    X1 is rational(0.1), X1 == rat(3602879701896397,36028797018963968),
+    X2 is rationalize(0.1), X2 == rat(1,10),
+    X3 is rationalize(-0.25), X3 == rat(-1,4),
+    X4 is rationalize(2.0), X4 == 2,
+    F is 1 rdiv 3 / 2, float(F),
+    \+ ( between(1, 1000, I),
+         G is sin(I) * 10.0 ** (I mod 40 - 20),
+         \+ float_roundtrip(G) ).
+
+float_roundtrip(G) :-
+    G1 is float(rational(G)), G1 == G,
+    G2 is float(rationalize(G)), G2 == G.
+
+:- export(test_huge/0).
+:- test test_huge # "Conversion to floats of rationals with huge
+   numerators and denominators".
+test_huge :-
+    N is 1 << 1400,
+    F1 is float((N + 1) rdiv N), F1 == 1.0,
+    F2 is float(N rdiv (3 * N + 1)), abs(F2 - 1/3) < 1.0e-15,
+    F3 is float(-(N rdiv (2 * N + 1))), abs(F3 + 0.5) < 1.0e-15,
+    F4 is float(1 rdiv N), F4 == 0.0,
+    F5 is float((1 << 400) rdiv (N + 1)), abs(F5 / 2.0 ** -1000 - 1) < 1.0e-15.
@@ -2,6 +2,7 @@
     connect_to_socket_type/4,
     connect_to_socket/3,
     bind_socket/3,
+    bind_socket/4,
     socket_accept/2,
     select_socket/5,
     socket_send/3,
@@ -9,6 +10,7 @@
     socket_send_stream/2,
     socket_recv/3,
     socket_shutdown/2,
+    socket_timeout/2,
     % socket_buffering/4,
     hostname_address/2,
     socket_getpeername/2,
@@ -88,6 +90,32 @@ connect_to_socket(Hostname, Port, Stream):-
    (hence no listen call in this set of primitives).  @var{Length}
    specifies the maximum number of pending connections.".
 
+:- pred bind_socket(?Port, +Length, +Options, -Socket)
+   :: int * int * list(bind_socket_option) * int
+   # "Like @pred{bind_socket/3}, with the following @var{Options}:
+   @begin{itemize}
+   @item @tt{reuseport}: allow several sockets (from this or other
+     processes) bound to the same port (@tt{SO_REUSEPORT}), so that
+     incoming connections are distributed among them by the O.S.
+   @end{itemize}".
+
+bind_socket(Port, Length, Options, Socket) :-
+    ( member_opt(reuseport, Options) ->
+        bind_socket_reuseport(Port, Length, Socket)
+    ; bind_socket(Port, Length, Socket)
+    ).
+
+member_opt(X, [Y|Ys]) :- ( X = Y -> true ; member_opt(X, Ys) ).
+
+:- export(bind_socket_option/1).
+:- regtype bind_socket_option(T) # "@var{T} is an option of
+   @pred{bind_socket/4}.".
+
+bind_socket_option(reuseport).
+
+:- trust pred bind_socket_reuseport(?Port, +Length, -Socket)
+   :: int * int * int
+   + foreign_low(prolog_bind_socket_reuseport).
 
 :- trust pred socket_accept(+Sock, -Stream)
    :: int * stream
@@ -143,6 +171,14 @@ connect_to_socket(Hostname, Port, Stream):-
    @tt{write}, or @var{read_write} should be used to denote the type
    of closing required.".
 
+:- trust pred socket_timeout(+Stream, +TO_ms)
+   :: stream * int
+   + foreign_low(prolog_socket_timeout)
+   # "Set a timeout of @var{TO_ms} milliseconds (or no timeout if it
+   is @tt{off}) for receiving and sending data through the socket
+   associated to @var{Stream}. Operations that exceed it raise an
+   exception.".
+
 :- regtype shutdown_type(T) # "@var{T} is a valid shutdown type.".
 shutdown_type(read).
 shutdown_type(write).
@@ -155,17 +155,39 @@ CBOOL__PROTO(prolog_connect_to_socket_type) {
 
 /* bind_socket(?Port, +Lenght, -Sock) */
 
+static CBOOL__PROTO(bind_socket_, int reuse_port, int sock_arg,
+                    char *err__name, intmach_t err__arity);
+
 CBOOL__PROTO(prolog_bind_socket)
 {
   ERR__FUNCTOR("sockets:bind_socket", 3);
+  return CBOOL__SUCCEED(bind_socket_, FALSE, 2, err__name, err__arity);
+}
+
+/* bind_socket_reuseport(?Port, +Lenght, -Sock): like bind_socket/3,
+   allowing several sockets bound to the same port (SO_REUSEPORT) */
+
+CBOOL__PROTO(prolog_bind_socket_reuseport)
+{
+  ERR__FUNCTOR("sockets:bind_socket", 4);
+#if defined(SO_REUSEPORT)
+  return CBOOL__SUCCEED(bind_socket_, TRUE, 2, err__name, err__arity);
+#else
+  BUILTIN_ERROR(ERR_system_error, X(0), 1);
+#endif
+}
+
+static CBOOL__PROTO(bind_socket_, int reuse_port, int sock_arg,
+                    char *err__name, intmach_t err__arity)
+{
   int sock, port;
   struct sockaddr_in sa;
   int reuse_address = 1;
 
-  DEREF(X(2), X(2));
-  if (!IsVar(X(2)))
+  DEREF(X(sock_arg), X(sock_arg));
+  if (!IsVar(X(sock_arg)))
     //"bind_socket: 3rd argument must be a variable");
-    BUILTIN_ERROR(ERR_instantiation_error, X(2), 3);
+    BUILTIN_ERROR(ERR_instantiation_error, X(sock_arg), sock_arg+1);
 
   DEREF(X(1), X(1));
   if (!TaggedIsSmall(X(1)))
@@ -193,6 +215,13 @@ CBOOL__PROTO(prolog_bind_socket)
     // MAJOR_FAULT("connect_to_socket/[3,4]: error setting option");
     BUILTIN_ERROR(ERR_system_error, X(0), 1);
 
+#if defined(SO_REUSEPORT)
+  if (reuse_port &&
+      setsockopt(sock, SOL_SOCKET, SO_REUSEPORT,
+                 (void *)&reuse_address, sizeof(int)))
+    BUILTIN_ERROR(ERR_system_error, X(0), 1);
+#endif
+
   if (bind(sock, (struct sockaddr *)&sa, sizeof(sa)) < 0)
     // MAJOR_FAULT("bind_socket: cannot bind");
     BUILTIN_ERROR(ERR_system_error, X(0), 1);
@@ -213,7 +242,7 @@ CBOOL__PROTO(prolog_bind_socket)
     BUILTIN_ERROR(ERR_system_error, X(0), 1);
   }
 
-  CBOOL__LASTUNIFY(MakeSmall(sock), X(2));
+  CBOOL__LASTUNIFY(MakeSmall(sock), X(sock_arg));
 }
 
 /* socket_accept(+Sock, -Stream) */
@@ -439,8 +468,11 @@ CBOOL__PROTO(prolog_socket_sendall) {
   unsigned char *buffpt = (unsigned char *)Atom_Buffer;
 
   bytes_sent = sendall(GetSmall(s->label), buffpt, msglen);
-  if (bytes_sent < 0)
+  if (bytes_sent < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) /* (timeout) */
+      BUILTIN_ERROR(ERR_system_error, X(0), 1);
     MAJOR_FAULT("socket_sendall/2: send() call failed");
+  }
     //BUILTIN_ERROR(ERR_system_error, X(0), 1);
 
   return TRUE;
@@ -507,8 +539,11 @@ CBOOL__PROTO(prolog_socket_receive) {
   bytes_read = recvfrom(GetSmall(s->label), buffer, BUFFSIZE, 0, NULL, NULL);
   total_bytes = bytes_read;
 
-  if (bytes_read < 0)
+  if (bytes_read < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) /* (timeout) */
+      BUILTIN_ERROR(ERR_system_error, X(0), 1);
     MAJOR_FAULT("socket_recv/3: recv() call failed")
+  }
 
   /*
     else if (bytes_read > BUFFSIZE)        
@@ -579,6 +614,43 @@ CBOOL__PROTO(prolog_socket_shutdown) {
 }
 
 
+/* socket_timeout(+Stream, +TO_ms) */
+
+CBOOL__PROTO(prolog_socket_timeout) {
+  ERR__FUNCTOR("sockets:socket_timeout", 2);
+  stream_node_t *s;
+  struct timeval timeout;
+  intmach_t miliseconds;
+  int errcode;
+
+  s = stream_to_ptr_check(X(0), 'r', &errcode);
+  if (!s) BUILTIN_ERROR(errcode, X(0), 1);
+
+  if (s->streammode != 's')
+    USAGE_FAULT("socket_timeout/2: first argument must be a socket stream");
+
+  DEREF(X(1), X(1));
+  if (X(1) == atom_off) {
+    miliseconds = 0; /* (no timeout) */
+  } else if (IsInteger(X(1))) {
+    miliseconds = TaggedToIntmach(X(1));
+    if (miliseconds <= 0)
+      BUILTIN_ERROR(ERR_domain_error(flag_value), X(1), 2);
+  } else {
+    BUILTIN_ERROR(ERR_type_error(integer), X(1), 2);
+  }
+  timeout.tv_sec = miliseconds / 1000;
+  timeout.tv_usec = (miliseconds - timeout.tv_sec * 1000) * 1000;
+
+  if (setsockopt(GetSmall(s->label), SOL_SOCKET, SO_RCVTIMEO,
+                 (void *)&timeout, sizeof(timeout)) ||
+      setsockopt(GetSmall(s->label), SOL_SOCKET, SO_SNDTIMEO,
+                 (void *)&timeout, sizeof(timeout)))
+    BUILTIN_ERROR(ERR_system_error, X(0), 1);
+
+  return TRUE;
+}
+
 /* socket_buffering(+Stream, +Direction, -OldBuf, +NewBuffer) */
 /*
 CBOOL__PROTO(prolog_socket_buffering) {
@@ -19,6 +19,7 @@
 #include <ciao/eng_bignum.h>
 #include <ciao/eng_registry.h>
 #include <ciao/io_basic.h>
+#include <ciao/eng_evtrace.h>
 
 
 #include <ciao/tabling.h>
@@ -37,19 +38,33 @@
 
 #if defined(TABLING)
 //parent tabled call stack
-struct gen **ptcp_stk;     
-intmach_t iptcp_stk;
-tagged_t args[2];
-tagged_t tmp_term;
+__thread struct gen **ptcp_stk;     
+__thread intmach_t iptcp_stk;
+__thread tagged_t args[2];
+__thread tagged_t tmp_term;
 FTYPE_ctype(f_o) dummy_frame_op = LASTCALL; /* TODO: (JFMC) */
 
-//first trie node
+//first trie node (tables shared by all threads)
 TrNode trie_node_top;
-TrNode auxiliar_trie;
+condition_t tables_cond;
+//incremented by abolish_all_tables/0 (to discard thread private tables)
+intmach_t tables_epoch;
+
+//first trie node (thread private tables)
+__thread TrNode private_trie_top;
+__thread TrNode auxiliar_trie;
+__thread intmach_t private_tables_epoch;
 //last generator
-struct gen *last_gen_list;   
+__thread struct gen *last_gen_list;   
+//current thread
+__thread struct tabling_thread *tabling_self;
+//goals that have made tabled calls (see abolish_all_tables_c)
+struct tabling_goal *tabling_goals;
+//(last goal of this thread registered in tabling_goals)
+__thread goal_descriptor_t *tabling_last_gd;
+__thread intmach_t tabling_last_goal_number;
 
-node_tr_t *initial_node_tr;             //NodeTR to check nested consumers.
+__thread node_tr_t *initial_node_tr;    //NodeTR to check nested consumers.
 
 //address for non determinist predicates
 try_node_t *address_nd_consume_answer_c;
@@ -76,6 +91,7 @@ tagged_t atom_gen_tree_backtracking;
 #include "tries.c"
 #include "exec_prolog_functions.c"
 #include "chat_tabling_tab.c"
+#include "table_store.c"
 
 
 //#include <time.h>
@@ -111,6 +127,132 @@ intmach_t is_executing(struct gen *gen)
   return IsVarTerm(term);  
 }                            
 
+//The tabling_goals entry g is for a goal that may still be reading
+//tables (with tables_cond locked).
+static bool_t tabling_goal_alive(struct tabling_goal *g)
+{
+  return (g->gd->goal_number == g->goal_number &&
+          (g->gd->state == WORKING || g->gd->state == PENDING_SOLS));
+}
+
+//Register the current goal in tabling_goals, removing the entries of
+//finished goals.
+CVOID__PROTO(register_tabling_goal) {
+  goal_descriptor_t *gd = w->misc->goal_desc_ptr;
+  struct tabling_goal **p, *g;
+  bool_t found = FALSE;
+
+  TABLES_LOCK;
+  for (p = &tabling_goals; (g = *p) != NULL; )
+    {
+      if (g->gd == gd && g->goal_number == gd->goal_number)
+        found = TRUE;
+      else if (!tabling_goal_alive(g))
+        {
+          *p = g->next;
+          checkdealloc_TYPE(struct tabling_goal, g);
+          continue;
+        }
+      p = &g->next;
+    }
+  if (!found)
+    {
+      g = checkalloc_TYPE(struct tabling_goal);
+      g->gd = gd;
+      g->goal_number = gd->goal_number;
+      g->next = tabling_goals;
+      tabling_goals = g;
+    }
+  TABLES_UNLOCK;
+  tabling_last_gd = gd;
+  tabling_last_goal_number = gd->goal_number;
+}
+
+//Initialize the tabling state of the current thread and worker (on
+//their first tabled call, X(0)..X(arity-1) are preserved)
+CVOID__PROTO(init_tabling_thread, intmach_t arity) {
+  if (tabling_self == NULL)
+    {
+      //(never freed, generators of finished threads may point to it)
+      tabling_self = checkalloc_TYPE(struct tabling_thread);
+      tabling_self->waiting_for = NULL;
+      INIT_TABLING_STACK;
+      iptcp_stk = 0;
+      ptcp_stk = (struct gen**) checkalloc (PTCP_STKSIZE * sizeof(struct gen*)); 
+      PUSH_PTCP(NULL);
+      INIT_NODE_TR(initial_node_tr);
+      private_tables_epoch = tables_epoch;
+    }
+
+  if (private_tables_epoch != tables_epoch)
+    {
+      //tables abolished by other thread
+      init_tries_module();
+      private_trie_top = NULL;
+      auxiliar_trie = NULL;
+      last_gen_list = NULL;
+      private_tables_epoch = tables_epoch;
+      tabling_last_gd = NULL;
+    }
+
+  if (tabling_last_gd != w->misc->goal_desc_ptr ||
+      tabling_last_goal_number != w->misc->goal_desc_ptr->goal_number)
+    CVOID__CALL(register_tabling_goal);
+
+  if (LastNodeTR != NULL) return;
+
+  //Initialize LastNodeTR
+  INIT_NODE_TR(LastNodeTR);
+
+  // ---------------------------------------------------------------------------
+  // TODO:[JF] fix this horrible hack that forces stack resizes!
+
+  if (Heap_End != HeapCharOffset(Heap_Start, TABLING_GLOBALSTKSIZE*sizeof(tagged_t))) {
+    intmach_t size = (TABLING_GLOBALSTKSIZE*sizeof(tagged_t) - HeapCharDifference(Heap_Start, w->heap_top))/2;
+    CVOID__CALL(explicit_heap_overflow,2*size,arity); // TODO:[oc-merge] pad was multiplied inside heap_overflow
+  }
+
+  if (Stack_End != StackOffset(Stack_Start, TABLING_LOCALSTKSIZE)) {
+    tagged_t *new_Stack_Start;
+    intmach_t reloc_factor;
+
+    new_Stack_Start = REALLOC_AREA(Stack_Start,
+                                   StackDifference(Stack_Start,Stack_End)*sizeof(tagged_t),
+                                   TABLING_LOCALSTKSIZE*sizeof(tagged_t));
+
+    reloc_factor = (char *)new_Stack_Start - (char *)Stack_Start;
+    stack_overflow_adjust_wam(w, reloc_factor);
+
+    /* Final adjustments */
+    Stack_Start = new_Stack_Start;            /* new bounds */
+    Stack_End = StackOffset(new_Stack_Start,TABLING_LOCALSTKSIZE);
+  }
+
+  if (Trail_End != TrailOffset(Trail_Start, TABLING_CHOICESTKSIZE + TABLING_TRAILSTKSIZE)) {
+    tagged_t *choice_top = ChoiceTopFromChoice(w->choice);
+    intmach_t size = (TABLING_CHOICESTKSIZE + TABLING_TRAILSTKSIZE -
+                      ChoiceDifference(Choice_Start, choice_top) -
+                      TrailDifference(Trail_Start, w->trail_top)) / 2;
+    CVOID__CALL(choice_overflow,2*size*sizeof(tagged_t),TRUE);
+  }  
+
+  // ---------------------------------------------------------------------------
+}
+
+//Waiting for the generator (of other thread) would close a cycle of
+//threads waiting for each other (with tables_cond locked).
+intmach_t tables_wait_deadlock(struct gen *gen)
+{
+  struct tabling_thread *thread = gen->owner;
+  //(there are no cycles without the current thread)
+  while (thread != tabling_self)
+    {
+      if (thread->waiting_for == NULL) return FALSE;
+      thread = thread->waiting_for->owner;
+    }
+  return TRUE;
+}
+
 CFUN__PROTO(get_cons,
             struct cons_list*,
             struct sf *sf, struct gen *gen, struct gen *last_gen) {
@@ -483,6 +625,7 @@ CFUN__PROTO(complete, int,
             struct gen *call, struct gen *parentcall) {
   if (call == call->leader) 
     {
+      EVTRACE(EVT_TABLE_COMPLETE, EVT_PH_INSTANT, (intmach_t)call);
       HeapFReg = call->heap_freg;
       StackFReg = call->stack_freg;
       Arg->heap_top = call->heap_top;
@@ -492,6 +635,7 @@ CFUN__PROTO(complete, int,
 
 #if defined(SWAPPING)
       struct gen *igen = last_gen_list;
+      TABLES_LOCK;
       while (igen != NULL)
         {
           if (igen->leader == call)
@@ -506,6 +650,7 @@ CFUN__PROTO(complete, int,
             }
           igen = igen->prev;
         } 
+      TABLES_UNLOCK_BROADCAST;
       igen = last_gen_list;
       while (igen != NULL)
         {
@@ -517,17 +662,52 @@ CFUN__PROTO(complete, int,
           else igen = igen->prev;
         } 
 #else
+      TABLES_LOCK;
       while (last_gen_list != call->prev)
         {
           last_gen_list->state = COMPLETE;
           last_gen_list->on_exec = NOEXECUTING;
           last_gen_list = last_gen_list->prev;
         } 
+      //wake up threads waiting for these generators
+      TABLES_UNLOCK_BROADCAST;
       if (last_gen_list != NULL) last_gen_list->post = NULL;
 #endif
     }
   return TRUE;
 }
+
+//The evaluation of the generator call (in this thread) has been
+//abandoned by an exception or because its goal is being killed: the
+//generators that it left incomplete are marked as abandoned (their
+//next call evaluates them again) and the threads waiting for them are
+//woken up. Its choice point is removed.
+CVOID__PROTO(abandon_generator, struct gen *call) {
+  if (call == call->leader)
+    {
+      //(frozen consumers of the evaluation are not resumed)
+      HeapFReg = call->heap_freg;
+      StackFReg = call->stack_freg;
+      DEALLOC_TABLING_STK(call->tabl_stk_top);
+      LastNodeTR = call->last_node_tr;
+    }
+
+  TABLES_LOCK;
+  //(the generators created after call have greater ids)
+  while (last_gen_list != NULL && last_gen_list->id >= call->id)
+    {
+      if (last_gen_list->state != COMPLETE)
+        {
+          last_gen_list->state = ABANDONED;
+          last_gen_list->on_exec = NOEXECUTING;
+        }
+      last_gen_list = last_gen_list->prev;
+    }
+  TABLES_UNLOCK_BROADCAST;
+  if (last_gen_list != NULL) last_gen_list->post = NULL;
+
+  pop_choicept(Arg);
+}
 #endif
 
 
@@ -546,7 +726,36 @@ CBOOL__PROTO(abolish_all_tables_c) {
 //  trail_time = 0;
 //  sch_time = 0;
 
+  //Other goals may be reading (complete) tables without locking, so
+  //the tables are removed only if the other goals which made tabled
+  //calls have finished (or fail otherwise).
+  goal_descriptor_t *gd = Arg->misc->goal_desc_ptr;
+  struct tabling_goal **p, *g;
+
+  TABLES_LOCK;
+  for (g = tabling_goals; g != NULL; g = g->next)
+    {
+      if (g->gd != gd && tabling_goal_alive(g))
+        {
+          TABLES_UNLOCK;
+          return FALSE;
+        }
+    }
+  for (p = &tabling_goals; (g = *p) != NULL; )
+    {
+      if (g->gd != gd)
+        {
+          *p = g->next;
+          checkdealloc_TYPE(struct tabling_goal, g);
+        }
+      else p = &g->next;
+    }
   DEALLOC_GLOBAL_TABLE;
+  trie_node_top = NULL;
+  shared_tables = NULL;
+  stored_tables = 0;
+  tables_epoch++;
+  TABLES_UNLOCK;
 
 //  printf("\nTOTAL MEMORY %g\n",(total_memory-24816)/(double)1024);
 //  GetFrameTop(Arg->local_top,Arg->choice,G->frame);
@@ -558,8 +767,10 @@ CBOOL__PROTO(abolish_all_tables_c) {
 //       (tabling_stack_free - tabling_stack) * sizeof(tagged_t));
 //  total_memory = 0;
   init_tries_module();
-  trie_node_top = NULL;
+  private_trie_top = NULL;
   auxiliar_trie = NULL;
+  last_gen_list = NULL;
+  private_tables_epoch = tables_epoch;
 
 
 #if defined(ANS_COUNTER)
@@ -587,36 +798,97 @@ CBOOL__PROTO(abolish_all_tables_c) {
 //tabled_call version for non constraint mode
 CBOOL__PROTO(tabled_call_c) {
 #if defined(TABLING)
+  ERR__FUNCTOR("tabling_rt:tabled_call", 1);
 #if defined(DEBUG_ALL)
   printf("\ntabled_call START\n"); fflush(stdout);
 #endif
 
+  CVOID__CALL(init_tabling_thread, 1);
+
   //I cannot use stacks here because a consumer can read
   //all its answers (from a complete generator) and this not
   //chronological
   struct sf *sf = (struct sf*) checkalloc(sizeof(struct sf));
   struct gen *callid;
   TrNode node;
-  TABLED_CALL(Arg, X(0), node, sf);
-  callid = (struct gen*) node->child;
+  intmach_t locked = FALSE;
+  intmach_t reused = FALSE;
+
+#if defined(SWAPPING)
+  //copy_term X(0) -> private_term (before locking the tables, since
+  //it calls Prolog)
+  tagged_t private_term = MkVarTerm(Arg);
+  args[0] = X(0);
+  args[1] = private_term;
+  tagged_t copy_term_call = MkApplTerm(functor_copy_term,2,args);
+  ciao_frame_re_begin(Arg->misc->goal_desc_ptr);
+  ciao_commit_call_term(ciao_refer(copy_term_call));
+  ciao_frame_re_end();
+  //end copy
+#endif
+
+  if (tabling_private_tables == atom_on)
+    {
+      TABLED_CALL(Arg, private_trie_top, X(0), node, sf);
+      callid = (struct gen*) node->child;
+    }
+  else
+    {
+    shared_call:
+      TABLES_LOCK;
+      locked = TRUE;
+      TABLED_CALL(Arg, trie_node_top, X(0), node, sf);
+      callid = (struct gen*) node->child;
+      if (callid != NULL && callid->owner != tabling_self &&
+          callid->state != COMPLETE && callid->state != ABANDONED)
+        {
+          //it is being evaluated by other thread
+          if (tables_wait_deadlock(callid))
+            {
+              //(the owner is waiting for us) evaluate it privately
+              TABLES_UNLOCK;
+              checkdealloc_sf(sf);
+              sf = (struct sf*) checkalloc(sizeof(struct sf));
+              TABLED_CALL(Arg, private_trie_top, X(0), node, sf);
+              callid = (struct gen*) node->child;
+            }
+          else
+            {
+              //wait until it is complete (or abandoned by its owner)
+              tabling_self->waiting_for = callid;
+              TABLES_UNLOCK;
+              Wait_For_Cond_Begin(callid->state != COMPLETE &&
+                                  callid->state != ABANDONED, tables_cond);
+              tabling_self->waiting_for = NULL;
+              TABLES_UNLOCK;
+              if (callid->state == ABANDONED)
+                {
+                  //take over its evaluation (unless other waiter did)
+                  checkdealloc_sf(sf);
+                  sf = (struct sf*) checkalloc(sizeof(struct sf));
+                  goto shared_call;
+                }
+            }
+          locked = FALSE;
+        }
+    }
+
+  if (callid != NULL && callid->state == ABANDONED)
+    {
+      //evaluate it again (in the same call trie node)
+      callid = NULL;
+      reused = TRUE;
+    }
 
   if (callid == NULL) //it is a generator
     {
       tagged_t on_exec = MkVarTerm(Arg);
+      tagged_t error = MkVarTerm(Arg);
       //TODO - replicate for constraints
       struct sf *sf_priv;
 #if defined(SWAPPING)
       sf_priv = (struct sf*) checkalloc(sizeof(struct sf));
-      //copy_term X(0) -> private_term
-      tagged_t private_term = MkVarTerm(Arg);
-      args[0] = X(0);
-      args[1] = private_term;
-      tagged_t copy_term_call = MkApplTerm(functor_copy_term,2,args);
-      ciao_frame_re_begin(Arg->misc->goal_desc_ptr);
-      ciao_commit_call_term(ciao_refer(copy_term_call));
-      ciao_frame_re_end();
-      //end copy
-      TABLED_CALL(Arg, private_term, node, sf_priv);
+      TABLED_CALL(Arg, private_trie_top, private_term, node, sf_priv);
 #endif
 
       push_choicept(Arg, address_nd_resume_cons_c);
@@ -645,6 +917,11 @@ CBOOL__PROTO(tabled_call_c) {
       //#endif
 
       node->child = (TrNode) callid;
+      if (locked)
+        {
+          if (!reused) add_shared_table(node);
+          TABLES_UNLOCK;
+        }
       PUSH_PTCP(callid);
 #if defined(DEBUG_ALL)
       printf("\nPUSH_PTCP %p\n",callid);
@@ -652,10 +929,25 @@ CBOOL__PROTO(tabled_call_c) {
       MAKE_UNDO_PUSH_PTCP(Arg,callid);
 
       int res;
-      EXECUTE_CALL(res,Arg, X(0), callid);
+      EXECUTE_CALL(res,Arg, generator_goal(Arg, X(0), error), callid);
+      if (Stop_This_Goal(Arg))
+        {
+          //the goal is being killed
+          CVOID__CALL(abandon_generator, callid);
+          return FALSE;
+        }
+      DEREF(error, error);
+      if (!IsVar(error))
+        {
+          //an exception (rethrown after abandoning the generator)
+          CVOID__CALL(abandon_generator, callid);
+          BUILTIN_ERROR(ERR_foreign_error, error, -1);
+        }
       return res;
     }
 
+  if (locked) TABLES_UNLOCK;
+
   //it is a consumer
   //  if (callid->state != COMPLETE)
   struct gen *leader = get_leader(callid);
@@ -761,10 +1053,13 @@ CBOOL__PROTO(lookup_trie_c) {
   //I cannot use stacks here because a consumer can read
   //all its answers (from a complete generator) and this not
   //chronological
+  CVOID__CALL(init_tabling_thread, 3);
+
+  //(tables with constraints are always thread private)
   struct sf *sf = (struct sf*) checkalloc(sizeof(struct sf));
   struct gen *callid;
   TrNode node;
-  TABLED_CALL(Arg, X(0), node, sf);
+  TABLED_CALL(Arg, private_trie_top, X(0), node, sf);
 
 #if defined(DEBUG_ALL)
   printf("\nlookup_trie END\n"); fflush(stdout);
@@ -1627,65 +1922,30 @@ CBOOL__PROTO(initial_tabling_c) {
     SetArity(GET_ATOM("tabling_rt:$push_ptcp"), 1);
   atom_pop_ptcp = GET_ATOM("tabling_rt:$pop_ptcp");
   atom_gen_tree_backtracking = GET_ATOM("tabling_rt:$gen_tree_backtracking");
+  functor_stored_call = SetArity(GET_ATOM("tabling_rt:$stored_call"), 1);
+  functor_gen_call = SetArity(GET_ATOM("tabling_rt:$gen_call"), 2);
 
   INIT_GLOBAL_TABLE;
-  INIT_TABLING_STACK;
+  Init_Cond(tables_cond);
+  tables_epoch = 0;
 
 //  trail_time = 0;
 //  sch_time = 0;
-  iptcp_stk = 0;
-  ptcp_stk = (struct gen**) checkalloc (PTCP_STKSIZE * sizeof(struct gen*)); 
-  PUSH_PTCP(NULL);
 
 //  total_memory = 0;
 
   trie_node_top = NULL;
-  auxiliar_trie = NULL;
-  last_gen_list = NULL;
-  init_tries_module();
+  shared_tables = NULL;
+  stored_tables = 0;
   address_nd_consume_answer_c = def_retry_c(nd_consume_answer_c,3);
   address_nd_consume_answer_attr_c = def_retry_c(nd_consume_answer_attr_c,5);
   //arity 3 for compatibility with consume answer
   address_nd_resume_cons_c = def_retry_c(nd_resume_cons_c,3); 
   address_nd_back_answer_c = def_retry_c(nd_back_answer_c,1);
 
-  //Initialize LastNodeTR
-  INIT_NODE_TR(initial_node_tr);
-  INIT_NODE_TR(LastNodeTR);
-
-  // ---------------------------------------------------------------------------
-  // TODO:[JF] fix this horrible hack that forces stack resizes!
-
-  if (Heap_End != HeapCharOffset(Heap_Start, TABLING_GLOBALSTKSIZE*sizeof(tagged_t))) {
-    intmach_t size = (TABLING_GLOBALSTKSIZE*sizeof(tagged_t) - HeapCharDifference(Heap_Start, w->heap_top))/2;
-    heap_overflow(Arg,2*size); // TODO:[oc-merge] pad was multiplied inside heap_overflow
-  }
-
-  if (Stack_End != StackOffset(Stack_Start, TABLING_LOCALSTKSIZE)) {
-    tagged_t *new_Stack_Start;
-    intmach_t reloc_factor;
-
-    new_Stack_Start = REALLOC_AREA(Stack_Start,
-                                   StackDifference(Stack_Start,Stack_End)*sizeof(tagged_t),
-                                   TABLING_LOCALSTKSIZE*sizeof(tagged_t));
-
-    reloc_factor = (char *)new_Stack_Start - (char *)Stack_Start;
-    stack_overflow_adjust_wam(w, reloc_factor);
-
-    /* Final adjustments */
-    Stack_Start = new_Stack_Start;            /* new bounds */
-    Stack_End = StackOffset(new_Stack_Start,TABLING_LOCALSTKSIZE);
-  }
-
-  if (Trail_End != TrailOffset(Trail_Start, TABLING_CHOICESTKSIZE + TABLING_TRAILSTKSIZE)) {
-    tagged_t *choice_top = ChoiceTopFromChoice(w->choice);
-    intmach_t size = (TABLING_CHOICESTKSIZE + TABLING_TRAILSTKSIZE -
-                      ChoiceDifference(Choice_Start, choice_top) -
-                      TrailDifference(Trail_Start, w->trail_top)) / 2;
-    CVOID__CALL(choice_overflow,2*size*sizeof(tagged_t),TRUE);
-  }  
-
-  // ---------------------------------------------------------------------------
+  //Initialize the tabling stack, LastNodeTR, etc. of this thread
+  //(other threads do it on their first tabled call)
+  CVOID__CALL(init_tabling_thread, 0);
 
 #if defined(ANS_COUNTER)
   ans_no_saved=0;
@@ -25,6 +25,7 @@ extern tagged_t atom_gen_tree_backtracking;
 #define READY           0
 #define EVALUATING      1
 #define COMPLETE        2
+#define ABANDONED       3 //its evaluation was abandoned (exception or killed thread).
 #define MEMSIZE         512*2*2*2*4*4*4
 
 
@@ -49,10 +50,17 @@ extern tagged_t atom_gen_tree_backtracking;
 
 #define SETMIN(x, y) if (y < x) x = y;
 
-#define TABLED_CALL(ARG, CALL, NODE, SF)                                \
+/* Shared tables: the call trie and the state of the generators in it
+   are protected by tables_cond (the answers of complete generators
+   are read without locking) */
+#define TABLES_LOCK Cond_Begin(tables_cond)
+#define TABLES_UNLOCK Wait_For_Cond_End(tables_cond)
+#define TABLES_UNLOCK_BROADCAST Broadcast_Cond(tables_cond)
+
+#define TABLED_CALL(ARG, TOP, CALL, NODE, SF)                           \
   {                                                                     \
-    if (trie_node_top == NULL) trie_node_top = open_trie();             \
-    NODE = put_trie_entry(trie_node_top, (CALL), (SF));                 \
+    if ((TOP) == NULL) (TOP) = open_trie();                             \
+    NODE = put_trie_entry((TOP), (CALL), (SF));                         \
   }
 
 #define INIT_CALLID(ARG, CALLID, SF, ON_EXEC, SF_PRIV)                  \
@@ -60,6 +68,7 @@ extern tagged_t atom_gen_tree_backtracking;
     ALLOC_GLOBAL_TABLE(*(CALLID), struct gen*, sizeof(struct gen));     \
     (*(CALLID))->ptcp = PTCP;                                           \
     (*(CALLID))->on_exec = (ON_EXEC);                                   \
+    (*(CALLID))->owner = tabling_self;                                  \
     (*(CALLID))->sf = (SF);                                             \
     (*(CALLID))->sf_priv = (SF_PRIV);                                   \
     (*(CALLID))->trie_ans = open_trie();                                \
@@ -95,12 +104,15 @@ extern tagged_t atom_gen_tree_backtracking;
     (CALLID)->state = EVALUATING;                                       \
                                                                         \
     int i;                                                              \
+    /* (the nested wam does not restore the error handler) */           \
+    SIGJMP_BUF *errhandler = (ARG)->misc->errhandler;                   \
                                                                         \
     PRINT_REG("\n\n\t EXECUTE_CALL - A -\n");                           \
     ciao_frame_re_begin((ARG)->misc->goal_desc_ptr);                    \
     PRINT_REG("\n\n\t EXECUTE_CALL - B -\n");                           \
     (BOOL) = ciao_commit_call_term(ciao_refer(CALL));                   \
     ciao_frame_re_end();                                                \
+    (ARG)->misc->errhandler = errhandler;                               \
     PRINT_REG("\n\n\t EXECUTE_CALL - C -\n");                           \
   }
 
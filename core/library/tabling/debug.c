@@ -23,6 +23,7 @@ tagged_t tabling_trace;
 tagged_t tabling_print;
 tagged_t tabling_bypass;
 //#endif
+__thread tagged_t tabling_private_tables; //tables of this thread are not shared
 
 #if defined(ANS_COUNTER)
 intmach_t ans_no_saved, ans_removed, ans_saved, ans_aggregated;
@@ -67,8 +68,9 @@ CBOOL__PROTO(set_tabling_flag_c) {
   else if (strcmp(flag, "trace")==0) tabling_trace = newvalue;
   else if (strcmp(flag, "print")==0) tabling_print = newvalue;
   else if (strcmp(flag, "bypass")==0) tabling_bypass = newvalue;
-  else return FALSE; 
   //#endif
+  else if (strcmp(flag, "private_tables")==0) tabling_private_tables = newvalue;
+  else return FALSE; 
 
   return TRUE;
 
@@ -106,6 +108,8 @@ CBOOL__PROTO(current_tabling_flag_c) {
   else if (strcmp(flag, "print")==0) return Unify(ARG2,tabling_print);
   else if (strcmp(flag, "bypass")==0) return Unify(ARG2,tabling_bypass);
   //#endif
+  else if (strcmp(flag, "private_tables")==0)
+    return Unify(ARG2,(tabling_private_tables == atom_on ? atom_on : atom_off));
 
   printf("The flag '%s' does not exists\n", flag);
   return FALSE;
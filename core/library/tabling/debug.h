@@ -18,6 +18,7 @@ extern tagged_t tabling_trace;
 extern tagged_t tabling_print;
 extern tagged_t tabling_bypass;
 //#endif
+extern __thread tagged_t tabling_private_tables;
 
 #if defined(ANS_COUNTER)
 CBOOL__PROTO(print_counters_c);
@@ -0,0 +1,159 @@
+#if defined(TABLING)
+
+/* -------------------------- */
+/*   Saved/loaded tables      */
+/* -------------------------- */
+
+//Calls of the shared tables (for save_tables/2), newest first. Entries
+//live in the global table (they are freed by abolish_all_tables/0).
+struct table_entry
+{
+  TrNode node;                    //leaf of the call trie.
+  intmach_t id;                   //(decreasing along the list)
+  struct table_entry *next;
+};
+
+struct table_entry *shared_tables;
+//(ids are not reused, so that '$next_table'/5 cursors stay valid)
+intmach_t last_table_id;
+//last entry returned by '$next_table'/5 in this thread (and the epoch
+//of the tables when it was returned)
+__thread struct table_entry *next_table_entry;
+__thread intmach_t next_table_epoch;
+
+//there are tables loaded with load_tables/1 (generators look for them
+//before executing the tabled clauses)
+intmach_t stored_tables;
+
+tagged_t functor_stored_call;
+tagged_t functor_gen_call;
+
+//Register the call trie leaf of a new shared generator (with
+//tables_cond locked).
+void add_shared_table(TrNode node)
+{
+  struct table_entry *entry;
+
+  ALLOC_GLOBAL_TABLE(entry, struct table_entry*, sizeof(struct table_entry));
+  entry->node = node;
+  entry->id = ++last_table_id;
+  entry->next = shared_tables;
+  shared_tables = entry;
+}
+
+//Goal evaluated by a new generator (error is bound to the exception
+//raised by call, if any, see tabling_rt:'$gen_call'/2).
+CFUN__PROTO(generator_goal, tagged_t, tagged_t call, tagged_t error)
+{
+  tagged_t gen_args[2];
+  gen_args[0] = call;
+  if (stored_tables) gen_args[0] = MkApplTerm(functor_stored_call, 1, &call);
+  gen_args[1] = error;
+  return MkApplTerm(functor_gen_call, 2, gen_args);
+}
+
+//Ensure that there are AMOUNT bytes available in the heap (with
+//X(0)..X(ARITY-1) live). The heap is expanded without garbage
+//collection, which is not supported with tabling (see tabling_doc.pl).
+#define TABLES_TEST_HEAP_OVERFLOW(AMOUNT, ARITY) ({                     \
+  if (HeapCharAvailable(G->heap_top) < (AMOUNT)) {                      \
+    bool_t gcmode = current_gcmode;                                     \
+    current_gcmode = FALSE;                                             \
+    TEST_HEAP_OVERFLOW(G->heap_top, (AMOUNT), (ARITY));                 \
+    current_gcmode = gcmode;                                            \
+  }                                                                     \
+})
+
+//Upper bound of the heap cells that get_trie_term/get_trie_answer
+//take for the term of the trie leaf node (for each trie node: its
+//argument cell, a structure header, and a variable or the list or
+//comma cells of an element).
+static intmach_t trie_term_cells(TrNode node)
+{
+  intmach_t cells = 0;
+  for (; node != NULL; node = TrNode_parent(node)) cells += 4;
+  return cells;
+}
+
+/* '$next_table'(+Ref0, -Ref, -Call, -Vars, -Answers): Call is the next
+   complete shared table after Ref0 (0 for the first one), Vars is the
+   '$ans'/N term with the N variables of Call (the atom '$ans' if Call
+   is ground) and Answers is the list of instances of Vars that are
+   answers of Call (last answer first). Ref is the id of its entry in
+   shared_tables (not a pointer, so that any Ref0 is safe). */
+CBOOL__PROTO(next_table_c) {
+  ERR__FUNCTOR("tabling_rt:$next_table", 5);
+  struct table_entry *entry;
+  struct gen *gen;
+  struct l_ans *ans;
+  struct sf sf;
+  tagged_t functor_ans;
+  tagged_t *call_vars;
+  intmach_t ref, cells, i;
+
+  DEREF(X(0),X(0));
+  if (!TaggedIsSmall(X(0))) ERROR_IN_ARG(X(0), 1, ERR_type_error(integer));
+  ref = IntOfTerm(X(0));
+
+  TABLES_LOCK;
+  if (ref == 0) entry = shared_tables;
+  else if (next_table_entry != NULL && next_table_entry->id == ref &&
+           next_table_epoch == tables_epoch)
+    entry = next_table_entry->next;
+  else
+    {
+      //(not the last entry returned in this thread)
+      for (entry = shared_tables; entry != NULL && entry->id >= ref;
+           entry = entry->next) ;
+    }
+  while (entry != NULL &&
+         ((struct gen *)entry->node->child)->state != COMPLETE)
+    entry = entry->next;
+  next_table_entry = entry;
+  next_table_epoch = tables_epoch;
+  TABLES_UNLOCK;
+  if (entry == NULL) return FALSE;
+
+  //(answers of complete generators are read without locking)
+  gen = (struct gen *)entry->node->child;
+
+  //X(5) = Call, X(6) = Vars, X(7) = Answers (also live in heap GCs)
+  cells = trie_term_cells(entry->node);
+  TABLES_TEST_HEAP_OVERFLOW((cells + cells/4 + 1)*sizeof(tagged_t)+CONTPAD, 5);
+  X(5) = get_trie_term(Arg, entry->node);
+  //(trie variable i of the call is stack_vars_base[i])
+  sf.size = max_index + 1;
+  sf.attr_size = 0;
+  sf.attrs = NULL;
+  call_vars = checkalloc_ARRAY(tagged_t, sf.size);
+  for (i = 0; i < sf.size; i++) call_vars[i] = stack_vars_base[i];
+  functor_ans = SetArity(MkAtomTerm("$ans"), sf.size);
+  X(6) = MkApplTerm(functor_ans, sf.size, call_vars);
+  checkdealloc_ARRAY(tagged_t, sf.size, call_vars);
+
+  X(7) = atom_nil;
+  sf.vars = checkalloc_ARRAY(tagged_t, sf.size);
+  for (ans = gen->first_ans; ans != NULL; ans = ans->next)
+    {
+      cells = trie_term_cells(ans->node) + 2*sf.size + 1 + LSTCELLS;
+      TABLES_TEST_HEAP_OVERFLOW(cells*sizeof(tagged_t)+CONTPAD, 8);
+      for (i = 0; i < sf.size; i++) sf.vars[i] = MkVarTerm(Arg);
+      get_trie_answer(Arg, ans->node, &sf);
+      X(7) = MkPairTerm(MkApplTerm(functor_ans, sf.size, sf.vars), X(7));
+    }
+  checkdealloc_ARRAY(tagged_t, sf.size, sf.vars);
+
+  return Unify(X(1),MkIntTerm(entry->id)) &&
+    Unify(X(2),X(5)) &&
+    Unify(X(3),X(6)) &&
+    Unify(X(4),X(7));
+}
+
+/* '$stored_tables'(+Flag): there are loaded tables if Flag is 1 */
+CBOOL__PROTO(stored_tables_c) {
+  DEREF(X(0),X(0));
+  stored_tables = IntOfTerm(X(0));
+  return TRUE;
+}
+
+#endif
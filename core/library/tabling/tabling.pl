@@ -27,7 +27,9 @@
             tabling_stats/0,
             set_tabling_flag/2,      % debug:    set_tabling_flag_c
             current_tabling_flag/2,  % debug:    current_tabling_flag_c
-            abolish_all_tables/0
+            abolish_all_tables/0,
+            save_tables/2,
+            load_tables/1
         ]).
 :- endif.
 
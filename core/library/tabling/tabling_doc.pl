@@ -58,6 +58,56 @@
    @math{\Theta}-CHAT approach @cite{demoen99:chat_complexity} which
    does not require major changes in the compiler or run-time system.
 
+   @section{Tabling and threads}
+
+   Tables are shared by all the threads (e.g., goals started with
+   @pred{eng_call/4}). A tabled call is evaluated by the first thread
+   that makes it (its @em{owner}). Other threads making the same
+   (variant) call before its table is complete wait until the owner
+   completes it and then read its answers, without any locking. If
+   waiting would make two or more threads wait for each other, the
+   call is evaluated again in a table private to the thread.
+
+   A thread can opt for private tables with
+   @tt{set_tabling_flag(private_tables, on)} (before making tabled
+   calls). Tables for calls with constraints (TCLP) are always
+   private.
+
+   If the owner abandons the evaluation of a call before its table
+   is complete (because of an exception or because its goal is
+   killed), the incomplete tables are discarded and the exception is
+   propagated as usual. The next call (e.g., of a waiting thread)
+   evaluates it again.
+
+   @pred{abolish_all_tables/0} removes the tables of all threads.
+   Since complete tables are read without locking, it raises a
+   permission error if other goals that have made tabled calls are
+   still alive (working or with pending solutions, see
+   @pred{eng_release/1}).
+
+   @section{Saving and loading tables}
+
+   Complete tables can be saved to a file with @pred{save_tables/2}
+   and loaded in a later execution with @pred{load_tables/1}, to avoid
+   recomputing expensive fixpoints:
+
+@begin{verbatim}
+?- path(a, X), fail ; save_tables('path.tab', [path/2]).
+...
+?- load_tables('path.tab'), path(a, X).
+@end{verbatim}
+
+   Each saved table is keyed by its call and by a fingerprint of the
+   code of the module defining the tabled predicate (computed by the
+   compiler from all the clauses of the module). Tables whose
+   fingerprint does not match the loaded code are ignored by
+   @pred{load_tables/1}. Note that the fingerprint does not cover
+   predicates defined in other modules.
+
+   Loaded tables are inserted in the table space lazily: the first
+   call which is a variant of a loaded call takes its answers from the
+   loaded table instead of executing the clauses of the predicate.
+
    @section{Tabled Constraint Logic Programming}
 
    The TCLP implementation allows the combination of tabling with
@@ -2,6 +2,8 @@
     print_counters/0,
     tabling_stats/0,
     abolish_all_tables/0,
+    save_tables/2,
+    load_tables/1,
     tabled_call/1,
     tabled_call_attr/1,
     new_answer/0,
@@ -26,13 +28,15 @@
     '$reinstall_store'/3,
     set_tabling_flag/2,      % debug:    set_tabling_flag_c
     current_tabling_flag/2  % debug:    current_tabling_flag_c
-], [assertions, hiord, regtypes, foreign_interface]).
+], [assertions, hiord, regtypes, datafacts, foreign_interface]).
 
 :- use_module(library(write)).
 :- use_module(library(lists)).
 :- use_module(engine(basic_props)).
 
 :- use_module(engine(hiord_rt), ['$meta_call'/1]).
+:- use_module(engine(stream_basic)).
+:- use_module(library(fastrw)).
 
 :- use_module(library(tabling/forward_trail)).
 
@@ -45,6 +49,7 @@
 :- multifile 'tabling_rt:answer_check_entail'/5.
 :- multifile 'tabling_rt:reinstall_store'/3.
 :- multifile 'tabling_rt:apply_answer'/3.
+:- multifile 'tabling_rt:table_fingerprint'/2. % (from tabling_tr)
 
 '$call_domain_projection'(Vars, Dom) :- 
     'tabling_rt:call_domain_projection'(Vars, Dom).
@@ -77,13 +82,170 @@
 '$reinstall_store'(Vars, DomOrig, Orig) :- 
     'tabling_rt:reinstall_store'(Vars, DomOrig, Orig).
 
-:- trust pred abolish_all_tables + foreign_low(abolish_all_tables_c)
-   # "Removes all tables currently in the system and frees all the
-   memory held by Ciao for these structures. Predicates that have been
-   declared as tabled remain so, but any information in their tables
-   is deleted. @pred{abolish_all_tables/0} works directly on the
-   memory structures allocated for table space. This makes it very
-   fast for abolishing a large volume of tables.".
+:- pred abolish_all_tables
+   # "Removes all tables currently in the system (including those
+   loaded with @pred{load_tables/1}) and frees all the memory held by
+   Ciao for these structures. Predicates that have been declared as
+   tabled remain so, but any information in their tables is
+   deleted. @pred{abolish_all_tables/0} works directly on the memory
+   structures allocated for table space. This makes it very fast for
+   abolishing a large volume of tables.
+
+   Since tables are shared by all threads, a permission error is
+   raised if other goals that have made tabled calls are still alive
+   (working or with pending solutions), as they may be reading the
+   tables.".
+
+abolish_all_tables :-
+    ( '$abolish_all_tables' -> true
+    ; throw(error(permission_error(modify, tables, all), abolish_all_tables/0))
+    ),
+    retractall_fact(stored_table(_, _, _, _)),
+    retractall_fact(stored_answer(_, _)).
+
+:- trust pred '$abolish_all_tables' + foreign_low(abolish_all_tables_c).
+
+%% saved tables
+:- pred save_tables(+File, +Preds) :: sourcename * term
+   # "Saves to @var{File} the complete tables of the tabled predicates
+   in @var{Preds}, which is @tt{all} or a list of predicate
+   specifications @tt{Name/Arity} or @tt{Module:Name/Arity}. Each
+   table is saved with its call, its answers, and the fingerprint of
+   the code of the module defining the predicate. Tables which are not
+   complete or thread private are not saved.".
+
+save_tables(File, Preds) :-
+    open(File, write, S),
+    fast_write(S, '$tables'(1)),
+    save_tables_(0, Preds, S),
+    close(S).
+
+% (a table is saved as table(M, Fp, Call, Vars, N) followed by its N
+% answers, one term each)
+save_tables_(Ref0, Preds, S) :-
+    '$next_table'(Ref0, Ref, Call, Vars, Answers0), !,
+    ( table_pred(Call, M, P),
+      selected_pred(Preds, M, P),
+      'tabling_rt:table_fingerprint'(M, Fp) ->
+        reverse(Answers0, Answers),
+        length(Answers, N),
+        fast_write(S, table(M, Fp, Call, Vars, N)),
+        save_answers(Answers, S)
+    ; true
+    ),
+    save_tables_(Ref, Preds, S).
+save_tables_(_, _, _).
+
+save_answers([], _).
+save_answers([Ans|Answers], S) :-
+    fast_write(S, Ans),
+    save_answers(Answers, S).
+
+% (calls are 'M:$Name'(...), see tabling_tr)
+table_pred(Call, M, Name/A) :-
+    functor(Call, F, A),
+    atom_codes(F, Cs),
+    append(MCs, [0':, 0'$|NameCs], Cs), !,
+    atom_codes(M, MCs),
+    atom_codes(Name, NameCs).
+
+selected_pred(all, _, _) :- !.
+selected_pred(Preds, M, P) :-
+    ( member(M:P, Preds) -> true
+    ; member(P, Preds)
+    ).
+
+:- pred load_tables(+File) :: sourcename
+   # "Loads the tables saved in @var{File} with @pred{save_tables/2}.
+   Tables whose code fingerprint does not match the current code of
+   their module (or whose module is not loaded) are ignored. Loaded
+   tables are not inserted in the table space until they are called:
+   the first call which is a variant of a loaded call takes its
+   answers from the loaded table instead of executing the clauses of
+   the predicate.".
+
+load_tables(File) :-
+    open(File, read, S),
+    fast_read(S, Header),
+    ( Header = '$tables'(1) ->
+        load_tables_(S),
+        close(S)
+    ; close(S),
+      throw(error(domain_error(tables_file, File), load_tables/1))
+    ),
+    ( current_fact(stored_table(_, _, _, _)) ->
+        '$stored_tables'(1)
+    ; true
+    ).
+
+% (fast_read/2 fails at the end of the file)
+load_tables_(S) :-
+    ( fast_read(S, table(M, Fp, Call, Vars, N)) ->
+        ( 'tabling_rt:table_fingerprint'(M, Fp0), Fp0 == Fp -> % (Fp may be a bignum)
+            table_key(Call, Key),
+            ( retract_fact(stored_table(Key, OldId, _, _)) ->
+                retractall_fact(stored_answer(OldId, _))
+            ; true
+            ),
+            retract_fact(stored_table_id(Id)),
+            Id1 is Id + 1,
+            asserta_fact(stored_table_id(Id1)),
+            assertz_fact(stored_table(Key, Id, Call, Vars)),
+            load_answers(N, Id, S)
+        ; skip_answers(N, S)
+        ),
+        load_tables_(S)
+    ; true
+    ).
+
+load_answers(0, _, _) :- !.
+load_answers(N, Id, S) :-
+    fast_read(S, Ans),
+    assertz_fact(stored_answer(Id, Ans)),
+    N1 is N - 1,
+    load_answers(N1, Id, S).
+
+skip_answers(0, _) :- !.
+skip_answers(N, S) :-
+    fast_read(S, _),
+    N1 is N - 1,
+    skip_answers(N1, S).
+
+% Loaded tables (indexed by their calls, with variables numbered) and
+% their answers
+:- data stored_table/4.
+:- data stored_answer/2.
+:- data stored_table_id/1.
+
+stored_table_id(0).
+
+table_key(Call, Key) :-
+    copy_term(Call, Key),
+    numbervars(Key, 0, _).
+
+% Goal of a new generator when there are loaded tables (see
+% table_store.c)
+'$stored_call'(Call) :-
+    table_key(Call, Key),
+    current_fact(stored_table(Key, Id, Call, Vars)), !,
+    current_fact(stored_answer(Id, Vars)),
+    new_answer.
+'$stored_call'(Call) :-
+    '$meta_call'(Call).
+
+% Goal of a new generator: Error is bound to the exception raised by
+% Call, which is rethrown after abandoning the generator (see
+% tabled_call_c)
+'$gen_call'(Call, Error) :-
+    catch('$meta_call'(Call), E, Error = E).
+
+:- trust pred '$next_table'(+Ref0, -Ref, -Call, -Vars, -Answers)
+   :: int * int * term * term * list + foreign_low(next_table_c)
+   # "@var{Call} is the next complete shared table after
+   @var{Ref0}.".
+
+:- trust pred '$stored_tables'(+Flag) :: int + foreign_low(stored_tables_c)
+   # "There are loaded tables if @var{Flag} is 1.".
 
 %% tabled_call/1 and new_answer/0 standard predicate (without attributes)
 :- trust pred tabled_call(+Call) :: cgoal + foreign_low(tabled_call_c)
@@ -0,0 +1,116 @@
+:- module(_, [], [assertions, tabling, datafacts]).
+
+:- doc(title, "Tests for tabling_rt.pl").
+
+:- use_module(library(concurrency)).
+:- use_module(library(system), [pause/1, mktemp_in_tmp/2, delete_file/1]).
+:- use_module(library(lists), [member/2, length/2]).
+:- use_module(library(aggregates), [findall/3]).
+
+% ---------------------------------------------------------------------------
+
+:- data first/0.
+:- concurrent started/0, go/0, result/2.
+
+% The first evaluation of p/1 is abandoned (with an exception) after
+% go/0 is asserted
+:- table p/1.
+p(X) :-
+    ( retract_fact(first) ->
+        assertz_fact(started),
+        wait_fact(go),
+        throw(boom)
+    ; true
+    ),
+    member(X, [1,2,3]).
+
+% (retract_fact/1 on concurrent facts waits for them, also on
+% backtracking)
+wait_fact(F) :- retract_fact(F), !.
+
+owner :-
+    catch((findall(X, p(X), L), R = L), E, R = E),
+    assertz_fact(result(owner, R)).
+
+waiter :-
+    findall(X, p(X), L),
+    assertz_fact(result(waiter, L)).
+
+:- export(test_abandoned/0).
+:- test test_abandoned # "A thread waiting for a call abandoned by its
+   owner evaluates it again".
+test_abandoned :-
+    abolish_all_tables,
+    assertz_fact(first),
+    eng_call(owner, create, create, Owner),
+    wait_fact(started),
+    eng_call(waiter, create, create, Waiter),
+    pause(1), % (so that waiter waits for p/1)
+    assertz_fact(go),
+    wait_fact(result(owner, R1)),
+    wait_fact(result(waiter, R2)),
+    eng_wait(Owner), eng_release(Owner),
+    eng_wait(Waiter), eng_release(Waiter),
+    findall(X, p(X), R3),
+    R1 == boom,
+    R2 == [1,2,3],
+    R3 == [1,2,3].
+
+:- export(test_recall/0).
+:- test test_recall # "A call abandoned by an exception is evaluated
+   again".
+test_recall :-
+    abolish_all_tables,
+    assertz_fact(first),
+    assertz_fact(go),
+    catch(findall(X, p(X), _), E, true),
+    wait_fact(started),
+    findall(X, p(X), L),
+    E == boom,
+    L == [1,2,3].
+
+:- export(test_abolish_in_use/0).
+:- test test_abolish_in_use # "abolish_all_tables/0 is refused while
+   other goals may read the tables".
+test_abolish_in_use :-
+    abolish_all_tables,
+    eng_call(p(_), create, create, Id), % (with pending solutions)
+    eng_wait(Id),
+    catch((abolish_all_tables, R = ok), error(E, _), R = E),
+    eng_release(Id),
+    abolish_all_tables,
+    R == permission_error(modify, tables, all).
+
+% ---------------------------------------------------------------------------
+
+:- data evaluated/1.
+
+:- table q/2.
+q(N, L) :-
+    assertz_fact(evaluated(N)),
+    between_(1, N, I),
+    length(L, 300), % (a large table, to fill the heap)
+    fill(L, I).
+
+between_(I, N, I) :- I =< N.
+between_(I0, N, I) :- I0 < N, I1 is I0 + 1, between_(I1, N, I).
+
+fill([], _).
+fill([I|Is], I) :- fill(Is, I).
+
+:- export(test_save_load/0).
+:- test test_save_load # "Saved tables are used after loading them".
+test_save_load :-
+    abolish_all_tables,
+    retractall_fact(evaluated(_)),
+    findall(L, q(10000, L), Ls),
+    mktemp_in_tmp('tablesXXXXXX', File),
+    save_tables(File, [q/2]),
+    abolish_all_tables,
+    load_tables(File),
+    delete_file(File),
+    findall(L, q(10000, L), Ls2),
+    findall(N, evaluated(N), Ns),
+    abolish_all_tables,
+    Ls2 == Ls,
+    Ns == [10000].
@@ -70,6 +70,20 @@ struct cons
   tagged_t attr_vars;
 };
 
+//thread evaluating tabled calls (shared tables ownership).
+struct tabling_thread
+{
+  struct gen *waiting_for;        //incomplete generator of other thread.
+};
+
+//goal that has made tabled calls (it may be reading tables).
+struct tabling_goal
+{
+  goal_descriptor_t *gd;
+  intmach_t goal_number;          //(gd may be reused by other goal).
+  struct tabling_goal *next;
+};
+
 //TODO - only essential info, this is global memory!
 struct gen 
 {
@@ -77,6 +91,7 @@ struct gen
   struct gen *leader;             //for precise SCC management.
   tagged_t on_exec;               //free var if the generator is on execution.
   intmach_t state;                     //state of the call.
+  struct tabling_thread *owner;   //thread that evaluates the call.
   struct gen *ptcp;               //to represent Global Dependence Tree (GDT).
   tagged_t realcall;          //temporal DELETE
 
@@ -4,6 +4,7 @@
 :- use_module(engine(io_basic)).
 :- use_module(engine(basic_props)).
 :- use_module(library(lists), [reverse/2, append/3, length/2]).
+:- use_module(library(write), [numbervars/3]).
 
 :- dynamic 'trans$tabled'/2, 'trans$default'/1.
 
@@ -19,6 +20,7 @@
 :- dynamic counter/1.
 
 :- data found_hook/2.
+:- data code_fingerprint/1.
 
 reset(M):-
     retractall_fact(found_hook(M, _)).
@@ -41,9 +43,13 @@ do_term_expansion(0, _, Module) :-
     ),
     assert(module(Mod)),
     assert(module_name(Mod)),
-    assert(counter(0)), retractall(counter(_)), assert(counter(1)).
+    assert(counter(0)), retractall(counter(_)), assert(counter(1)),
+    retractall_fact(code_fingerprint(_)),
+    fnv_offset_basis(Fp0),
+    asserta_fact(code_fingerprint(Fp0)).
 
-do_term_expansion(end_of_file, Tail0, _) :- !,
+do_term_expansion(end_of_file, Tail, _) :- !,
+    fingerprint_info(Tail, Tail0),
     retractall('trans$default'(_)),
     assert('trans$default'((prolog))),
     retractall('trans$prolog'(_)),
@@ -64,6 +70,7 @@ do_term_expansion(':-'(Com), Clauses, _) :- !,
 %%      display(Clauses), nl.
 
 do_term_expansion(Clause, Clauses, _) :-
+    add_fingerprint(Clause),
     (
         Clause = (Head :- Body) ->
         true
@@ -99,6 +106,66 @@ do_term_expansion(Clause, Clauses, _) :-
 %%      ),
 %%      display(Clauses), nl.
 
+% Fingerprint of the code of the module (all its clauses), used to
+% check that saved tables (save_tables/2) are valid for it. It is a
+% 64-bit FNV-1a digest of the clauses (with their variables numbered),
+% each atom, number and functor prefixed by its kind and terminated by
+% 0.
+add_fingerprint(Clause) :-
+    copy_term(Clause, Clause1),
+    numbervars(Clause1, 0, _),
+    retract_fact(code_fingerprint(Fp0)),
+    fnv_term(Clause1, Fp0, Fp),
+    asserta_fact(code_fingerprint(Fp)).
+
+fnv_offset_basis(0xcbf29ce484222325).
+
+fnv_term(T, H0, H) :- atom(T), !,
+    atom_codes(T, Cs),
+    fnv_token(0'a, Cs, H0, H).
+fnv_term(T, H0, H) :- number(T), !,
+    number_codes(T, Cs),
+    fnv_token(0'n, Cs, H0, H).
+fnv_term(T, H0, H) :-
+    functor(T, F, A),
+    atom_codes(F, Cs),
+    fnv_token(0'f, Cs, H0, H1),
+    number_codes(A, ACs),
+    fnv_token(0'/, ACs, H1, H2),
+    fnv_args(1, A, T, H2, H).
+
+fnv_args(I, A, _, H, H) :- I > A, !.
+fnv_args(I, A, T, H0, H) :-
+    arg(I, T, X),
+    fnv_term(X, H0, H1),
+    I1 is I + 1,
+    fnv_args(I1, A, T, H1, H).
+
+fnv_token(Kind, Cs, H0, H) :-
+    fnv_code(Kind, H0, H1),
+    fnv_codes(Cs, H1, H2),
+    fnv_code(0, H2, H).
+
+fnv_codes([], H, H).
+fnv_codes([C|Cs], H0, H) :-
+    fnv_code(C, H0, H1),
+    fnv_codes(Cs, H1, H).
+
+fnv_code(C, H0, H) :-
+    H is ((H0 # C) * 0x100000001b3) /\ 0xFFFFFFFFFFFFFFFF.
+
+fingerprint_info(Tail, Tail0) :-
+    'trans$tabled'(_, _),
+    module_name(Mod), !,
+    atom_codes(M, Mod),
+    code_fingerprint(Fp),
+    Tail = [
+               ( :- multifile 'tabling_rt:table_fingerprint'/2 ),
+               'tabling_rt:table_fingerprint'(M, Fp)
+           | Tail0],
+    ( tclp_actived -> true ; Tail0 = [end_of_file] ).
+fingerprint_info(Tail, Tail).
+
 write_multifile_info(Tail0) :-
     (
         tclp_aggregates(_) ->
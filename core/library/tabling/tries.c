@@ -13,15 +13,16 @@ static CFUN__PROTO(get_trie, tagged_t,
 
 //static struct global_trie_stats GLOBAL_STATS;
 //static struct local_trie_stats LOCAL_STATS;
-TrNode TRIES;
-TrHash HASHES;
-static tagged_t TERM_STACK[TERM_STACK_SIZE];
-static tagged_t ATTR_STACK[ATTR_STACK_SIZE];
-static tagged_t *stack_args, *stack_args_base;
-static tagged_t *stack_vars, *stack_vars_base;
-static tagged_t *stack_attrs, *stack_attrs_base;
-static intmach_t max_index;
-static intmach_t max_index_attr;
+// (per thread: the tries are shared but the work stacks are not)
+__thread TrNode TRIES;
+__thread TrHash HASHES;
+static __thread tagged_t TERM_STACK[TERM_STACK_SIZE];
+static __thread tagged_t ATTR_STACK[ATTR_STACK_SIZE];
+static __thread tagged_t *stack_args, *stack_args_base;
+static __thread tagged_t *stack_vars, *stack_vars_base;
+static __thread tagged_t *stack_attrs, *stack_attrs_base;
+static __thread intmach_t max_index;
+static __thread intmach_t max_index_attr;
 
 intmach_t variant = 0; 
 